@@ -33,7 +33,9 @@
   _ (2, ADMIN_UP, "admin-up")                                                 \
   _ (3, LINK_UP, "link-up")                                                   \
   _ (4, ZEROCOPY, "zero-copy")                                                \
-  _ (5, SYSCALL_LOCK, "syscall-lock")
+  _ (5, SYSCALL_LOCK, "syscall-lock")                                         \
+  _ (6, SHARED_UMEM, "shared-umem")                                           \
+  _ (7, BUSY_POLL, "busy-poll")
 
 enum
 {
@@ -128,6 +130,11 @@ typedef struct
   af_xdp_device_t *devices;
   vlib_log_class_t log_class;
   u16 msg_id_base;
+
+  /* UMEM covering the whole buffer memory, shared by all queues of all
+   * devices created with AF_XDP_CREATE_FLAGS_SHARED_UMEM */
+  struct xsk_umem *shared_umem;
+  u32 shared_umem_refcnt;
 } af_xdp_main_t;
 
 extern af_xdp_main_t af_xdp_main;
@@ -142,6 +149,8 @@ typedef enum
 typedef enum
 {
   AF_XDP_CREATE_FLAGS_NO_SYSCALL_LOCK = 1,
+  AF_XDP_CREATE_FLAGS_SHARED_UMEM = 2,
+  AF_XDP_CREATE_FLAGS_BUSY_POLL = 4,
 } af_xdp_create_flag_t;
 
 typedef struct
@@ -50,7 +50,8 @@ VLIB_CLI_COMMAND (af_xdp_create_command, static) = {
   .short_help =
     "create interface af_xdp <host-if linux-ifname> [name ifname] "
     "[rx-queue-size size] [tx-queue-size size] [num-rx-queues <num|all>] "
-    "[prog pathname] [zero-copy|no-zero-copy] [no-syscall-lock]",
+    "[prog pathname] [zero-copy|no-zero-copy] [no-syscall-lock] "
+    "[shared-umem] [busy-poll]",
   .function = af_xdp_create_command_fn,
 };
 /* *INDENT-ON* */
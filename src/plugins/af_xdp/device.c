@@ -31,6 +31,16 @@
 #include <vnet/interface/rx_queue_funcs.h>
 #include "af_xdp.h"
 
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+
+/* time in us a busy-polling syscall spins waiting for packets */
+#define AF_XDP_BUSY_POLL_USECS 20
+
 af_xdp_main_t af_xdp_main;
 
 typedef struct
@@ -89,6 +99,30 @@ af_xdp_flag_change (vnet_main_t * vnm, vnet_hw_interface_t * hw, u32 flags)
   return ~0;
 }
 
+static void
+af_xdp_umem_put (struct xsk_umem *umem)
+{
+  af_xdp_main_t *axm = &af_xdp_main;
+
+  if (!umem)
+    return;
+
+  if (umem != axm->shared_umem)
+    {
+      xsk_umem__delete (umem);
+      return;
+    }
+
+  /* the shared umem can only be released once all the sockets using it are
+   * gone */
+  ASSERT (axm->shared_umem_refcnt > 0);
+  if (--axm->shared_umem_refcnt)
+    return;
+
+  xsk_umem__delete (umem);
+  axm->shared_umem = 0;
+}
+
 void
 af_xdp_delete_if (vlib_main_t * vm, af_xdp_device_t * ad)
 {
@@ -111,7 +145,7 @@ af_xdp_delete_if (vlib_main_t * vm, af_xdp_device_t * ad)
     xsk_socket__delete (*xsk);
 
   vec_foreach (umem, ad->umem)
-    xsk_umem__delete (*umem);
+    af_xdp_umem_put (*umem);
 
   for (i = 0; i < ad->rxq_num; i++)
     clib_file_del_by_index (&file_main, vec_elt (ad->rxqs, i).file_index);
@@ -213,14 +247,6 @@ af_xdp_create_queue (vlib_main_t *vm, af_xdp_create_if_args_t *args,
     sizeof (vlib_buffer_t) + vlib_buffer_get_default_data_size (vm);
   umem_config.frame_headroom = sizeof (vlib_buffer_t);
   umem_config.flags = XDP_UMEM_UNALIGNED_CHUNK_FLAG;
-  if (xsk_umem__create
-      (umem, uword_to_pointer (vm->buffer_main->buffer_mem_start, void *),
-       vm->buffer_main->buffer_mem_size, fq, cq, &umem_config))
-    {
-      args->rv = VNET_API_ERROR_SYSCALL_ERROR_1;
-      args->error = clib_error_return_unix (0, "xsk_umem__create() failed");
-      goto err0;
-    }
 
   memset (&sock_config, 0, sizeof (sock_config));
   sock_config.rx_size = args->rxq_size;
@@ -237,15 +263,72 @@ af_xdp_create_queue (vlib_main_t *vm, af_xdp_create_if_args_t *args,
       sock_config.bind_flags |= XDP_ZEROCOPY;
       break;
     }
-  if (xsk_socket__create
-      (xsk, ad->linux_ifname, qid, *umem, rx, tx, &sock_config))
+
+  if (ad->flags & AF_XDP_DEVICE_F_SHARED_UMEM)
     {
-      args->rv = VNET_API_ERROR_SYSCALL_ERROR_2;
-      args->error =
-	clib_error_return_unix (0,
-				"xsk_socket__create() failed (is linux netdev %s up?)",
-				ad->linux_ifname);
-      goto err1;
+#ifdef AF_XDP_HAVE_SHARED_UMEM
+      af_xdp_main_t *axm = &af_xdp_main;
+
+      /*
+       * All the buffer memory is registered once in a single umem and every
+       * queue of every device binds a socket to it with its own fill and
+       * completion rings. The first socket uses the rings passed at umem
+       * creation, the others get new ones. Ring sizes and bind flags are
+       * inherited from the first socket.
+       */
+      if (!axm->shared_umem &&
+	  xsk_umem__create (
+	    &axm->shared_umem,
+	    uword_to_pointer (vm->buffer_main->buffer_mem_start, void *),
+	    vm->buffer_main->buffer_mem_size, fq, cq, &umem_config))
+	{
+	  axm->shared_umem = 0;
+	  args->rv = VNET_API_ERROR_SYSCALL_ERROR_1;
+	  args->error =
+	    clib_error_return_unix (0, "xsk_umem__create() failed");
+	  goto err0;
+	}
+
+      *umem = axm->shared_umem;
+      axm->shared_umem_refcnt++;
+
+      if (xsk_socket__create_shared (xsk, ad->linux_ifname, qid, *umem, rx,
+				     tx, fq, cq, &sock_config))
+	{
+	  args->rv = VNET_API_ERROR_SYSCALL_ERROR_2;
+	  args->error = clib_error_return_unix (
+	    0, "xsk_socket__create_shared() failed (is linux netdev %s up?)",
+	    ad->linux_ifname);
+	  goto err1;
+	}
+#else
+      args->rv = VNET_API_ERROR_UNSUPPORTED;
+      args->error = clib_error_return (
+	0, "shared umem not supported by this version of libbpf");
+      goto err0;
+#endif
+    }
+  else
+    {
+      if (xsk_umem__create (
+	    umem, uword_to_pointer (vm->buffer_main->buffer_mem_start, void *),
+	    vm->buffer_main->buffer_mem_size, fq, cq, &umem_config))
+	{
+	  args->rv = VNET_API_ERROR_SYSCALL_ERROR_1;
+	  args->error =
+	    clib_error_return_unix (0, "xsk_umem__create() failed");
+	  goto err0;
+	}
+
+      if (xsk_socket__create (xsk, ad->linux_ifname, qid, *umem, rx, tx,
+			      &sock_config))
+	{
+	  args->rv = VNET_API_ERROR_SYSCALL_ERROR_2;
+	  args->error = clib_error_return_unix (
+	    0, "xsk_socket__create() failed (is linux netdev %s up?)",
+	    ad->linux_ifname);
+	  goto err1;
+	}
     }
 
   fd = xsk_socket__fd (*xsk);
@@ -260,6 +343,28 @@ af_xdp_create_queue (vlib_main_t *vm, af_xdp_create_if_args_t *args,
   if (opt.flags & XDP_OPTIONS_ZEROCOPY)
     ad->flags |= AF_XDP_DEVICE_F_ZEROCOPY;
 
+  if (ad->flags & AF_XDP_DEVICE_F_BUSY_POLL)
+    {
+      /*
+       * Let the syscalls done by the data-plane drive the driver napi
+       * instead of irqs. To be effective, the netdev irqs should be deferred
+       * with its napi_defer_hard_irqs and gro_flush_timeout sysfs knobs.
+       */
+      int prefer = 1, usecs = AF_XDP_BUSY_POLL_USECS,
+	  budget = VLIB_FRAME_SIZE;
+      if (setsockopt (fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer,
+		      sizeof (prefer)) ||
+	  setsockopt (fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof (usecs)) ||
+	  setsockopt (fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget,
+		      sizeof (budget)))
+	{
+	  args->rv = VNET_API_ERROR_SYSCALL_ERROR_4;
+	  args->error =
+	    clib_error_return_unix (0, "setsockopt(SO_BUSY_POLL) failed");
+	  goto err2;
+	}
+    }
+
   rxq->xsk_fd = is_rx ? fd : -1;
 
   if (is_tx)
@@ -292,7 +397,7 @@ af_xdp_create_queue (vlib_main_t *vm, af_xdp_create_if_args_t *args,
 err2:
   xsk_socket__delete (*xsk);
 err1:
-  xsk_umem__delete (*umem);
+  af_xdp_umem_put (*umem);
 err0:
   *umem = 0;
   *xsk = 0;
@@ -433,6 +538,10 @@ af_xdp_create_if (vlib_main_t * vm, af_xdp_create_if_args_t * args)
   if (tm->n_vlib_mains > 1 &&
       0 == (args->flags & AF_XDP_CREATE_FLAGS_NO_SYSCALL_LOCK))
     ad->flags |= AF_XDP_DEVICE_F_SYSCALL_LOCK;
+  if (args->flags & AF_XDP_CREATE_FLAGS_SHARED_UMEM)
+    ad->flags |= AF_XDP_DEVICE_F_SHARED_UMEM;
+  if (args->flags & AF_XDP_CREATE_FLAGS_BUSY_POLL)
+    ad->flags |= AF_XDP_DEVICE_F_BUSY_POLL;
 
   ad->linux_ifname = (char *) format (0, "%s", args->linux_ifname);
   vec_validate (ad->linux_ifname, IFNAMSIZ - 1);	/* libbpf expects ifname to be at least IFNAMSIZ */
@@ -16,6 +16,7 @@
  */
 
 #include <poll.h>
+#include <sys/socket.h>
 #include <vlib/vlib.h>
 #include <vlib/unix/unix.h>
 #include <vlib/pci/pci.h>
@@ -103,6 +104,30 @@ af_xdp_device_input_refill_db (vlib_main_t * vm,
     }
 }
 
+static_always_inline void
+af_xdp_device_input_busy_poll (vlib_main_t *vm,
+			       const vlib_node_runtime_t *node,
+			       af_xdp_device_t *ad, af_xdp_rxq_t *rxq)
+{
+  /* in busy-poll mode the driver napi only runs from our syscalls, so we
+   * must kick the kernel even if it did not ask for a wakeup */
+  if (AF_XDP_RXQ_MODE_INTERRUPT == rxq->mode)
+    return;
+
+  if (clib_spinlock_trylock_if_init (&rxq->syscall_lock))
+    {
+      int ret = recvfrom (rxq->xsk_fd, 0, 0, MSG_DONTWAIT, 0, 0);
+      clib_spinlock_unlock_if_init (&rxq->syscall_lock);
+      if (PREDICT_FALSE (ret < 0 && errno != EAGAIN && errno != EBUSY))
+	{
+	  /* something bad is happening */
+	  vlib_error_count (vm, node->node_index,
+			    AF_XDP_INPUT_ERROR_SYSCALL_FAILURES, 1);
+	  af_xdp_device_error (ad, "rx recvfrom() failed");
+	}
+    }
+}
+
 static_always_inline void
 af_xdp_device_input_refill_inline (vlib_main_t *vm,
 				   const vlib_node_runtime_t *node,
@@ -289,6 +314,9 @@ af_xdp_device_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   u32 n_rx_packets, n_rx_bytes;
   u32 idx;
 
+  if (ad->flags & AF_XDP_DEVICE_F_BUSY_POLL)
+    af_xdp_device_input_busy_poll (vm, node, ad, rxq);
+
   n_rx_packets = xsk_ring_cons__peek (&rxq->rx, VLIB_FRAME_SIZE, &idx);
 
   if (PREDICT_FALSE (0 == n_rx_packets))
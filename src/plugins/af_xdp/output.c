@@ -1,5 +1,6 @@
 #include <poll.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <vlib/vlib.h>
 #include <vlib/unix/unix.h>
 #include <vnet/ethernet/ethernet.h>
@@ -90,16 +91,32 @@ af_xdp_device_output_tx_db (vlib_main_t * vm,
 			    af_xdp_device_t * ad,
 			    af_xdp_txq_t * txq, const u32 n_tx)
 {
+  const int busy_poll = ad->flags & AF_XDP_DEVICE_F_BUSY_POLL;
+
   xsk_ring_prod__submit (&txq->tx, n_tx);
 
-  if (!xsk_ring_prod__needs_wakeup (&txq->tx))
+  if (!busy_poll && !xsk_ring_prod__needs_wakeup (&txq->tx))
     return;
 
   vlib_error_count (vm, node->node_index, AF_XDP_TX_ERROR_SYSCALL_REQUIRED, 1);
 
   clib_spinlock_lock_if_init (&txq->syscall_lock);
 
-  if (xsk_ring_prod__needs_wakeup (&txq->tx))
+  if (busy_poll)
+    {
+      /* in busy-poll mode the driver napi only runs from our syscalls, and
+       * sendto() is the one driving it for tx */
+      int ret = sendto (txq->xsk_fd, 0, 0, MSG_DONTWAIT, 0, 0);
+      if (PREDICT_FALSE (ret < 0 && errno != EAGAIN && errno != EBUSY &&
+			 errno != ENOBUFS))
+	{
+	  /* something bad is happening */
+	  vlib_error_count (vm, node->node_index,
+			    AF_XDP_TX_ERROR_SYSCALL_FAILURES, 1);
+	  af_xdp_device_error (ad, "tx sendto() failed");
+	}
+    }
+  else if (xsk_ring_prod__needs_wakeup (&txq->tx))
     {
       struct pollfd fd = { .fd = txq->xsk_fd, .events = POLLIN | POLLOUT };
       int ret = poll (&fd, 1, 0);
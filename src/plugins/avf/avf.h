@@ -337,6 +337,8 @@ typedef struct
   u16 txq_num;
   u16 rxq_size;
   u16 txq_size;
+  /* rx buffers come from the smallest buffer size class fitting it */
+  u16 rx_buffer_size;
   /* return */
   int rv;
   u32 sw_if_index;
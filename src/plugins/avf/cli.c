@@ -54,6 +54,8 @@ avf_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	args.rxq_num = tmp;
       else if (unformat (line_input, "num-tx-queues %u", &tmp))
 	args.txq_num = tmp;
+      else if (unformat (line_input, "rx-buffer-size %u", &tmp))
+	args.rx_buffer_size = tmp;
       else if (unformat (line_input, "name %s", &args.name))
 	;
       else
@@ -74,7 +76,7 @@ VLIB_CLI_COMMAND (avf_create_command, static) = {
   .path = "create interface avf",
   .short_help = "create interface avf <pci-address> "
 		"[rx-queue-size <size>] [tx-queue-size <size>] "
-		"[num-rx-queues <size>]",
+		"[num-rx-queues <size>] [rx-buffer-size <size>]",
   .function = avf_create_command_fn,
 };
 /* *INDENT-ON* */
@@ -244,7 +244,8 @@ avf_cmd_rx_ctl_reg_write (vlib_main_t * vm, avf_device_t * ad, u32 reg,
 }
 
 clib_error_t *
-avf_rxq_init (vlib_main_t * vm, avf_device_t * ad, u16 qid, u16 rxq_size)
+avf_rxq_init (vlib_main_t *vm, avf_device_t *ad, u16 qid, u16 rxq_size,
+	      u16 rx_buffer_size)
 {
   clib_error_t *err;
   avf_rxq_t *rxq;
@@ -259,8 +260,12 @@ avf_rxq_init (vlib_main_t * vm, avf_device_t * ad, u16 qid, u16 rxq_size)
 						   2 * CLIB_CACHE_LINE_BYTES,
 						   ad->numa_node);
 
-  rxq->buffer_pool_index =
-    vlib_buffer_pool_get_default_for_numa (vm, ad->numa_node);
+  if (rx_buffer_size)
+    rxq->buffer_pool_index =
+      vlib_buffer_pool_get_for_size (vm, ad->numa_node, rx_buffer_size);
+  else
+    rxq->buffer_pool_index =
+      vlib_buffer_pool_get_default_for_numa (vm, ad->numa_node);
 
   if (rxq->descs == 0)
     return vlib_physmem_last_error (vm);
@@ -689,8 +694,11 @@ avf_op_config_vsi_queues (vlib_main_t * vm, avf_device_t * ad)
       if (i < vec_len (ad->rxqs))
 	{
 	  avf_rxq_t *q = vec_elt_at_index (ad->rxqs, i);
+	  vlib_buffer_pool_t *bp =
+	    vlib_get_buffer_pool (vm, q->buffer_pool_index);
 	  rxq->ring_len = q->size;
-	  rxq->databuffer_size = vlib_buffer_get_default_data_size (vm);
+	  /* the device takes buffer sizes in 128 byte units */
+	  rxq->databuffer_size = bp->data_size & ~127;
 	  rxq->dma_ring_addr = avf_dma_addr (vm, ad, (void *) q->descs);
 	  avf_reg_write (ad, AVF_QRX_TAIL (i), q->size - 1);
 	}
@@ -1042,7 +1050,8 @@ avf_device_init (vlib_main_t * vm, avf_main_t * am, avf_device_t * ad,
    * Init Queues
    */
   for (i = 0; i < ad->n_rx_queues; i++)
-    if ((error = avf_rxq_init (vm, ad, i, args->rxq_size)))
+    if ((error = avf_rxq_init (vm, ad, i, args->rxq_size,
+			       args->rx_buffer_size)))
       return error;
 
   for (i = 0; i < ad->n_tx_queues; i++)
@@ -1736,6 +1745,7 @@ avf_create_if (vlib_main_t * vm, avf_create_if_args_t * args)
 
   vnet_hw_interface_t *hw = vnet_get_hw_interface (vnm, ad->hw_if_index);
   hw->caps |= VNET_HW_INTERFACE_CAP_SUPPORTS_INT_MODE;
+  hw->numa_node = ad->numa_node;
   vnet_hw_if_set_input_node (vnm, ad->hw_if_index, avf_input_node.index);
 
   for (i = 0; i < ad->n_rx_queues; i++)
@@ -29,6 +29,7 @@ cnat_timestamp_new (f64 t)
   ts->last_seen = t;
   ts->lifetime = cnat_main.session_max_age;
   ts->refcnt = CNAT_TIMESTAMP_INIT_REFCNT;
+  ts->timer_time[0] = ts->timer_time[1] = 0;
   index = ts - cnat_timestamps;
   clib_rwlock_writer_unlock (&cnat_main.ts_lock);
   return index;
@@ -253,17 +253,17 @@ cnat_ip4_translate_l3 (ip4_header_t * ip4, ip4_address_t new_addr[VLIB_N_DIR])
 }
 
 static_always_inline void
-cnat_tcp_update_session_lifetime (tcp_header_t * tcp, u32 index)
+cnat_tcp_update_session_lifetime (tcp_header_t *tcp,
+				  const cnat_session_t *session)
 {
   cnat_main_t *cm = &cnat_main;
-  if (PREDICT_FALSE (tcp_fin (tcp)))
-    {
-      cnat_timestamp_set_lifetime (index, CNAT_DEFAULT_TCP_RST_TIMEOUT);
-    }
+  u32 index = session->value.cs_ts_index;
 
-  if (PREDICT_FALSE (tcp_rst (tcp)))
+  if (PREDICT_FALSE (tcp_fin (tcp) || tcp_rst (tcp)))
     {
       cnat_timestamp_set_lifetime (index, CNAT_DEFAULT_TCP_RST_TIMEOUT);
+      /* bring the session's check in, if it is set further out */
+      cnat_session_timer_add (session, cnat_timestamp_exp (index));
     }
 
   if (PREDICT_FALSE (tcp_syn (tcp) && tcp_ack (tcp)))
@@ -398,7 +398,7 @@ cnat_translation_ip4 (const cnat_session_t * session,
       cnat_ip4_translate_l4 (ip4, udp, &sum, new_addr, new_port);
       tcp->checksum = ip_csum_fold (sum);
       cnat_ip4_translate_l3 (ip4, new_addr);
-      cnat_tcp_update_session_lifetime (tcp, session->value.cs_ts_index);
+      cnat_tcp_update_session_lifetime (tcp, session);
     }
   else if (ip4->protocol == IP_PROTOCOL_UDP)
     {
@@ -655,7 +655,7 @@ cnat_translation_ip6 (const cnat_session_t * session,
       cnat_ip6_translate_l4 (ip6, udp, &sum, new_addr, new_port);
       tcp->checksum = ip_csum_fold (sum);
       cnat_ip6_translate_l3 (ip6, new_addr);
-      cnat_tcp_update_session_lifetime (tcp, session->value.cs_ts_index);
+      cnat_tcp_update_session_lifetime (tcp, session);
     }
   else if (ip6->protocol == IP_PROTOCOL_UDP)
     {
@@ -851,6 +851,7 @@ cnat_session_create (cnat_session_t *session, cnat_node_ctx_t *ctx,
 
   session->value.cs_ts_index = cnat_timestamp_new (ctx->now);
   cnat_bihash_add_del (&cnat_session_db, bkey, 1);
+  cnat_session_timer_add (session, ctx->now + cnat_main.session_max_age);
 
   if (!(rsession_flags & CNAT_SESSION_FLAG_NO_CLIENT))
     {
@@ -927,6 +928,7 @@ cnat_session_create (cnat_session_t *session, cnat_node_ctx_t *ctx,
   rsession->value.cs_port[VLIB_RX] = session->key.cs_port[VLIB_TX];
 
   cnat_bihash_add_del (&cnat_session_db, &rkey, 1);
+  cnat_session_timer_add (rsession, ctx->now + cnat_main.session_max_age);
 }
 
 always_inline uword
@@ -16,14 +16,35 @@
 #include <cnat/cnat_session.h>
 #include <cnat/cnat_client.h>
 
+#define foreach_cnat_scanner_error                                            \
+  _ (VISITED, "session timers visited")                                       \
+  _ (EXPIRED, "sessions expired")                                             \
+  _ (RESCHEDULED, "session timers rescheduled")                               \
+  _ (STALE, "stale session timers")
+
+typedef enum
+{
+#define _(sym, str) CNAT_SCANNER_ERROR_##sym,
+  foreach_cnat_scanner_error
+#undef _
+    CNAT_SCANNER_N_ERROR,
+} cnat_scanner_error_t;
+
+static char *cnat_scanner_error_strings[] = {
+#define _(sym, string) string,
+  foreach_cnat_scanner_error
+#undef _
+};
+
 static uword
 cnat_scanner_process (vlib_main_t * vm,
 		      vlib_node_runtime_t * rt, vlib_frame_t * f)
 {
   uword event_type, *event_data = 0;
   cnat_main_t *cm = &cnat_main;
+  cnat_session_expire_stats_t stats;
   f64 start_time;
-  int enabled = 0, i = 0;
+  int enabled = 0;
 
   while (1)
     {
@@ -53,7 +74,24 @@ cnat_scanner_process (vlib_main_t * vm,
 	}
 
       cnat_client_throttle_pool_process ();
-      i = cnat_session_scan (vm, start_time, i);
+
+      if (!enabled)
+	continue;
+
+      clib_memset (&stats, 0, sizeof (stats));
+      cnat_session_expire (vm, start_time, &stats);
+
+      vlib_node_increment_counter (vm, rt->node_index,
+				   CNAT_SCANNER_ERROR_VISITED,
+				   stats.n_visited);
+      vlib_node_increment_counter (vm, rt->node_index,
+				   CNAT_SCANNER_ERROR_EXPIRED,
+				   stats.n_expired);
+      vlib_node_increment_counter (vm, rt->node_index,
+				   CNAT_SCANNER_ERROR_RESCHEDULED,
+				   stats.n_rescheduled);
+      vlib_node_increment_counter (vm, rt->node_index,
+				   CNAT_SCANNER_ERROR_STALE, stats.n_stale);
     }
   return 0;
 }
@@ -62,6 +100,8 @@ VLIB_REGISTER_NODE (cnat_scanner_process_node) = {
   .function = cnat_scanner_process,
   .type = VLIB_NODE_TYPE_PROCESS,
   .name = "cnat-scanner-process",
+  .n_errors = CNAT_SCANNER_N_ERROR,
+  .error_strings = cnat_scanner_error_strings,
 };
 
 static clib_error_t *
@@ -21,6 +21,7 @@
 #include <vppinfra/bihash_template.c>
 
 cnat_bihash_t cnat_session_db;
+cnat_session_wheel_t *cnat_session_wheels;
 void (*cnat_free_port_cb) (u16 port, ip_protocol_t iproto);
 
 typedef struct cnat_session_walk_ctx_t_
@@ -172,82 +173,114 @@ cnat_session_purge (void)
   return (0);
 }
 
-u64
-cnat_session_scan (vlib_main_t * vm, f64 start_time, int i)
+static void
+cnat_session_timer_expire (cnat_session_timer_t *t, f64 now,
+			   cnat_session_expire_stats_t *stats)
 {
-  BVT (clib_bihash) * h = &cnat_session_db;
-  int j, k;
+  cnat_bihash_kv_t bkey, bvalue;
+  cnat_session_t *session;
+  f64 expiry;
 
-  /* Don't scan the l2 fib if it hasn't been instantiated yet */
-  if (alloc_arena (h) == 0)
-    return 0.0;
+  clib_memcpy_fast (bkey.key, t->key, sizeof (bkey.key));
+  if (cnat_bihash_search_i2 (&cnat_session_db, &bkey, &bvalue))
+    {
+      /* session was already freed */
+      stats->n_stale++;
+      return;
+    }
 
-  for ( /* caller saves starting point */ ; i < h->nbuckets; i++)
+  session = (cnat_session_t *) &bvalue;
+  if (!cnat_session_timer_is_live (session, t))
     {
-      /* allow no more than 100us without a pause */
-      if ((vlib_time_now (vm) - start_time) > 10e-5)
-	return (i);
+      /* superseded by a sooner timer */
+      stats->n_stale++;
+      return;
+    }
+
+  expiry = cnat_timestamp_exp (session->value.cs_ts_index);
+
+  if (now > expiry)
+    {
+      cnat_session_free (session);
+      stats->n_expired++;
+    }
+  else
+    {
+      /* refreshed since the timer was set */
+      cnat_session_timer_add_i (session, expiry, 1 /* is_resched */);
+      stats->n_rescheduled++;
+    }
+}
+
+void
+cnat_session_expire (vlib_main_t *vm, f64 now,
+		     cnat_session_expire_stats_t *stats)
+{
+  static cnat_session_timer_t *timers;
+  cnat_session_timer_t *t, *due;
+  cnat_session_wheel_t *w;
+  u32 now_time = now, n_slots, slot;
+  f64 start_time = vlib_time_now (vm);
 
-      if (i < (h->nbuckets - 3))
+  vec_foreach (w, cnat_session_wheels)
+    {
+      /* a full revolution visits every timer once */
+      for (n_slots = 0; n_slots < CNAT_SESSION_WHEEL_N_SLOTS; n_slots++)
 	{
-	  BVT (clib_bihash_bucket) * b =
-	    BV (clib_bihash_get_bucket) (h, i + 3);
-	  clib_prefetch_load (b);
-	  b = BV (clib_bihash_get_bucket) (h, i + 1);
-	  if (!BV (clib_bihash_bucket_is_empty) (b))
+	  clib_spinlock_lock (&w->lock);
+	  if (w->next_time >= now_time)
 	    {
-	      BVT (clib_bihash_value) * v =
-		BV (clib_bihash_get_value) (h, b->offset);
-	      clib_prefetch_load (v);
+	      clib_spinlock_unlock (&w->lock);
+	      break;
 	    }
-	}
+	  slot = w->next_time % CNAT_SESSION_WHEEL_N_SLOTS;
+	  due = w->slots[slot];
+	  w->slots[slot] = timers;
+	  w->next_time++;
+	  clib_spinlock_unlock (&w->lock);
 
-      BVT (clib_bihash_bucket) * b = BV (clib_bihash_get_bucket) (h, i);
-      if (BV (clib_bihash_bucket_is_empty) (b))
-	continue;
-      BVT (clib_bihash_value) * v = BV (clib_bihash_get_value) (h, b->offset);
-      for (j = 0; j < (1 << b->log2_pages); j++)
-	{
-	  for (k = 0; k < BIHASH_KVP_PER_PAGE; k++)
+	  vec_foreach (t, due)
 	    {
-	      if (v->kvp[k].key[0] == ~0ULL && v->kvp[k].value[0] == ~0ULL)
-		continue;
-
-	      cnat_session_t *session = (cnat_session_t *) & v->kvp[k];
-
-	      if (start_time >
-		  cnat_timestamp_exp (session->value.cs_ts_index))
+	      /* allow no more than 100us without a pause */
+	      if ((vlib_time_now (vm) - start_time) > 10e-5)
 		{
-		  /* age it */
-		  cnat_session_free (session);
-
-		  /*
-		   * Note: we may have just freed the bucket's backing
-		   * storage, so check right here...
-		   */
-		  if (BV (clib_bihash_bucket_is_empty) (b))
-		    goto doublebreak;
+		  vlib_process_suspend (vm, 10e-5);
+		  start_time = vlib_time_now (vm);
 		}
+	      cnat_session_timer_expire (t, now, stats);
 	    }
-	  v++;
+	  stats->n_visited += vec_len (due);
+
+	  vec_reset_length (due);
+	  timers = due;
 	}
-    doublebreak:
-      ;
-    }
 
-  /* start again */
-  return (0);
+      clib_spinlock_lock (&w->lock);
+      w->next_time = clib_max (w->next_time, now_time);
+      clib_spinlock_unlock (&w->lock);
+    }
 }
 
 static clib_error_t *
 cnat_session_init (vlib_main_t * vm)
 {
   cnat_main_t *cm = &cnat_main;
+  cnat_session_wheel_t *w;
+
   BV (clib_bihash_init) (&cnat_session_db,
 			 "CNat Session DB", cm->session_hash_buckets,
 			 cm->session_hash_memory);
   BV (clib_bihash_set_kvp_format_fn) (&cnat_session_db, format_cnat_session);
 
+  vec_validate_aligned (cnat_session_wheels, vlib_num_workers (),
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (w, cnat_session_wheels)
+    {
+      clib_spinlock_init (&w->lock);
+      vec_validate (w->slots, CNAT_SESSION_WHEEL_N_SLOTS - 1);
+      w->next_time = vlib_time_now (vm);
+    }
+
   return (NULL);
 }
 
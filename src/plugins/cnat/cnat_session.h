@@ -19,6 +19,7 @@
 #include <vnet/udp/udp_packet.h>
 
 #include <cnat/cnat_types.h>
+#include <cnat/cnat_inline.h>
 #include <cnat/cnat_client.h>
 #include <cnat/cnat_bihash.h>
 
@@ -157,6 +158,126 @@ STATIC_ASSERT (sizeof (cnat_session_t) == sizeof (cnat_bihash_kv_t),
  */
 extern cnat_bihash_t cnat_session_db;
 
+/**
+ * Number of one second slots in a session expiry wheel. Sessions that
+ * expire further in the future are parked in the furthest slot and
+ * rescheduled when it is visited.
+ */
+#define CNAT_SESSION_WHEEL_N_SLOTS 1024
+
+/**
+ * A session expiry timer, i.e. the key of the session to check and the
+ * wheel time it was scheduled at
+ */
+typedef struct cnat_session_timer_t_
+{
+  u64 key[5];
+  u32 time;
+} cnat_session_timer_t;
+
+STATIC_ASSERT (sizeof (((cnat_session_timer_t *) 0)->key) ==
+		 sizeof (((cnat_bihash_kv_t *) 0)->key),
+	       "session timer key");
+
+/**
+ * Per-thread expiry wheel. Timers are added lazily: refreshing a session
+ * only bumps its timestamp, and the scanner reschedules the timers it
+ * finds not yet expired. Each scan only visits the slots which are due.
+ * A session has at most one live timer, whose time is recorded in the
+ * session's timestamp; timers superseded by a sooner one are dropped
+ * when visited.
+ */
+typedef struct cnat_session_wheel_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* Taken by the owning worker to add and by the scanner to drain */
+  clib_spinlock_t lock;
+
+  /* Time in seconds the next slot to be drained expires at */
+  u32 next_time;
+
+  /* One vector of timers per slot */
+  cnat_session_timer_t **slots;
+} cnat_session_wheel_t;
+
+extern cnat_session_wheel_t *cnat_session_wheels;
+
+static_always_inline void
+cnat_session_timer_add_i (const cnat_session_t *session, f64 expiry,
+			  int is_resched)
+{
+  cnat_session_wheel_t *w;
+  cnat_session_timer_t *t;
+  cnat_timestamp_t *ts;
+  u32 time = (u32) expiry + 1;
+  u32 *scheduled;
+
+  w = vec_elt_at_index (cnat_session_wheels, vlib_get_thread_index ());
+  clib_rwlock_reader_lock (&cnat_main.ts_lock);
+  ts = pool_elt_at_index (cnat_timestamps, session->value.cs_ts_index);
+  scheduled =
+    &ts->timer_time[!!(session->value.flags & CNAT_SESSION_IS_RETURN)];
+
+  clib_spinlock_lock (&w->lock);
+  time = clib_max (time, w->next_time);
+  time = clib_min (time, w->next_time + CNAT_SESSION_WHEEL_N_SLOTS - 1);
+
+  /* the pending check is due sooner and will reschedule if need be */
+  if (!is_resched && *scheduled && *scheduled <= time)
+    goto done;
+
+  vec_add2 (w->slots[time % CNAT_SESSION_WHEEL_N_SLOTS], t, 1);
+  clib_memcpy_fast (t->key, &session->key, sizeof (t->key));
+  t->time = time;
+  *scheduled = time;
+
+done:
+  clib_spinlock_unlock (&w->lock);
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
+}
+
+/**
+ * Schedule a check of the session at expiry time (in seconds), unless
+ * one is already scheduled sooner. A later check is superseded.
+ */
+static_always_inline void
+cnat_session_timer_add (const cnat_session_t *session, f64 expiry)
+{
+  cnat_session_timer_add_i (session, expiry, 0 /* is_resched */);
+}
+
+/**
+ * Is the timer the live one of the session
+ */
+static_always_inline int
+cnat_session_timer_is_live (const cnat_session_t *session,
+			    const cnat_session_timer_t *t)
+{
+  cnat_timestamp_t *ts;
+  int is_live;
+
+  clib_rwlock_reader_lock (&cnat_main.ts_lock);
+  ts = pool_elt_at_index (cnat_timestamps, session->value.cs_ts_index);
+  is_live =
+    (t->time ==
+     ts->timer_time[!!(session->value.flags & CNAT_SESSION_IS_RETURN)]);
+  clib_rwlock_reader_unlock (&cnat_main.ts_lock);
+
+  return (is_live);
+}
+
+/**
+ * What a session expiry run did
+ */
+typedef struct cnat_session_expire_stats_t_
+{
+  u32 n_visited;
+  u32 n_expired;
+  u32 n_rescheduled;
+  u32 n_stale;
+} cnat_session_expire_stats_t;
+
 /**
  * Callback function invoked during a walk of all translations
  */
@@ -169,9 +290,10 @@ typedef walk_rc_t (*cnat_session_walk_cb_t) (const cnat_session_t *
 extern void cnat_session_walk (cnat_session_walk_cb_t cb, void *ctx);
 
 /**
- * Scan the session DB for expired sessions
+ * Free the sessions whose timers are due
  */
-extern u64 cnat_session_scan (vlib_main_t * vm, f64 start_time, int i);
+extern void cnat_session_expire (vlib_main_t *vm, f64 now,
+				 cnat_session_expire_stats_t *stats);
 
 /**
  * Purge all the sessions
@@ -150,6 +150,8 @@ typedef struct cnat_timestamp_t_
   u16 lifetime;
   /* Users refcount, initially 3 (session, rsession, dpo) */
   u16 refcnt;
+  /* Wheel time the session / rsession check is scheduled at, 0 if none */
+  u32 timer_time[2];
 } cnat_timestamp_t;
 
 typedef struct cnat_node_ctx_
@@ -92,8 +92,7 @@ dpdk_buffer_pool_init (vlib_main_t * vm, vlib_buffer_pool_t * bp)
 
   /* Call the mempool priv initializer */
   memset (&priv, 0, sizeof (priv));
-  priv.mbuf_data_room_size = VLIB_BUFFER_PRE_DATA_SIZE +
-    vlib_buffer_get_default_data_size (vm);
+  priv.mbuf_data_room_size = VLIB_BUFFER_PRE_DATA_SIZE + bp->data_size;
   priv.mbuf_priv_size = VLIB_BUFFER_HDR_SIZE;
   rte_pktmbuf_pool_init (mp, &priv);
   rte_pktmbuf_pool_init (nmp, &priv);
@@ -420,7 +419,7 @@ dpdk_ops_vpp_get_count (const struct rte_mempool *mp)
       vlib_buffer_pool_t *pool = vlib_get_buffer_pool (vm, mp->pool_id);
       if (pool)
 	{
-	  return pool->n_avail;
+	  return vlib_buffer_pool_n_avail (pool);
 	}
     }
   return 0;
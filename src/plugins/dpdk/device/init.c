@@ -771,6 +771,10 @@ dpdk_lib_init (dpdk_main_t * dm)
       vnet_hw_if_set_input_node (dm->vnet_main, xd->hw_if_index,
 				 dpdk_input_node.index);
 
+      /* set before the RX queues are placed */
+      hi = vnet_get_hw_interface (dm->vnet_main, xd->hw_if_index);
+      hi->numa_node = xd->cpu_socket;
+
       if (devconf->workers)
 	{
 	  int i;
@@ -801,7 +805,6 @@ dpdk_lib_init (dpdk_main_t * dm)
 	{
 	  hi->max_packet_bytes = mtu;
 	  hi->max_supported_packet_bytes = max_rx_frame;
-	  hi->numa_node = xd->cpu_socket;
 
 	  /* Indicate ability to support L3 DMAC filtering and
 	   * initialize interface to L3 non-promisc mode */
@@ -66,726 +66,261 @@ validate_geneve_fib (vlib_buffer_t * b, geneve_tunnel_t * t, u32 is_ip4)
   return (fib_index == t->encap_fib_index);
 }
 
-always_inline uword
-geneve_input (vlib_main_t * vm,
-	      vlib_node_runtime_t * node,
-	      vlib_frame_t * from_frame, u32 is_ip4)
+static_always_inline void
+geneve4_key (vlib_buffer_t * b0, geneve4_tunnel_key_t * key4)
 {
-  u32 n_left_from, next_index, *from, *to_next;
-  geneve_main_t *vxm = &geneve_main;
-  vnet_main_t *vnm = vxm->vnet_main;
-  vnet_interface_main_t *im = &vnm->interface_main;
-  u32 last_tunnel_index = ~0;
-  geneve4_tunnel_key_t last_key4;
-  geneve6_tunnel_key_t last_key6;
-  u32 pkts_decapsulated = 0;
-  u32 thread_index = vm->thread_index;
-  u32 stats_sw_if_index, stats_n_packets, stats_n_bytes;
-  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
-
-  if (is_ip4)
-    last_key4.as_u64 = ~0;
-  else
-    clib_memset (&last_key6, 0xff, sizeof (last_key6));
-
-  from = vlib_frame_vector_args (from_frame);
-  n_left_from = from_frame->n_vectors;
-  vlib_get_buffers (vm, from, bufs, n_left_from);
-
-  next_index = node->cached_next_index;
-  stats_sw_if_index = node->runtime_data[0];
-  stats_n_packets = stats_n_bytes = 0;
-
-  while (n_left_from > 0)
-    {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-      while (n_left_from >= 4 && n_left_to_next >= 2)
-	{
-	  u32 bi0, bi1;
-	  vlib_buffer_t *b0, *b1;
-	  u32 next0, next1;
-	  ip4_header_t *ip4_0, *ip4_1;
-	  ip6_header_t *ip6_0, *ip6_1;
-	  geneve_header_t *geneve0, *geneve1;
-	  uword *p0, *p1;
-	  u32 tunnel_index0, tunnel_index1;
-	  geneve_tunnel_t *t0, *t1, *mt0 = NULL, *mt1 = NULL;
-	  geneve4_tunnel_key_t key4_0, key4_1;
-	  geneve6_tunnel_key_t key6_0, key6_1;
-	  u32 error0, error1;
-	  u32 sw_if_index0, sw_if_index1, len0, len1;
-
-	  /* Prefetch next iteration. */
-	  {
-	    vlib_prefetch_buffer_header (b[2], LOAD);
-	    vlib_prefetch_buffer_header (b[3], LOAD);
-
-	    CLIB_PREFETCH (b[2]->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
-	    CLIB_PREFETCH (b[3]->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
-	  }
-
-	  bi0 = from[0];
-	  bi1 = from[1];
-	  to_next[0] = bi0;
-	  to_next[1] = bi1;
-	  from += 2;
-	  to_next += 2;
-	  n_left_to_next -= 2;
-	  n_left_from -= 2;
+  /* udp leaves current_data pointing at the geneve header */
+  geneve_header_t *geneve0 = vlib_buffer_get_current (b0);
+  ip4_header_t *ip4_0 = (void *) geneve0 - sizeof (udp_header_t) -
+    sizeof (ip4_header_t);
 
-	  b0 = b[0];
-	  b1 = b[1];
-	  b += 2;
+  udp_tunnel4_key_init (key4, 0, ip4_0->src_address.as_u32, 0, 0,
+			vnet_get_geneve_vni_network_order (geneve0));
+}
 
-	  /* udp leaves current_data pointing at the geneve header */
-	  geneve0 = vlib_buffer_get_current (b0);
-	  geneve1 = vlib_buffer_get_current (b1);
+static_always_inline void
+geneve6_key (vlib_buffer_t * b0, geneve6_tunnel_key_t * key6)
+{
+  geneve_header_t *geneve0 = vlib_buffer_get_current (b0);
+  ip6_header_t *ip6_0 = (void *) geneve0 - sizeof (udp_header_t) -
+    sizeof (ip6_header_t);
 
-	  vnet_geneve_hdr_1word_ntoh (geneve0);
-	  vnet_geneve_hdr_1word_ntoh (geneve1);
+  udp_tunnel6_key_init (key6, &ip6_0->src_address, 0, 0,
+			vnet_get_geneve_vni_network_order (geneve0));
+}
 
-	  if (is_ip4)
-	    {
-	      vlib_buffer_advance
-		(b0, -(word) (sizeof (udp_header_t) + sizeof (ip4_header_t)));
-	      vlib_buffer_advance
-		(b1, -(word) (sizeof (udp_header_t) + sizeof (ip4_header_t)));
-	      ip4_0 = vlib_buffer_get_current (b0);
-	      ip4_1 = vlib_buffer_get_current (b1);
-	    }
-	  else
-	    {
-	      vlib_buffer_advance
-		(b0, -(word) (sizeof (udp_header_t) + sizeof (ip6_header_t)));
-	      vlib_buffer_advance
-		(b1, -(word) (sizeof (udp_header_t) + sizeof (ip6_header_t)));
-	      ip6_0 = vlib_buffer_get_current (b0);
-	      ip6_1 = vlib_buffer_get_current (b1);
-	    }
+typedef struct
+{
+  vlib_combined_counter_main_t *rx_counter;
+  u32 thread_index;
+  u32 pkts_decapsulated;
+  u32 stats_sw_if_index;
+  u32 stats_n_packets;
+  u32 stats_n_bytes;
+} geneve_decap_ctx_t;
+
+static_always_inline u16
+geneve_decap_one (vlib_main_t * vm, vlib_node_runtime_t * node,
+		  vlib_buffer_t * b0, void *key, void *arg, u8 is_ip4)
+{
+  geneve_main_t *vxm = &geneve_main;
+  geneve_decap_ctx_t *ctx = arg;
+  geneve4_tunnel_key_t *key4_0 = key;
+  geneve6_tunnel_key_t *key6_0 = key;
+  ip4_header_t *ip4_0;
+  ip6_header_t *ip6_0;
+  geneve_tunnel_t *t0, *mt0 = NULL;
+  u32 next0, tunnel_index0, error0, sw_if_index0, len0;
+
+  /* udp leaves current_data pointing at the geneve header */
+  geneve_header_t *geneve0 = vlib_buffer_get_current (b0);
+  vnet_geneve_hdr_1word_ntoh (geneve0);
 
-	  /* pop (ip, udp, geneve) */
-	  if (is_ip4)
-	    {
-	      vlib_buffer_advance (b0,
-				   sizeof (*ip4_0) + sizeof (udp_header_t) +
-				   GENEVE_BASE_HEADER_LENGTH +
-				   vnet_get_geneve_options_len (geneve0));
-	      vlib_buffer_advance (b1,
-				   sizeof (*ip4_1) + sizeof (udp_header_t) +
-				   GENEVE_BASE_HEADER_LENGTH +
-				   vnet_get_geneve_options_len (geneve1));
-	    }
-	  else
-	    {
-	      vlib_buffer_advance (b0,
-				   sizeof (*ip6_0) + sizeof (udp_header_t) +
-				   GENEVE_BASE_HEADER_LENGTH +
-				   vnet_get_geneve_options_len (geneve0));
-	      vlib_buffer_advance (b1,
-				   sizeof (*ip6_1) + sizeof (udp_header_t) +
-				   GENEVE_BASE_HEADER_LENGTH +
-				   vnet_get_geneve_options_len (geneve1));
-	    }
+  if (is_ip4)
+    ip4_0 = (void *) geneve0 - sizeof (udp_header_t) - sizeof (ip4_header_t);
+  else
+    ip6_0 = (void *) geneve0 - sizeof (udp_header_t) - sizeof (ip6_header_t);
 
-	  tunnel_index0 = ~0;
-	  error0 = 0;
+  /* pop (ip, udp, geneve) */
+  vlib_buffer_advance (b0, GENEVE_BASE_HEADER_LENGTH +
+		       vnet_get_geneve_options_len (geneve0));
 
-	  tunnel_index1 = ~0;
-	  error1 = 0;
+  tunnel_index0 = ~0;
+  error0 = 0;
 
-	  if (PREDICT_FALSE
-	      (vnet_get_geneve_version (geneve0) != GENEVE_VERSION))
-	    {
-	      error0 = GENEVE_ERROR_BAD_FLAGS;
-	      next0 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace0;
-	    }
+  if (PREDICT_FALSE (vnet_get_geneve_version (geneve0) != GENEVE_VERSION))
+    {
+      error0 = GENEVE_ERROR_BAD_FLAGS;
+      next0 = GENEVE_INPUT_NEXT_DROP;
+      goto trace00;
+    }
 #if SUPPORT_OPTIONS_HEADER==1
-	  if (PREDICT_FALSE (vnet_get_geneve_critical_bit (geneve0) == 1))
-	    {
-	      error0 = GENEVE_ERROR_BAD_FLAGS;
-	      next0 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace0;
-	    }
+  if (PREDICT_FALSE (vnet_get_geneve_critical_bit (geneve0) == 1))
+    {
+      error0 = GENEVE_ERROR_BAD_FLAGS;
+      next0 = GENEVE_INPUT_NEXT_DROP;
+      goto trace00;
+    }
 #endif
-	  if (is_ip4)
-	    {
-	      key4_0.remote = ip4_0->src_address.as_u32;
-	      key4_0.vni = vnet_get_geneve_vni_network_order (geneve0);
-
-	      /* Make sure GENEVE tunnel exist according to packet SIP and VNI */
-	      if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
-		{
-		  p0 = hash_get (vxm->geneve4_tunnel_by_key, key4_0.as_u64);
-		  if (PREDICT_FALSE (p0 == NULL))
-		    {
-		      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next0 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace0;
-		    }
-		  last_key4.as_u64 = key4_0.as_u64;
-		  tunnel_index0 = last_tunnel_index = p0[0];
-		}
-	      else
-		tunnel_index0 = last_tunnel_index;
-	      t0 = pool_elt_at_index (vxm->tunnels, tunnel_index0);
-
-	      /* Validate GENEVE tunnel encap-fib index against packet */
-	      if (PREDICT_FALSE (validate_geneve_fib (b0, t0, is_ip4) == 0))
-		{
-		  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		  next0 = GENEVE_INPUT_NEXT_DROP;
-		  goto trace0;
-		}
-
-	      /* Validate GENEVE tunnel SIP against packet DIP */
-	      if (PREDICT_TRUE
-		  (ip4_0->dst_address.as_u32 == t0->local.ip4.as_u32))
-		goto next0;	/* valid packet */
-	      if (PREDICT_FALSE
-		  (ip4_address_is_multicast (&ip4_0->dst_address)))
-		{
-		  key4_0.remote = ip4_0->dst_address.as_u32;
-		  key4_0.vni = vnet_get_geneve_vni_network_order (geneve0);
-		  /* Make sure mcast GENEVE tunnel exist by packet DIP and VNI */
-		  p0 = hash_get (vxm->geneve4_tunnel_by_key, key4_0.as_u64);
-		  if (PREDICT_TRUE (p0 != NULL))
-		    {
-		      mt0 = pool_elt_at_index (vxm->tunnels, p0[0]);
-		      goto next0;	/* valid packet */
-		    }
-		}
-	      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-	      next0 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace0;
-
-	    }
-	  else			/* !is_ip4 */
+  if (is_ip4)
+    {
+      /* Make sure GENEVE tunnel exist according to packet SIP and VNI,
+       * unless a flow offloaded to the rx interface found it */
+      tunnel_index0 = geneve_flow_tunnel_index (vxm, b0);
+      if (PREDICT_TRUE (tunnel_index0 == ~0))
+	{
+	  if (PREDICT_FALSE (key4_0->value == UDP_TUNNEL_KEY_NOT_FOUND))
 	    {
-	      key6_0.remote.as_u64[0] = ip6_0->src_address.as_u64[0];
-	      key6_0.remote.as_u64[1] = ip6_0->src_address.as_u64[1];
-	      key6_0.vni = vnet_get_geneve_vni_network_order (geneve0);
-
-	      /* Make sure GENEVE tunnel exist according to packet SIP and VNI */
-	      if (PREDICT_FALSE
-		  (memcmp (&key6_0, &last_key6, sizeof (last_key6)) != 0))
-		{
-		  p0 = hash_get_mem (vxm->geneve6_tunnel_by_key, &key6_0);
-		  if (PREDICT_FALSE (p0 == NULL))
-		    {
-		      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next0 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace0;
-		    }
-		  clib_memcpy_fast (&last_key6, &key6_0, sizeof (key6_0));
-		  tunnel_index0 = last_tunnel_index = p0[0];
-		}
-	      else
-		tunnel_index0 = last_tunnel_index;
-	      t0 = pool_elt_at_index (vxm->tunnels, tunnel_index0);
-
-	      /* Validate GENEVE tunnel encap-fib index against packet */
-	      if (PREDICT_FALSE (validate_geneve_fib (b0, t0, is_ip4) == 0))
-		{
-		  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		  next0 = GENEVE_INPUT_NEXT_DROP;
-		  goto trace0;
-		}
-
-	      /* Validate GENEVE tunnel SIP against packet DIP */
-	      if (PREDICT_TRUE (ip6_address_is_equal (&ip6_0->dst_address,
-						      &t0->local.ip6)))
-		goto next0;	/* valid packet */
-	      if (PREDICT_FALSE
-		  (ip6_address_is_multicast (&ip6_0->dst_address)))
-		{
-		  key6_0.remote.as_u64[0] = ip6_0->dst_address.as_u64[0];
-		  key6_0.remote.as_u64[1] = ip6_0->dst_address.as_u64[1];
-		  key6_0.vni = vnet_get_geneve_vni_network_order (geneve0);
-		  p0 = hash_get_mem (vxm->geneve6_tunnel_by_key, &key6_0);
-		  if (PREDICT_TRUE (p0 != NULL))
-		    {
-		      mt0 = pool_elt_at_index (vxm->tunnels, p0[0]);
-		      goto next0;	/* valid packet */
-		    }
-		}
 	      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
 	      next0 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace0;
-	    }
-
-	next0:
-	  next0 = t0->decap_next_index;
-	  sw_if_index0 = t0->sw_if_index;
-	  len0 = vlib_buffer_length_in_chain (vm, b0);
-
-	  /* Required to make the l2 tag push / pop code work on l2 subifs */
-	  if (PREDICT_TRUE (next0 == GENEVE_INPUT_NEXT_L2_INPUT))
-	    vnet_update_l2_len (b0);
-
-	  /* Set packet input sw_if_index to unicast GENEVE tunnel for learning */
-	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = sw_if_index0;
-	  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
-
-	  pkts_decapsulated++;
-	  stats_n_packets += 1;
-	  stats_n_bytes += len0;
-
-	  /* Batch stats increment on the same geneve tunnel so counter
-	     is not incremented per packet */
-	  if (PREDICT_FALSE (sw_if_index0 != stats_sw_if_index))
-	    {
-	      stats_n_packets -= 1;
-	      stats_n_bytes -= len0;
-	      if (stats_n_packets)
-		vlib_increment_combined_counter
-		  (im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
-		   thread_index, stats_sw_if_index,
-		   stats_n_packets, stats_n_bytes);
-	      stats_n_packets = 1;
-	      stats_n_bytes = len0;
-	      stats_sw_if_index = sw_if_index0;
-	    }
-
-	trace0:
-	  b0->error = error0 ? node->errors[error0] : 0;
-
-	  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
-	    {
-	      geneve_rx_trace_t *tr
-		= vlib_add_trace (vm, node, b0, sizeof (*tr));
-	      tr->next_index = next0;
-	      tr->error = error0;
-	      tr->tunnel_index = tunnel_index0;
-	      tr->vni_rsvd = vnet_get_geneve_vni (geneve0);
-	    }
-
-	  if (PREDICT_FALSE
-	      (vnet_get_geneve_version (geneve1) != GENEVE_VERSION))
-	    {
-	      error1 = GENEVE_ERROR_BAD_FLAGS;
-	      next1 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace1;
-	    }
-#if SUPPORT_OPTIONS_HEADER==1
-	  if (PREDICT_FALSE (vnet_get_geneve_critical_bit (geneve1) == 1))
-	    {
-	      error1 = GENEVE_ERROR_BAD_FLAGS;
-	      next1 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace1;
-	    }
-#endif
-	  if (is_ip4)
-	    {
-	      key4_1.remote = ip4_1->src_address.as_u32;
-	      key4_1.vni = vnet_get_geneve_vni_network_order (geneve1);
-
-	      /* Make sure unicast GENEVE tunnel exist by packet SIP and VNI */
-	      if (PREDICT_FALSE (key4_1.as_u64 != last_key4.as_u64))
-		{
-		  p1 = hash_get (vxm->geneve4_tunnel_by_key, key4_1.as_u64);
-		  if (PREDICT_FALSE (p1 == NULL))
-		    {
-		      error1 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next1 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace1;
-		    }
-		  last_key4.as_u64 = key4_1.as_u64;
-		  tunnel_index1 = last_tunnel_index = p1[0];
-		}
-	      else
-		tunnel_index1 = last_tunnel_index;
-	      t1 = pool_elt_at_index (vxm->tunnels, tunnel_index1);
-
-	      /* Validate GENEVE tunnel encap-fib index against packet */
-	      if (PREDICT_FALSE (validate_geneve_fib (b1, t1, is_ip4) == 0))
-		{
-		  error1 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		  next1 = GENEVE_INPUT_NEXT_DROP;
-		  goto trace1;
-		}
-
-	      /* Validate GENEVE tunnel SIP against packet DIP */
-	      if (PREDICT_TRUE
-		  (ip4_1->dst_address.as_u32 == t1->local.ip4.as_u32))
-		goto next1;	/* valid packet */
-	      if (PREDICT_FALSE
-		  (ip4_address_is_multicast (&ip4_1->dst_address)))
-		{
-		  key4_1.remote = ip4_1->dst_address.as_u32;
-		  key4_1.vni = vnet_get_geneve_vni_network_order (geneve1);
-		  /* Make sure mcast GENEVE tunnel exist by packet DIP and VNI */
-		  p1 = hash_get (vxm->geneve4_tunnel_by_key, key4_1.as_u64);
-		  if (PREDICT_TRUE (p1 != NULL))
-		    {
-		      mt1 = pool_elt_at_index (vxm->tunnels, p1[0]);
-		      goto next1;	/* valid packet */
-		    }
-		}
-	      error1 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-	      next1 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace1;
-
-	    }
-	  else			/* !is_ip4 */
-	    {
-	      key6_1.remote.as_u64[0] = ip6_1->src_address.as_u64[0];
-	      key6_1.remote.as_u64[1] = ip6_1->src_address.as_u64[1];
-	      key6_1.vni = vnet_get_geneve_vni_network_order (geneve1);
-
-	      /* Make sure GENEVE tunnel exist according to packet SIP and VNI */
-	      if (PREDICT_FALSE
-		  (memcmp (&key6_1, &last_key6, sizeof (last_key6)) != 0))
-		{
-		  p1 = hash_get_mem (vxm->geneve6_tunnel_by_key, &key6_1);
-
-		  if (PREDICT_FALSE (p1 == NULL))
-		    {
-		      error1 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next1 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace1;
-		    }
-
-		  clib_memcpy_fast (&last_key6, &key6_1, sizeof (key6_1));
-		  tunnel_index1 = last_tunnel_index = p1[0];
-		}
-	      else
-		tunnel_index1 = last_tunnel_index;
-	      t1 = pool_elt_at_index (vxm->tunnels, tunnel_index1);
-
-	      /* Validate GENEVE tunnel encap-fib index against packet */
-	      if (PREDICT_FALSE (validate_geneve_fib (b1, t1, is_ip4) == 0))
-		{
-		  error1 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		  next1 = GENEVE_INPUT_NEXT_DROP;
-		  goto trace1;
-		}
-
-	      /* Validate GENEVE tunnel SIP against packet DIP */
-	      if (PREDICT_TRUE (ip6_address_is_equal (&ip6_1->dst_address,
-						      &t1->local.ip6)))
-		goto next1;	/* valid packet */
-	      if (PREDICT_FALSE
-		  (ip6_address_is_multicast (&ip6_1->dst_address)))
-		{
-		  key6_1.remote.as_u64[0] = ip6_1->dst_address.as_u64[0];
-		  key6_1.remote.as_u64[1] = ip6_1->dst_address.as_u64[1];
-		  key6_1.vni = vnet_get_geneve_vni_network_order (geneve1);
-		  p1 = hash_get_mem (vxm->geneve6_tunnel_by_key, &key6_1);
-		  if (PREDICT_TRUE (p1 != NULL))
-		    {
-		      mt1 = pool_elt_at_index (vxm->tunnels, p1[0]);
-		      goto next1;	/* valid packet */
-		    }
-		}
-	      error1 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-	      next1 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace1;
-	    }
-
-	next1:
-	  next1 = t1->decap_next_index;
-	  sw_if_index1 = t1->sw_if_index;
-	  len1 = vlib_buffer_length_in_chain (vm, b1);
-
-	  /* Required to make the l2 tag push / pop code work on l2 subifs */
-	  if (PREDICT_TRUE (next1 == GENEVE_INPUT_NEXT_L2_INPUT))
-	    vnet_update_l2_len (b1);
-
-	  /* Set packet input sw_if_index to unicast GENEVE tunnel for learning */
-	  vnet_buffer (b1)->sw_if_index[VLIB_RX] = sw_if_index1;
-	  sw_if_index1 = (mt1) ? mt1->sw_if_index : sw_if_index1;
-
-	  pkts_decapsulated++;
-	  stats_n_packets += 1;
-	  stats_n_bytes += len1;
-
-	  /* Batch stats increment on the same geneve tunnel so counter
-	     is not incremented per packet */
-	  if (PREDICT_FALSE (sw_if_index1 != stats_sw_if_index))
-	    {
-	      stats_n_packets -= 1;
-	      stats_n_bytes -= len1;
-	      if (stats_n_packets)
-		vlib_increment_combined_counter
-		  (im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
-		   thread_index, stats_sw_if_index,
-		   stats_n_packets, stats_n_bytes);
-	      stats_n_packets = 1;
-	      stats_n_bytes = len1;
-	      stats_sw_if_index = sw_if_index1;
-	    }
-
-	trace1:
-	  b1->error = error1 ? node->errors[error1] : 0;
-
-	  if (PREDICT_FALSE (b1->flags & VLIB_BUFFER_IS_TRACED))
-	    {
-	      geneve_rx_trace_t *tr
-		= vlib_add_trace (vm, node, b1, sizeof (*tr));
-	      tr->next_index = next1;
-	      tr->error = error1;
-	      tr->tunnel_index = tunnel_index1;
-	      tr->vni_rsvd = vnet_get_geneve_vni (geneve1);
+	      goto trace00;
 	    }
-
-	  vlib_validate_buffer_enqueue_x2 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, bi1, next0, next1);
+	  tunnel_index0 = key4_0->value;
 	}
+      t0 = pool_elt_at_index (vxm->tunnels, tunnel_index0);
 
-      while (n_left_from > 0 && n_left_to_next > 0)
+      /* Validate GENEVE tunnel encap-fib index agaist packet */
+      if (PREDICT_FALSE (validate_geneve_fib (b0, t0, is_ip4) == 0))
 	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
-	  u32 next0;
-	  ip4_header_t *ip4_0;
-	  ip6_header_t *ip6_0;
-	  geneve_header_t *geneve0;
-	  uword *p0;
-	  u32 tunnel_index0;
-	  geneve_tunnel_t *t0, *mt0 = NULL;
-	  geneve4_tunnel_key_t key4_0;
-	  geneve6_tunnel_key_t key6_0;
-	  u32 error0;
-	  u32 sw_if_index0, len0;
-
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = b[0];
-	  b += 1;
-
-	  /* udp leaves current_data pointing at the geneve header */
-	  geneve0 = vlib_buffer_get_current (b0);
-	  vnet_geneve_hdr_1word_ntoh (geneve0);
-
-	  if (is_ip4)
-	    {
-	      vlib_buffer_advance
-		(b0, -(word) (sizeof (udp_header_t) + sizeof (ip4_header_t)));
-	      ip4_0 = vlib_buffer_get_current (b0);
-	    }
-	  else
-	    {
-	      vlib_buffer_advance
-		(b0, -(word) (sizeof (udp_header_t) + sizeof (ip6_header_t)));
-	      ip6_0 = vlib_buffer_get_current (b0);
-	    }
+	  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
+	  next0 = GENEVE_INPUT_NEXT_DROP;
+	  goto trace00;
+	}
 
-	  /* pop (ip, udp, geneve) */
-	  if (is_ip4)
-	    {
-	      vlib_buffer_advance
-		(b0,
-		 sizeof (*ip4_0) + sizeof (udp_header_t) +
-		 GENEVE_BASE_HEADER_LENGTH +
-		 vnet_get_geneve_options_len (geneve0));
-	    }
-	  else
+      /* Validate GENEVE tunnel SIP against packet DIP */
+      if (PREDICT_TRUE (ip4_0->dst_address.as_u32 == t0->local.ip4.as_u32))
+	goto next00;		/* valid packet */
+      if (PREDICT_FALSE (ip4_address_is_multicast (&ip4_0->dst_address)))
+	{
+	  udp_tunnel4_key_init (key4_0, 0, ip4_0->dst_address.as_u32, 0, 0,
+				vnet_get_geneve_vni_network_order (geneve0));
+	  /* Make sure mcast GENEVE tunnel exist by packet DIP and VNI */
+	  if (PREDICT_TRUE (clib_bihash_search_inline_16_8
+			    (&vxm->geneve4_tunnel_by_key, key4_0) == 0))
 	    {
-	      vlib_buffer_advance
-		(b0,
-		 sizeof (*ip6_0) + sizeof (udp_header_t) +
-		 GENEVE_BASE_HEADER_LENGTH +
-		 vnet_get_geneve_options_len (geneve0));
+	      mt0 = pool_elt_at_index (vxm->tunnels, key4_0->value);
+	      goto next00;	/* valid packet */
 	    }
+	}
+      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
+      next0 = GENEVE_INPUT_NEXT_DROP;
+      goto trace00;
+    }
+  else				/* !is_ip4 */
+    {
+      /* Make sure GENEVE tunnel exist according to packet SIP and VNI */
+      if (PREDICT_FALSE (key6_0->value == UDP_TUNNEL_KEY_NOT_FOUND))
+	{
+	  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
+	  next0 = GENEVE_INPUT_NEXT_DROP;
+	  goto trace00;
+	}
+      tunnel_index0 = key6_0->value;
+      t0 = pool_elt_at_index (vxm->tunnels, tunnel_index0);
 
-	  tunnel_index0 = ~0;
-	  error0 = 0;
+      /* Validate GENEVE tunnel encap-fib index agaist packet */
+      if (PREDICT_FALSE (validate_geneve_fib (b0, t0, is_ip4) == 0))
+	{
+	  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
+	  next0 = GENEVE_INPUT_NEXT_DROP;
+	  goto trace00;
+	}
 
-	  if (PREDICT_FALSE
-	      (vnet_get_geneve_version (geneve0) != GENEVE_VERSION))
-	    {
-	      error0 = GENEVE_ERROR_BAD_FLAGS;
-	      next0 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace00;
-	    }
-#if SUPPORT_OPTIONS_HEADER==1
-	  if (PREDICT_FALSE (vnet_get_geneve_critical_bit (geneve0) == 1))
+      /* Validate GENEVE tunnel SIP against packet DIP */
+      if (PREDICT_TRUE (ip6_address_is_equal (&ip6_0->dst_address,
+					      &t0->local.ip6)))
+	goto next00;		/* valid packet */
+      if (PREDICT_FALSE (ip6_address_is_multicast (&ip6_0->dst_address)))
+	{
+	  udp_tunnel6_key_init (key6_0, &ip6_0->dst_address, 0, 0,
+				vnet_get_geneve_vni_network_order (geneve0));
+	  if (PREDICT_TRUE (clib_bihash_search_inline_24_8
+			    (&vxm->geneve6_tunnel_by_key, key6_0) == 0))
 	    {
-	      error0 = GENEVE_ERROR_BAD_FLAGS;
-	      next0 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace00;
+	      mt0 = pool_elt_at_index (vxm->tunnels, key6_0->value);
+	      goto next00;	/* valid packet */
 	    }
-#endif
-	  if (is_ip4)
-	    {
-	      key4_0.remote = ip4_0->src_address.as_u32;
-	      key4_0.vni = vnet_get_geneve_vni_network_order (geneve0);
-
-	      /* Make sure unicast GENEVE tunnel exist by packet SIP and VNI */
-	      if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
-		{
-		  p0 = hash_get (vxm->geneve4_tunnel_by_key, key4_0.as_u64);
-		  if (PREDICT_FALSE (p0 == NULL))
-		    {
-		      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next0 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace00;
-		    }
-		  last_key4.as_u64 = key4_0.as_u64;
-		  tunnel_index0 = last_tunnel_index = p0[0];
-		}
-	      else
-		tunnel_index0 = last_tunnel_index;
-	      t0 = pool_elt_at_index (vxm->tunnels, tunnel_index0);
-
-	      /* Validate GENEVE tunnel encap-fib index agaist packet */
-	      if (PREDICT_FALSE (validate_geneve_fib (b0, t0, is_ip4) == 0))
-		{
-		  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		  next0 = GENEVE_INPUT_NEXT_DROP;
-		  goto trace00;
-		}
+	}
+      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
+      next0 = GENEVE_INPUT_NEXT_DROP;
+      goto trace00;
+    }
 
-	      /* Validate GENEVE tunnel SIP against packet DIP */
-	      if (PREDICT_TRUE
-		  (ip4_0->dst_address.as_u32 == t0->local.ip4.as_u32))
-		goto next00;	/* valid packet */
-	      if (PREDICT_FALSE
-		  (ip4_address_is_multicast (&ip4_0->dst_address)))
-		{
-		  key4_0.remote = ip4_0->dst_address.as_u32;
-		  key4_0.vni = vnet_get_geneve_vni_network_order (geneve0);
-		  /* Make sure mcast GENEVE tunnel exist by packet DIP and VNI */
-		  p0 = hash_get (vxm->geneve4_tunnel_by_key, key4_0.as_u64);
-		  if (PREDICT_TRUE (p0 != NULL))
-		    {
-		      mt0 = pool_elt_at_index (vxm->tunnels, p0[0]);
-		      goto next00;	/* valid packet */
-		    }
-		}
-	      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-	      next0 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace00;
+next00:
+  next0 = t0->decap_next_index;
+  sw_if_index0 = t0->sw_if_index;
+  len0 = vlib_buffer_length_in_chain (vm, b0);
 
-	    }
-	  else			/* !is_ip4 */
-	    {
-	      key6_0.remote.as_u64[0] = ip6_0->src_address.as_u64[0];
-	      key6_0.remote.as_u64[1] = ip6_0->src_address.as_u64[1];
-	      key6_0.vni = vnet_get_geneve_vni_network_order (geneve0);
+  /* Required to make the l2 tag push / pop code work on l2 subifs */
+  if (PREDICT_TRUE (next0 == GENEVE_INPUT_NEXT_L2_INPUT))
+    vnet_update_l2_len (b0);
 
-	      /* Make sure GENEVE tunnel exist according to packet SIP and VNI */
-	      if (PREDICT_FALSE
-		  (memcmp (&key6_0, &last_key6, sizeof (last_key6)) != 0))
-		{
-		  p0 = hash_get_mem (vxm->geneve6_tunnel_by_key, &key6_0);
-		  if (PREDICT_FALSE (p0 == NULL))
-		    {
-		      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next0 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace00;
-		    }
-		  clib_memcpy_fast (&last_key6, &key6_0, sizeof (key6_0));
-		  tunnel_index0 = last_tunnel_index = p0[0];
-		}
-	      else
-		tunnel_index0 = last_tunnel_index;
-	      t0 = pool_elt_at_index (vxm->tunnels, tunnel_index0);
+  /* Set packet input sw_if_index to unicast GENEVE tunnel for learning */
+  vnet_buffer (b0)->sw_if_index[VLIB_RX] = sw_if_index0;
+  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
 
-	      /* Validate GENEVE tunnel encap-fib index agaist packet */
-	      if (PREDICT_FALSE (validate_geneve_fib (b0, t0, is_ip4) == 0))
-		{
-		  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		  next0 = GENEVE_INPUT_NEXT_DROP;
-		  goto trace00;
-		}
+  ctx->pkts_decapsulated++;
 
-	      /* Validate GENEVE tunnel SIP against packet DIP */
-	      if (PREDICT_TRUE (ip6_address_is_equal (&ip6_0->dst_address,
-						      &t0->local.ip6)))
-		goto next00;	/* valid packet */
-	      if (PREDICT_FALSE
-		  (ip6_address_is_multicast (&ip6_0->dst_address)))
-		{
-		  key6_0.remote.as_u64[0] = ip6_0->dst_address.as_u64[0];
-		  key6_0.remote.as_u64[1] = ip6_0->dst_address.as_u64[1];
-		  key6_0.vni = vnet_get_geneve_vni_network_order (geneve0);
-		  p0 = hash_get_mem (vxm->geneve6_tunnel_by_key, &key6_0);
-		  if (PREDICT_TRUE (p0 != NULL))
-		    {
-		      mt0 = pool_elt_at_index (vxm->tunnels, p0[0]);
-		      goto next00;	/* valid packet */
-		    }
-		}
-	      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-	      next0 = GENEVE_INPUT_NEXT_DROP;
-	      goto trace00;
-	    }
+  /* Batch stats increment on the same geneve tunnel so counter
+     is not incremented per packet */
+  if (PREDICT_FALSE (sw_if_index0 != ctx->stats_sw_if_index))
+    {
+      if (ctx->stats_n_packets)
+	vlib_increment_combined_counter
+	  (ctx->rx_counter, ctx->thread_index, ctx->stats_sw_if_index,
+	   ctx->stats_n_packets, ctx->stats_n_bytes);
+      ctx->stats_n_packets = 0;
+      ctx->stats_n_bytes = 0;
+      ctx->stats_sw_if_index = sw_if_index0;
+    }
+  ctx->stats_n_packets += 1;
+  ctx->stats_n_bytes += len0;
 
-	next00:
-	  next0 = t0->decap_next_index;
-	  sw_if_index0 = t0->sw_if_index;
-	  len0 = vlib_buffer_length_in_chain (vm, b0);
+trace00:
+  b0->error = error0 ? node->errors[error0] : 0;
 
-	  /* Required to make the l2 tag push / pop code work on l2 subifs */
-	  if (PREDICT_TRUE (next0 == GENEVE_INPUT_NEXT_L2_INPUT))
-	    vnet_update_l2_len (b0);
+  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+    {
+      geneve_rx_trace_t *tr = vlib_add_trace (vm, node, b0, sizeof (*tr));
+      tr->next_index = next0;
+      tr->error = error0;
+      tr->tunnel_index = tunnel_index0;
+      tr->vni_rsvd = vnet_get_geneve_vni (geneve0);
+    }
 
-	  /* Set packet input sw_if_index to unicast GENEVE tunnel for learning */
-	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = sw_if_index0;
-	  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
+  return next0;
+}
 
-	  pkts_decapsulated++;
-	  stats_n_packets += 1;
-	  stats_n_bytes += len0;
+static_always_inline u16
+geneve4_decap (vlib_main_t * vm, vlib_node_runtime_t * node,
+	       vlib_buffer_t * b0, void *key, void *ctx)
+{
+  return geneve_decap_one (vm, node, b0, key, ctx, /* is_ip4 */ 1);
+}
 
-	  /* Batch stats increment on the same geneve tunnel so counter
-	     is not incremented per packet */
-	  if (PREDICT_FALSE (sw_if_index0 != stats_sw_if_index))
-	    {
-	      stats_n_packets -= 1;
-	      stats_n_bytes -= len0;
-	      if (stats_n_packets)
-		vlib_increment_combined_counter
-		  (im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
-		   thread_index, stats_sw_if_index,
-		   stats_n_packets, stats_n_bytes);
-	      stats_n_packets = 1;
-	      stats_n_bytes = len0;
-	      stats_sw_if_index = sw_if_index0;
-	    }
+static_always_inline u16
+geneve6_decap (vlib_main_t * vm, vlib_node_runtime_t * node,
+	       vlib_buffer_t * b0, void *key, void *ctx)
+{
+  return geneve_decap_one (vm, node, b0, key, ctx, /* is_ip4 */ 0);
+}
 
-	trace00:
-	  b0->error = error0 ? node->errors[error0] : 0;
+always_inline uword
+geneve_input (vlib_main_t * vm,
+	      vlib_node_runtime_t * node,
+	      vlib_frame_t * from_frame, u32 is_ip4)
+{
+  geneve_main_t *vxm = &geneve_main;
+  vnet_interface_main_t *im = &vxm->vnet_main->interface_main;
+  geneve_decap_ctx_t ctx = {
+    .rx_counter = im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
+    .thread_index = vm->thread_index,
+    .stats_sw_if_index = node->runtime_data[0],
+  };
 
-	  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
-	    {
-	      geneve_rx_trace_t *tr
-		= vlib_add_trace (vm, node, b0, sizeof (*tr));
-	      tr->next_index = next0;
-	      tr->error = error0;
-	      tr->tunnel_index = tunnel_index0;
-	      tr->vni_rsvd = vnet_get_geneve_vni (geneve0);
-	    }
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
-	}
+  if (is_ip4)
+    udp_tunnel_decap_inline (vm, node, from_frame,
+			     &vxm->geneve4_tunnel_by_key, /* is_ip4 */ 1,
+			     geneve4_key, 0, geneve4_decap, &ctx);
+  else
+    udp_tunnel_decap_inline (vm, node, from_frame,
+			     &vxm->geneve6_tunnel_by_key, /* is_ip4 */ 0,
+			     0, geneve6_key, geneve6_decap, &ctx);
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-    }
   /* Do we still need this now that tunnel tx stats is kept? */
   vlib_node_increment_counter (vm, is_ip4 ?
 			       geneve4_input_node.
 			       index : geneve6_input_node.index,
-			       GENEVE_ERROR_DECAPSULATED, pkts_decapsulated);
+			       GENEVE_ERROR_DECAPSULATED,
+			       ctx.pkts_decapsulated);
 
   /* Increment any remaining batch stats */
-  if (stats_n_packets)
+  if (ctx.stats_n_packets)
     {
       vlib_increment_combined_counter
-	(im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
-	 thread_index, stats_sw_if_index, stats_n_packets, stats_n_bytes);
-      node->runtime_data[0] = stats_sw_if_index;
+	(ctx.rx_counter, ctx.thread_index, ctx.stats_sw_if_index,
+	 ctx.stats_n_packets, ctx.stats_n_bytes);
+      node->runtime_data[0] = ctx.stats_sw_if_index;
     }
 
   return from_frame->n_vectors;
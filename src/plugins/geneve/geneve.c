@@ -365,7 +365,7 @@ int vnet_geneve_add_del_tunnel
   geneve_main_t *vxm = &geneve_main;
   geneve_tunnel_t *t = 0;
   vnet_main_t *vnm = vxm->vnet_main;
-  uword *p;
+  u64 *p;
   u32 hw_if_index = ~0;
   u32 sw_if_index = ~0;
   int rv;
@@ -375,15 +375,19 @@ int vnet_geneve_add_del_tunnel
 
   if (!is_ip6)
     {
-      key4.remote = a->remote.ip4.as_u32;
-      key4.vni = clib_host_to_net_u32 (a->vni << GENEVE_VNI_SHIFT);
-      p = hash_get (vxm->geneve4_tunnel_by_key, key4.as_u64);
+      udp_tunnel4_key_init (&key4, 0, a->remote.ip4.as_u32, 0, 0,
+			    clib_host_to_net_u32 (a->vni << GENEVE_VNI_SHIFT));
+      p = &key4.value;
+      if (clib_bihash_search_inline_16_8 (&vxm->geneve4_tunnel_by_key, &key4))
+	p = 0;
     }
   else
     {
-      key6.remote = a->remote.ip6;
-      key6.vni = clib_host_to_net_u32 (a->vni << GENEVE_VNI_SHIFT);
-      p = hash_get_mem (vxm->geneve6_tunnel_by_key, &key6);
+      udp_tunnel6_key_init (&key6, &a->remote.ip6, 0, 0,
+			    clib_host_to_net_u32 (a->vni << GENEVE_VNI_SHIFT));
+      p = &key6.value;
+      if (clib_bihash_search_inline_24_8 (&vxm->geneve6_tunnel_by_key, &key6))
+	p = 0;
     }
 
   if (a->is_add)
@@ -407,6 +411,7 @@ int vnet_geneve_add_del_tunnel
 #define _(x) t->x = a->x;
       foreach_copy_field;
 #undef _
+      t->flow_index = ~0;
 
       rv = geneve_rewrite (t, is_ip6);
       if (rv)
@@ -417,10 +422,17 @@ int vnet_geneve_add_del_tunnel
 
       /* copy the key */
       if (is_ip6)
-	hash_set_mem_alloc (&vxm->geneve6_tunnel_by_key, &key6,
-			    t - vxm->tunnels);
+	{
+	  key6.value = t - vxm->tunnels;
+	  clib_bihash_add_del_24_8 (&vxm->geneve6_tunnel_by_key, &key6,
+				    1 /* add */);
+	}
       else
-	hash_set (vxm->geneve4_tunnel_by_key, key4.as_u64, t - vxm->tunnels);
+	{
+	  key4.value = t - vxm->tunnels;
+	  clib_bihash_add_del_16_8 (&vxm->geneve4_tunnel_by_key, &key4,
+				    1 /* add */);
+	}
 
       vnet_hw_interface_t *hi;
       if (a->l3_mode)
@@ -586,10 +598,15 @@ int vnet_geneve_add_del_tunnel
 
       vxm->tunnel_index_by_sw_if_index[t->sw_if_index] = ~0;
 
+      if (t->flow_index != ~0)
+	vnet_flow_del (vnm, t->flow_index);
+
       if (!is_ip6)
-	hash_unset (vxm->geneve4_tunnel_by_key, key4.as_u64);
+	clib_bihash_add_del_16_8 (&vxm->geneve4_tunnel_by_key, &key4,
+				  0 /* del */);
       else
-	hash_unset_mem_free (&vxm->geneve6_tunnel_by_key, &key6);
+	clib_bihash_add_del_24_8 (&vxm->geneve6_tunnel_by_key, &key6,
+				  0 /* del */);
 
       if (!ip46_address_is_multicast (&t->remote))
 	{
@@ -1099,6 +1116,128 @@ VLIB_CLI_COMMAND (set_interface_ip6_geneve_bypass_command, static) = {
 };
 /* *INDENT-ON* */
 
+int
+vnet_geneve_add_del_rx_flow (u32 hw_if_index, u32 t_index, int is_add)
+{
+  geneve_main_t *vxm = &geneve_main;
+  geneve_tunnel_t *t = pool_elt_at_index (vxm->tunnels, t_index);
+  vnet_main_t *vnm = vnet_get_main ();
+  int rv;
+
+  if (is_add)
+    {
+      if (t->flow_index == ~0)
+	{
+	  /* only mark the packets, they still go through the ip stack and
+	   * geneve4-input gets the tunnel from the mark */
+	  vnet_flow_t flow = {
+	    .actions = VNET_FLOW_ACTION_MARK,
+	    .mark_flow_id = t_index + vxm->flow_id_start,
+	    .type = VNET_FLOW_TYPE_IP4_GENEVE,
+	    .ip4_geneve = {
+	      .protocol.prot = IP_PROTOCOL_UDP,
+	      .src_addr.addr = t->remote.ip4,
+	      .src_addr.mask.as_u32 = ~0,
+	      .dst_addr.addr = t->local.ip4,
+	      .dst_addr.mask.as_u32 = ~0,
+	      .dst_port.port = UDP_DST_PORT_geneve,
+	      .dst_port.mask = 0xffff,
+	      .vni = t->vni,
+	    },
+	  };
+	  rv = vnet_flow_add (vnm, &flow, &t->flow_index);
+	  if (rv)
+	    {
+	      t->flow_index = ~0;
+	      return rv;
+	    }
+	}
+      return vnet_flow_enable (vnm, t->flow_index, hw_if_index);
+    }
+
+  /* flow index is removed when the tunnel is deleted */
+  return vnet_flow_disable (vnm, t->flow_index, hw_if_index);
+}
+
+static clib_error_t *
+geneve_offload_command_fn (vlib_main_t * vm,
+			   unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  geneve_main_t *vxm = &geneve_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 rx_sw_if_index = ~0;
+  u32 hw_if_index = ~0;
+  int is_add = 1;
+  geneve_tunnel_t *t;
+  u32 t_index;
+
+  /* Get a line of input. */
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "hw %U", unformat_vnet_hw_interface, vnm,
+		    &hw_if_index))
+	continue;
+      if (unformat (line_input, "rx %U", unformat_vnet_sw_interface, vnm,
+		    &rx_sw_if_index))
+	continue;
+      if (unformat (line_input, "del"))
+	{
+	  is_add = 0;
+	  continue;
+	}
+      return clib_error_return (0, "unknown input `%U'",
+				format_unformat_error, line_input);
+    }
+  unformat_free (line_input);
+
+  if (rx_sw_if_index == ~0)
+    return clib_error_return (0, "missing rx interface");
+  if (hw_if_index == ~0)
+    return clib_error_return (0, "missing hw interface");
+
+  if (rx_sw_if_index >= vec_len (vxm->tunnel_index_by_sw_if_index) ||
+      (t_index = vxm->tunnel_index_by_sw_if_index[rx_sw_if_index]) == ~0)
+    return clib_error_return (0, "%U is not a geneve tunnel",
+			      format_vnet_sw_if_index_name, vnm,
+			      rx_sw_if_index);
+
+  t = pool_elt_at_index (vxm->tunnels, t_index);
+
+  if (!ip46_address_is_ip4 (&t->remote) ||
+      ip46_address_is_multicast (&t->remote))
+    return clib_error_return (0, "only unicast ip4 tunnels are supported");
+
+  if (vnet_geneve_add_del_rx_flow (hw_if_index, t_index, is_add))
+    return clib_error_return (0, "error %s flow",
+			      is_add ? "enabling" : "disabling");
+
+  return 0;
+}
+
+/*?
+ * Offload the lookup of a GENEVE tunnel to the flow director of an rx
+ * interface. The interface marks the packets of the tunnel, which are then
+ * decapsulated without looking the tunnel up.
+ *
+ * @cliexpar
+ * @cliexcmd{set flow-offload geneve hw GigabitEthernet2/0/0 rx geneve_tunnel0}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (geneve_offload_command, static) = {
+  .path = "set flow-offload geneve",
+  .short_help =
+    "set flow-offload geneve hw <interface-name> rx <tunnel-name> [del]",
+  .function = geneve_offload_command_fn,
+};
+/* *INDENT-ON* */
+
+#define GENEVE_HASH_NUM_BUCKETS (2 * 1024)
+#define GENEVE_HASH_MEMORY_SIZE (1 << 20)
+
 clib_error_t *
 geneve_init (vlib_main_t * vm)
 {
@@ -1107,10 +1246,13 @@ geneve_init (vlib_main_t * vm)
   vxm->vnet_main = vnet_get_main ();
   vxm->vlib_main = vm;
 
-  /* initialize the ip6 hash */
-  vxm->geneve6_tunnel_by_key = hash_create_mem (0,
-						sizeof (geneve6_tunnel_key_t),
-						sizeof (uword));
+  vnet_flow_get_range (vxm->vnet_main, "geneve", GENEVE_FLOW_N_IDS,
+		       &vxm->flow_id_start);
+
+  clib_bihash_init_16_8 (&vxm->geneve4_tunnel_by_key, "geneve4",
+			 GENEVE_HASH_NUM_BUCKETS, GENEVE_HASH_MEMORY_SIZE);
+  clib_bihash_init_24_8 (&vxm->geneve6_tunnel_by_key, "geneve6",
+			 GENEVE_HASH_NUM_BUCKETS, GENEVE_HASH_MEMORY_SIZE);
   vxm->vtep_table = vtep_table_create ();
   vxm->mcast_shared = hash_create_mem (0,
 				       sizeof (ip46_address_t),
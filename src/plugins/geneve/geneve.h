@@ -31,7 +31,9 @@
 #include <vnet/ip/ip6_packet.h>
 #include <vnet/udp/udp_packet.h>
 #include <vnet/udp/udp_local.h>
+#include <vnet/udp/udp_tunnel.h>
 #include <vnet/dpo/dpo.h>
+#include <vnet/flow/flow.h>
 #include <vnet/adj/adj_types.h>
 
 #define SUPPORT_OPTIONS_HEADER 0
@@ -50,32 +52,12 @@ typedef CLIB_PACKED (struct
 		     geneve_header_t geneve;	/* Min 8 bytes, Max 260 bytes */
 		     }) ip6_geneve_header_t;
 
-typedef CLIB_PACKED (struct
-		     {
-		     /*
-		      * Key fields: ip source and geneve vni on incoming GENEVE packet
-		      * all fields in NET byte order
-		      */
-		     union
-		     {
-		     struct
-		     {
-		     u32 remote;
-		     u32 vni;	/* shifted left 8 bits */
-		     };
-		     u64 as_u64;
-		     };
-		     }) geneve4_tunnel_key_t;
-
-typedef CLIB_PACKED (struct
-		     {
-		     /*
-		      * Key fields: ip source and geneve vni on incoming GENEVE packet
-		      * all fields in NET byte order
-		      */
-		     ip6_address_t remote;
-		     u32 vni;	/* shifted left 8 bits */
-		     }) geneve6_tunnel_key_t;
+/*
+ * Key fields: ip source and geneve vni (shifted left 8 bits) on incoming
+ * GENEVE packet, all fields in NET byte order
+ */
+typedef udp_tunnel4_key_t geneve4_tunnel_key_t;
+typedef udp_tunnel6_key_t geneve6_tunnel_key_t;
 
 typedef struct
 {
@@ -140,6 +122,9 @@ typedef struct
   u32 sibling_index;
 
   u8 l3_mode;
+
+  /* flow offloaded to rx interfaces, or ~0 */
+  u32 flow_index;
 } geneve_tunnel_t;
 
 #define foreach_geneve_input_next        \
@@ -168,8 +153,8 @@ typedef struct
   geneve_tunnel_t *tunnels;
 
   /* lookup tunnel by key */
-  uword *geneve4_tunnel_by_key;	/* keyed on ipv4.remote + vni */
-  uword *geneve6_tunnel_by_key;	/* keyed on ipv6.remote + vni */
+  clib_bihash_16_8_t geneve4_tunnel_by_key;	/* keyed on ipv4.remote + vni */
+  clib_bihash_24_8_t geneve6_tunnel_by_key;	/* keyed on ipv6.remote + vni */
 
   /* local VTEP IPs ref count used by geneve-bypass node to check if
      received GENEVE packet DIP matches any local VTEP address */
@@ -186,6 +171,10 @@ typedef struct
   vnet_main_t *vnet_main;
 
   u16 msg_id_base;
+
+  /* offloaded flows mark packets with flow_id_start + tunnel index */
+  u32 flow_id_start;
+
   /* cache for last 8 geneve tunnel */
 #ifdef CLIB_HAVE_VEC512
   vtep4_cache_t vtep4_u512;
@@ -221,6 +210,25 @@ int vnet_geneve_add_del_tunnel
   (vnet_geneve_add_del_tunnel_args_t * a, u32 * sw_if_indexp);
 
 void vnet_int_geneve_bypass_mode (u32 sw_if_index, u8 is_ip6, u8 is_enable);
+
+#define GENEVE_FLOW_N_IDS (1024 * 1024)
+
+int vnet_geneve_add_del_rx_flow (u32 hw_if_index, u32 t_index, int is_add);
+
+/**
+ * Tunnel of a packet marked by a flow offloaded to its rx interface, or ~0.
+ * The mark is consumed so that it does not apply to the inner packet.
+ */
+always_inline u32
+geneve_flow_tunnel_index (geneve_main_t * vxm, vlib_buffer_t * b)
+{
+  u32 t_index = vnet_flow_mark_to_index (b->flow_id, vxm->flow_id_start,
+					 GENEVE_FLOW_N_IDS);
+
+  if (PREDICT_FALSE (t_index != ~0))
+    b->flow_id = 0;
+  return t_index;
+}
 #endif /* included_vnet_geneve_h */
 
 /*
@@ -355,7 +355,7 @@ int vnet_gtpu_add_mod_del_tunnel
   gtpu_main_t *gtm = &gtpu_main;
   gtpu_tunnel_t *t = 0;
   vnet_main_t *vnm = gtm->vnet_main;
-  uword *p;
+  u64 *p;
   u32 hw_if_index = ~0;
   u32 sw_if_index = ~0;
   gtpu4_tunnel_key_t key4;
@@ -364,15 +364,20 @@ int vnet_gtpu_add_mod_del_tunnel
 
   if (!is_ip6)
     {
-      key4.src = a->dst.ip4.as_u32;	/* decap src in key is encap dst in config */
-      key4.teid = clib_host_to_net_u32 (a->teid);
-      p = hash_get (gtm->gtpu4_tunnel_by_key, key4.as_u64);
+      /* decap src in key is encap dst in config */
+      udp_tunnel4_key_init (&key4, 0, a->dst.ip4.as_u32, 0, 0,
+			    clib_host_to_net_u32 (a->teid));
+      p = &key4.value;
+      if (clib_bihash_search_inline_16_8 (&gtm->gtpu4_tunnel_by_key, &key4))
+	p = 0;
     }
   else
     {
-      key6.src = a->dst.ip6;
-      key6.teid = clib_host_to_net_u32 (a->teid);
-      p = hash_get_mem (gtm->gtpu6_tunnel_by_key, &key6);
+      udp_tunnel6_key_init (&key6, &a->dst.ip6, 0, 0,
+			    clib_host_to_net_u32 (a->teid));
+      p = &key6.value;
+      if (clib_bihash_search_inline_24_8 (&gtm->gtpu6_tunnel_by_key, &key6))
+	p = 0;
     }
 
   if (a->opn == GTPU_ADD_TUNNEL)
@@ -408,10 +413,17 @@ int vnet_gtpu_add_mod_del_tunnel
 
       /* copy the key */
       if (is_ip6)
-	hash_set_mem_alloc (&gtm->gtpu6_tunnel_by_key, &key6,
-			    t - gtm->tunnels);
+	{
+	  key6.value = t - gtm->tunnels;
+	  clib_bihash_add_del_24_8 (&gtm->gtpu6_tunnel_by_key, &key6,
+				    1 /* add */);
+	}
       else
-	hash_set (gtm->gtpu4_tunnel_by_key, key4.as_u64, t - gtm->tunnels);
+	{
+	  key4.value = t - gtm->tunnels;
+	  clib_bihash_add_del_16_8 (&gtm->gtpu4_tunnel_by_key, &key4,
+				    1 /* add */);
+	}
 
       vnet_hw_interface_t *hi;
       if (vec_len (gtm->free_gtpu_tunnel_hw_if_indices) > 0)
@@ -594,9 +606,11 @@ int vnet_gtpu_add_mod_del_tunnel
       gtm->tunnel_index_by_sw_if_index[t->sw_if_index] = ~0;
 
       if (!is_ip6)
-	hash_unset (gtm->gtpu4_tunnel_by_key, key4.as_u64);
+	clib_bihash_add_del_16_8 (&gtm->gtpu4_tunnel_by_key, &key4,
+				  0 /* del */);
       else
-	hash_unset_mem_free (&gtm->gtpu6_tunnel_by_key, &key6);
+	clib_bihash_add_del_24_8 (&gtm->gtpu6_tunnel_by_key, &key6,
+				  0 /* del */);
 
       if (!ip46_address_is_multicast (&t->dst))
 	{
@@ -1238,6 +1252,9 @@ VLIB_CLI_COMMAND (gtpu_offload_command, static) = {
 };
 /* *INDENT-ON* */
 
+#define GTPU_HASH_NUM_BUCKETS (2 * 1024)
+#define GTPU_HASH_MEMORY_SIZE (1 << 20)
+
 clib_error_t *
 gtpu_init (vlib_main_t * vm)
 {
@@ -1249,10 +1266,10 @@ gtpu_init (vlib_main_t * vm)
   vnet_flow_get_range (gtm->vnet_main, "gtpu", 1024 * 1024,
 		       &gtm->flow_id_start);
 
-  /* initialize the ip6 hash */
-  gtm->gtpu6_tunnel_by_key = hash_create_mem (0,
-					      sizeof (gtpu6_tunnel_key_t),
-					      sizeof (uword));
+  clib_bihash_init_16_8 (&gtm->gtpu4_tunnel_by_key, "gtpu4",
+			 GTPU_HASH_NUM_BUCKETS, GTPU_HASH_MEMORY_SIZE);
+  clib_bihash_init_24_8 (&gtm->gtpu6_tunnel_by_key, "gtpu6",
+			 GTPU_HASH_NUM_BUCKETS, GTPU_HASH_MEMORY_SIZE);
   gtm->vtep_table = vtep_table_create ();
   gtm->mcast_shared = hash_create_mem (0,
 				       sizeof (ip46_address_t),
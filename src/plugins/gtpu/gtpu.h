@@ -32,6 +32,7 @@
 #include <vnet/ip/ip6_packet.h>
 #include <vnet/udp/udp_packet.h>
 #include <vnet/udp/udp_local.h>
+#include <vnet/udp/udp_tunnel.h>
 #include <vnet/dpo/dpo.h>
 #include <vnet/adj/adj_types.h>
 #include <vnet/fib/fib_table.h>
@@ -96,34 +97,12 @@ typedef CLIB_PACKED(struct
 }) ip6_gtpu_header_t;
 /* *INDENT-ON* */
 
-/* *INDENT-OFF* */
-typedef CLIB_PACKED
-(struct {
-  /*
-   * Key fields: ip src and gtpu teid on incoming gtpu packet
-   * all fields in NET byte order
-   */
-  union {
-    struct {
-      u32 src;
-      u32 teid;
-    };
-    u64 as_u64;
-  };
-}) gtpu4_tunnel_key_t;
-/* *INDENT-ON* */
-
-/* *INDENT-OFF* */
-typedef CLIB_PACKED
-(struct {
-  /*
-   * Key fields: ip src and gtpu teid on incoming gtpu packet
-   * all fields in NET byte order
-   */
-  ip6_address_t src;
-  u32 teid;
-}) gtpu6_tunnel_key_t;
-/* *INDENT-ON* */
+/*
+ * Key fields: ip src and gtpu teid on incoming gtpu packet
+ * all fields in NET byte order
+ */
+typedef udp_tunnel4_key_t gtpu4_tunnel_key_t;
+typedef udp_tunnel6_key_t gtpu6_tunnel_key_t;
 
 typedef struct
 {
@@ -208,8 +187,8 @@ typedef struct
   gtpu_tunnel_t *tunnels;
 
   /* lookup tunnel by key */
-  uword *gtpu4_tunnel_by_key;	/* keyed on ipv4.dst + teid */
-  uword *gtpu6_tunnel_by_key;	/* keyed on ipv6.dst + teid */
+  clib_bihash_16_8_t gtpu4_tunnel_by_key;	/* keyed on ipv4.dst + teid */
+  clib_bihash_24_8_t gtpu6_tunnel_by_key;	/* keyed on ipv6.dst + teid */
 
   /* local VTEP IPs ref count used by gtpu-bypass node to check if
      received gtpu packet DIP matches any local VTEP address */
@@ -53,671 +53,263 @@ validate_gtpu_fib (vlib_buffer_t *b, gtpu_tunnel_t *t, u32 is_ip4)
   return t->encap_fib_index == vlib_buffer_get_ip_fib_index (b, is_ip4);
 }
 
-always_inline uword
-gtpu_input (vlib_main_t * vm,
-             vlib_node_runtime_t * node,
-             vlib_frame_t * from_frame,
-             u32 is_ip4)
+static_always_inline void
+gtpu4_key (vlib_buffer_t * b0, gtpu4_tunnel_key_t * key4)
 {
-  u32 n_left_from, next_index, * from, * to_next;
-  gtpu_main_t * gtm = &gtpu_main;
-  vnet_main_t * vnm = gtm->vnet_main;
-  vnet_interface_main_t * im = &vnm->interface_main;
-  u32 last_tunnel_index = ~0;
-  gtpu4_tunnel_key_t last_key4;
-  gtpu6_tunnel_key_t last_key6;
-  u32 pkts_decapsulated = 0;
-  u32 thread_index = vlib_get_thread_index();
-  u32 stats_sw_if_index, stats_n_packets, stats_n_bytes;
-
-  if (is_ip4)
-    last_key4.as_u64 = ~0;
-  else
-    clib_memset (&last_key6, 0xff, sizeof (last_key6));
-
-  from = vlib_frame_vector_args (from_frame);
-  n_left_from = from_frame->n_vectors;
-
-  next_index = node->cached_next_index;
-  stats_sw_if_index = node->runtime_data[0];
-  stats_n_packets = stats_n_bytes = 0;
-
-  while (n_left_from > 0)
-    {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index,
-			   to_next, n_left_to_next);
-      while (n_left_from >= 4 && n_left_to_next >= 2)
-	{
-          u32 bi0, bi1;
-	  vlib_buffer_t * b0, * b1;
-	  u32 next0, next1;
-          ip4_header_t * ip4_0, * ip4_1;
-          ip6_header_t * ip6_0, * ip6_1;
-          gtpu_header_t * gtpu0, * gtpu1;
-          u32 gtpu_hdr_len0, gtpu_hdr_len1;
-	  uword * p0, * p1;
-          u32 tunnel_index0, tunnel_index1;
-          gtpu_tunnel_t * t0, * t1, * mt0 = NULL, * mt1 = NULL;
-          gtpu4_tunnel_key_t key4_0, key4_1;
-          gtpu6_tunnel_key_t key6_0, key6_1;
-          u32 error0, error1;
-	  u32 sw_if_index0, sw_if_index1, len0, len1;
-          u8 has_space0, has_space1;
-          u8 ver0, ver1;
-
-	  /* Prefetch next iteration. */
-	  {
-	    vlib_buffer_t * p2, * p3;
-
-	    p2 = vlib_get_buffer (vm, from[2]);
-	    p3 = vlib_get_buffer (vm, from[3]);
-
-	    vlib_prefetch_buffer_header (p2, LOAD);
-	    vlib_prefetch_buffer_header (p3, LOAD);
-
-	    CLIB_PREFETCH (p2->data, 2*CLIB_CACHE_LINE_BYTES, LOAD);
-	    CLIB_PREFETCH (p3->data, 2*CLIB_CACHE_LINE_BYTES, LOAD);
-	  }
-
-	  bi0 = from[0];
-	  bi1 = from[1];
-	  to_next[0] = bi0;
-	  to_next[1] = bi1;
-	  from += 2;
-	  to_next += 2;
-	  n_left_to_next -= 2;
-	  n_left_from -= 2;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  b1 = vlib_get_buffer (vm, bi1);
-
-          /* udp leaves current_data pointing at the gtpu header */
-          gtpu0 = vlib_buffer_get_current (b0);
-          gtpu1 = vlib_buffer_get_current (b1);
-          if (is_ip4)
-            {
-              ip4_0 = (void *)((u8*)gtpu0 - sizeof(udp_header_t) - sizeof(ip4_header_t));
-              ip4_1 = (void *)((u8*)gtpu1 - sizeof(udp_header_t) - sizeof(ip4_header_t));
-            }
-          else
-            {
-              ip6_0 = (void *)((u8*)gtpu0 - sizeof(udp_header_t) - sizeof(ip6_header_t));
-              ip6_1 = (void *)((u8*)gtpu1 - sizeof(udp_header_t) - sizeof(ip6_header_t));
-            }
-
-          tunnel_index0 = ~0;
-          error0 = 0;
-
-          tunnel_index1 = ~0;
-          error1 = 0;
-
-          /* speculatively load gtp header version field */
-          ver0 = gtpu0->ver_flags;
-          ver1 = gtpu1->ver_flags;
-
-	  /*
-           * Manipulate gtpu header
-           * TBD: Manipulate Sequence Number and N-PDU Number
-           * TBD: Manipulate Next Extension Header
-           */
-          gtpu_hdr_len0 = sizeof(gtpu_header_t) - (((ver0 & GTPU_E_S_PN_BIT) == 0) * 4);
-          gtpu_hdr_len1 = sizeof(gtpu_header_t) - (((ver1 & GTPU_E_S_PN_BIT) == 0) * 4);
-
-          has_space0 = vlib_buffer_has_space (b0, gtpu_hdr_len0);
-          has_space1 = vlib_buffer_has_space (b1, gtpu_hdr_len1);
-
-	  if (PREDICT_FALSE (((ver0 & GTPU_VER_MASK) != GTPU_V1_VER) | (!has_space0)))
-	    {
-	      error0 = has_space0 ? GTPU_ERROR_BAD_VER : GTPU_ERROR_TOO_SMALL;
-	      next0 = GTPU_INPUT_NEXT_DROP;
-	      goto trace0;
-	    }
-
-	  /* Manipulate packet 0 */
-          if (is_ip4) {
-            key4_0.src = ip4_0->src_address.as_u32;
-            key4_0.teid = gtpu0->teid;
-
- 	    /* Make sure GTPU tunnel exist according to packet SIP and teid
- 	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
-           if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
-              {
-                p0 = hash_get (gtm->gtpu4_tunnel_by_key, key4_0.as_u64);
-                if (PREDICT_FALSE (p0 == NULL))
-                  {
-                    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next0 = GTPU_INPUT_NEXT_DROP;
-                    goto trace0;
-                  }
-                last_key4.as_u64 = key4_0.as_u64;
-                tunnel_index0 = last_tunnel_index = p0[0];
-              }
-            else
-              tunnel_index0 = last_tunnel_index;
-	    t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
-
-	    /* Validate GTPU tunnel encap-fib index against packet */
-	    if (PREDICT_FALSE (validate_gtpu_fib (b0, t0, is_ip4) == 0))
-	      {
-		error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-		next0 = GTPU_INPUT_NEXT_DROP;
-		goto trace0;
-	      }
-
-	    /* Validate GTPU tunnel SIP against packet DIP */
-	    if (PREDICT_TRUE (ip4_0->dst_address.as_u32 == t0->src.ip4.as_u32))
-	      goto next0; /* valid packet */
-	    if (PREDICT_FALSE (ip4_address_is_multicast (&ip4_0->dst_address)))
-	      {
-		key4_0.src = ip4_0->dst_address.as_u32;
-		key4_0.teid = gtpu0->teid;
-		/* Make sure mcast GTPU tunnel exist by packet DIP and teid */
-		p0 = hash_get (gtm->gtpu4_tunnel_by_key, key4_0.as_u64);
-		if (PREDICT_TRUE (p0 != NULL))
-		  {
-		    mt0 = pool_elt_at_index (gtm->tunnels, p0[0]);
-		    goto next0; /* valid packet */
-		  }
-	      }
-	    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-	    next0 = GTPU_INPUT_NEXT_DROP;
-	    goto trace0;
-
-         } else /* !is_ip4 */ {
-            key6_0.src.as_u64[0] = ip6_0->src_address.as_u64[0];
-            key6_0.src.as_u64[1] = ip6_0->src_address.as_u64[1];
-            key6_0.teid = gtpu0->teid;
-
- 	    /* Make sure GTPU tunnel exist according to packet SIP and teid
- 	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
-            if (PREDICT_FALSE (memcmp(&key6_0, &last_key6, sizeof(last_key6)) != 0))
-              {
-                p0 = hash_get_mem (gtm->gtpu6_tunnel_by_key, &key6_0);
-                if (PREDICT_FALSE (p0 == NULL))
-                  {
-                    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next0 = GTPU_INPUT_NEXT_DROP;
-                    goto trace0;
-                  }
-                clib_memcpy_fast (&last_key6, &key6_0, sizeof(key6_0));
-                tunnel_index0 = last_tunnel_index = p0[0];
-              }
-            else
-              tunnel_index0 = last_tunnel_index;
-	    t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
-
-	    /* Validate GTPU tunnel encap-fib index against packet */
-	    if (PREDICT_FALSE (validate_gtpu_fib (b0, t0, is_ip4) == 0))
-	      {
-		error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-		next0 = GTPU_INPUT_NEXT_DROP;
-		goto trace0;
-	      }
-
-	    /* Validate GTPU tunnel SIP against packet DIP */
-	    if (PREDICT_TRUE (ip6_address_is_equal (&ip6_0->dst_address,
-						    &t0->src.ip6)))
-		goto next0; /* valid packet */
-	    if (PREDICT_FALSE (ip6_address_is_multicast (&ip6_0->dst_address)))
-	      {
-		key6_0.src.as_u64[0] = ip6_0->dst_address.as_u64[0];
-		key6_0.src.as_u64[1] = ip6_0->dst_address.as_u64[1];
-		key6_0.teid = gtpu0->teid;
-		p0 = hash_get_mem (gtm->gtpu6_tunnel_by_key, &key6_0);
-		if (PREDICT_TRUE (p0 != NULL))
-		  {
-		    mt0 = pool_elt_at_index (gtm->tunnels, p0[0]);
-		    goto next0; /* valid packet */
-		  }
-	      }
-	    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-	    next0 = GTPU_INPUT_NEXT_DROP;
-	    goto trace0;
-          }
-
-	next0:
-	  /* Pop gtpu header */
-	  vlib_buffer_advance (b0, gtpu_hdr_len0);
-
-          next0 = t0->decap_next_index;
-          sw_if_index0 = t0->sw_if_index;
-          len0 = vlib_buffer_length_in_chain (vm, b0);
+  /* udp leaves current_data pointing at the gtpu header */
+  gtpu_header_t * gtpu0 = vlib_buffer_get_current (b0);
+  ip4_header_t * ip4_0 = (void *) ((u8 *) gtpu0 - sizeof (udp_header_t) -
+				   sizeof (ip4_header_t));
+
+  /* SIP identify a GTPU path, and teid identify a tunnel in a given GTPU
+   * path */
+  udp_tunnel4_key_init (key4, 0, ip4_0->src_address.as_u32, 0, 0,
+			gtpu0->teid);
+}
 
-          /* Required to make the l2 tag push / pop code work on l2 subifs */
-          if (PREDICT_TRUE(next0 == GTPU_INPUT_NEXT_L2_INPUT))
-            vnet_update_l2_len (b0);
+static_always_inline void
+gtpu6_key (vlib_buffer_t * b0, gtpu6_tunnel_key_t * key6)
+{
+  gtpu_header_t * gtpu0 = vlib_buffer_get_current (b0);
+  ip6_header_t * ip6_0 = (void *) ((u8 *) gtpu0 - sizeof (udp_header_t) -
+				   sizeof (ip6_header_t));
 
-          /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
-          vnet_buffer(b0)->sw_if_index[VLIB_RX] = sw_if_index0;
-	  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
+  udp_tunnel6_key_init (key6, &ip6_0->src_address, 0, 0, gtpu0->teid);
+}
 
-          pkts_decapsulated ++;
-          stats_n_packets += 1;
-          stats_n_bytes += len0;
+typedef struct {
+  vlib_combined_counter_main_t * rx_counter;
+  u32 thread_index;
+  u32 pkts_decapsulated;
+  u32 stats_sw_if_index;
+  u32 stats_n_packets;
+  u32 stats_n_bytes;
+} gtpu_decap_ctx_t;
+
+static_always_inline u16
+gtpu_decap_one (vlib_main_t * vm, vlib_node_runtime_t * node,
+		vlib_buffer_t * b0, void * key, void * arg, u8 is_ip4)
+{
+  gtpu_main_t * gtm = &gtpu_main;
+  gtpu_decap_ctx_t * ctx = arg;
+  gtpu4_tunnel_key_t * key4_0 = key;
+  gtpu6_tunnel_key_t * key6_0 = key;
+  u32 next0;
+  ip4_header_t * ip4_0;
+  ip6_header_t * ip6_0;
+  gtpu_header_t * gtpu0;
+  u32 gtpu_hdr_len0;
+  u32 tunnel_index0;
+  gtpu_tunnel_t * t0, * mt0 = NULL;
+  u32 error0;
+  u32 sw_if_index0, len0;
+  u8 has_space0;
+  u8 ver0;
+
+  /* udp leaves current_data pointing at the gtpu header */
+  gtpu0 = vlib_buffer_get_current (b0);
+  if (is_ip4) {
+    ip4_0 = (void *)((u8*)gtpu0 - sizeof(udp_header_t) - sizeof(ip4_header_t));
+  } else {
+    ip6_0 = (void *)((u8*)gtpu0 - sizeof(udp_header_t) - sizeof(ip6_header_t));
+  }
 
-	  /* Batch stats increment on the same gtpu tunnel so counter
-	     is not incremented per packet */
-	  if (PREDICT_FALSE (sw_if_index0 != stats_sw_if_index))
-	    {
-	      stats_n_packets -= 1;
-	      stats_n_bytes -= len0;
-	      if (stats_n_packets)
-		vlib_increment_combined_counter
-		  (im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
-		   thread_index, stats_sw_if_index,
-		   stats_n_packets, stats_n_bytes);
-	      stats_n_packets = 1;
-	      stats_n_bytes = len0;
-	      stats_sw_if_index = sw_if_index0;
-	    }
+  tunnel_index0 = ~0;
+  error0 = 0;
 
-        trace0:
-          b0->error = error0 ? node->errors[error0] : 0;
+  /* speculatively load gtp header version field */
+  ver0 = gtpu0->ver_flags;
 
-          if (PREDICT_FALSE(b0->flags & VLIB_BUFFER_IS_TRACED))
-            {
-              gtpu_rx_trace_t *tr
-                = vlib_add_trace (vm, node, b0, sizeof (*tr));
-              tr->next_index = next0;
-              tr->error = error0;
-              tr->tunnel_index = tunnel_index0;
-              tr->teid = has_space0 ? clib_net_to_host_u32(gtpu0->teid) : ~0;
-            }
+  /*
+   * Manipulate gtpu header
+   * TBD: Manipulate Sequence Number and N-PDU Number
+   * TBD: Manipulate Next Extension Header
+   */
+  gtpu_hdr_len0 = sizeof(gtpu_header_t) - (((ver0 & GTPU_E_S_PN_BIT) == 0) * 4);
 
-	  if (PREDICT_FALSE (((ver1 & GTPU_VER_MASK) != GTPU_V1_VER) | (!has_space1)))
-	    {
-	      error1 = has_space1 ? GTPU_ERROR_BAD_VER : GTPU_ERROR_TOO_SMALL;
-	      next1 = GTPU_INPUT_NEXT_DROP;
-	      goto trace1;
-	    }
+  has_space0 = vlib_buffer_has_space (b0, gtpu_hdr_len0);
 
-          /* Manipulate packet 1 */
-          if (is_ip4) {
-            key4_1.src = ip4_1->src_address.as_u32;
-            key4_1.teid = gtpu1->teid;
+  if (PREDICT_FALSE (((ver0 & GTPU_VER_MASK) != GTPU_V1_VER) | (!has_space0)))
+    {
+      error0 = has_space0 ? GTPU_ERROR_BAD_VER : GTPU_ERROR_TOO_SMALL;
+      next0 = GTPU_INPUT_NEXT_DROP;
+      goto trace00;
+    }
 
- 	    /* Make sure GTPU tunnel exist according to packet SIP and teid
- 	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
-	    if (PREDICT_FALSE (key4_1.as_u64 != last_key4.as_u64))
-              {
-                p1 = hash_get (gtm->gtpu4_tunnel_by_key, key4_1.as_u64);
-                if (PREDICT_FALSE (p1 == NULL))
-                  {
-                    error1 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next1 = GTPU_INPUT_NEXT_DROP;
-                    goto trace1;
-                  }
-                last_key4.as_u64 = key4_1.as_u64;
-                tunnel_index1 = last_tunnel_index = p1[0];
-              }
-            else
-              tunnel_index1 = last_tunnel_index;
- 	    t1 = pool_elt_at_index (gtm->tunnels, tunnel_index1);
-
-	    /* Validate GTPU tunnel encap-fib index against packet */
-	    if (PREDICT_FALSE (validate_gtpu_fib (b1, t1, is_ip4) == 0))
-	      {
-		error1 = GTPU_ERROR_NO_SUCH_TUNNEL;
-		next1 = GTPU_INPUT_NEXT_DROP;
-		goto trace1;
-	      }
-
-	    /* Validate GTPU tunnel SIP against packet DIP */
-	    if (PREDICT_TRUE (ip4_1->dst_address.as_u32 == t1->src.ip4.as_u32))
-	      goto next1; /* valid packet */
-	    if (PREDICT_FALSE (ip4_address_is_multicast (&ip4_1->dst_address)))
-	      {
-		key4_1.src = ip4_1->dst_address.as_u32;
-		key4_1.teid = gtpu1->teid;
-		/* Make sure mcast GTPU tunnel exist by packet DIP and teid */
-		p1 = hash_get (gtm->gtpu4_tunnel_by_key, key4_1.as_u64);
-		if (PREDICT_TRUE (p1 != NULL))
-		  {
-		    mt1 = pool_elt_at_index (gtm->tunnels, p1[0]);
-		    goto next1; /* valid packet */
-		  }
-	      }
-	    error1 = GTPU_ERROR_NO_SUCH_TUNNEL;
-	    next1 = GTPU_INPUT_NEXT_DROP;
-	    goto trace1;
-
-         } else /* !is_ip4 */ {
-            key6_1.src.as_u64[0] = ip6_1->src_address.as_u64[0];
-            key6_1.src.as_u64[1] = ip6_1->src_address.as_u64[1];
-            key6_1.teid = gtpu1->teid;
-
- 	    /* Make sure GTPU tunnel exist according to packet SIP and teid
- 	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
-            if (PREDICT_FALSE (memcmp(&key6_1, &last_key6, sizeof(last_key6)) != 0))
-              {
-                p1 = hash_get_mem (gtm->gtpu6_tunnel_by_key, &key6_1);
+  if (is_ip4) {
+    /* Make sure GTPU tunnel exist according to packet SIP and teid */
+    if (PREDICT_FALSE (key4_0->value == UDP_TUNNEL_KEY_NOT_FOUND))
+      {
+	error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
+	next0 = GTPU_INPUT_NEXT_DROP;
+	goto trace00;
+      }
+    tunnel_index0 = key4_0->value;
+    t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
 
-                if (PREDICT_FALSE (p1 == NULL))
-                  {
-                    error1 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next1 = GTPU_INPUT_NEXT_DROP;
-                    goto trace1;
-                  }
+    /* Validate GTPU tunnel encap-fib index against packet */
+    if (PREDICT_FALSE (validate_gtpu_fib (b0, t0, is_ip4) == 0))
+      {
+	error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
+	next0 = GTPU_INPUT_NEXT_DROP;
+	goto trace00;
+      }
 
-                clib_memcpy_fast (&last_key6, &key6_1, sizeof(key6_1));
-                tunnel_index1 = last_tunnel_index = p1[0];
-              }
-            else
-              tunnel_index1 = last_tunnel_index;
- 	    t1 = pool_elt_at_index (gtm->tunnels, tunnel_index1);
-
-	    /* Validate GTPU tunnel encap-fib index against packet */
-	    if (PREDICT_FALSE (validate_gtpu_fib (b1, t1, is_ip4) == 0))
-	      {
-		error1 = GTPU_ERROR_NO_SUCH_TUNNEL;
-		next1 = GTPU_INPUT_NEXT_DROP;
-		goto trace1;
-	      }
-
-	    /* Validate GTPU tunnel SIP against packet DIP */
-	    if (PREDICT_TRUE (ip6_address_is_equal (&ip6_1->dst_address,
-						    &t1->src.ip6)))
-		goto next1; /* valid packet */
-	    if (PREDICT_FALSE (ip6_address_is_multicast (&ip6_1->dst_address)))
-	      {
-		key6_1.src.as_u64[0] = ip6_1->dst_address.as_u64[0];
-		key6_1.src.as_u64[1] = ip6_1->dst_address.as_u64[1];
-		key6_1.teid = gtpu1->teid;
-		p1 = hash_get_mem (gtm->gtpu6_tunnel_by_key, &key6_1);
-		if (PREDICT_TRUE (p1 != NULL))
-		  {
-		    mt1 = pool_elt_at_index (gtm->tunnels, p1[0]);
-		    goto next1; /* valid packet */
-		  }
-	      }
-	    error1 = GTPU_ERROR_NO_SUCH_TUNNEL;
-	    next1 = GTPU_INPUT_NEXT_DROP;
-	    goto trace1;
+    /* Validate GTPU tunnel SIP against packet DIP */
+    if (PREDICT_TRUE (ip4_0->dst_address.as_u32 == t0->src.ip4.as_u32))
+      goto next00; /* valid packet */
+    if (PREDICT_FALSE (ip4_address_is_multicast (&ip4_0->dst_address)))
+      {
+	udp_tunnel4_key_init (key4_0, 0, ip4_0->dst_address.as_u32, 0, 0,
+			      gtpu0->teid);
+	/* Make sure mcast GTPU tunnel exist by packet DIP and teid */
+	if (PREDICT_TRUE (clib_bihash_search_inline_16_8
+			  (&gtm->gtpu4_tunnel_by_key, key4_0) == 0))
+	  {
+	    mt0 = pool_elt_at_index (gtm->tunnels, key4_0->value);
+	    goto next00; /* valid packet */
 	  }
+      }
+    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
+    next0 = GTPU_INPUT_NEXT_DROP;
+    goto trace00;
 
-	next1:
-	  /* Pop gtpu header */
-	  vlib_buffer_advance (b1, gtpu_hdr_len1);
-
-          next1 = t1->decap_next_index;
-          sw_if_index1 = t1->sw_if_index;
-          len1 = vlib_buffer_length_in_chain (vm, b1);
-
-          /* Required to make the l2 tag push / pop code work on l2 subifs */
-          if (PREDICT_TRUE(next1 == GTPU_INPUT_NEXT_L2_INPUT))
-            vnet_update_l2_len (b1);
-
-          /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
-          vnet_buffer(b1)->sw_if_index[VLIB_RX] = sw_if_index1;
-	  sw_if_index1 = (mt1) ? mt1->sw_if_index : sw_if_index1;
-
-          pkts_decapsulated ++;
-          stats_n_packets += 1;
-          stats_n_bytes += len1;
-
-	  /* Batch stats increment on the same gtpu tunnel so counter
-	     is not incremented per packet */
-	  if (PREDICT_FALSE (sw_if_index1 != stats_sw_if_index))
-	    {
-	      stats_n_packets -= 1;
-	      stats_n_bytes -= len1;
-	      if (stats_n_packets)
-		vlib_increment_combined_counter
-		  (im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
-		   thread_index, stats_sw_if_index,
-		   stats_n_packets, stats_n_bytes);
-	      stats_n_packets = 1;
-	      stats_n_bytes = len1;
-	      stats_sw_if_index = sw_if_index1;
-	    }
-
-        trace1:
-          b1->error = error1 ? node->errors[error1] : 0;
-
-          if (PREDICT_FALSE(b1->flags & VLIB_BUFFER_IS_TRACED))
-            {
-              gtpu_rx_trace_t *tr
-                = vlib_add_trace (vm, node, b1, sizeof (*tr));
-              tr->next_index = next1;
-              tr->error = error1;
-              tr->tunnel_index = tunnel_index1;
-              tr->teid = has_space1 ? clib_net_to_host_u32(gtpu1->teid) : ~0;
-            }
-
-	  vlib_validate_buffer_enqueue_x2 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, bi1, next0, next1);
-	}
-
-      while (n_left_from > 0 && n_left_to_next > 0)
-	{
-	  u32 bi0;
-	  vlib_buffer_t * b0;
-	  u32 next0;
-          ip4_header_t * ip4_0;
-          ip6_header_t * ip6_0;
-          gtpu_header_t * gtpu0;
-          u32 gtpu_hdr_len0;
-	  uword * p0;
-          u32 tunnel_index0;
-          gtpu_tunnel_t * t0, * mt0 = NULL;
-          gtpu4_tunnel_key_t key4_0;
-          gtpu6_tunnel_key_t key6_0;
-          u32 error0;
-	  u32 sw_if_index0, len0;
-          u8 has_space0;
-          u8 ver0;
-
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-
-          /* udp leaves current_data pointing at the gtpu header */
-          gtpu0 = vlib_buffer_get_current (b0);
-          if (is_ip4) {
-            ip4_0 = (void *)((u8*)gtpu0 - sizeof(udp_header_t) - sizeof(ip4_header_t));
-          } else {
-            ip6_0 = (void *)((u8*)gtpu0 - sizeof(udp_header_t) - sizeof(ip6_header_t));
-          }
+  } else /* !is_ip4 */ {
+    /* Make sure GTPU tunnel exist according to packet SIP and teid */
+    if (PREDICT_FALSE (key6_0->value == UDP_TUNNEL_KEY_NOT_FOUND))
+      {
+	error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
+	next0 = GTPU_INPUT_NEXT_DROP;
+	goto trace00;
+      }
+    tunnel_index0 = key6_0->value;
+    t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
 
-          tunnel_index0 = ~0;
-          error0 = 0;
+    /* Validate GTPU tunnel encap-fib index against packet */
+    if (PREDICT_FALSE (validate_gtpu_fib (b0, t0, is_ip4) == 0))
+      {
+	error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
+	next0 = GTPU_INPUT_NEXT_DROP;
+	goto trace00;
+      }
 
-          /* speculatively load gtp header version field */
-          ver0 = gtpu0->ver_flags;
+    /* Validate GTPU tunnel SIP against packet DIP */
+    if (PREDICT_TRUE (ip6_address_is_equal (&ip6_0->dst_address,
+					    &t0->src.ip6)))
+	goto next00; /* valid packet */
+    if (PREDICT_FALSE (ip6_address_is_multicast (&ip6_0->dst_address)))
+      {
+	udp_tunnel6_key_init (key6_0, &ip6_0->dst_address, 0, 0,
+			      gtpu0->teid);
+	if (PREDICT_TRUE (clib_bihash_search_inline_24_8
+			  (&gtm->gtpu6_tunnel_by_key, key6_0) == 0))
+	  {
+	    mt0 = pool_elt_at_index (gtm->tunnels, key6_0->value);
+	    goto next00; /* valid packet */
+	  }
+      }
+    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
+    next0 = GTPU_INPUT_NEXT_DROP;
+    goto trace00;
+  }
 
-	  /*
-           * Manipulate gtpu header
-           * TBD: Manipulate Sequence Number and N-PDU Number
-           * TBD: Manipulate Next Extension Header
-           */
-          gtpu_hdr_len0 = sizeof(gtpu_header_t) - (((ver0 & GTPU_E_S_PN_BIT) == 0) * 4);
+ next00:
+  /* Pop gtpu header */
+  vlib_buffer_advance (b0, gtpu_hdr_len0);
 
-          has_space0 = vlib_buffer_has_space (b0, gtpu_hdr_len0);
+  next0 = t0->decap_next_index;
+  sw_if_index0 = t0->sw_if_index;
+  len0 = vlib_buffer_length_in_chain (vm, b0);
 
-	  if (PREDICT_FALSE (((ver0 & GTPU_VER_MASK) != GTPU_V1_VER) | (!has_space0)))
-            {
-	      error0 = has_space0 ? GTPU_ERROR_BAD_VER : GTPU_ERROR_TOO_SMALL;
-              next0 = GTPU_INPUT_NEXT_DROP;
-              goto trace00;
-            }
+  /* Required to make the l2 tag push / pop code work on l2 subifs */
+  if (PREDICT_TRUE(next0 == GTPU_INPUT_NEXT_L2_INPUT))
+    vnet_update_l2_len (b0);
 
-          if (is_ip4) {
-            key4_0.src = ip4_0->src_address.as_u32;
-            key4_0.teid = gtpu0->teid;
+  /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
+  vnet_buffer(b0)->sw_if_index[VLIB_RX] = sw_if_index0;
+  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
 
- 	    /* Make sure GTPU tunnel exist according to packet SIP and teid
- 	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
-            if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
-              {
-                p0 = hash_get (gtm->gtpu4_tunnel_by_key, key4_0.as_u64);
-                if (PREDICT_FALSE (p0 == NULL))
-                  {
-                    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next0 = GTPU_INPUT_NEXT_DROP;
-                    goto trace00;
-                  }
-                last_key4.as_u64 = key4_0.as_u64;
-                tunnel_index0 = last_tunnel_index = p0[0];
-              }
-            else
-              tunnel_index0 = last_tunnel_index;
-	    t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
-
-	    /* Validate GTPU tunnel encap-fib index against packet */
-	    if (PREDICT_FALSE (validate_gtpu_fib (b0, t0, is_ip4) == 0))
-	      {
-		error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-		next0 = GTPU_INPUT_NEXT_DROP;
-		goto trace00;
-	      }
-
-	    /* Validate GTPU tunnel SIP against packet DIP */
-	    if (PREDICT_TRUE (ip4_0->dst_address.as_u32 == t0->src.ip4.as_u32))
-	      goto next00; /* valid packet */
-	    if (PREDICT_FALSE (ip4_address_is_multicast (&ip4_0->dst_address)))
-	      {
-		key4_0.src = ip4_0->dst_address.as_u32;
-		key4_0.teid = gtpu0->teid;
-		/* Make sure mcast GTPU tunnel exist by packet DIP and teid */
-		p0 = hash_get (gtm->gtpu4_tunnel_by_key, key4_0.as_u64);
-		if (PREDICT_TRUE (p0 != NULL))
-		  {
-		    mt0 = pool_elt_at_index (gtm->tunnels, p0[0]);
-		    goto next00; /* valid packet */
-		  }
-	      }
-	    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-	    next0 = GTPU_INPUT_NEXT_DROP;
-	    goto trace00;
-
-          } else /* !is_ip4 */ {
-            key6_0.src.as_u64[0] = ip6_0->src_address.as_u64[0];
-            key6_0.src.as_u64[1] = ip6_0->src_address.as_u64[1];
-            key6_0.teid = gtpu0->teid;
-
- 	    /* Make sure GTPU tunnel exist according to packet SIP and teid
- 	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
-            if (PREDICT_FALSE (memcmp(&key6_0, &last_key6, sizeof(last_key6)) != 0))
-              {
-                p0 = hash_get_mem (gtm->gtpu6_tunnel_by_key, &key6_0);
-                if (PREDICT_FALSE (p0 == NULL))
-                  {
-                    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next0 = GTPU_INPUT_NEXT_DROP;
-                    goto trace00;
-                  }
-                clib_memcpy_fast (&last_key6, &key6_0, sizeof(key6_0));
-                tunnel_index0 = last_tunnel_index = p0[0];
-              }
-            else
-              tunnel_index0 = last_tunnel_index;
-	    t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
-
-	    /* Validate GTPU tunnel encap-fib index against packet */
-	    if (PREDICT_FALSE (validate_gtpu_fib (b0, t0, is_ip4) == 0))
-	      {
-		error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-		next0 = GTPU_INPUT_NEXT_DROP;
-		goto trace00;
-	      }
-
-	    /* Validate GTPU tunnel SIP against packet DIP */
-	    if (PREDICT_TRUE (ip6_address_is_equal (&ip6_0->dst_address,
-						    &t0->src.ip6)))
-		goto next00; /* valid packet */
-	    if (PREDICT_FALSE (ip6_address_is_multicast (&ip6_0->dst_address)))
-	      {
-		key6_0.src.as_u64[0] = ip6_0->dst_address.as_u64[0];
-		key6_0.src.as_u64[1] = ip6_0->dst_address.as_u64[1];
-		key6_0.teid = gtpu0->teid;
-		p0 = hash_get_mem (gtm->gtpu6_tunnel_by_key, &key6_0);
-		if (PREDICT_TRUE (p0 != NULL))
-		  {
-		    mt0 = pool_elt_at_index (gtm->tunnels, p0[0]);
-		    goto next00; /* valid packet */
-		  }
-	      }
-	    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-	    next0 = GTPU_INPUT_NEXT_DROP;
-	    goto trace00;
-          }
+  ctx->pkts_decapsulated ++;
 
-	next00:
-	  /* Pop gtpu header */
-	  vlib_buffer_advance (b0, gtpu_hdr_len0);
+  /* Batch stats increment on the same gtpu tunnel so counter
+     is not incremented per packet */
+  if (PREDICT_FALSE (sw_if_index0 != ctx->stats_sw_if_index))
+    {
+      if (ctx->stats_n_packets)
+	vlib_increment_combined_counter
+	  (ctx->rx_counter, ctx->thread_index, ctx->stats_sw_if_index,
+	   ctx->stats_n_packets, ctx->stats_n_bytes);
+      ctx->stats_n_packets = 0;
+      ctx->stats_n_bytes = 0;
+      ctx->stats_sw_if_index = sw_if_index0;
+    }
+  ctx->stats_n_packets += 1;
+  ctx->stats_n_bytes += len0;
 
-	  next0 = t0->decap_next_index;
-	  sw_if_index0 = t0->sw_if_index;
-	  len0 = vlib_buffer_length_in_chain (vm, b0);
+ trace00:
+  b0->error = error0 ? node->errors[error0] : 0;
 
-          /* Required to make the l2 tag push / pop code work on l2 subifs */
-          if (PREDICT_TRUE(next0 == GTPU_INPUT_NEXT_L2_INPUT))
-            vnet_update_l2_len (b0);
+  if (PREDICT_FALSE(b0->flags & VLIB_BUFFER_IS_TRACED))
+    {
+      gtpu_rx_trace_t *tr
+	= vlib_add_trace (vm, node, b0, sizeof (*tr));
+      tr->next_index = next0;
+      tr->error = error0;
+      tr->tunnel_index = tunnel_index0;
+      tr->teid = has_space0 ? clib_net_to_host_u32(gtpu0->teid) : ~0;
+    }
 
-          /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
-          vnet_buffer(b0)->sw_if_index[VLIB_RX] = sw_if_index0;
-	  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
+  return next0;
+}
 
-          pkts_decapsulated ++;
-          stats_n_packets += 1;
-          stats_n_bytes += len0;
+static_always_inline u16
+gtpu4_decap (vlib_main_t * vm, vlib_node_runtime_t * node,
+	     vlib_buffer_t * b0, void * key, void * ctx)
+{
+  return gtpu_decap_one (vm, node, b0, key, ctx, /* is_ip4 */ 1);
+}
 
-	  /* Batch stats increment on the same gtpu tunnel so counter
-	     is not incremented per packet */
-	  if (PREDICT_FALSE (sw_if_index0 != stats_sw_if_index))
-	    {
-	      stats_n_packets -= 1;
-	      stats_n_bytes -= len0;
-	      if (stats_n_packets)
-		vlib_increment_combined_counter
-		  (im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
-		   thread_index, stats_sw_if_index,
-		   stats_n_packets, stats_n_bytes);
-	      stats_n_packets = 1;
-	      stats_n_bytes = len0;
-	      stats_sw_if_index = sw_if_index0;
-	    }
+static_always_inline u16
+gtpu6_decap (vlib_main_t * vm, vlib_node_runtime_t * node,
+	     vlib_buffer_t * b0, void * key, void * ctx)
+{
+  return gtpu_decap_one (vm, node, b0, key, ctx, /* is_ip4 */ 0);
+}
 
-        trace00:
-          b0->error = error0 ? node->errors[error0] : 0;
+always_inline uword
+gtpu_input (vlib_main_t * vm,
+             vlib_node_runtime_t * node,
+             vlib_frame_t * from_frame,
+             u32 is_ip4)
+{
+  gtpu_main_t * gtm = &gtpu_main;
+  vnet_interface_main_t * im = &gtm->vnet_main->interface_main;
+  gtpu_decap_ctx_t ctx = {
+    .rx_counter = im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
+    .thread_index = vm->thread_index,
+    .stats_sw_if_index = node->runtime_data[0],
+  };
 
-          if (PREDICT_FALSE(b0->flags & VLIB_BUFFER_IS_TRACED))
-            {
-              gtpu_rx_trace_t *tr
-                = vlib_add_trace (vm, node, b0, sizeof (*tr));
-              tr->next_index = next0;
-              tr->error = error0;
-              tr->tunnel_index = tunnel_index0;
-              tr->teid = has_space0 ? clib_net_to_host_u32(gtpu0->teid) : ~0;
-            }
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
-	}
+  if (is_ip4)
+    udp_tunnel_decap_inline (vm, node, from_frame, &gtm->gtpu4_tunnel_by_key,
+			     /* is_ip4 */ 1, gtpu4_key, 0, gtpu4_decap, &ctx);
+  else
+    udp_tunnel_decap_inline (vm, node, from_frame, &gtm->gtpu6_tunnel_by_key,
+			     /* is_ip4 */ 0, 0, gtpu6_key, gtpu6_decap, &ctx);
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-    }
   /* Do we still need this now that tunnel tx stats is kept? */
   vlib_node_increment_counter (vm, is_ip4?
 			       gtpu4_input_node.index:gtpu6_input_node.index,
                                GTPU_ERROR_DECAPSULATED,
-                               pkts_decapsulated);
+                               ctx.pkts_decapsulated);
 
   /* Increment any remaining batch stats */
-  if (stats_n_packets)
+  if (ctx.stats_n_packets)
     {
       vlib_increment_combined_counter
-	(im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
-	 thread_index, stats_sw_if_index, stats_n_packets, stats_n_bytes);
-      node->runtime_data[0] = stats_sw_if_index;
+	(ctx.rx_counter, ctx.thread_index, ctx.stats_sw_if_index,
+	 ctx.stats_n_packets, ctx.stats_n_bytes);
+      node->runtime_data[0] = ctx.stats_sw_if_index;
     }
 
   return from_frame->n_vectors;
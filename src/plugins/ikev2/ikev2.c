@@ -2289,7 +2289,7 @@ ikev2_generate_message (vlib_buffer_t *b, ikev2_sa_t *sa, ike_header_t *ike,
 			void *user, udp_header_t *udp, ikev2_stats_t *stats)
 {
   ikev2_main_t *km = &ikev2_main;
-  u16 buffer_data_size = vlib_buffer_get_default_data_size (km->vlib_main);
+  u16 buffer_data_size = vlib_buffer_get_data_size (km->vlib_main, b);
   v8 *integ = 0;
   ike_payload_header_t *ph;
   u16 plen;
@@ -16,6 +16,7 @@
 #include <vnet/vnet.h>
 #include <vnet/plugin/plugin.h>
 #include <lb/lb.h>
+#include <lb/maglev.h>
 
 #include <vppinfra/byte_order.h>
 #include <vppinfra/string.h>
@@ -155,12 +156,46 @@ vl_api_lb_add_del_as_t_handler
   if (mp->is_del)
     rv = lb_vip_del_ass(vip_index, &as_address, 1, mp->is_flush);
   else
-    rv = lb_vip_add_ass(vip_index, &as_address, 1);
+    rv = lb_vip_add_ass(vip_index, &as_address, 1, LB_AS_WEIGHT_KEEP);
 
 done:
  REPLY_MACRO (VL_API_LB_ADD_DEL_AS_REPLY);
 }
 
+static void
+vl_api_lb_add_del_as_v2_t_handler
+(vl_api_lb_add_del_as_v2_t * mp)
+{
+  lb_main_t *lbm = &lb_main;
+  vl_api_lb_add_del_as_v2_reply_t * rmp;
+  int rv = 0;
+  u32 vip_index;
+  ip46_address_t vip_ip_prefix;
+  ip46_address_t as_address;
+
+  /* if port == 0, it means all-port VIP */
+  if (mp->port == 0)
+    {
+      mp->protocol = ~0;
+    }
+  ip_address_decode (&mp->pfx.address, &vip_ip_prefix);
+  ip_address_decode (&mp->as_address, &as_address);
+
+  if ((rv = lb_vip_find_index(&vip_ip_prefix, mp->pfx.len,
+                              mp->protocol, ntohs(mp->port), &vip_index)))
+    goto done;
+
+  if (mp->is_del)
+    rv = lb_vip_del_ass(vip_index, &as_address, 1, mp->is_flush);
+  else if (ntohl(mp->weight) == 0 || ntohl(mp->weight) > LB_AS_WEIGHT_MAX)
+    rv = VNET_API_ERROR_INVALID_VALUE;
+  else
+    rv = lb_vip_add_ass(vip_index, &as_address, 1, ntohl(mp->weight));
+
+done:
+ REPLY_MACRO (VL_API_LB_ADD_DEL_AS_V2_REPLY);
+}
+
 static void
 vl_api_lb_vip_dump_t_handler
 (vl_api_lb_vip_dump_t * mp)
@@ -15,6 +15,7 @@
 
 #include <lb/lb.h>
 #include <lb/util.h>
+#include <lb/maglev.h>
 
 static clib_error_t *
 lb_vip_command_fn (vlib_main_t * vm,
@@ -199,6 +200,7 @@ lb_as_command_fn (vlib_main_t * vm,
   ip46_address_t *as_array = 0;
   u32 vip_index;
   u32 port = 0;
+  u32 weight = LB_AS_WEIGHT_KEEP;
   u8 protocol = 0;
   u8 del = 0;
   u8 flush = 0;
@@ -223,6 +225,15 @@ lb_as_command_fn (vlib_main_t * vm,
       {
         vec_add1(as_array, as_addr);
       }
+    else if (unformat(line_input, "weight %u", &weight))
+      {
+        if (weight == 0 || weight > LB_AS_WEIGHT_MAX)
+          {
+            error = clib_error_return (0, "weight must be 1 to %u",
+                                       LB_AS_WEIGHT_MAX);
+            goto done;
+          }
+      }
     else if (unformat(line_input, "del"))
       {
         del = 1;
@@ -275,7 +286,8 @@ lb_as_command_fn (vlib_main_t * vm,
       goto done;
     }
   } else {
-    if ((ret = lb_vip_add_ass(vip_index, as_array, vec_len(as_array))))
+    if ((ret = lb_vip_add_ass(vip_index, as_array, vec_len(as_array),
+                              weight)))
     {
       error = clib_error_return (0, "lb_vip_add_ass error %d", ret);
       goto done;
@@ -293,7 +305,7 @@ VLIB_CLI_COMMAND (lb_as_command, static) =
 {
   .path = "lb as",
   .short_help = "lb as <vip-prefix> [protocol (tcp|udp) port <n>]"
-      " [<address> [<address> [...]]] [del] [flush]",
+      " [<address> [<address> [...]]] [weight <n>] [del] [flush]",
   .function = lb_as_command_fn,
 };
 
@@ -308,6 +320,7 @@ lb_conf_command_fn (vlib_main_t * vm,
   u32 per_cpu_sticky_buckets = lbm->per_cpu_sticky_buckets;
   u32 per_cpu_sticky_buckets_log2 = 0;
   u32 flow_timeout = lbm->flow_timeout;
+  u8 maglev_incremental = lbm->maglev_incremental;
   int ret;
   clib_error_t *error = 0;
 
@@ -328,6 +341,10 @@ lb_conf_command_fn (vlib_main_t * vm,
       per_cpu_sticky_buckets = 1 << per_cpu_sticky_buckets_log2;
     } else if (unformat(line_input, "timeout %d", &flow_timeout))
       ;
+    else if (unformat(line_input, "maglev incremental"))
+      maglev_incremental = 1;
+    else if (unformat(line_input, "maglev full"))
+      maglev_incremental = 0;
     else {
       error = clib_error_return (0, "parse error: '%U'",
                                  format_unformat_error, line_input);
@@ -342,6 +359,8 @@ lb_conf_command_fn (vlib_main_t * vm,
     goto done;
   }
 
+  lb_conf_maglev(maglev_incremental);
+
 done:
   unformat_free (line_input);
 
@@ -351,7 +370,7 @@ done:
 VLIB_CLI_COMMAND (lb_conf_command, static) =
 {
   .path = "lb conf",
-  .short_help = "lb conf [ip4-src-address <addr>] [ip6-src-address <addr>] [buckets <n>] [timeout <s>]",
+  .short_help = "lb conf [ip4-src-address <addr>] [ip6-src-address <addr>] [buckets <n>] [timeout <s>] [maglev (incremental|full)]",
   .function = lb_conf_command_fn,
 };
 
@@ -591,3 +610,141 @@ VLIB_CLI_COMMAND (lb_flowtable_flush_command, static) =
   .short_help = "test lb flowtable flush",
   .function = lb_flowtable_flush_command_fn,
 };
+
+//Every bucket is owned, and every AS owns its share
+static clib_error_t *
+lb_maglev_test_check (char *what, lb_maglev_as_t *ass, u32 *table)
+{
+  lb_maglev_as_t *as;
+  u64 total_weight = 0, n_owned = 0;
+  u32 i;
+
+  vec_foreach(as, ass)
+    total_weight += as->weight;
+
+  vec_foreach(as, ass) {
+    u32 count = 0;
+    for (i = 0; i < vec_len(table); i++)
+      count += (table[i] == as->as_index);
+    if (count != as->count || count != as->target ||
+        count < (u64) as->weight * vec_len(table) / total_weight)
+      return clib_error_return (0, "%s: AS %u weight %u owns %u buckets, "
+                                "share %u", what, as->as_index, as->weight,
+                                count, as->target);
+    n_owned += count;
+  }
+  if (n_owned != vec_len(table))
+    return clib_error_return (0, "%s: %lu of %u buckets owned", what,
+                              n_owned, vec_len(table));
+  return 0;
+}
+
+static clib_error_t *
+lb_maglev_test_rebuild (vlib_main_t * vm, char *what, lb_maglev_as_t *ass,
+                        u32 *old_table, u32 *table)
+{
+  clib_error_t *error;
+  u64 t_full, t_incr;
+  u32 moved_full, moved_incr;
+
+  t_full = clib_cpu_time_now();
+  moved_full = lb_maglev_build(ass, table, old_table, 0);
+  t_full = clib_cpu_time_now() - t_full;
+  if ((error = lb_maglev_test_check(what, ass, table)))
+    return error;
+
+  t_incr = clib_cpu_time_now();
+  moved_incr = lb_maglev_build(ass, table, old_table, 1);
+  t_incr = clib_cpu_time_now() - t_incr;
+  if ((error = lb_maglev_test_check(what, ass, table)))
+    return error;
+
+  vlib_cli_output(vm, "%s: full %.2f%% remapped in %.2f Mclocks, "
+                  "incremental %.2f%% remapped in %.2f Mclocks", what,
+                  100.0 * moved_full / vec_len(table), t_full * 1e-6,
+                  100.0 * moved_incr / vec_len(table), t_incr * 1e-6);
+  return 0;
+}
+
+static clib_error_t *
+lb_maglev_test_command_fn (vlib_main_t * vm,
+              unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  u32 n_ass = 1000, new_len = 1 << 16, heavy = 2, i;
+  u32 *table = 0, *old_table = 0;
+  lb_maglev_as_t *ass = 0, *as, removed;
+  u64 seed = 0xdeadbeef, t0;
+  clib_error_t *error = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+  {
+    if (unformat(input, "ass %u", &n_ass))
+      ;
+    else if (unformat(input, "new_len %u", &new_len))
+      ;
+    else if (unformat(input, "weight %u", &heavy))
+      ;
+    else
+      return clib_error_return (0, "parse error: '%U'",
+                                format_unformat_error, input);
+  }
+
+  if (n_ass < 2 || !is_pow2(new_len))
+    return clib_error_return (0, "need 2 ASs or more and a power of 2 "
+                              "new_len");
+  if (heavy == 0 || heavy > LB_AS_WEIGHT_MAX / 2)
+    return clib_error_return (0, "weight must be 1 to %u",
+                              LB_AS_WEIGHT_MAX / 2);
+
+  //One in four AS is heavier
+  for (i = 0; i < n_ass; i++) {
+    vec_add2(ass, as, 1);
+    as->seed = random_u64(&seed);
+    as->weight = (i & 3) ? 1 : heavy;
+    as->as_index = i + 1;
+  }
+
+  vec_validate(table, new_len - 1);
+  vec_validate(old_table, new_len - 1);
+
+  t0 = clib_cpu_time_now();
+  lb_maglev_build(ass, old_table, 0, 0);
+  vlib_cli_output(vm, "%u ASs, %u buckets: built in %.2f Mclocks",
+                  n_ass, new_len, (clib_cpu_time_now() - t0) * 1e-6);
+  if ((error = lb_maglev_test_check("build", ass, old_table)))
+    goto done;
+
+  //Remove an AS, then add it back
+  removed = ass[n_ass / 2];
+  vec_delete(ass, 1, n_ass / 2);
+  if ((error = lb_maglev_test_rebuild(vm, "remove", ass, old_table, table)))
+    goto done;
+
+  clib_memcpy_fast(old_table, table, new_len * sizeof(table[0]));
+  vec_insert_elts(ass, &removed, 1, n_ass / 2);
+  if ((error = lb_maglev_test_rebuild(vm, "add", ass, old_table, table)))
+    goto done;
+
+  //Double the weight of an AS
+  clib_memcpy_fast(old_table, table, new_len * sizeof(table[0]));
+  ass[0].weight *= 2;
+  error = lb_maglev_test_rebuild(vm, "reweight", ass, old_table, table);
+
+done:
+
+  vec_free(ass);
+  vec_free(table);
+  vec_free(old_table);
+  return error;
+}
+
+/*
+ * Maglev table build time and remapped flows when ASs change
+ * This is indented for debug and unit-tests purposes only
+ */
+VLIB_CLI_COMMAND (lb_maglev_test_command, static) =
+{
+  .path = "test lb maglev",
+  .short_help = "test lb maglev [ass <n>] [new_len <n>] [weight <n>]",
+  .function = lb_maglev_test_command_fn,
+};
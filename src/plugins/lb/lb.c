@@ -14,6 +14,7 @@
  */
 
 #include <lb/lb.h>
+#include <lb/maglev.h>
 #include <vnet/plugin/plugin.h>
 #include <vpp/app/version.h>
 #include <vnet/api_errno.h>
@@ -107,6 +108,7 @@ u8 *format_lb_main (u8 * s, va_list * args)
   s = format(s, " ip6-src-address: %U \n", format_ip6_address, &lbm->ip6_src_address);
   s = format(s, " #vips: %u\n", pool_elts(lbm->vips));
   s = format(s, " #ass: %u\n", pool_elts(lbm->ass) - 1);
+  s = format(s, " maglev: %s\n", lbm->maglev_incremental ? "incremental" : "full");
 
   u32 thread_index;
   for(thread_index = 0; thread_index < tm->n_vlib_mains; thread_index++ ) {
@@ -257,10 +259,10 @@ u8 *format_lb_vip_detailed (u8 * s, va_list * args)
   u32 *as_index;
   pool_foreach (as_index, vip->as_indexes) {
       as = &lbm->ass[*as_index];
-      s = format(s, "%U    %U %u buckets   %Lu flows  dpo:%u %s\n",
+      s = format(s, "%U    %U weight:%u %u buckets   %Lu flows  dpo:%u %s\n",
                    format_white_space, indent,
                    format_ip46_address, &as->address, IP46_TYPE_ANY,
-                   count[as - lbm->ass],
+                   as->weight, count[as - lbm->ass],
                    vlib_refcount_get(&lbm->as_refcount, as - lbm->ass),
                    as->dpo.dpoi_index,
                    (as->flags & LB_AS_FLAGS_USED)?"used":" removed");
@@ -270,18 +272,12 @@ u8 *format_lb_vip_detailed (u8 * s, va_list * args)
   return s;
 }
 
-typedef struct {
-  u32 as_index;
-  u32 last;
-  u32 skip;
-} lb_pseudorand_t;
-
-static int lb_pseudorand_compare(void *a, void *b)
+static int lb_maglev_as_compare(void *a, void *b)
 {
   lb_as_t *asa, *asb;
   lb_main_t *lbm = &lb_main;
-  asa = &lbm->ass[((lb_pseudorand_t *)a)->as_index];
-  asb = &lbm->ass[((lb_pseudorand_t *)b)->as_index];
+  asa = &lbm->ass[((lb_maglev_as_t *)a)->as_index];
+  asb = &lbm->ass[((lb_maglev_as_t *)b)->as_index];
   return memcmp(&asa->address, &asb->address, sizeof(asb->address));
 }
 
@@ -386,88 +382,44 @@ static void lb_vip_update_new_flow_table(lb_vip_t *vip)
   u32 i, *as_index;
   lb_new_flow_entry_t *new_flow_table = 0;
   lb_as_t *as;
-  lb_pseudorand_t *pr, *sort_arr = 0;
+  lb_maglev_as_t *mas, *maglev_ass = 0;
 
   CLIB_SPINLOCK_ASSERT_LOCKED (&lbm->writer_lock); // We must have the lock
 
-  //Check if some AS is configured or not
-  i = 0;
+  STATIC_ASSERT (sizeof (lb_new_flow_entry_t) == sizeof (u32),
+                 "new flow entries are built as u32 tables");
+
+  vec_validate(new_flow_table, vip->new_flow_table_mask);
+
+  //Collect the ASs which are still used
   pool_foreach (as_index, vip->as_indexes) {
       as = &lbm->ass[*as_index];
-      if (as->flags & LB_AS_FLAGS_USED) { //Not used anymore
-        i = 1;
-        goto out; //Not sure 'break' works in this macro-loop
-      }
+      if (!(as->flags & LB_AS_FLAGS_USED)) //Not used anymore
+        continue;
+
+      vec_add2(maglev_ass, mas, 1);
+      mas->as_index = as - lbm->ass;
+      mas->weight = as->weight;
+      mas->seed = clib_xxhash(as->address.as_u64[0] ^
+                              as->address.as_u64[1]);
   }
 
-out:
-  if (i == 0) {
+  if (vec_len(maglev_ass) == 0) {
     //Only the default. i.e. no AS
-    vec_validate(new_flow_table, vip->new_flow_table_mask);
     for (i=0; i<vec_len(new_flow_table); i++)
       new_flow_table[i].as_index = 0;
 
     goto finished;
   }
 
-  //First, let's sort the ASs
-  vec_alloc(sort_arr, pool_elts(vip->as_indexes));
-
-  i = 0;
-  pool_foreach (as_index, vip->as_indexes) {
-      as = &lbm->ass[*as_index];
-      if (!(as->flags & LB_AS_FLAGS_USED)) //Not used anymore
-        continue;
-
-      sort_arr[i].as_index = as - lbm->ass;
-      i++;
-  }
-  _vec_len(sort_arr) = i;
-
-  vec_sort_with_function(sort_arr, lb_pseudorand_compare);
-
-  //Now let's pseudo-randomly generate permutations
-  vec_foreach(pr, sort_arr) {
-    lb_as_t *as = &lbm->ass[pr->as_index];
-
-    u64 seed = clib_xxhash(as->address.as_u64[0] ^
-                           as->address.as_u64[1]);
-    /* We have 2^n buckets.
-     * skip must be prime with 2^n.
-     * So skip must be odd.
-     * MagLev actually state that M should be prime,
-     * but this has a big computation cost (% operation).
-     * Using 2^n is more better (& operation).
-     */
-    pr->skip = ((seed & 0xffffffff) | 1) & vip->new_flow_table_mask;
-    pr->last = (seed >> 32) & vip->new_flow_table_mask;
-  }
+  //Sort the ASs so that the table only depends on the configuration
+  vec_sort_with_function(maglev_ass, lb_maglev_as_compare);
 
-  //Let's create a new flow table
-  vec_validate(new_flow_table, vip->new_flow_table_mask);
-  for (i=0; i<vec_len(new_flow_table); i++)
-    new_flow_table[i].as_index = 0;
-
-  u32 done = 0;
-  while (1) {
-    vec_foreach(pr, sort_arr) {
-      while (1) {
-        u32 last = pr->last;
-        pr->last = (pr->last + pr->skip) & vip->new_flow_table_mask;
-        if (new_flow_table[last].as_index == 0) {
-          new_flow_table[last].as_index = pr->as_index;
-          break;
-        }
-      }
-      done++;
-      if (done == vec_len(new_flow_table))
-        goto finished;
-    }
-  }
+  lb_maglev_build(maglev_ass, (u32 *) new_flow_table,
+                  (u32 *) vip->new_flow_table, lbm->maglev_incremental);
 
 finished:
-  vec_free(sort_arr);
-
+  vec_free(maglev_ass);
   old_table = vip->new_flow_table;
   vip->new_flow_table = new_flow_table;
   vec_free(old_table);
@@ -490,6 +442,15 @@ int lb_conf(ip4_address_t *ip4_address, ip6_address_t *ip6_address,
   return 0;
 }
 
+void lb_conf_maglev(u8 incremental)
+{
+  lb_main_t *lbm = &lb_main;
+
+  lb_get_writer_lock();
+  lbm->maglev_incremental = incremental;
+  lb_put_writer_lock();
+}
+
 
 
 static
@@ -582,7 +543,8 @@ static int lb_as_find_index_vip(lb_vip_t *vip, ip46_address_t *address, u32 *as_
   return -1;
 }
 
-int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n)
+int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n,
+                   u32 weight)
 {
   lb_main_t *lbm = &lb_main;
   lb_get_writer_lock();
@@ -592,6 +554,12 @@ int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n)
     return VNET_API_ERROR_NO_SUCH_ENTRY;
   }
 
+  if (weight == 0 ||
+      (weight > LB_AS_WEIGHT_MAX && weight != LB_AS_WEIGHT_KEEP)) {
+    lb_put_writer_lock();
+    return VNET_API_ERROR_INVALID_VALUE;
+  }
+
   ip46_type_t type = lb_encap_is_ip4(vip)?IP46_TYPE_IP4:IP46_TYPE_IP6;
   u32 *to_be_added = 0;
   u32 *to_be_updated = 0;
@@ -603,7 +571,9 @@ int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n)
   while (n--) {
 
     if (!lb_as_find_index_vip(vip, &addresses[n], &i)) {
-      if (lbm->ass[i].flags & LB_AS_FLAGS_USED) {
+      //Used ASs can only be given a new weight
+      if ((lbm->ass[i].flags & LB_AS_FLAGS_USED) &&
+          (weight == LB_AS_WEIGHT_KEEP || lbm->ass[i].weight == weight)) {
         vec_free(to_be_added);
         vec_free(to_be_updated);
         lb_put_writer_lock();
@@ -637,6 +607,8 @@ next:
   //Update reused ASs
   vec_foreach(ip, to_be_updated) {
     lbm->ass[*ip].flags = LB_AS_FLAGS_USED;
+    if (weight != LB_AS_WEIGHT_KEEP)
+      lbm->ass[*ip].weight = weight;
   }
   vec_free(to_be_updated);
 
@@ -647,6 +619,7 @@ next:
     pool_get(lbm->ass, as);
     as->address = addresses[*ip];
     as->flags = LB_AS_FLAGS_USED;
+    as->weight = (weight == LB_AS_WEIGHT_KEEP) ? 1 : weight;
     as->vip_index = vip_index;
     pool_get(vip->as_indexes, as_index);
     *as_index = as - lbm->ass;
@@ -145,6 +145,11 @@ typedef struct {
    */
   u32 last_used;
 
+  /**
+   * Relative share of the VIP new flow table given to this AS.
+   */
+  u32 weight;
+
   /**
    * The FIB entry index for the next-hop
    */
@@ -526,6 +531,12 @@ typedef struct {
    */
   u32 flow_timeout;
 
+  /**
+   * Rebuild the VIP new flow tables from the previous ones when the set
+   * of ASs changes, rather than from scratch. See maglev.h.
+   */
+  u8 maglev_incremental;
+
   /**
    * Per VIP counter
    */
@@ -599,6 +610,13 @@ extern vlib_node_registration_t lb_nat6_in2out_node;
 int lb_conf(ip4_address_t *ip4_address, ip6_address_t *ip6_address,
             u32 sticky_buckets, u32 flow_timeout);
 
+/**
+ * Choose how VIP new flow tables are rebuilt.
+ * @param incremental rebuild from the previous table to bound the number
+ *        of remapped flows, rather than from scratch.
+ */
+void lb_conf_maglev(u8 incremental);
+
 int lb_vip_add(lb_vip_add_args_t args, u32 *vip_index);
 
 int lb_vip_del(u32 vip_index);
@@ -608,7 +626,18 @@ int lb_vip_find_index(ip46_address_t *prefix, u8 plen, u8 protocol,
 
 #define lb_vip_get_by_index(index) (pool_is_free_index(lb_main.vips, index)?NULL:pool_elt_at_index(lb_main.vips, index))
 
-int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n);
+/**
+ * Weight of lb_vip_add_ass leaving the weight of existing ASs unchanged,
+ * new ASs get a weight of 1.
+ */
+#define LB_AS_WEIGHT_KEEP ((u32) ~0)
+
+/**
+ * Add ASs to a VIP, or change the weight of existing ones.
+ * @param weight from 1 to LB_AS_WEIGHT_MAX, or LB_AS_WEIGHT_KEEP.
+ */
+int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n,
+                   u32 weight);
 int lb_vip_del_ass(u32 vip_index, ip46_address_t *addresses, u32 n, u8 flush);
 int lb_flush_vip_as (u32 vip_index, u32 as_index);
 
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <lb/maglev.h>
+#include <vppinfra/vec.h>
+
+#define LB_MAGLEV_FREE ((u32) ~0)
+
+u32 lb_maglev_build(lb_maglev_as_t *ass, u32 *table, const u32 *old_table,
+                    int incremental)
+{
+  u32 len = vec_len(table), mask = len - 1;
+  u32 i, p, n_extra = len, n_free = len, n_moved = 0;
+  u32 *position = 0; //as_index -> 1 + index in ass
+  u64 total_weight = 0;
+  lb_maglev_as_t *as;
+
+  ASSERT(is_pow2(len));
+  ASSERT(vec_len(ass));
+
+  if (old_table && vec_len(old_table) != len)
+    old_table = 0;
+  if (!old_table)
+    incremental = 0;
+
+  vec_foreach(as, ass)
+    total_weight += as->weight;
+
+  vec_foreach(as, ass) {
+    as->target = ((u64) as->weight * len) / total_weight;
+    as->count = 0;
+    n_extra -= as->target;
+
+    /* We have 2^n buckets.
+     * skip must be prime with 2^n.
+     * So skip must be odd.
+     * MagLev actually state that M should be prime,
+     * but this has a big computation cost (% operation).
+     * Using 2^n is more better (& operation).
+     */
+    as->skip = ((as->seed & 0xffffffff) | 1) & mask;
+    as->next = (as->seed >> 32) & mask;
+
+    vec_validate(position, as->as_index);
+    position[as->as_index] = as - ass + 1;
+  }
+
+  /* Shares are rounded down, hand out the remaining buckets.
+   * Favour the ASs which already own them when rebuilding. */
+  if (incremental) {
+    for (i = 0; i < len; i++)
+      if (old_table[i] < vec_len(position) && (p = position[old_table[i]]))
+        ass[p - 1].count++;
+    vec_foreach(as, ass) {
+      if (n_extra && as->count > as->target) {
+        as->target++;
+        n_extra--;
+      }
+      as->count = 0;
+    }
+  }
+  vec_foreach(as, ass) {
+    if (!n_extra)
+      break;
+    as->target++;
+    n_extra--;
+  }
+
+  for (i = 0; i < len; i++)
+    table[i] = LB_MAGLEV_FREE;
+
+  if (incremental) {
+    //Keep the buckets of ASs which are still within their share
+    for (i = 0; i < len; i++) {
+      p = old_table[i] < vec_len(position) ? position[old_table[i]] : 0;
+      if (p && ass[p - 1].count < ass[p - 1].target) {
+        table[i] = old_table[i];
+        ass[p - 1].count++;
+        n_free--;
+      }
+    }
+  }
+
+  //ASs take turns to claim their next preferred free bucket
+  while (n_free) {
+    u32 n_claimed = 0;
+    vec_foreach(as, ass) {
+      if (as->count == as->target)
+        continue;
+
+      while (table[as->next] != LB_MAGLEV_FREE)
+        as->next = (as->next + as->skip) & mask;
+
+      table[as->next] = as->as_index;
+      as->next = (as->next + as->skip) & mask;
+      as->count++;
+      n_claimed++;
+      if (--n_free == 0)
+        break;
+    }
+    //Shares add up to the table length, this is only a safety net
+    if (!n_claimed && n_free) {
+      for (i = 0, as = ass; i < len; i++)
+        if (table[i] == LB_MAGLEV_FREE) {
+          table[i] = as->as_index;
+          as->count++;
+          as = (as + 1 == vec_end(ass)) ? ass : as + 1;
+        }
+      n_free = 0;
+    }
+  }
+
+  if (old_table)
+    for (i = 0; i < len; i++)
+      n_moved += (table[i] != old_table[i]);
+
+  vec_free(position);
+  return n_moved;
+}
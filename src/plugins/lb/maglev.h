@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Weighted Maglev lookup table builder.
+ *
+ * Each AS is given a pseudo-random permutation of the table buckets,
+ * seeded by its address, and ASs take turns claiming their next
+ * preferred free bucket until each one owns its share of the table.
+ * Shares are proportional to the AS weights and exact, i.e. they add
+ * up to the table length.
+ *
+ * A full build only depends on the set of ASs and their weights, so
+ * every load-balancer sharing the same configuration computes the same
+ * table. An incremental build starts from the previous table instead,
+ * keeps every bucket whose AS is still under its share, and only
+ * reassigns the others. This bounds the number of remapped flows to the
+ * change in shares (e.g. 1/N of the table when adding the N-th AS) at
+ * the cost of the table depending on the configuration history.
+ */
+
+#ifndef LB_PLUGIN_LB_MAGLEV_H_
+#define LB_PLUGIN_LB_MAGLEV_H_
+
+#include <vppinfra/clib.h>
+
+/**
+ * Largest AS weight, i.e. ratio between the shares of two ASs.
+ */
+#define LB_AS_WEIGHT_MAX 0xffff
+
+typedef struct {
+  /**
+   * Seed of the bucket permutation. Derived from the AS address.
+   */
+  u64 seed;
+
+  /**
+   * Relative weight, from 1 to LB_AS_WEIGHT_MAX.
+   */
+  u32 weight;
+
+  /**
+   * Value written in the buckets owned by this AS.
+   */
+  u32 as_index;
+
+  //Filled in by the builder
+
+  /**
+   * Next bucket of the permutation and increment to the following one.
+   */
+  u32 next;
+  u32 skip;
+
+  /**
+   * Number of buckets this AS should own, and owns.
+   */
+  u32 target;
+  u32 count;
+} lb_maglev_as_t;
+
+/**
+ * Fill table, a vector whose length is a power of 2, with the as_index
+ * of the ASs.
+ * @param ass the ASs, ordered by address for the build to be canonical.
+ * @param table the table to fill.
+ * @param old_table the previous table, or NULL. Ignored if its length
+ *        differs from the one of table.
+ * @param incremental rebuild from old_table rather than from scratch.
+ * @return the number of buckets whose AS changed from old_table.
+ */
+u32 lb_maglev_build(lb_maglev_as_t *ass, u32 *table, const u32 *old_table,
+                    int incremental);
+
+#endif /* LB_PLUGIN_LB_MAGLEV_H_ */
@@ -119,7 +119,8 @@ ip4_map_fragment (vlib_main_t * vm, u32 bi, u16 mtu, bool df, u32 ** buffers,
 	vlib_buffer_t *p = vlib_get_buffer (vm, *i);
 	ip6_header_t *ip6 = vlib_buffer_get_current (p);
 	ip6->payload_length =
-	  clib_host_to_net_u16 (p->current_length - sizeof (ip6_header_t));
+	  clib_host_to_net_u16 (vlib_buffer_length_in_chain (vm, p) -
+				sizeof (ip6_header_t));
       }
     }
   else
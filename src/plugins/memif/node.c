@@ -22,6 +22,7 @@
 #include <sys/uio.h>
 
 #include <vlib/vlib.h>
+#include <vlib/copy.h>
 #include <vlib/unix/unix.h>
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/interface/rx_queue_funcs.h>
@@ -140,6 +141,52 @@ memif_add_to_chain (vlib_main_t * vm, vlib_buffer_t * b, u32 * buffers,
     }
 }
 
+static_always_inline void
+memif_device_input_release (memif_queue_t *mq, memif_ring_type_t type,
+			    u16 cur_slot)
+{
+  if (type == MEMIF_RING_S2M)
+    {
+      __atomic_store_n (&mq->ring->tail, cur_slot, __ATOMIC_RELEASE);
+      mq->last_head = cur_slot;
+    }
+  else
+    {
+      mq->last_tail = cur_slot;
+    }
+}
+
+static_always_inline void
+memif_device_input_refill (memif_if_t *mif, memif_queue_t *mq)
+{
+  memif_ring_t *ring = mq->ring;
+  u16 ring_size = 1 << mq->log2_ring_size;
+  u16 mask = ring_size - 1;
+  u16 head = ring->head;
+  u16 n_slots = ring_size - head + mq->last_tail;
+
+  while (n_slots--)
+    {
+      u16 s = head++ & mask;
+      memif_desc_t *d = &ring->desc[s];
+      d->length = mif->run.buffer_size;
+    }
+
+  __atomic_store_n (&ring->head, head, __ATOMIC_RELEASE);
+}
+
+static void
+memif_device_input_copy_done (vlib_main_t *vm, vlib_copy_batch_t *b)
+{
+  memif_main_t *mm = &memif_main;
+  memif_if_t *mif = pool_elt_at_index (mm->interfaces, b->cookie[0]);
+  memif_queue_t *mq = vec_elt_at_index (mif->rx_queues, b->cookie[1]);
+
+  memif_device_input_release (mq, b->cookie[2], b->cookie[3]);
+  if (b->cookie[2] == MEMIF_RING_M2S)
+    memif_device_input_refill (mif, mq);
+}
+
 static_always_inline uword
 memif_device_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 			   memif_if_t *mif, memif_ring_type_t type, u16 qid,
@@ -169,6 +216,7 @@ memif_device_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   memif_region_index_t last_region = ~0;
   void *last_region_shm = 0;
   void *last_region_max = 0;
+  int is_async = 0;
 
   mq = vec_elt_at_index (mif->rx_queues, qid);
   ring = mq->ring;
@@ -274,6 +322,28 @@ memif_device_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   /* copy data */
   n_left = vec_len (ptd->copy_ops);
   co = ptd->copy_ops;
+
+  /* in ip mode, the next node depends on the copied data */
+  if (vlib_copy_is_async () && mode == MEMIF_INTERFACE_MODE_ETHERNET)
+    {
+      /* copies complete before this node returns, and slots are only
+       * released to the peer once they do */
+      vlib_copy_batch_t *cb =
+	vlib_copy_batch_get (vm, memif_device_input_copy_done);
+      for (; n_left; n_left--, co++)
+	{
+	  b0 = vlib_get_buffer (vm, ptd->buffers[co->buffer_vec_index]);
+	  vlib_copy_batch_add (cb, b0->data + co->buffer_offset, co->data,
+			       co->data_len);
+	}
+      cb->cookie[0] = mif->dev_instance;
+      cb->cookie[1] = qid;
+      cb->cookie[2] = type;
+      cb->cookie[3] = cur_slot;
+      vlib_copy_batch_submit (vm, cb);
+      is_async = 1;
+    }
+
   while (n_left >= 8)
     {
       clib_prefetch_load (co[4].data);
@@ -308,15 +378,8 @@ memif_device_input_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
     }
 
   /* release slots from the ring */
-  if (type == MEMIF_RING_S2M)
-    {
-      __atomic_store_n (&ring->tail, cur_slot, __ATOMIC_RELEASE);
-      mq->last_head = cur_slot;
-    }
-  else
-    {
-      mq->last_tail = cur_slot;
-    }
+  if (!is_async)
+    memif_device_input_release (mq, type, cur_slot);
 
   /* prepare buffer template and next indices */
   vnet_buffer (&ptd->buffer_template)->sw_if_index[VLIB_RX] =
@@ -499,22 +562,26 @@ refill:
   vec_reset_length (ptd->buffers);
   vec_reset_length (ptd->copy_ops);
 
-  if (type == MEMIF_RING_M2S)
-    {
-      u16 head = ring->head;
-      n_slots = ring_size - head + mq->last_tail;
+  if (type == MEMIF_RING_M2S && !is_async)
+    memif_device_input_refill (mif, mq);
 
-      while (n_slots--)
-	{
-	  u16 s = head++ & mask;
-	  memif_desc_t *d = &ring->desc[s];
-	  d->length = mif->run.buffer_size;
-	}
+  return n_rx_packets;
+}
 
-      __atomic_store_n (&ring->head, head, __ATOMIC_RELEASE);
-    }
+static_always_inline void
+memif_device_input_zc_set_length (vlib_main_t *vm, vlib_node_runtime_t *node,
+				  vlib_buffer_t *b, memif_desc_t *d,
+				  i16 start_offset, u32 buffer_length)
+{
+  b->current_data = start_offset;
+  b->current_length = d->length;
 
-  return n_rx_packets;
+  /* the peer must not write past the buffer we gave it */
+  if (PREDICT_FALSE (d->length > buffer_length))
+    {
+      vlib_error_count (vm, node->node_index, MEMIF_INPUT_ERROR_BAD_DESC, 1);
+      b->current_length = buffer_length;
+    }
 }
 
 static_always_inline uword
@@ -568,6 +635,16 @@ memif_device_input_zc_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   while (n_slots && n_rx_packets < MEMIF_RX_VECTOR_SZ)
     {
       vlib_buffer_t *hb;
+      u16 n_segs = 1;
+
+      /* leave packets whose chain is not fully produced yet in the ring */
+      while (ring->desc[(cur_slot + n_segs - 1) & mask].flags &
+	     MEMIF_DESC_FLAG_NEXT)
+	{
+	  if (PREDICT_FALSE (n_segs == n_slots))
+	    goto chain_incomplete;
+	  n_segs++;
+	}
 
       s0 = cur_slot & mask;
       bi0 = mq->buffers[s0];
@@ -576,38 +653,40 @@ memif_device_input_zc_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       clib_prefetch_load (&ring->desc[(cur_slot + 8) & mask]);
       d0 = &ring->desc[s0];
       hb = b0 = vlib_get_buffer (vm, bi0);
-      b0->current_data = start_offset;
-      b0->current_length = d0->length;
-      n_rx_bytes += d0->length;
+      memif_device_input_zc_set_length (vm, node, b0, d0, start_offset,
+					buffer_length);
+      n_rx_bytes += b0->current_length;
 
       cur_slot++;
       n_slots--;
-      if (PREDICT_FALSE ((d0->flags & MEMIF_DESC_FLAG_NEXT) && n_slots))
+      if (PREDICT_FALSE (n_segs > 1))
 	{
 	  hb->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
 	  hb->total_length_not_including_first_buffer = 0;
-	next_slot:
-	  s0 = cur_slot & mask;
-	  d0 = &ring->desc[s0];
-	  bi0 = mq->buffers[s0];
-
-	  /* previous buffer */
-	  b0->next_buffer = bi0;
-	  b0->flags |= VLIB_BUFFER_NEXT_PRESENT;
-
-	  /* current buffer */
-	  b0 = vlib_get_buffer (vm, bi0);
-	  b0->current_data = start_offset;
-	  b0->current_length = d0->length;
-	  hb->total_length_not_including_first_buffer += d0->length;
-	  n_rx_bytes += d0->length;
-
-	  cur_slot++;
-	  n_slots--;
-	  if ((d0->flags & MEMIF_DESC_FLAG_NEXT) && n_slots)
-	    goto next_slot;
+	  while (--n_segs)
+	    {
+	      s0 = cur_slot & mask;
+	      d0 = &ring->desc[s0];
+	      bi0 = mq->buffers[s0];
+
+	      /* previous buffer */
+	      b0->next_buffer = bi0;
+	      b0->flags |= VLIB_BUFFER_NEXT_PRESENT;
+
+	      /* current buffer */
+	      b0 = vlib_get_buffer (vm, bi0);
+	      memif_device_input_zc_set_length (vm, node, b0, d0,
+						start_offset, buffer_length);
+	      hb->total_length_not_including_first_buffer +=
+		b0->current_length;
+	      n_rx_bytes += b0->current_length;
+
+	      cur_slot++;
+	      n_slots--;
+	    }
 	}
     }
+chain_incomplete:
 
   /* release slots from the ring */
   mq->last_tail = cur_slot;
@@ -615,6 +694,42 @@ memif_device_input_zc_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   n_from = n_rx_packets;
   buffers = ptd->buffers;
 
+  if (n_from && mode == MEMIF_INTERFACE_MODE_ETHERNET &&
+      mif->per_interface_next_index == ~0 &&
+      !vnet_device_input_have_features (mif->sw_if_index))
+    {
+      /* every packet goes to ethernet-input, hand it a single frame */
+      u32 n_left_to_next;
+      vlib_next_frame_t *nf;
+      vlib_frame_t *f;
+      ethernet_input_frame_t *ef;
+
+      vlib_get_new_next_frame (vm, node, next_index, to_next,
+			       n_left_to_next);
+      nf = vlib_node_runtime_get_next_frame (vm, node, next_index);
+      f = vlib_get_frame (vm, nf->frame);
+      f->flags = ETH_INPUT_FRAME_F_SINGLE_SW_IF_IDX;
+      ef = vlib_frame_scalar_args (f);
+      ef->sw_if_index = mif->sw_if_index;
+      ef->hw_if_index = mif->hw_if_index;
+      vlib_frame_no_append (f);
+
+      vlib_buffer_copy_indices (to_next, buffers, n_from);
+      while (n_from)
+	{
+	  b0 = vlib_get_buffer (vm, buffers[0]);
+	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = mif->sw_if_index;
+	  vnet_buffer (b0)->sw_if_index[VLIB_TX] = ~0;
+	  if (PREDICT_FALSE (n_trace > 0))
+	    memif_trace_buffer (vm, node, mif, b0, next_index, qid, &n_trace);
+	  buffers++;
+	  n_from--;
+	}
+
+      vlib_put_next_frame (vm, node, next_index,
+			   n_left_to_next - n_rx_packets);
+    }
+
   while (n_from)
     {
       u32 n_left_to_next;
@@ -877,6 +992,9 @@ VLIB_NODE_FN (memif_input_node) (vlib_main_t * vm,
 	}
     }
 
+  if (vlib_copy_is_async ())
+    vlib_copy_wait_all (vm);
+
   return n_rx;
 }
 
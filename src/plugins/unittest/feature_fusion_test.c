@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+
+/*
+ * A private arc of UT_FUSION_N_FEATURES pass-through features, all
+ * fusable, to check and benchmark feature fusion.
+ */
+
+#define UT_FUSION_N_FEATURES 4
+
+typedef struct
+{
+  u8 arc_index;
+  u64 n_seen[UT_FUSION_N_FEATURES];
+  u64 sum[UT_FUSION_N_FEATURES];
+  u64 n_output;
+} ut_fusion_main_t;
+
+static ut_fusion_main_t ut_fusion_main;
+
+static_always_inline void
+ut_fusion_buffers (vlib_buffer_t **b, u32 n_buffers, int feature)
+{
+  ut_fusion_main_t *ufm = &ut_fusion_main;
+  u32 i;
+
+  for (i = 0; i < n_buffers; i++)
+    ufm->sum[feature] += *(u32 *) vlib_buffer_get_current (b[i]);
+  ufm->n_seen[feature] += n_buffers;
+}
+
+static_always_inline uword
+ut_fusion_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+		  vlib_frame_t *frame, int feature)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_left = frame->n_vectors;
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+  ut_fusion_buffers (b, n_left, feature);
+
+  while (n_left)
+    {
+      vnet_feature_next_u16 (next, b[0]);
+      b += 1;
+      next += 1;
+      n_left -= 1;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+  return frame->n_vectors;
+}
+
+#define foreach_ut_fusion_feature _ (0) _ (1) _ (2) _ (3)
+
+#define _(i)                                                                  \
+  static uword ut_fusion_node_fn_##i (vlib_main_t *vm,                        \
+				      vlib_node_runtime_t *node,              \
+				      vlib_frame_t *frame)                    \
+  {                                                                           \
+    return ut_fusion_inline (vm, node, frame, i);                             \
+  }                                                                           \
+  static void ut_fusion_fused_fn_##i (vlib_main_t *vm,                        \
+				      vlib_node_runtime_t *node,              \
+				      vlib_buffer_t **b, u32 n_buffers)       \
+  {                                                                           \
+    ut_fusion_buffers (b, n_buffers, i);                                      \
+  }                                                                           \
+  VLIB_REGISTER_NODE (ut_fusion_node_##i) = {                                 \
+    .function = ut_fusion_node_fn_##i,                                        \
+    .name = "unittest-fusion-" #i,                                            \
+    .vector_size = sizeof (u32),                                              \
+    .type = VLIB_NODE_TYPE_INTERNAL,                                          \
+  };                                                                          \
+  VNET_FEATURE_INIT (ut_fusion_feature_##i, static) = {                       \
+    .arc_name = "unittest-fusion",                                            \
+    .node_name = "unittest-fusion-" #i,                                       \
+    .fused_function = ut_fusion_fused_fn_##i,                                 \
+  };
+foreach_ut_fusion_feature
+#undef _
+
+static uword
+ut_fusion_input_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
+		    vlib_frame_t *frame)
+{
+  ut_fusion_main_t *ufm = &ut_fusion_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE];
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 i, next;
+
+  vlib_get_buffers (vm, from, bufs, frame->n_vectors);
+
+  for (i = 0; i < frame->n_vectors; i++)
+    {
+      next = 0;
+      vnet_feature_arc_start (ufm->arc_index,
+			      vnet_buffer (b[i])->sw_if_index[VLIB_RX], &next,
+			      b[i]);
+      nexts[i] = next;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+  return frame->n_vectors;
+}
+
+static uword
+ut_fusion_output_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
+		     vlib_frame_t *frame)
+{
+  ut_fusion_main.n_output += frame->n_vectors;
+  vlib_buffer_free (vm, vlib_frame_vector_args (frame), frame->n_vectors);
+  return frame->n_vectors;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (ut_fusion_input_node) = {
+  .function = ut_fusion_input_fn,
+  .name = "unittest-fusion-input",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_next_nodes = 1,
+  .next_nodes = {
+    [0] = "unittest-fusion-output",
+  },
+};
+
+VLIB_REGISTER_NODE (ut_fusion_output_node) = {
+  .function = ut_fusion_output_fn,
+  .name = "unittest-fusion-output",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+};
+
+VNET_FEATURE_ARC_INIT (ut_fusion_arc, static) = {
+  .arc_name = "unittest-fusion",
+  .start_nodes = VNET_FEATURES ("unittest-fusion-input"),
+  .last_in_arc = "unittest-fusion-output",
+  .arc_index_ptr = &ut_fusion_main.arc_index,
+};
+
+VNET_FEATURE_ARC_ORDER (ut_fusion_order, static) = {
+  .arc_name = "unittest-fusion",
+  .node_names = VNET_FEATURES ("unittest-fusion-0", "unittest-fusion-1",
+			       "unittest-fusion-2", "unittest-fusion-3",
+			       "unittest-fusion-output"),
+};
+
+VNET_FEATURE_INIT (ut_fusion_output_feature, static) = {
+  .arc_name = "unittest-fusion",
+  .node_name = "unittest-fusion-output",
+};
+/* *INDENT-ON* */
+
+static u64
+ut_fusion_arc_clocks (vlib_main_t *vm)
+{
+  u32 node_indices[] = {
+    ut_fusion_input_node.index,	 ut_fusion_node_0.index,
+    ut_fusion_node_1.index,	 ut_fusion_node_2.index,
+    ut_fusion_node_3.index,	 ut_fusion_output_node.index,
+    vnet_feature_fused_node.index,
+  };
+  u64 clocks = 0;
+  vlib_node_t *n;
+  int i;
+
+  for (i = 0; i < ARRAY_LEN (node_indices); i++)
+    {
+      n = vlib_get_node (vm, node_indices[i]);
+      vlib_node_sync_stats (vm, n);
+      clocks += n->stats_total.clocks;
+    }
+  return clocks;
+}
+
+static clib_error_t *
+ut_fusion_send (vlib_main_t *vm, u32 n_packets)
+{
+  u32 bi[VLIB_FRAME_SIZE], i, n, n_frames;
+  vlib_buffer_t *b;
+  vlib_frame_t *f;
+
+  while (n_packets)
+    {
+      /* a few frames per main loop, like a busy input node */
+      for (n_frames = 0; n_frames < 8 && n_packets; n_frames++)
+	{
+	  n = clib_min (n_packets, VLIB_FRAME_SIZE);
+	  if (vlib_buffer_alloc (vm, bi, n) != n)
+	    return clib_error_return (0, "buffer allocation failure");
+
+	  for (i = 0; i < n; i++)
+	    {
+	      b = vlib_get_buffer (vm, bi[i]);
+	      b->current_length = 64;
+	      vnet_buffer (b)->sw_if_index[VLIB_RX] = 0;
+	    }
+
+	  f = vlib_get_frame_to_node (vm, ut_fusion_input_node.index);
+	  clib_memcpy_fast (vlib_frame_vector_args (f), bi, n * sizeof (u32));
+	  f->n_vectors = n;
+	  vlib_put_frame_to_node (vm, ut_fusion_input_node.index, f);
+	  n_packets -= n;
+	}
+      vlib_process_suspend (vm, 1e-5);
+    }
+  vlib_process_suspend (vm, 1e-5);
+  return 0;
+}
+
+static clib_error_t *
+test_feature_fusion_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				vlib_cli_command_t *cmd)
+{
+  static char *features[] = { "unittest-fusion-0", "unittest-fusion-1",
+			      "unittest-fusion-2", "unittest-fusion-3" };
+  ut_fusion_main_t *ufm = &ut_fusion_main;
+  u32 n_packets = 1 << 20, n_features = UT_FUSION_N_FEATURES;
+  clib_error_t *error = 0;
+  f64 clocks_per_packet[2];
+  u64 clocks;
+  int fused, i;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "features %u", &n_features))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_features < 1 || n_features > UT_FUSION_N_FEATURES || !n_packets)
+    return clib_error_return (0, "1 to %u features, at least 1 packet",
+			      UT_FUSION_N_FEATURES);
+
+  for (i = 0; i < n_features; i++)
+    vnet_feature_enable_disable ("unittest-fusion", features[i], 0, 1, 0, 0);
+
+  for (fused = 0; fused < 2; fused++)
+    {
+      vnet_feature_arc_fuse (ufm->arc_index, fused);
+      clib_memset (ufm->n_seen, 0, sizeof (ufm->n_seen));
+      ufm->n_output = 0;
+
+      clocks = ut_fusion_arc_clocks (vm);
+      if ((error = ut_fusion_send (vm, n_packets)))
+	goto done;
+      clocks = ut_fusion_arc_clocks (vm) - clocks;
+      clocks_per_packet[fused] = (f64) clocks / n_packets;
+
+      if (ufm->n_output != n_packets)
+	{
+	  error = clib_error_return (0, "%s arc failed: %llu packets out of %u",
+				     fused ? "fused" : "unfused",
+				     ufm->n_output, n_packets);
+	  goto done;
+	}
+      for (i = 0; i < n_features; i++)
+	if (ufm->n_seen[i] != n_packets)
+	  {
+	    error = clib_error_return (0, "%s arc failed: feature %d saw %llu",
+				       fused ? "fused" : "unfused", i,
+				       ufm->n_seen[i]);
+	    goto done;
+	  }
+    }
+
+  vlib_cli_output (vm, "%u features, %u packets", n_features, n_packets);
+  vlib_cli_output (vm, "  unfused: %.2f clocks/packet",
+		   clocks_per_packet[0]);
+  vlib_cli_output (vm, "  fused:   %.2f clocks/packet",
+		   clocks_per_packet[1]);
+
+done:
+  vnet_feature_arc_fuse (ufm->arc_index, 0);
+  for (i = 0; i < n_features; i++)
+    vnet_feature_enable_disable ("unittest-fusion", features[i], 0, 0, 0, 0);
+  return error;
+}
+
+/*?
+ * Run packets through an arc of pass-through features, unfused then
+ * fused, check that every feature saw every packet and report the cost
+ * of the arc nodes per packet.
+ *
+ * @cliexpar
+ * @cliexcmd{test feature fusion packets 1000000 features 4}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_feature_fusion_command, static) = {
+  .path = "test feature fusion",
+  .short_help = "test feature fusion [packets <n>] [features <1-4>]",
+  .function = test_feature_fusion_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip_frag.h>
+
+#define IP_FRAG_TEST_I(_cond, _comment, _args...)                             \
+  ({                                                                          \
+    int _evald = (_cond);                                                     \
+    if (!(_evald))                                                            \
+      {                                                                       \
+	fformat (stderr, "FAIL:%d: " _comment "\n", __LINE__, ##_args);       \
+      }                                                                       \
+    _evald;                                                                   \
+  })
+
+#define IP_FRAG_TEST(_cond, _comment, _args...)                               \
+  {                                                                           \
+    if (!IP_FRAG_TEST_I (_cond, _comment, ##_args))                           \
+      {                                                                       \
+	return 1;                                                             \
+      }                                                                       \
+  }
+
+typedef struct
+{
+  char *name;
+  u8 is_ip6;
+  u16 mtu;
+  u16 l2_len;
+  /* payload bytes in the first buffer, after the headers */
+  u16 first_len;
+  /* bytes in the buffers chained to the first one, 0 terminated */
+  i16 lens[12];
+  /* bytes past the end of the ip packet */
+  u16 pad;
+} ip_frag_test_case_t;
+
+static ip_frag_test_case_t ip_frag_test_cases[] = {
+  {
+    .name = "ip4 aligned",
+    .mtu = 1500,
+    .first_len = 200,
+    .lens = { 1400, 1400, 1400 },
+  },
+  {
+    .name = "ip4 empty and tiny buffers",
+    .mtu = 576,
+    .first_len = 60,
+    .lens = { -1, 3, 2000, -1, -1, 1999, 1, 700 },
+  },
+  {
+    .name = "ip4 unfragmentable l2",
+    .mtu = 1280,
+    .l2_len = 40,
+    .first_len = 60,
+    .lens = { -1, 3, 2000, -1, -1, 1999, 1, 700 },
+  },
+  {
+    .name = "ip4 padding",
+    .mtu = 600,
+    .first_len = 10,
+    .lens = { 1000, 1000, 300 },
+    .pad = 500,
+  },
+  {
+    .name = "ip6 empty and tiny buffers",
+    .is_ip6 = 1,
+    .mtu = 1280,
+    .first_len = 0,
+    .lens = { 1, -1, 2000, 2000, -1, 5, 1700 },
+  },
+  {
+    .name = "ip6 fragments larger than a buffer",
+    .is_ip6 = 1,
+    .mtu = 9000,
+    .first_len = 100,
+    .lens = { 2000, 2000, 2000, 2000, 2000, 2000, 2000, 2000 },
+  },
+  {
+    .name = "ip6 full first buffer",
+    .is_ip6 = 1,
+    .mtu = 9000,
+    .first_len = 2008,
+    .lens = { 1000, -1, 2000 },
+  },
+};
+
+static u32
+ip_frag_test_n_free_buffers (vlib_main_t *vm)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_pool_thread_t *bpt;
+  vlib_buffer_pool_t *bp;
+  u32 n = 0;
+
+  vec_foreach (bp, bm->buffer_pools)
+    {
+      n += vlib_buffer_pool_n_avail (bp);
+      vec_foreach (bpt, bp->threads)
+	n += bpt->n_cached;
+    }
+  return n;
+}
+
+static u8
+ip_frag_test_byte (u32 i)
+{
+  return i * 7 + (i >> 8);
+}
+
+/* returns the ip payload the chain carries */
+static u8 *
+ip_frag_test_build (vlib_main_t *vm, ip_frag_test_case_t *tc, u32 *bi)
+{
+  u32 hdr_len = tc->is_ip6 ? sizeof (ip6_header_t) : sizeof (ip4_header_t);
+  u32 bis[ARRAY_LEN (tc->lens) + 1];
+  u32 i, j, n = 1, n_bytes = 0;
+  u8 *payload = 0, *p;
+  vlib_buffer_t *b;
+
+  while (n <= ARRAY_LEN (tc->lens) && tc->lens[n - 1])
+    n++;
+  if (vlib_buffer_alloc (vm, bis, n) != n)
+    return 0;
+
+  for (i = 0; i < n; i++)
+    {
+      u32 len;
+
+      b = vlib_get_buffer (vm, bis[i]);
+      b->current_data = 0;
+      if (i == 0)
+	len = tc->l2_len + hdr_len + tc->first_len;
+      else
+	len = tc->lens[i - 1] < 0 ? 0 : tc->lens[i - 1];
+      b->current_length = len;
+      b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+      if (i + 1 < n)
+	{
+	  b->flags |= VLIB_BUFFER_NEXT_PRESENT;
+	  b->next_buffer = bis[i + 1];
+	}
+
+      p = vlib_buffer_get_current (b);
+      if (i == 0)
+	{
+	  clib_memset (p, 0xee, tc->l2_len);
+	  p += tc->l2_len + hdr_len;
+	  len = tc->first_len;
+	}
+      for (j = 0; j < len; j++)
+	p[j] = ip_frag_test_byte (n_bytes++);
+    }
+
+  /* the padding is not part of the ip packet */
+  n_bytes -= tc->pad;
+  for (i = 0; i < n_bytes; i++)
+    vec_add1 (payload, ip_frag_test_byte (i));
+
+  b = vlib_get_buffer (vm, bis[0]);
+  p = vlib_buffer_get_current (b) + tc->l2_len;
+  if (tc->is_ip6)
+    {
+      ip6_header_t *ip6 = (ip6_header_t *) p;
+      clib_memset (ip6, 0, sizeof (*ip6));
+      ip6->ip_version_traffic_class_and_flow_label =
+	clib_host_to_net_u32 (0x6 << 28);
+      ip6->payload_length = clib_host_to_net_u16 (n_bytes);
+      ip6->protocol = IP_PROTOCOL_UDP;
+      ip6->hop_limit = 64;
+    }
+  else
+    {
+      ip4_header_t *ip4 = (ip4_header_t *) p;
+      clib_memset (ip4, 0, sizeof (*ip4));
+      ip4->ip_version_and_header_length = 0x45;
+      ip4->length = clib_host_to_net_u16 (sizeof (*ip4) + n_bytes);
+      ip4->protocol = IP_PROTOCOL_UDP;
+      ip4->ttl = 64;
+      ip4->checksum = ip4_header_checksum (ip4);
+    }
+
+  *bi = bis[0];
+  return payload;
+}
+
+static int
+ip_frag_test_check (vlib_main_t *vm, ip_frag_test_case_t *tc, u32 *frags,
+		    u8 *payload)
+{
+  u8 *seen = 0;
+  u32 *bi;
+
+  vec_validate (seen, vec_len (payload) - 1);
+
+  vec_foreach (bi, frags)
+    {
+      vlib_buffer_t *b = vlib_get_buffer (vm, *bi);
+      u32 offset, len, hdr_len, ip_len;
+      u8 *ip = vlib_buffer_get_current (b) + tc->l2_len;
+      int more;
+
+      if (tc->is_ip6)
+	{
+	  ip6_header_t *ip6 = (ip6_header_t *) vlib_buffer_get_current (b);
+	  ip6_frag_hdr_t *fh = (ip6_frag_hdr_t *) (ip6 + 1);
+
+	  IP_FRAG_TEST (ip6->protocol == IP_PROTOCOL_IPV6_FRAGMENTATION,
+			"%s: fragment header missing", tc->name);
+	  hdr_len = sizeof (*ip6) + sizeof (*fh);
+	  ip_len = sizeof (*ip6) + clib_net_to_host_u16 (ip6->payload_length);
+	  offset = ip6_frag_hdr_offset_bytes (fh);
+	  more = ip6_frag_hdr_more (fh);
+	  ip = (u8 *) ip6;
+	}
+      else
+	{
+	  ip4_header_t *ip4 = (ip4_header_t *) ip;
+
+	  IP_FRAG_TEST (ip4_header_checksum_is_valid (ip4),
+			"%s: bad checksum", tc->name);
+	  hdr_len = sizeof (*ip4);
+	  ip_len = clib_net_to_host_u16 (ip4->length);
+	  offset = ip4_get_fragment_offset_bytes (ip4);
+	  more = ip4_get_fragment_more (ip4);
+	  IP_FRAG_TEST (vlib_buffer_length_in_chain (vm, b) ==
+			  tc->l2_len + ip_len,
+			"%s: fragment of %u bytes, ip length %u", tc->name,
+			vlib_buffer_length_in_chain (vm, b), ip_len);
+	}
+
+      IP_FRAG_TEST (ip_len <= tc->mtu, "%s: fragment of %u bytes, mtu %u",
+		    tc->name, ip_len, tc->mtu);
+      len = ip_len - hdr_len;
+      IP_FRAG_TEST (offset + len <= vec_len (payload),
+		    "%s: fragment past the end of the packet", tc->name);
+      IP_FRAG_TEST (more || offset + len == vec_len (payload),
+		    "%s: last fragment does not end the packet", tc->name);
+
+      /* walk the chain, every buffer within its data area */
+      u32 skip = ip - (u8 *) vlib_buffer_get_current (b) + hdr_len;
+      u32 pos = offset;
+      while (1)
+	{
+	  u8 *data = vlib_buffer_get_current (b);
+	  u32 n = b->current_length;
+
+	  IP_FRAG_TEST (b->current_data + b->current_length <=
+			  vlib_buffer_get_data_size (vm, b),
+			"%s: buffer overflow", tc->name);
+	  IP_FRAG_TEST (skip <= n, "%s: headers split", tc->name);
+	  data += skip;
+	  n -= skip;
+	  skip = 0;
+	  IP_FRAG_TEST (pos + n <= offset + len,
+			"%s: chain longer than the fragment", tc->name);
+	  IP_FRAG_TEST (!memcmp (data, payload + pos, n),
+			"%s: payload mismatch at %u", tc->name, pos);
+	  clib_memset (seen + pos, 1, n);
+	  pos += n;
+	  if (!(b->flags & VLIB_BUFFER_NEXT_PRESENT))
+	    break;
+	  b = vlib_get_buffer (vm, b->next_buffer);
+	}
+      IP_FRAG_TEST (pos == offset + len, "%s: chain shorter than the fragment",
+		    tc->name);
+    }
+
+  for (u32 i = 0; i < vec_len (payload); i++)
+    IP_FRAG_TEST (seen[i], "%s: payload byte %u not covered", tc->name, i);
+  vec_free (seen);
+  return 0;
+}
+
+static int
+ip_frag_test_one (vlib_main_t *vm, ip_frag_test_case_t *tc)
+{
+  u32 n_free, bi, *frags = 0;
+  ip_frag_error_t error;
+  u8 *payload;
+  int rv;
+
+  n_free = ip_frag_test_n_free_buffers (vm);
+
+  payload = ip_frag_test_build (vm, tc, &bi);
+  IP_FRAG_TEST (payload != 0, "%s: no buffers", tc->name);
+
+  if (tc->is_ip6)
+    error = ip6_frag_do_fragment (vm, bi, tc->mtu, tc->l2_len, &frags);
+  else
+    error = ip4_frag_do_fragment (vm, bi, tc->mtu, tc->l2_len, &frags);
+  IP_FRAG_TEST (error == IP_FRAG_ERROR_NONE, "%s: error %u", tc->name,
+		error);
+
+  rv = ip_frag_test_check (vm, tc, frags, payload);
+
+  /* the caller frees the original packet, left unchained */
+  vlib_buffer_free_one (vm, bi);
+  vlib_buffer_free (vm, frags, vec_len (frags));
+  vec_free (frags);
+  vec_free (payload);
+  if (rv)
+    return rv;
+
+  IP_FRAG_TEST (ip_frag_test_n_free_buffers (vm) == n_free,
+		"%s: %d buffers leaked", tc->name,
+		(i32) (n_free - ip_frag_test_n_free_buffers (vm)));
+  return 0;
+}
+
+static clib_error_t *
+test_ip_frag_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			 vlib_cli_command_t *cmd)
+{
+  ip_frag_test_case_t *tc;
+  u32 n_failed = 0;
+
+  for (tc = ip_frag_test_cases;
+       tc < ip_frag_test_cases + ARRAY_LEN (ip_frag_test_cases); tc++)
+    if (ip_frag_test_one (vm, tc))
+      n_failed++;
+    else
+      vlib_cli_output (vm, "%s: ok", tc->name);
+
+  if (n_failed)
+    return clib_error_return (0, "%u of %u ip frag tests failed", n_failed,
+			      ARRAY_LEN (ip_frag_test_cases));
+  return 0;
+}
+
+VLIB_CLI_COMMAND (test_ip_frag_command, static) = {
+  .path = "test ip frag",
+  .short_help = "test ip frag",
+  .function = test_ip_frag_command_fn,
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/ip/ip.h>
+#include <vnet/ip/reass/ip4_full_reass.h>
+#include <vnet/ip/reass/ip6_full_reass.h>
+
+typedef struct
+{
+  u8 is_ip6;
+  u32 n_packets;
+  /* fragments per packet */
+  u32 n_fragments;
+  /* payload bytes per fragment */
+  u32 fragment_size;
+} ip_reass_test_args_t;
+
+static void
+ip_reass_test_fragment (vlib_buffer_t *b, ip_reass_test_args_t *a, u32 id,
+			u32 k)
+{
+  u32 offset = k * a->fragment_size;
+  int more = k + 1 < a->n_fragments;
+
+  b->current_data = 0;
+  b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+  vnet_buffer (b)->sw_if_index[VLIB_RX] = 0;
+  vnet_buffer (b)->sw_if_index[VLIB_TX] = ~0;
+
+  if (a->is_ip6)
+    {
+      ip6_header_t *ip6 = vlib_buffer_get_current (b);
+      ip6_frag_hdr_t *fh = (ip6_frag_hdr_t *) (ip6 + 1);
+
+      clib_memset (ip6, 0, sizeof (*ip6) + sizeof (*fh));
+      ip6->ip_version_traffic_class_and_flow_label =
+	clib_host_to_net_u32 (0x6 << 28);
+      ip6->payload_length =
+	clib_host_to_net_u16 (sizeof (*fh) + a->fragment_size);
+      ip6->protocol = IP_PROTOCOL_IPV6_FRAGMENTATION;
+      ip6->hop_limit = 64;
+      ip6->src_address.as_u32[0] = clib_host_to_net_u32 (0x20010db8);
+      ip6->src_address.as_u32[3] = clib_host_to_net_u32 (1);
+      ip6->dst_address.as_u32[0] = clib_host_to_net_u32 (0x20010db8);
+      ip6->dst_address.as_u32[3] = clib_host_to_net_u32 (2);
+      fh->next_hdr = IP_PROTOCOL_UDP;
+      fh->identification = clib_host_to_net_u32 (id);
+      fh->fragment_offset_and_more =
+	ip6_frag_hdr_offset_and_more (offset / 8, more);
+      b->current_length = sizeof (*ip6) + sizeof (*fh) + a->fragment_size;
+    }
+  else
+    {
+      ip4_header_t *ip4 = vlib_buffer_get_current (b);
+
+      clib_memset (ip4, 0, sizeof (*ip4));
+      ip4->ip_version_and_header_length = 0x45;
+      ip4->length = clib_host_to_net_u16 (sizeof (*ip4) + a->fragment_size);
+      /* 16 bits of id, the rest of it in the source address */
+      ip4->fragment_id = clib_host_to_net_u16 (id);
+      ip4->flags_and_fragment_offset = clib_host_to_net_u16 (
+	(offset / 8) | (more ? IP4_HEADER_FLAG_MORE_FRAGMENTS : 0));
+      ip4->ttl = 64;
+      ip4->protocol = IP_PROTOCOL_UDP;
+      ip4->src_address.as_u32 = clib_host_to_net_u32 (0x0a000000 + (id >> 16));
+      ip4->dst_address.as_u32 = clib_host_to_net_u32 (0xc0000201);
+      ip4->checksum = ip4_header_checksum (ip4);
+      b->current_length = sizeof (*ip4) + a->fragment_size;
+    }
+}
+
+typedef struct
+{
+  u32 timeout_ms;
+  u32 max_reassemblies;
+  u32 max_reassembly_length;
+  u32 expire_walk_interval_ms;
+} ip_reass_test_config_t;
+
+static void
+ip_reass_test_config_get (u8 is_ip6, ip_reass_test_config_t *c)
+{
+  if (is_ip6)
+    ip6_full_reass_get (&c->timeout_ms, &c->max_reassemblies,
+			&c->max_reassembly_length, &c->expire_walk_interval_ms);
+  else
+    ip4_full_reass_get (&c->timeout_ms, &c->max_reassemblies,
+			&c->max_reassembly_length, &c->expire_walk_interval_ms);
+}
+
+static void
+ip_reass_test_config_set (u8 is_ip6, ip_reass_test_config_t *c)
+{
+  if (is_ip6)
+    ip6_full_reass_set (c->timeout_ms, c->max_reassemblies,
+			c->max_reassembly_length, c->expire_walk_interval_ms);
+  else
+    ip4_full_reass_set (c->timeout_ms, c->max_reassemblies,
+			c->max_reassembly_length, c->expire_walk_interval_ms);
+}
+
+static void
+ip_reass_test_stats (vlib_main_t *vm, vlib_node_t *n, u64 *clocks,
+		     u64 *vectors)
+{
+  vlib_node_sync_stats (vm, n);
+  *clocks = n->stats_total.clocks;
+  *vectors = n->stats_total.vectors;
+}
+
+static clib_error_t *
+ip_reass_test_send (vlib_main_t *vm, vlib_node_t *n, ip_reass_test_args_t *a)
+{
+  u32 i, j, n_left, n_frames, n_fragments;
+  vlib_buffer_t *b;
+  vlib_frame_t *f;
+  u32 *to;
+
+  n_left = a->n_packets * a->n_fragments;
+  for (i = 0; n_left;)
+    {
+      /* a few frames per main loop, like a busy input node */
+      for (n_frames = 0; n_frames < 8 && n_left; n_frames++)
+	{
+	  n_fragments = clib_min (n_left, VLIB_FRAME_SIZE);
+	  f = vlib_get_frame_to_node (vm, n->index);
+	  to = vlib_frame_vector_args (f);
+	  if (vlib_buffer_alloc (vm, to, n_fragments) != n_fragments)
+	    {
+	      vlib_frame_free (vm, vlib_node_get_runtime (vm, n->index), f);
+	      return clib_error_return (0, "buffer allocation failure");
+	    }
+
+	  for (j = 0; j < n_fragments; j++, i++)
+	    {
+	      b = vlib_get_buffer (vm, to[j]);
+	      ip_reass_test_fragment (b, a, i / a->n_fragments,
+				      i % a->n_fragments);
+	    }
+
+	  f->n_vectors = n_fragments;
+	  vlib_put_frame_to_node (vm, n->index, f);
+	  n_left -= n_fragments;
+	}
+      vlib_process_suspend (vm, 1e-5);
+    }
+  vlib_process_suspend (vm, 1e-5);
+  return 0;
+}
+
+static clib_error_t *
+test_ip_reass_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			  vlib_cli_command_t *cmd)
+{
+  ip_reass_test_args_t a = {
+    .n_packets = 1 << 16,
+    .n_fragments = 4,
+    .fragment_size = 1024,
+  };
+  u64 clocks[2], vectors[2], out_clocks, out[2];
+  u64 n_vectors, n_out;
+  ip_reass_test_config_t config, saved;
+  vlib_node_t *n, *next;
+  clib_error_t *error;
+  f64 secs;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "ip6"))
+	a.is_ip6 = 1;
+      else if (unformat (input, "ip4"))
+	a.is_ip6 = 0;
+      else if (unformat (input, "packets %u", &a.n_packets))
+	;
+      else if (unformat (input, "fragments %u", &a.n_fragments))
+	;
+      else if (unformat (input, "fragment-size %u", &a.fragment_size))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!a.n_packets || a.n_fragments < 2 || !a.fragment_size ||
+      a.fragment_size % 8 ||
+      a.fragment_size > VLIB_BUFFER_DEFAULT_DATA_SIZE - 64 ||
+      (u64) a.n_fragments * a.fragment_size > 65000)
+    return clib_error_return (0, "at least 1 packet of 2 or more fragments, "
+			      "fragment size a multiple of 8 and packets "
+			      "of up to 65000 bytes");
+
+  /* reassembled packets go on to ip4/6-input and are dropped there */
+  n = vlib_get_node_by_name (
+    vm, (u8 *) (a.is_ip6 ? "ip6-full-reassembly" : "ip4-full-reassembly"));
+  next =
+    vlib_get_node_by_name (vm, (u8 *) (a.is_ip6 ? "ip6-input" : "ip4-input"));
+
+  /* allow as many fragments per reassembly as the packets have */
+  ip_reass_test_config_get (a.is_ip6, &saved);
+  config = saved;
+  config.max_reassembly_length =
+    clib_max (config.max_reassembly_length, a.n_fragments);
+  ip_reass_test_config_set (a.is_ip6, &config);
+
+  ip_reass_test_stats (vm, n, &clocks[0], &vectors[0]);
+  ip_reass_test_stats (vm, next, &out_clocks, &out[0]);
+  error = ip_reass_test_send (vm, n, &a);
+  ip_reass_test_stats (vm, n, &clocks[1], &vectors[1]);
+  ip_reass_test_stats (vm, next, &out_clocks, &out[1]);
+
+  ip_reass_test_config_set (a.is_ip6, &saved);
+  if (error)
+    return error;
+
+  n_vectors = vectors[1] - vectors[0];
+  n_out = out[1] - out[0];
+  if (n_vectors != (u64) a.n_packets * a.n_fragments || n_out != a.n_packets)
+    return clib_error_return (0,
+			      "reassembly failed: %llu fragments in, "
+			      "%llu packets out of %u",
+			      n_vectors, n_out, a.n_packets);
+
+  secs = (clocks[1] - clocks[0]) / vm->clib_time.clocks_per_second;
+  vlib_cli_output (vm, "%u %s packets of %u %u byte fragments", a.n_packets,
+		   a.is_ip6 ? "ip6" : "ip4", a.n_fragments, a.fragment_size);
+  vlib_cli_output (vm, "  %.2f clocks/fragment, %.0f reassemblies/sec",
+		   (f64) (clocks[1] - clocks[0]) / n_vectors,
+		   secs > 0 ? a.n_packets / secs : 0);
+  return 0;
+}
+
+/*?
+ * Fragment storm: feed the fragments of many packets to the full
+ * reassembly node of the thread running the command and report the time
+ * the node spent per fragment and the reassemblies per second it
+ * sustains.
+ *
+ * @cliexpar
+ * @cliexcmd{test ip reassembly ip4 packets 100000 fragments 4}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_ip_reass_command, static) = {
+  .path = "test ip reassembly",
+  .short_help = "test ip reassembly [ip4|ip6] [packets <n>] "
+		"[fragments <n>] [fragment-size <bytes>]",
+  .function = test_ip_reass_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -15,6 +15,7 @@
 
 #include <vlib/vlib.h>
 #include <vlib/buffer_funcs.h>
+#include <pthread.h>
 
 #define TEST_I(_cond, _comment, _args...)                                     \
   ({                                                                          \
@@ -318,6 +319,336 @@ VLIB_CLI_COMMAND (test_linearize_speed_command, static) = {
   .function = test_linearize_speed_fn,
 };
 
+static u32
+test_buffer_n_free (vlib_main_t *vm)
+{
+  vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, 0);
+  vlib_buffer_pool_thread_t *bpt;
+  u32 n_free = vlib_buffer_pool_n_avail (bp);
+
+  vec_foreach (bpt, bp->threads)
+    n_free += bpt->n_cached;
+  return n_free;
+}
+
+static clib_error_t *
+test_clone_fn (vlib_main_t *vm, unformat_input_t *input,
+	       vlib_cli_command_t *cmd)
+{
+  u32 n_clones = 256, n_iter = 1000, size = 1500, i, j, n_free;
+  u32 bi, *clones = 0;
+  u64 tot = 0;
+  int res = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "clones %u", &n_clones))
+	;
+      else if (unformat (input, "size %u", &size))
+	;
+      else if (unformat (input, "iter %u", &n_iter))
+	;
+      else
+	return clib_error_create ("unknown input `%U'", format_unformat_error,
+				  input);
+    }
+
+  if (n_clones == 0 || n_clones > 256 || size < 64 ||
+      size > vlib_buffer_get_default_data_size (vm))
+    return clib_error_create ("invalid clones or size");
+
+  vec_validate (clones, n_clones - 1);
+  n_free = test_buffer_n_free (vm);
+
+  for (i = 0; i < n_iter; i++)
+    {
+      vlib_buffer_t *b, *c;
+      u16 n_cloned;
+
+      if (vlib_buffer_alloc (vm, &bi, 1) != 1)
+	return clib_error_create ("buffer allocation failure");
+      b = vlib_get_buffer (vm, bi);
+      b->current_length = size;
+      for (j = 0; j < size; j++)
+	b->data[j] = j + i;
+
+      CLIB_COMPILER_BARRIER ();
+      u64 start = clib_cpu_time_now ();
+      CLIB_COMPILER_BARRIER ();
+
+      n_cloned =
+	vlib_buffer_clone (vm, bi, clones, n_clones, VLIB_BUFFER_CLONE_HEAD_SIZE);
+
+      CLIB_COMPILER_BARRIER ();
+      tot += clib_cpu_time_now () - start;
+      CLIB_COMPILER_BARRIER ();
+
+      TEST (n_cloned == n_clones, "%u clones", n_cloned);
+      for (j = 0; j < n_cloned; j++)
+	{
+	  u32 k, off = 0, bad = ~0;
+
+	  c = vlib_get_buffer (vm, clones[j]);
+	  TEST (vlib_buffer_length_in_chain (vm, c) == size,
+		"clone %u length %u", j, vlib_buffer_length_in_chain (vm, c));
+	  /* compare every byte, whether copied or shared */
+	  while (1)
+	    {
+	      u8 *data = vlib_buffer_get_current (c);
+	      for (k = 0; k < c->current_length; k++, off++)
+		if (data[k] != (u8) (off + i) && bad == ~0)
+		  bad = off;
+	      if (!(c->flags & VLIB_BUFFER_NEXT_PRESENT))
+		break;
+	      c = vlib_get_buffer (vm, c->next_buffer);
+	    }
+	  TEST (bad == ~0, "clone %u data at %u", j, bad);
+	}
+      vlib_buffer_free (vm, clones, n_cloned);
+    }
+
+  TEST (test_buffer_n_free (vm) == n_free, "no buffer leak");
+  vlib_cli_output (vm, "%u clones of %u bytes: %.03f ticks/clone", n_clones,
+		   size, (f64) tot / n_iter / n_clones);
+  goto done;
+
+err:
+  res = 1;
+done:
+  vec_free (clones);
+  if (res)
+    return clib_error_create ("buffer clone test failed");
+  return 0;
+}
+
+VLIB_CLI_COMMAND (test_clone_command, static) = {
+  .path = "test buffer-clone",
+  .short_help = "test buffer-clone [clones <n>] [size <n>] [iter <n>]",
+  .function = test_clone_fn,
+};
+
+#define TEST_DEPOT_N_BATCHES 4
+#define TEST_DEPOT_MAX_BATCH 256
+
+typedef struct
+{
+  /* copy of the main thread vlib_main_t, with its own thread index */
+  vlib_main_t *vm;
+  pthread_t handle;
+  u32 n_iter;
+  u32 batch;
+  u32 n_fail;
+  u64 ticks;
+} test_depot_thread_t;
+
+static volatile u32 test_depot_start;
+static volatile u32 test_depot_n_running;
+
+/* Hold several batches at once so buffers overflow the per-thread cache
+ * and go through the depot both ways */
+static void *
+test_depot_thread_fn (void *arg)
+{
+  test_depot_thread_t *t = arg;
+  u32 buffers[TEST_DEPOT_N_BATCHES * TEST_DEPOT_MAX_BATCH];
+  u32 i, j, n;
+  u64 start;
+
+  while (test_depot_start == 0)
+    CLIB_PAUSE ();
+
+  start = clib_cpu_time_now ();
+  for (i = 0; i < t->n_iter; i++)
+    {
+      for (j = n = 0; j < TEST_DEPOT_N_BATCHES; j++)
+	n += vlib_buffer_alloc (t->vm, buffers + n, t->batch);
+      if (n != TEST_DEPOT_N_BATCHES * t->batch)
+	t->n_fail++;
+      vlib_buffer_free (t->vm, buffers, n);
+    }
+  t->ticks = clib_cpu_time_now () - start;
+
+  clib_atomic_fetch_sub (&test_depot_n_running, 1);
+  return 0;
+}
+
+static clib_error_t *
+test_depot_fn (vlib_main_t *vm, unformat_input_t *input,
+	       vlib_cli_command_t *cmd)
+{
+  u32 n_threads = 4, n_iter = 10000, batch = 64, n_vlib_threads, n_free, i;
+  vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, 0);
+  vlib_buffer_pool_thread_t *bpt, *main_bpt;
+  test_depot_thread_t *threads = 0, *t;
+  u64 retries = 0, locked = 0, retries_after = 0, locked_after = 0;
+  u64 ticks = 0;
+  int res = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "threads %u", &n_threads))
+	;
+      else if (unformat (input, "iter %u", &n_iter))
+	;
+      else if (unformat (input, "batch %u", &batch))
+	;
+      else
+	return clib_error_create ("unknown input `%U'", format_unformat_error,
+				  input);
+    }
+
+  if (n_threads == 0 || n_threads > 64 || batch == 0 ||
+      batch > TEST_DEPOT_MAX_BATCH)
+    return clib_error_create ("invalid threads or batch");
+
+  /* the benchmark threads get per-thread pool data past the vlib ones */
+  vlib_worker_thread_barrier_sync (vm);
+  n_vlib_threads = vec_len (bp->threads);
+  clib_spinlock_lock (&bp->lock);
+  vec_validate_aligned (bp->threads, n_vlib_threads + n_threads - 1,
+			CLIB_CACHE_LINE_BYTES);
+  clib_spinlock_unlock (&bp->lock);
+
+  n_free = test_buffer_n_free (vm);
+  vec_foreach (bpt, bp->threads)
+    {
+      retries += bpt->n_depot_retries;
+      locked += bpt->n_locked;
+    }
+
+  test_depot_start = 0;
+  test_depot_n_running = n_threads;
+  vec_validate (threads, n_threads - 1);
+  vec_foreach (t, threads)
+    {
+      t->vm = clib_mem_alloc_aligned (sizeof (vlib_main_t),
+				      CLIB_CACHE_LINE_BYTES);
+      clib_memcpy_fast (t->vm, vm, sizeof (vlib_main_t));
+      t->vm->thread_index = n_vlib_threads + (t - threads);
+      t->n_iter = n_iter;
+      t->batch = batch;
+      if (pthread_create (&t->handle, NULL, test_depot_thread_fn, t))
+	clib_panic ("pthread_create failed");
+    }
+
+  test_depot_start = 1;
+  vec_foreach (t, threads)
+    {
+      pthread_join (t->handle, 0);
+      res |= TEST_I (t->n_fail == 0, "thread %u allocations", t - threads);
+      ticks += t->ticks;
+      clib_mem_free (t->vm);
+    }
+
+  vec_foreach (bpt, bp->threads)
+    {
+      retries_after += bpt->n_depot_retries;
+      locked_after += bpt->n_locked;
+    }
+
+  /* return the benchmark thread caches and fold their counters into the
+   * main thread ones before dropping their per-thread data */
+  main_bpt = vec_elt_at_index (bp->threads, vm->thread_index);
+  for (i = n_vlib_threads; i < vec_len (bp->threads); i++)
+    {
+      bpt = vec_elt_at_index (bp->threads, i);
+      vlib_buffer_pool_put_slow (bp, main_bpt, bpt->cached_buffers,
+				 bpt->n_cached);
+      main_bpt->n_magazines_in += bpt->n_magazines_in;
+      main_bpt->n_magazines_out += bpt->n_magazines_out;
+      main_bpt->n_depot_retries += bpt->n_depot_retries;
+      main_bpt->n_locked += bpt->n_locked;
+    }
+  clib_spinlock_lock (&bp->lock);
+  vec_set_len (bp->threads, n_vlib_threads);
+  clib_spinlock_unlock (&bp->lock);
+  vlib_worker_thread_barrier_release (vm);
+
+  vlib_cli_output (vm,
+		   "%u threads, %u x %u buffers held: %.02f ticks/buffer, "
+		   "%lu depot retries, %lu locked",
+		   n_threads, TEST_DEPOT_N_BATCHES, batch,
+		   (f64) ticks / n_threads / n_iter /
+		     (TEST_DEPOT_N_BATCHES * batch),
+		   retries_after - retries, locked_after - locked);
+  res |= TEST_I (test_buffer_n_free (vm) == n_free, "no buffer leak");
+
+  vec_free (threads);
+  if (res)
+    return clib_error_create ("buffer depot test failed");
+  return 0;
+}
+
+VLIB_CLI_COMMAND (test_depot_command, static) = {
+  .path = "test buffer-depot",
+  .short_help = "test buffer-depot [threads <n>] [iter <n>] [batch <n>]",
+  .function = test_depot_fn,
+};
+
+static clib_error_t *
+test_size_class_fn (vlib_main_t *vm, unformat_input_t *input,
+		    vlib_cli_command_t *cmd)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  u32 sizes[] = { 0, 128, 256, 257, 2048, 2049, 9216, 65535 };
+  u8 *pools = bm->size_class_pool_index_for_numa[vm->numa_node];
+  u8 data[4000], contents[sizeof (data)];
+  u32 i, j, bi = ~0, expected;
+  vlib_buffer_t *b, *last;
+  int res = 0;
+  u8 pool;
+
+  for (i = 0; i < ARRAY_LEN (sizes); i++)
+    {
+      if (vlib_buffer_alloc_for_size (vm, &bi, 1, sizes[i]) != 1)
+	return clib_error_create ("buffer allocation failure");
+      pool = vlib_get_buffer (vm, bi)->buffer_pool_index;
+      vlib_buffer_free_one (vm, bi);
+      bi = ~0;
+
+      /* smallest class fitting the size, else the largest */
+      expected = pools[bm->n_size_classes - 1];
+      for (j = 0; j < bm->n_size_classes; j++)
+	if (sizes[i] <= bm->size_class_data_size[j])
+	  {
+	    expected = pools[j];
+	    break;
+	  }
+      TEST (pool == expected, "size %u from pool %u", sizes[i], pool);
+    }
+
+  /* appended data fills each buffer of the chain up to its own size */
+  if (vlib_buffer_alloc_for_size (vm, &bi, 1, 0) != 1)
+    return clib_error_create ("buffer allocation failure");
+  b = last = vlib_get_buffer (vm, bi);
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i;
+
+  TEST (vlib_buffer_chain_append_data_with_alloc (vm, b, &last, data,
+						  sizeof (data)) ==
+	  sizeof (data),
+	"append %u bytes", sizeof (data));
+  TEST (vlib_buffer_contents (vm, bi, contents) == sizeof (data),
+	"chain length %u", vlib_buffer_length_in_chain (vm, b));
+  TEST (memcmp (contents, data, sizeof (data)) == 0, "chain data");
+  goto done;
+
+err:
+  res = 1;
+done:
+  if (bi != ~0)
+    vlib_buffer_free_one (vm, bi);
+  if (res)
+    return clib_error_create ("buffer size class test failed");
+  return 0;
+}
+
+VLIB_CLI_COMMAND (test_size_class_command, static) = {
+  .path = "test buffer-size-class",
+  .short_help = "test buffer-size-class",
+  .function = test_size_class_fn,
+};
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
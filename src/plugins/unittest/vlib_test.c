@@ -14,6 +14,7 @@
  */
 
 #include <vlib/vlib.h>
+#include <vlib/copy.h>
 #include <vnet/vnet.h>
 
 u8 *vlib_validate_buffers (vlib_main_t * vm,
@@ -224,9 +225,361 @@ VLIB_CLI_COMMAND (test_vlib2_command, static) =
 };
 /* *INDENT-ON* */
 
+typedef struct
+{
+  u32 n_batches;
+  u32 len;
+  /* per thread results of the workers */
+  clib_error_t **errors;
+  u32 n_workers_done;
+} test_async_copy_main_t;
+
+static test_async_copy_main_t test_async_copy_main;
+
+static void
+test_async_copy_done (vlib_main_t *vm, vlib_copy_batch_t *b)
+{
+  u32 *n_done = (u32 *) b->cookie[1];
+
+  /* batches complete in submission order */
+  if (b->cookie[0] == *n_done)
+    (*n_done)++;
+}
+
+static clib_error_t *
+test_async_copy_run (vlib_main_t *vm, u32 n_batches, u32 len)
+{
+  vlib_copy_per_thread_t *ptd =
+    vec_elt_at_index (vlib_copy_main.per_thread, vm->thread_index);
+  u64 n_async = ptd->n_async;
+  clib_error_t *error = 0;
+  u8 *src = 0, *dst = 0;
+  vlib_copy_batch_t *b;
+  u32 i, j, n_done = 0;
+
+  vec_validate (src, len - 1);
+  vec_validate (dst, len * n_batches - 1);
+  for (i = 0; i < len; i++)
+    src[i] = i * 7;
+
+  /* more batches than the thread has forces early completions */
+  for (i = 0; i < n_batches; i++)
+    {
+      b = vlib_copy_batch_get (vm, test_async_copy_done);
+      /* odd-sized chunks, from 1 byte to the whole buffer */
+      for (j = 0; j < len;)
+	{
+	  u32 n = clib_min (len - j, 1 + (i + j) % 3001);
+	  vlib_copy_batch_add (b, dst + i * len + j, src + j, n);
+	  j += n;
+	}
+      b->cookie[0] = i;
+      b->cookie[1] = pointer_to_uword (&n_done);
+      vlib_copy_batch_submit (vm, b);
+    }
+  vlib_copy_wait_all (vm);
+
+  if (n_done != n_batches)
+    {
+      error = clib_error_return (0, "thread %u: %u batches completed in "
+				 "order out of %u", vm->thread_index,
+				 n_done, n_batches);
+      goto done;
+    }
+
+  for (i = 0; i < n_batches; i++)
+    if (memcmp (dst + i * len, src, len))
+      {
+	error = clib_error_return (0, "thread %u: batch %u data mismatch",
+				   vm->thread_index, i);
+	goto done;
+      }
+
+  if (vlib_copy_is_async () && len >= vlib_copy_main.min_async_bytes &&
+      ptd->n_async == n_async)
+    error = clib_error_return (0, "thread %u: no batch was handed off",
+			       vm->thread_index);
+
+done:
+  vec_free (src);
+  vec_free (dst);
+  return error;
+}
+
+/* runs the test once on each worker it is scheduled on */
+static uword
+test_async_copy_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
+			 vlib_frame_t *frame)
+{
+  test_async_copy_main_t *tm = &test_async_copy_main;
+
+  tm->errors[vm->thread_index] =
+    test_async_copy_run (vm, tm->n_batches, tm->len);
+  clib_atomic_fetch_add (&tm->n_workers_done, 1);
+  return 0;
+}
+
+VLIB_REGISTER_NODE (test_async_copy_node, static) = {
+  .function = test_async_copy_node_fn,
+  .name = "test-async-copy",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+};
+
+static clib_error_t *
+test_async_copy_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			    vlib_cli_command_t *cmd)
+{
+  test_async_copy_main_t *tm = &test_async_copy_main;
+  u32 n_batches = 2 * VLIB_COPY_RING_SIZE + 3;
+  u32 len = 64 << 10, n_workers, i;
+  clib_error_t *error;
+  f64 timeout;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "batches %u", &n_batches))
+	;
+      else if (unformat (input, "len %u", &len))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_batches == 0 || len == 0)
+    return clib_error_return (0, "batches and len must be non-zero");
+
+  if ((error = test_async_copy_run (vm, n_batches, len)))
+    return error;
+
+  /* the command is mp-safe, so the workers run their share concurrently */
+  n_workers = vlib_get_n_threads () - 1;
+  tm->n_batches = n_batches;
+  tm->len = len;
+  tm->n_workers_done = 0;
+  vec_validate (tm->errors, n_workers);
+  for (i = 1; i <= n_workers; i++)
+    {
+      tm->errors[i] = 0;
+      vlib_node_set_interrupt_pending (vlib_get_main_by_index (i),
+				       test_async_copy_node.index);
+    }
+
+  timeout = vlib_time_now (vm) + 10;
+  while (clib_atomic_load_acq_n (&tm->n_workers_done) < n_workers)
+    {
+      if (vlib_time_now (vm) > timeout)
+	return clib_error_return (0, "%u of %u workers done",
+				  tm->n_workers_done, n_workers);
+      vlib_process_suspend (vm, 1e-3);
+    }
+
+  for (i = 1; i <= n_workers; i++)
+    if (tm->errors[i] && !error)
+      error = tm->errors[i];
+    else
+      clib_error_free (tm->errors[i]);
+  if (error)
+    return error;
 
+  vlib_cli_output (vm, "%U", format_vlib_copy_main, &vlib_copy_main);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (test_async_copy_command, static) = {
+  .path = "test async-copy",
+  .short_help = "test async-copy [batches <n>] [len <n>]",
+  .function = test_async_copy_command_fn,
+  .is_mp_safe = 1,
+};
+
+typedef struct
+{
+  /* worker loop counts when the call was queued */
+  u32 *loop_counts;
+  u32 n_calls;
+  clib_error_t *error;
+} test_quiescence_main_t;
 
+static test_quiescence_main_t test_quiescence_main;
 
+static void
+test_quiescence_call (void *arg)
+{
+  test_quiescence_main_t *qm = arg;
+  u32 i;
+
+  qm->n_calls++;
+  if (vlib_worker_thread_barrier_held ())
+    {
+      qm->error = clib_error_return (0, "called under the barrier");
+      return;
+    }
+  for (i = 1; i < vec_len (qm->loop_counts); i++)
+    if (qm->loop_counts[i] ==
+	clib_atomic_load_acq_n (&vlib_get_main_by_index (i)->main_loop_count))
+      {
+	qm->error = clib_error_return (0, "called before worker %u went "
+				       "around its loop", i);
+	return;
+      }
+}
+
+static clib_error_t *
+test_quiescence_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			    vlib_cli_command_t *cmd)
+{
+  test_quiescence_main_t *qm = &test_quiescence_main;
+  u32 n_threads = vlib_get_n_threads ();
+  u32 i, n_calls, barrier;
+  f64 timeout;
+
+  if (n_threads < 2)
+    return clib_error_return (0, "test needs workers");
+
+  /* queue the call with the workers running, then while they are parked
+   * at the barrier */
+  for (barrier = 0; barrier < 2; barrier++)
+    {
+      qm->n_calls = 0;
+      qm->error = 0;
+      vec_validate (qm->loop_counts, n_threads - 1);
+
+      if (barrier)
+	vlib_worker_thread_barrier_sync (vm);
+      for (i = 1; i < n_threads; i++)
+	qm->loop_counts[i] = clib_atomic_load_acq_n (
+	  &vlib_get_main_by_index (i)->main_loop_count);
+      vlib_worker_call_after_quiescence (test_quiescence_call, qm);
+      n_calls = qm->n_calls;
+      if (barrier)
+	vlib_worker_thread_barrier_release (vm);
+
+      if (n_calls)
+	return clib_error_return (0, "called without a grace period");
+
+      timeout = vlib_time_now (vm) + 5;
+      while (qm->n_calls == 0)
+	{
+	  if (vlib_time_now (vm) > timeout)
+	    return clib_error_return (0, "call not made");
+	  vlib_process_suspend (vm, 1e-3);
+	}
+
+      if (qm->n_calls != 1)
+	return clib_error_return (0, "called %u times", qm->n_calls);
+      if (qm->error)
+	return qm->error;
+
+      vlib_cli_output (vm, "%s: called after the workers went around",
+		       barrier ? "barrier" : "running");
+    }
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (test_quiescence_command, static) = {
+  .path = "test worker-quiescence",
+  .short_help = "test worker-quiescence",
+  .function = test_quiescence_command_fn,
+  .is_mp_safe = 1,
+};
+
+/* Place workers on a fake topology: 2 NUMA nodes of 2 cores of 2
+   hyperthreads, numbered the Linux way, cpu n and n + 4 are siblings and
+   node 0 holds cores 0 and 1. The main thread runs on cpu 1. */
+static clib_error_t *
+test_cpu_placement_one (vlib_main_t *vm, vlib_cpu_topology_t *topology,
+			uword *numa_bitmap, u32 *expected, u32 n_expected)
+{
+  uword *avail = 0, *busy = 0, c;
+  clib_error_t *error = 0;
+  u32 i;
+
+  avail = clib_bitmap_set_region (avail, 0, 1, 8);
+  avail = clib_bitmap_set (avail, 1, 0);
+  busy = vlib_thread_placement_busy (topology, busy, 1);
+
+  for (i = 0; i <= n_expected; i++)
+    {
+      c = vlib_thread_placement_next_cpu (topology, numa_bitmap, avail,
+					  busy);
+      if (i == n_expected)
+	{
+	  if (c != ~0)
+	    error = clib_error_return (0, "cpu %lu placed, none left", c);
+	  break;
+	}
+      if (c != expected[i])
+	{
+	  error = clib_error_return (0, "worker %u placed on cpu %ld, "
+				     "expected %u", i, c, expected[i]);
+	  break;
+	}
+      avail = clib_bitmap_set (avail, c, 0);
+      busy = vlib_thread_placement_busy (topology, busy, c);
+    }
+
+  clib_bitmap_free (avail);
+  clib_bitmap_free (busy);
+  return error;
+}
+
+static clib_error_t *
+test_cpu_placement_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			       vlib_cli_command_t *cmd)
+{
+  /* physical cores of the NIC node first, then their hyperthreads, then
+   * the other node, the core of cpu 0 last */
+  u32 nic_on_1[] = { 2, 3, 6, 7, 5, 0, 4 };
+  u32 no_nic[] = { 2, 3, 5, 6, 7, 0, 4 };
+  u32 no_topology[] = { 2, 3, 4, 5, 6, 7, 0 };
+  vlib_cpu_topology_t *topology = 0, *t;
+  uword *numa_bitmap = 0;
+  clib_error_t *error;
+  u32 c;
+
+  vec_validate (topology, 7);
+  vec_foreach_index (c, topology)
+    {
+      t = topology + c;
+      t->core_id = c % 4;
+      t->package_id = t->numa_id = (c % 4) / 2;
+      t->siblings = clib_bitmap_set (t->siblings, c % 4, 1);
+      t->siblings = clib_bitmap_set (t->siblings, c % 4 + 4, 1);
+    }
+
+  numa_bitmap = clib_bitmap_set (numa_bitmap, 1, 1);
+  if ((error = test_cpu_placement_one (vm, topology, numa_bitmap, nic_on_1,
+				       ARRAY_LEN (nic_on_1))))
+    goto done;
+  vlib_cli_output (vm, "nic on node 1: ok");
+
+  if ((error = test_cpu_placement_one (vm, topology, 0, no_nic,
+				       ARRAY_LEN (no_nic))))
+    goto done;
+  vlib_cli_output (vm, "no nic: ok");
+
+  /* topology unknown, every cpu on its own core off the NIC node */
+  if ((error = test_cpu_placement_one (vm, 0, numa_bitmap, no_topology,
+				       ARRAY_LEN (no_topology))))
+    goto done;
+  vlib_cli_output (vm, "no topology: ok");
+
+done:
+  vec_foreach (t, topology)
+    clib_bitmap_free (t->siblings);
+  vec_free (topology);
+  clib_bitmap_free (numa_bitmap);
+  return error;
+}
+
+VLIB_CLI_COMMAND (test_cpu_placement_command, static) = {
+  .path = "test cpu-placement",
+  .short_help = "test cpu-placement",
+  .function = test_cpu_placement_command_fn,
+};
 
 /*
  * fd.io coding-style-patch-verification: ON
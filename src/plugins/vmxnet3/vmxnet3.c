@@ -826,6 +826,7 @@ vmxnet3_create_if (vlib_main_t * vm, vmxnet3_create_if_args_t * args)
 		   VNET_HW_INTERFACE_CAP_SUPPORTS_TX_UDP_CKSUM);
     }
 
+  hw->numa_node = vd->numa_node;
   vnet_hw_if_set_input_node (vnm, vd->hw_if_index, vmxnet3_input_node.index);
   /* Disable interrupts */
   vmxnet3_disable_interrupt (vd);
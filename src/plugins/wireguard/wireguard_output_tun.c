@@ -149,7 +149,7 @@ VLIB_NODE_FN (wg_output_tun_node) (vlib_main_t * vm,
        */
       if (PREDICT_FALSE (encrypted_packet_len >= WG_DEFAULT_DATA_SIZE) ||
 	  PREDICT_FALSE ((b[0]->current_data + encrypted_packet_len) >=
-			 vlib_buffer_get_default_data_size (vm)))
+			 vlib_buffer_get_data_size (vm, b[0])))
 	{
 	  b[0]->error = node->errors[WG_OUTPUT_ERROR_TOO_BIG];
 	  goto out;
@@ -74,6 +74,10 @@ buffer_gauges_update_available_fn (stat_segment_directory_entry_t * e,
 static void
 buffer_gauges_update_used_fn (stat_segment_directory_entry_t * e, u32 index);
 
+static void
+buffer_gauges_update_contention_fn (stat_segment_directory_entry_t *e,
+				    u32 index);
+
 uword
 vlib_buffer_length_in_chain_slow_path (vlib_main_t * vm,
 				       vlib_buffer_t * b_first)
@@ -215,10 +219,9 @@ vlib_validate_buffer_helper (vlib_main_t * vm,
   if ((signed) b->current_data < (signed) -VLIB_BUFFER_PRE_DATA_SIZE)
     return format (0, "current data %d before pre-data", b->current_data);
 
-  if (b->current_data + b->current_length >
-      vlib_buffer_get_default_data_size (vm))
+  if (b->current_data + b->current_length > vlib_buffer_get_data_size (vm, b))
     return format (0, "%d-%d beyond end of buffer %d", b->current_data,
-		   b->current_length, vlib_buffer_get_default_data_size (vm));
+		   b->current_length, vlib_buffer_get_data_size (vm, b));
 
   if (follow_buffer_next && (b->flags & VLIB_BUFFER_NEXT_PRESENT))
     {
@@ -408,7 +411,6 @@ vlib_buffer_add_data (vlib_main_t * vm, u32 * buffer_index, void *data,
 
   d = data;
   n_left = n_data_bytes;
-  n_buffer_bytes = vlib_buffer_get_default_data_size (vm);
 
   b = vlib_get_buffer (vm, bi);
   b->flags &= ~VLIB_BUFFER_TOTAL_LENGTH_VALID;
@@ -421,6 +423,7 @@ vlib_buffer_add_data (vlib_main_t * vm, u32 * buffer_index, void *data,
     {
       u32 n;
 
+      n_buffer_bytes = vlib_buffer_get_data_size (vm, b);
       ASSERT (n_buffer_bytes >= b->current_length);
       n_left_this_buffer =
 	n_buffer_bytes - (b->current_data + b->current_length);
@@ -456,7 +459,7 @@ vlib_buffer_chain_append_data_with_alloc (vlib_main_t * vm,
 					  u16 data_len)
 {
   vlib_buffer_t *l = *last;
-  u32 n_buffer_bytes = vlib_buffer_get_default_data_size (vm);
+  u32 n_buffer_bytes = vlib_buffer_get_data_size (vm, l);
   u16 copied = 0;
   ASSERT (n_buffer_bytes >= l->current_length + l->current_data);
   while (data_len)
@@ -468,6 +471,7 @@ vlib_buffer_chain_append_data_with_alloc (vlib_main_t * vm,
 						first->buffer_pool_index))
 	    return copied;
 	  *last = l = vlib_buffer_chain_buffer (vm, l, l->next_buffer);
+	  n_buffer_bytes = vlib_buffer_get_data_size (vm, l);
 	  max = n_buffer_bytes - l->current_length - l->current_data;
 	}
 
@@ -494,6 +498,127 @@ vlib_buffer_alloc_size (uword ext_hdr_size, uword data_size)
   return alloc_size;
 }
 
+/* Magazines beyond those needed to hold all buffers of a pool, so threads
+ * moving buffers between their cache and the depot find an empty one */
+#define VLIB_BUFFER_POOL_N_SPARE_MAGAZINES 64
+
+__clib_export uword
+vlib_buffer_pool_get_slow (vlib_buffer_pool_t *bp,
+			   vlib_buffer_pool_thread_t *bpt, u32 *buffers,
+			   u32 n_buffers)
+{
+  u32 n, n_left = n_buffers;
+
+  bpt->n_locked++;
+  clib_spinlock_lock (&bp->lock);
+
+  while (1)
+    {
+      n = clib_min (n_left, bp->n_avail);
+      bp->n_avail -= n;
+      vlib_buffer_copy_indices (buffers, bp->buffers + bp->n_avail, n);
+      buffers += n;
+      n_left -= n;
+
+      /* break a full magazine for the rest */
+      if (n_left == 0 ||
+	  vlib_buffer_depot_get (bp, bpt, bp->buffers + bp->n_avail))
+	break;
+      bp->n_avail += VLIB_BUFFER_MAGAZINE_SZ;
+    }
+
+  clib_spinlock_unlock (&bp->lock);
+  return n_buffers - n_left;
+}
+
+__clib_export void
+vlib_buffer_pool_put_slow (vlib_buffer_pool_t *bp,
+			   vlib_buffer_pool_thread_t *bpt, u32 *buffers,
+			   u32 n_buffers)
+{
+  bpt->n_locked++;
+  clib_spinlock_lock (&bp->lock);
+
+  vlib_buffer_copy_indices (bp->buffers + bp->n_avail, buffers, n_buffers);
+  bp->n_avail += n_buffers;
+
+  /* back to the depot as soon as empty magazines are */
+  while (bp->n_avail >= VLIB_BUFFER_MAGAZINE_SZ &&
+	 vlib_buffer_depot_put (bp, bpt, bp->buffers + bp->n_avail -
+					    VLIB_BUFFER_MAGAZINE_SZ) == 0)
+    bp->n_avail -= VLIB_BUFFER_MAGAZINE_SZ;
+
+  clib_spinlock_unlock (&bp->lock);
+}
+
+/* Called when a free overflows the per-thread cache. It runs at most once
+ * per magazine freed, and inlined it would grow the stack frame of every
+ * caller of vlib_buffer_free */
+__clib_export void
+vlib_buffer_pool_put_magazines (vlib_buffer_pool_t *bp,
+				vlib_buffer_pool_thread_t *bpt, u32 *buffers,
+				u32 n_buffers)
+{
+  u32 n_cached = bpt->n_cached;
+  u32 n_empty = VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ - n_cached;
+
+  /* give whole magazines to the depot, the freed buffers first */
+  while (n_buffers > n_empty && n_buffers >= VLIB_BUFFER_MAGAZINE_SZ)
+    {
+      if (vlib_buffer_depot_put (bp, bpt, buffers + n_buffers -
+					     VLIB_BUFFER_MAGAZINE_SZ))
+	goto no_empty_magazine;
+      n_buffers -= VLIB_BUFFER_MAGAZINE_SZ;
+    }
+
+  /* less than a magazine left not fitting, so the cache holds more */
+  if (n_buffers > n_empty)
+    {
+      if (vlib_buffer_depot_put (bp, bpt, bpt->cached_buffers + n_cached -
+					     VLIB_BUFFER_MAGAZINE_SZ))
+	goto no_empty_magazine;
+      n_cached -= VLIB_BUFFER_MAGAZINE_SZ;
+    }
+
+  vlib_buffer_copy_indices (bpt->cached_buffers + n_cached, buffers,
+			    n_buffers);
+  bpt->n_cached = n_cached + n_buffers;
+  return;
+
+no_empty_magazine:
+  vlib_buffer_copy_indices (bpt->cached_buffers + n_cached,
+			    buffers + n_buffers - n_empty, n_empty);
+  bpt->n_cached = VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ;
+  vlib_buffer_pool_put_slow (bp, bpt, buffers, n_buffers - n_empty);
+}
+
+static void
+vlib_buffer_pool_init_depot (vlib_buffer_pool_t *bp)
+{
+  vlib_buffer_pool_thread_t *bpt = vec_elt_at_index (bp->threads, 0);
+  u32 i, n_magazines;
+
+  n_magazines = bp->n_avail / VLIB_BUFFER_MAGAZINE_SZ +
+		VLIB_BUFFER_POOL_N_SPARE_MAGAZINES;
+  bp->magazines = clib_mem_alloc_aligned (
+    n_magazines * sizeof (vlib_buffer_magazine_t), CLIB_CACHE_LINE_BYTES);
+  bp->full.index = bp->empty.index = ~0;
+
+  /* the buffers stay listed in bp->buffers, which is only a copy */
+  for (i = 0; i < n_magazines; i++)
+    if (bp->n_avail >= VLIB_BUFFER_MAGAZINE_SZ)
+      {
+	bp->n_avail -= VLIB_BUFFER_MAGAZINE_SZ;
+	vlib_buffer_copy_indices (bp->magazines[i].buffers,
+				  bp->buffers + bp->n_avail,
+				  VLIB_BUFFER_MAGAZINE_SZ);
+	vlib_buffer_depot_push (bp, &bp->full, bpt, i);
+	bp->n_magazines_init++;
+      }
+    else
+      vlib_buffer_depot_push (bp, &bp->empty, bpt, i);
+}
+
 u8
 vlib_buffer_pool_create (vlib_main_t * vm, char *name, u32 data_size,
 			 u32 physmem_map_index)
@@ -585,6 +710,8 @@ vlib_buffer_pool_create (vlib_main_t * vm, char *name, u32 data_size,
 	vlib_get_buffer (vm, bi);
       }
 
+  vlib_buffer_pool_init_depot (bp);
+
   return bp->index;
 }
 
@@ -594,23 +721,29 @@ format_vlib_buffer_pool (u8 * s, va_list * va)
   vlib_main_t *vm = va_arg (*va, vlib_main_t *);
   vlib_buffer_pool_t *bp = va_arg (*va, vlib_buffer_pool_t *);
   vlib_buffer_pool_thread_t *bpt;
-  u32 cached = 0;
+  u32 cached = 0, avail;
+  u64 retries = 0, locked = 0;
 
   if (!bp)
-    return format (s, "%-20s%=6s%=6s%=6s%=11s%=6s%=8s%=8s%=8s",
+    return format (s, "%-20s%=6s%=6s%=6s%=11s%=6s%=8s%=8s%=8s%=10s%=10s",
 		   "Pool Name", "Index", "NUMA", "Size", "Data Size",
-		   "Total", "Avail", "Cached", "Used");
+		   "Total", "Avail", "Cached", "Used", "Retries", "Locked");
 
   /* *INDENT-OFF* */
   vec_foreach (bpt, bp->threads)
-    cached += bpt->n_cached;
+    {
+      cached += bpt->n_cached;
+      retries += bpt->n_depot_retries;
+      locked += bpt->n_locked;
+    }
   /* *INDENT-ON* */
 
-  s = format (s, "%-20s%=6d%=6d%=6u%=11u%=6u%=8u%=8u%=8u",
+  avail = vlib_buffer_pool_n_avail (bp);
+  s = format (s, "%-20s%=6d%=6d%=6u%=11u%=6u%=8u%=8u%=8u%=10lu%=10lu",
 	      bp->name, bp->index, bp->numa_node, bp->data_size +
 	      sizeof (vlib_buffer_t) + vm->buffer_main->ext_hdr_size,
-	      bp->data_size, bp->n_buffers, bp->n_avail, cached,
-	      bp->n_buffers - bp->n_avail - cached);
+	      bp->data_size, bp->n_buffers, avail, cached,
+	      bp->n_buffers - avail - cached, retries, locked);
 
   return s;
 }
@@ -669,12 +802,13 @@ VLIB_WORKER_INIT_FUNCTION (vlib_buffer_worker_init);
 
 static clib_error_t *
 vlib_buffer_main_init_numa_alloc (struct vlib_main_t *vm, u32 numa_node,
+				  u32 data_size, u32 n_buffers,
 				  u32 * physmem_map_index,
 				  clib_mem_page_sz_t log2_page_size,
 				  u8 unpriv)
 {
   vlib_buffer_main_t *bm = vm->buffer_main;
-  u32 buffers_per_numa = bm->buffers_per_numa;
+  u32 buffers_per_numa = n_buffers ? n_buffers : bm->buffers_per_numa;
   clib_error_t *error;
   u32 buffer_size;
   uword n_pages, pagesize;
@@ -683,9 +817,7 @@ vlib_buffer_main_init_numa_alloc (struct vlib_main_t *vm, u32 numa_node,
   ASSERT (log2_page_size != CLIB_MEM_PAGE_SZ_UNKNOWN);
 
   pagesize = clib_mem_page_bytes (log2_page_size);
-  buffer_size = vlib_buffer_alloc_size (bm->ext_hdr_size,
-					vlib_buffer_get_default_data_size
-					(vm));
+  buffer_size = vlib_buffer_alloc_size (bm->ext_hdr_size, data_size);
   if (buffer_size > pagesize)
     return clib_error_return (0, "buffer size (%llu) is greater than page "
 			      "size (%llu)", buffer_size, pagesize);
@@ -694,7 +826,10 @@ vlib_buffer_main_init_numa_alloc (struct vlib_main_t *vm, u32 numa_node,
     buffers_per_numa = unpriv ? VLIB_BUFFER_DEFAULT_BUFFERS_PER_NUMA_UNPRIV :
       VLIB_BUFFER_DEFAULT_BUFFERS_PER_NUMA;
 
-  name = format (0, "buffers-numa-%d%c", numa_node, 0);
+  if (data_size == bm->default_data_size)
+    name = format (0, "buffers-numa-%d%c", numa_node, 0);
+  else
+    name = format (0, "buffers-%u-numa-%d%c", data_size, numa_node, 0);
   n_pages = (buffers_per_numa - 1) / (pagesize / buffer_size) + 1;
   error = vlib_physmem_shared_map_create (vm, (char *) name,
 					  n_pages * pagesize,
@@ -706,7 +841,7 @@ vlib_buffer_main_init_numa_alloc (struct vlib_main_t *vm, u32 numa_node,
 
 static clib_error_t *
 vlib_buffer_main_init_numa_node (struct vlib_main_t *vm, u32 numa_node,
-				 u8 * index)
+				 u32 data_size, u32 n_buffers, u8 * index)
 {
   vlib_buffer_main_t *bm = vm->buffer_main;
   u32 physmem_map_index;
@@ -715,8 +850,8 @@ vlib_buffer_main_init_numa_node (struct vlib_main_t *vm, u32 numa_node,
 
   if (bm->log2_page_size == CLIB_MEM_PAGE_SZ_UNKNOWN)
     {
-      error = vlib_buffer_main_init_numa_alloc (vm, numa_node,
-						&physmem_map_index,
+      error = vlib_buffer_main_init_numa_alloc (vm, numa_node, data_size,
+						n_buffers, &physmem_map_index,
 						CLIB_MEM_PAGE_SZ_DEFAULT_HUGE,
 						0 /* unpriv */ );
       if (!error)
@@ -728,23 +863,25 @@ vlib_buffer_main_init_numa_node (struct vlib_main_t *vm, u32 numa_node,
 		     "buffer pool (%U)", numa_node, format_clib_error, error);
       clib_error_free (error);
 
-      error = vlib_buffer_main_init_numa_alloc (vm, numa_node,
-						&physmem_map_index,
+      error = vlib_buffer_main_init_numa_alloc (vm, numa_node, data_size,
+						n_buffers, &physmem_map_index,
 						CLIB_MEM_PAGE_SZ_DEFAULT,
 						1 /* unpriv */ );
     }
   else
-    error = vlib_buffer_main_init_numa_alloc (vm, numa_node,
-					      &physmem_map_index,
+    error = vlib_buffer_main_init_numa_alloc (vm, numa_node, data_size,
+					      n_buffers, &physmem_map_index,
 					      bm->log2_page_size,
 					      0 /* unpriv */ );
   if (error)
     return error;
 
 buffer_pool_create:
-  name = format (name, "default-numa-%d%c", numa_node, 0);
-  *index = vlib_buffer_pool_create (vm, (char *) name,
-				    vlib_buffer_get_default_data_size (vm),
+  if (data_size == bm->default_data_size)
+    name = format (name, "default-numa-%d%c", numa_node, 0);
+  else
+    name = format (name, "%u-numa-%d%c", data_size, numa_node, 0);
+  *index = vlib_buffer_pool_create (vm, (char *) name, data_size,
 				    physmem_map_index);
 
   if (*index == (u8) ~ 0)
@@ -755,6 +892,70 @@ buffer_pool_create:
   return error;
 }
 
+static int
+vlib_buffer_size_class_cmp (void *a1, void *a2)
+{
+  vlib_buffer_size_class_t *sc1 = a1, *sc2 = a2;
+
+  return (int) sc1->data_size - (int) sc2->data_size;
+}
+
+/* Create the pools of the configured size classes next to the default
+ * pools, and sort all classes by data size for vlib_buffer_pool_get_for_size
+ */
+static void
+vlib_buffer_main_init_size_classes (struct vlib_main_t *vm, uword *bmp)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_size_class_t *sc, *classes = 0;
+  clib_error_t *err;
+  u32 numa_node, i;
+  u8 index;
+
+  vec_add2 (classes, sc, 1);
+  sc->data_size = bm->default_data_size;
+
+  vec_foreach (sc, bm->size_classes)
+    {
+      if (sc->data_size == bm->default_data_size)
+	vlib_log_warn (bm->log_default,
+		       "size class %u is the default data size, ignored",
+		       sc->data_size);
+      else
+	vec_add1 (classes, sc[0]);
+    }
+
+  vec_sort_with_function (classes, vlib_buffer_size_class_cmp);
+
+  vec_foreach (sc, classes)
+    {
+      i = sc - classes;
+      bm->size_class_data_size[i] = sc->data_size;
+
+      clib_bitmap_foreach (numa_node, bmp)
+	{
+	  bm->size_class_pool_index_for_numa[numa_node][i] =
+	    bm->default_buffer_pool_index_for_numa[numa_node];
+
+	  if (sc->data_size == bm->default_data_size)
+	    continue;
+
+	  if ((err = vlib_buffer_main_init_numa_node (
+		 vm, numa_node, sc->data_size, sc->n_buffers, &index)))
+	    {
+	      clib_error_report (err);
+	      clib_error_free (err);
+	      continue;
+	    }
+
+	  bm->size_class_pool_index_for_numa[numa_node][i] = index;
+	}
+    }
+
+  bm->n_size_classes = vec_len (classes);
+  vec_free (classes);
+}
+
 void
 vlib_buffer_main_alloc (vlib_main_t * vm)
 {
@@ -805,7 +1006,8 @@ buffer_gauges_update_used_fn (stat_segment_directory_entry_t * e, u32 index)
   if (!bp)
     return;
 
-  e->value = bp->n_buffers - bp->n_avail - buffer_get_cached (bp);
+  e->value =
+    bp->n_buffers - vlib_buffer_pool_n_avail (bp) - buffer_get_cached (bp);
 }
 
 static void
@@ -817,7 +1019,7 @@ buffer_gauges_update_available_fn (stat_segment_directory_entry_t * e,
   if (!bp)
     return;
 
-  e->value = bp->n_avail;
+  e->value = vlib_buffer_pool_n_avail (bp);
 }
 
 static void
@@ -831,6 +1033,21 @@ buffer_gauges_update_cached_fn (stat_segment_directory_entry_t * e, u32 index)
   e->value = buffer_get_cached (bp);
 }
 
+static void
+buffer_gauges_update_contention_fn (stat_segment_directory_entry_t *e,
+				    u32 index)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_buffer_pool_t *bp = buffer_get_by_index (vm->buffer_main, index);
+  vlib_buffer_pool_thread_t *bpt;
+  if (!bp)
+    return;
+
+  e->value = 0;
+  vec_foreach (bpt, bp->threads)
+    e->value += bpt->n_depot_retries + bpt->n_locked;
+}
+
 clib_error_t *
 vlib_buffer_main_init (struct vlib_main_t * vm)
 {
@@ -873,7 +1090,8 @@ vlib_buffer_main_init (struct vlib_main_t * vm)
     {
       u8 *index = bm->default_buffer_pool_index_for_numa + numa_node;
       index[0] = ~0;
-      if ((err = vlib_buffer_main_init_numa_node (vm, numa_node, index)))
+      if ((err = vlib_buffer_main_init_numa_node (
+	     vm, numa_node, bm->default_data_size, 0, index)))
         {
 	  clib_error_report (err);
 	  clib_error_free (err);
@@ -900,6 +1118,8 @@ vlib_buffer_main_init (struct vlib_main_t * vm)
     }
   /* *INDENT-ON* */
 
+  vlib_buffer_main_init_size_classes (vm, bmp);
+
   vec_foreach (bp, bm->buffer_pools)
   {
     if (bp->n_buffers == 0)
@@ -919,6 +1139,11 @@ vlib_buffer_main_init (struct vlib_main_t * vm)
     name = format (name, "/buffer-pools/%s/available%c", bp->name, 0);
     stat_segment_register_gauge (name, buffer_gauges_update_available_fn,
 				 bp - bm->buffer_pools);
+
+    vec_reset_length (name);
+    name = format (name, "/buffer-pools/%s/contention%c", bp->name, 0);
+    stat_segment_register_gauge (name, buffer_gauges_update_contention_fn,
+				 bp - bm->buffer_pools);
   }
 
 done:
@@ -932,6 +1157,7 @@ static clib_error_t *
 vlib_buffers_configure (vlib_main_t * vm, unformat_input_t * input)
 {
   vlib_buffer_main_t *bm;
+  vlib_buffer_size_class_t sc, *s;
 
   vlib_buffer_main_alloc (vm);
 
@@ -948,6 +1174,25 @@ vlib_buffers_configure (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "default data-size %u",
 			 &bm->default_data_size))
 	;
+      else if (unformat (input, "size-class data-size %u", &sc.data_size))
+	{
+	  sc.n_buffers = 0;
+	  if (unformat (input, "buffers %u", &sc.n_buffers))
+	    ;
+
+	  if (sc.data_size < VLIB_BUFFER_MIN_CHAIN_SEG_SIZE)
+	    return clib_error_return (0, "size class data size %u below %u",
+				      sc.data_size,
+				      VLIB_BUFFER_MIN_CHAIN_SEG_SIZE);
+	  if (vec_len (bm->size_classes) >= VLIB_BUFFER_MAX_SIZE_CLASSES - 1)
+	    return clib_error_return (0, "too many size classes");
+	  vec_foreach (s, bm->size_classes)
+	    if (s->data_size == sc.data_size)
+	      return clib_error_return (0, "duplicate size class %u",
+					sc.data_size);
+
+	  vec_add1 (bm->size_classes, sc);
+	}
       else
 	return unformat_parse_error (input);
     }
@@ -440,13 +440,45 @@ struct vlib_main_t;
 
 #define VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ 512
 
+/* Buffers move between the per-thread caches and the pool in magazines of
+   this many buffers */
+#define VLIB_BUFFER_MAGAZINE_SZ 64
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   u32 cached_buffers[VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ];
   u32 n_cached;
+
+  /* magazines this thread took from and gave to the depot */
+  u64 n_magazines_out;
+  u64 n_magazines_in;
+
+  /* contention: failed depot compare-and-swaps, and slow path entries
+     taking the pool lock */
+  u64 n_depot_retries;
+  u64 n_locked;
 } vlib_buffer_pool_thread_t;
 
+typedef struct
+{
+  u32 next;
+  u32 buffers[VLIB_BUFFER_MAGAZINE_SZ];
+} vlib_buffer_magazine_t;
+
+/* Head of a lock-free stack of magazines. The tag changes on every update
+   so a compare-and-swap fails if the head was popped and pushed back
+   meanwhile (ABA). */
+typedef union
+{
+  struct
+  {
+    u32 index;
+    u32 tag;
+  };
+  u64 as_u64;
+} vlib_buffer_depot_head_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
@@ -463,15 +495,35 @@ typedef struct
   u8 *name;
   clib_spinlock_t lock;
 
+  /* Depot: full magazines of free buffers, and empty magazines. The
+     buffers list above, protected by the lock, only holds what does not
+     make a whole magazine, n_avail counts it. */
+  vlib_buffer_magazine_t *magazines;
+  u32 n_magazines_init;
+
   /* per-thread data */
   vlib_buffer_pool_thread_t *threads;
 
+  CLIB_CACHE_LINE_ALIGN_MARK (depot);
+  vlib_buffer_depot_head_t full;
+  vlib_buffer_depot_head_t empty;
+
   /* buffer metadata template */
   vlib_buffer_t buffer_template;
 } vlib_buffer_pool_t;
 
 #define VLIB_BUFFER_MAX_NUMA_NODES 32
 
+/* Number of buffer data sizes, the default one included */
+#define VLIB_BUFFER_MAX_SIZE_CLASSES 4
+
+typedef struct
+{
+  u32 data_size;
+  /* per numa node, 0 for buffers-per-numa */
+  u32 n_buffers;
+} vlib_buffer_size_class_t;
+
 typedef u32 (vlib_buffer_alloc_free_callback_t) (struct vlib_main_t *vm,
 						 u8 buffer_pool_index,
 						 u32 *buffers, u32 n_buffers);
@@ -490,10 +542,19 @@ typedef struct
 
   u8 default_buffer_pool_index_for_numa[VLIB_BUFFER_MAX_NUMA_NODES];
 
+  /* Data size of each size class, smallest first, the default data size
+     being one of them, and the buffer pool of each class on each numa
+     node. A numa node without a pool for a class uses its default pool. */
+  u32 size_class_data_size[VLIB_BUFFER_MAX_SIZE_CLASSES];
+  u8 size_class_pool_index_for_numa[VLIB_BUFFER_MAX_NUMA_NODES]
+				   [VLIB_BUFFER_MAX_SIZE_CLASSES];
+  u8 n_size_classes;
+
   /* config */
   u32 buffers_per_numa;
   u16 ext_hdr_size;
   u32 default_data_size;
+  vlib_buffer_size_class_t *size_classes;
   clib_mem_page_sz_t log2_page_size;
 
   /* Hash table mapping buffer index into number
@@ -169,9 +169,10 @@ next:
 CLIB_MARCH_FN_REGISTRATION (vlib_buffer_enqueue_to_single_next_fn);
 
 static inline vlib_frame_queue_elt_t *
-vlib_get_frame_queue_elt (vlib_frame_queue_main_t *fqm, u32 index,
-			  int dont_wait)
+vlib_get_frame_queue_elt (vlib_main_t *vm, vlib_frame_queue_main_t *fqm,
+			  u32 index, int dont_wait)
 {
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
   vlib_frame_queue_t *fq;
   u64 nelts, tail, new_tail;
 
@@ -186,7 +187,11 @@ retry:
   if (new_tail >= fq->head + nelts)
     {
       if (dont_wait)
-	return 0;
+	{
+	  vlib_histogram_add (&tm->handoff_queue_depth, vm->thread_index,
+			      index, nelts);
+	  return 0;
+	}
 
       /* Wait until a ring slot is available */
       while (new_tail >= fq->head + nelts)
@@ -197,6 +202,9 @@ retry:
 				    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
     goto retry;
 
+  vlib_histogram_add (&tm->handoff_queue_depth, vm->thread_index, index,
+		      new_tail - fq->head);
+
   return fq->elts + (new_tail & (nelts - 1));
 }
 
@@ -218,7 +226,7 @@ vlib_buffer_enqueue_to_thread_inline (vlib_main_t *vm,
 
 more:
   clib_mask_compare_u16 (thread_index, thread_indices, mask, n_packets);
-  hf = vlib_get_frame_queue_elt (fqm, thread_index, drop_on_congestion);
+  hf = vlib_get_frame_queue_elt (vm, fqm, thread_index, drop_on_congestion);
 
   n_comp = clib_compress_u32 (hf ? hf->buffer_index : drop_list + n_drop,
 			      buffer_indices, mask, n_packets);
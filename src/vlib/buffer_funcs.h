@@ -192,6 +192,29 @@ vlib_buffer_pool_get_default_for_numa (vlib_main_t * vm, u32 numa_node)
   return vm->buffer_main->default_buffer_pool_index_for_numa[numa_node];
 }
 
+/** \brief Get the buffer pool of the smallest size class able to hold
+    a given number of data bytes
+
+    @param vm - (vlib_main_t *) vlib main data structure pointer
+    @param numa_node - (u32) numa node
+    @param size - (u32) number of data bytes
+    @return - (u8) buffer pool index, the pool of the largest size class
+    if none is large enough
+*/
+always_inline u8
+vlib_buffer_pool_get_for_size (vlib_main_t *vm, u32 numa_node, u32 size)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  u32 i;
+
+  ASSERT (numa_node < VLIB_BUFFER_MAX_NUMA_NODES);
+  for (i = 0; i < bm->n_size_classes - 1; i++)
+    if (size <= bm->size_class_data_size[i])
+      break;
+
+  return bm->size_class_pool_index_for_numa[numa_node][i];
+}
+
 /** \brief Translate array of buffer indices into buffer pointers with offset
 
     @param vm - (vlib_main_t *) vlib main data structure pointer
@@ -555,32 +578,153 @@ vlib_get_buffer_pool (vlib_main_t * vm, u8 buffer_pool_index)
   return vec_elt_at_index (bm->buffer_pools, buffer_pool_index);
 }
 
+/** \brief Size of the data area of a buffer, which depends on the size
+    class of its pool
+
+    @param vm - (vlib_main_t *) vlib main data structure pointer
+    @param b - (vlib_buffer_t *) pointer to buffer
+    @return - (u32) data size
+*/
+static_always_inline u32
+vlib_buffer_get_data_size (vlib_main_t *vm, vlib_buffer_t *b)
+{
+  return vlib_get_buffer_pool (vm, b->buffer_pool_index)->data_size;
+}
+
+/** \brief Number of free buffers in a pool, per-thread caches excluded
+
+    @param bp - (vlib_buffer_pool_t *) buffer pool
+    @return - (u32) number of buffers in the depot and on the locked list
+*/
+always_inline u32
+vlib_buffer_pool_n_avail (vlib_buffer_pool_t *bp)
+{
+  vlib_buffer_pool_thread_t *bpt;
+  i64 n_full = bp->n_magazines_init;
+
+  vec_foreach (bpt, bp->threads)
+    n_full += bpt->n_magazines_in - bpt->n_magazines_out;
+
+  return n_full * VLIB_BUFFER_MAGAZINE_SZ + bp->n_avail;
+}
+
+static_always_inline u32
+vlib_buffer_depot_pop (vlib_buffer_pool_t *bp, vlib_buffer_depot_head_t *h,
+		       vlib_buffer_pool_thread_t *bpt)
+{
+  vlib_buffer_depot_head_t old, new;
+
+  old.as_u64 = clib_atomic_load_acq_n (&h->as_u64);
+  while (old.index != ~0)
+    {
+      /* if the magazine is popped meanwhile, the tag fails the swap */
+      new.index = clib_atomic_load_relax_n (&bp->magazines[old.index].next);
+      new.tag = old.tag + 1;
+      if (clib_atomic_cmp_and_swap_acq_relax_n (&h->as_u64, &old.as_u64,
+						 new.as_u64, 0 /* weak */))
+	return old.index;
+      bpt->n_depot_retries++;
+    }
+
+  return ~0;
+}
+
+static_always_inline void
+vlib_buffer_depot_push (vlib_buffer_pool_t *bp, vlib_buffer_depot_head_t *h,
+			vlib_buffer_pool_thread_t *bpt, u32 index)
+{
+  vlib_buffer_depot_head_t old, new;
+
+  new.index = index;
+  old.as_u64 = clib_atomic_load_relax_n (&h->as_u64);
+  while (1)
+    {
+      bp->magazines[index].next = old.index;
+      new.tag = old.tag + 1;
+      /* release, the magazine content is visible to whoever pops it */
+      if (__atomic_compare_exchange_n (&h->as_u64, &old.as_u64, new.as_u64,
+				       0 /* weak */, __ATOMIC_RELEASE,
+				       __ATOMIC_RELAXED))
+	return;
+      bpt->n_depot_retries++;
+    }
+}
+
+/** \brief Take a full magazine of buffers from the depot of a pool
+
+    @return - 0 on success, -1 if the depot has no full magazine
+*/
+static_always_inline int
+vlib_buffer_depot_get (vlib_buffer_pool_t *bp, vlib_buffer_pool_thread_t *bpt,
+		       u32 *buffers)
+{
+  u32 index = vlib_buffer_depot_pop (bp, &bp->full, bpt);
+
+  if (index == ~0)
+    return -1;
+
+  vlib_buffer_copy_indices (buffers, bp->magazines[index].buffers,
+			    VLIB_BUFFER_MAGAZINE_SZ);
+  vlib_buffer_depot_push (bp, &bp->empty, bpt, index);
+  bpt->n_magazines_out++;
+  return 0;
+}
+
+/** \brief Give a full magazine of buffers to the depot of a pool
+
+    @return - 0 on success, -1 if the depot has no empty magazine
+*/
+static_always_inline int
+vlib_buffer_depot_put (vlib_buffer_pool_t *bp, vlib_buffer_pool_thread_t *bpt,
+		       u32 *buffers)
+{
+  u32 index = vlib_buffer_depot_pop (bp, &bp->empty, bpt);
+
+  if (index == ~0)
+    return -1;
+
+  vlib_buffer_copy_indices (bp->magazines[index].buffers, buffers,
+			    VLIB_BUFFER_MAGAZINE_SZ);
+  vlib_buffer_depot_push (bp, &bp->full, bpt, index);
+  bpt->n_magazines_in++;
+  return 0;
+}
+
+uword vlib_buffer_pool_get_slow (vlib_buffer_pool_t *bp,
+				 vlib_buffer_pool_thread_t *bpt, u32 *buffers,
+				 u32 n_buffers);
+void vlib_buffer_pool_put_slow (vlib_buffer_pool_t *bp,
+				vlib_buffer_pool_thread_t *bpt, u32 *buffers,
+				u32 n_buffers);
+void vlib_buffer_pool_put_magazines (vlib_buffer_pool_t *bp,
+				     vlib_buffer_pool_thread_t *bpt,
+				     u32 *buffers, u32 n_buffers);
+
 static_always_inline __clib_warn_unused_result uword
 vlib_buffer_pool_get (vlib_main_t * vm, u8 buffer_pool_index, u32 * buffers,
 		      u32 n_buffers)
 {
   vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, buffer_pool_index);
-  u32 len;
+  vlib_buffer_pool_thread_t *bpt =
+    vec_elt_at_index (bp->threads, vm->thread_index);
+  u32 n_left = n_buffers;
 
   ASSERT (bp->buffers);
 
-  clib_spinlock_lock (&bp->lock);
-  len = bp->n_avail;
-  if (PREDICT_TRUE (n_buffers < len))
+  /* whole magazines come from the depot, lock-free */
+  while (n_left >= VLIB_BUFFER_MAGAZINE_SZ)
     {
-      len -= n_buffers;
-      vlib_buffer_copy_indices (buffers, bp->buffers + len, n_buffers);
-      bp->n_avail = len;
-      clib_spinlock_unlock (&bp->lock);
-      return n_buffers;
-    }
-  else
-    {
-      vlib_buffer_copy_indices (buffers, bp->buffers, len);
-      bp->n_avail = 0;
-      clib_spinlock_unlock (&bp->lock);
-      return len;
+      if (vlib_buffer_depot_get (bp, bpt, buffers))
+	break;
+      buffers += VLIB_BUFFER_MAGAZINE_SZ;
+      n_left -= VLIB_BUFFER_MAGAZINE_SZ;
     }
+
+  if (PREDICT_TRUE (n_left == 0))
+    return n_buffers;
+
+  return n_buffers - n_left +
+	 vlib_buffer_pool_get_slow (bp, bpt, buffers, n_left);
 }
 
 
@@ -646,7 +790,7 @@ vlib_buffer_alloc_from_pool (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
       n_left -= len;
     }
 
-  len = round_pow2 (n_left, 32);
+  len = round_pow2 (n_left, VLIB_BUFFER_MAGAZINE_SZ);
   len = vlib_buffer_pool_get (vm, buffer_pool_index, bpt->cached_buffers,
 			      len);
   bpt->n_cached = len;
@@ -704,6 +848,24 @@ vlib_buffer_alloc (vlib_main_t * vm, u32 * buffers, u32 n_buffers)
   return vlib_buffer_alloc_on_numa (vm, buffers, n_buffers, vm->numa_node);
 }
 
+/** \brief Allocate buffers of the smallest size class able to hold a
+    given number of data bytes into supplied array
+
+    @param vm - (vlib_main_t *) vlib main data structure pointer
+    @param buffers - (u32 * ) buffer index array
+    @param n_buffers - (u32) number of buffers requested
+    @param size - (u32) number of data bytes each buffer should hold
+    @return - (u32) number of buffers actually allocated, may be
+    less than the number requested or zero
+*/
+always_inline __clib_warn_unused_result u32
+vlib_buffer_alloc_for_size (vlib_main_t *vm, u32 *buffers, u32 n_buffers,
+			    u32 size)
+{
+  u8 index = vlib_buffer_pool_get_for_size (vm, vm->numa_node, size);
+  return vlib_buffer_alloc_from_pool (vm, buffers, n_buffers, index);
+}
+
 /** \brief Allocate buffers into ring
 
     @param vm - (vlib_main_t *) vlib main data structure pointer
@@ -792,15 +954,7 @@ vlib_buffer_pool_put (vlib_main_t * vm, u8 buffer_pool_index,
       return;
     }
 
-  vlib_buffer_copy_indices (bpt->cached_buffers + n_cached,
-			    buffers + n_buffers - n_empty, n_empty);
-  bpt->n_cached = VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ;
-
-  clib_spinlock_lock (&bp->lock);
-  vlib_buffer_copy_indices (bp->buffers + bp->n_avail, buffers,
-			    n_buffers - n_empty);
-  bp->n_avail += n_buffers - n_empty;
-  clib_spinlock_unlock (&bp->lock);
+  vlib_buffer_pool_put_magazines (bp, bpt, buffers, n_buffers);
 }
 
 static_always_inline void
@@ -1164,8 +1318,7 @@ vlib_buffer_move (vlib_main_t * vm, vlib_buffer_t * b, i16 offset)
 {
   ASSERT ((b->flags & VLIB_BUFFER_NEXT_PRESENT) == 0);
   ASSERT (offset + VLIB_BUFFER_PRE_DATA_SIZE >= 0);
-  ASSERT (offset + b->current_length <
-	  vlib_buffer_get_default_data_size (vm));
+  ASSERT (offset + b->current_length < vlib_buffer_get_data_size (vm, b));
 
   u8 *source = vlib_buffer_get_current (b);
   b->current_data = offset;
@@ -1203,8 +1356,7 @@ vlib_buffer_clone_256 (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
   ASSERT (n_buffers);
   ASSERT (n_buffers <= 256);
   ASSERT (offset + VLIB_BUFFER_PRE_DATA_SIZE >= 0);
-  ASSERT ((offset + head_end_offset) <
-	  vlib_buffer_get_default_data_size (vm));
+  ASSERT ((offset + head_end_offset) < vlib_buffer_get_data_size (vm, s));
 
   if (s->current_length <= head_end_offset + CLIB_CACHE_LINE_BYTES * 2)
     {
@@ -1212,6 +1364,30 @@ vlib_buffer_clone_256 (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
       if (offset)
 	vlib_buffer_move (vm, s, offset);
 
+      /* copies of single buffer packets are allocated in one go */
+      if (!(s->flags & VLIB_BUFFER_NEXT_PRESENT))
+	{
+	  if (n_buffers > 1)
+	    n_buffers = 1 + vlib_buffer_alloc (vm, buffers + 1, n_buffers - 1);
+
+	  for (i = 1; i < n_buffers; i++)
+	    {
+	      vlib_buffer_t *d = vlib_get_buffer (vm, buffers[i]);
+	      d->current_data = s->current_data;
+	      d->current_length = s->current_length;
+	      d->flags = s->flags & VLIB_BUFFER_COPY_CLONE_FLAGS_MASK;
+	      d->trace_handle = s->trace_handle;
+	      d->total_length_not_including_first_buffer =
+		s->total_length_not_including_first_buffer;
+	      clib_memcpy_fast (d->opaque, s->opaque, sizeof (s->opaque));
+	      clib_memcpy_fast (d->opaque2, s->opaque2, sizeof (s->opaque2));
+	      clib_memcpy_fast (vlib_buffer_get_current (d),
+				vlib_buffer_get_current (s),
+				s->current_length);
+	    }
+	  return n_buffers;
+	}
+
       for (i = 1; i < n_buffers; i++)
 	{
 	  vlib_buffer_t *d;
@@ -1404,7 +1580,7 @@ vlib_buffer_chain_append_data (vlib_main_t * vm,
 			       vlib_buffer_t * first,
 			       vlib_buffer_t * last, void *data, u16 data_len)
 {
-  u32 n_buffer_bytes = vlib_buffer_get_default_data_size (vm);
+  u32 n_buffer_bytes = vlib_buffer_get_data_size (vm, last);
   ASSERT (n_buffer_bytes >= last->current_length + last->current_data);
   u16 len = clib_min (data_len,
 		      n_buffer_bytes - last->current_length -
@@ -1461,7 +1637,7 @@ vlib_packet_template_free (vlib_main_t * vm, vlib_packet_template_t * t)
 always_inline u32
 vlib_buffer_space_left_at_end (vlib_main_t * vm, vlib_buffer_t * b)
 {
-  return b->data + vlib_buffer_get_default_data_size (vm) -
+  return b->data + vlib_buffer_get_data_size (vm, b) -
     ((u8 *) vlib_buffer_get_current (b) + b->current_length);
 }
 
@@ -1472,7 +1648,7 @@ vlib_buffer_chain_linearize (vlib_main_t * vm, vlib_buffer_t * b)
 {
   vlib_buffer_t *dst_b;
   u32 n_buffers = 1, to_free = 0;
-  u16 rem_len, dst_len, data_size, src_len = 0;
+  u16 rem_len, dst_len, src_len = 0;
   u8 *dst, *src = 0;
 
   if (PREDICT_TRUE ((b->flags & VLIB_BUFFER_NEXT_PRESENT) == 0))
@@ -1482,7 +1658,6 @@ vlib_buffer_chain_linearize (vlib_main_t * vm, vlib_buffer_t * b)
   if (PREDICT_FALSE (1 != b->ref_count))
     return 0;
 
-  data_size = vlib_buffer_get_default_data_size (vm);
   rem_len = vlib_buffer_length_in_chain (vm, b) - b->current_length;
 
   dst_b = b;
@@ -1524,6 +1699,7 @@ vlib_buffer_chain_linearize (vlib_main_t * vm, vlib_buffer_t * b)
 	      /* cloned buffer, build a new dest chain from there */
 	      vlib_buffer_t *bufs[VLIB_BUFFER_LINEARIZE_MAX];
 	      u32 bis[VLIB_BUFFER_LINEARIZE_MAX + 1];
+	      const u32 data_size = vlib_buffer_get_default_data_size (vm);
 	      const int n = (rem_len + data_size - 1) / data_size;
 	      int n_alloc;
 	      int i;
@@ -1558,7 +1734,8 @@ vlib_buffer_chain_linearize (vlib_main_t * vm, vlib_buffer_t * b)
 	  dst_b->current_length = 0;
 
 	  dst = dst_b->data + dst_b->current_data;
-	  dst_len = data_size - dst_b->current_data;
+	  dst_len =
+	    vlib_buffer_get_data_size (vm, dst_b) - dst_b->current_data;
 	}
 
       copy_len = clib_min (src_len, dst_len);
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/copy.h>
+#include <vlib/unix/unix.h>
+
+vlib_copy_main_t vlib_copy_main = {
+  /* below this, handing off costs more than copying */
+  .min_async_bytes = 16 << 10,
+};
+
+static_always_inline int
+vlib_copy_batch_run (vlib_copy_batch_t *b)
+{
+  /* the helper and the submitting thread race to run queued batches */
+  if (!clib_atomic_bool_cmp_and_swap (&b->state, VLIB_COPY_BATCH_STATE_QUEUED,
+				      VLIB_COPY_BATCH_STATE_RUNNING))
+    return 0;
+
+  vlib_copy_ops (b->ops, vec_len (b->ops));
+  clib_atomic_store_rel_n (&b->state, VLIB_COPY_BATCH_STATE_DONE);
+  return 1;
+}
+
+void
+vlib_copy_batch_submit (vlib_main_t *vm, vlib_copy_batch_t *b)
+{
+  vlib_copy_main_t *cm = &vlib_copy_main;
+  vlib_copy_per_thread_t *ptd =
+    vec_elt_at_index (cm->per_thread, vm->thread_index);
+  u32 head = ptd->head;
+
+  vec_add1 (ptd->pending, b->index);
+
+  /* ring entries of stolen batches are only released by the helper, so
+   * the ring may be full even if we have free batches */
+  if (cm->n_helpers_started && b->n_bytes >= cm->min_async_bytes &&
+      head - clib_atomic_load_acq_n (&ptd->tail) < VLIB_COPY_RING_SIZE)
+    {
+      /* a helper may see the batch through a stale ring entry */
+      clib_atomic_store_rel_n (&b->state, VLIB_COPY_BATCH_STATE_QUEUED);
+      ptd->ring[head & (VLIB_COPY_RING_SIZE - 1)] = b;
+      clib_atomic_store_rel_n (&ptd->head, head + 1);
+      ptd->n_async++;
+      ptd->n_async_bytes += b->n_bytes;
+      return;
+    }
+
+  vlib_copy_ops (b->ops, vec_len (b->ops));
+  b->state = VLIB_COPY_BATCH_STATE_DONE;
+  ptd->n_inline++;
+  ptd->n_inline_bytes += b->n_bytes;
+}
+
+void
+vlib_copy_wait_all (vlib_main_t *vm)
+{
+  vlib_copy_main_t *cm = &vlib_copy_main;
+  vlib_copy_per_thread_t *ptd =
+    vec_elt_at_index (cm->per_thread, vm->thread_index);
+  vlib_copy_batch_t *b;
+  u32 i;
+
+  /* callbacks must not submit new batches */
+  for (i = 0; i < vec_len (ptd->pending); i++)
+    {
+      b = vec_elt_at_index (ptd->batches, ptd->pending[i]);
+
+      /* rather than waiting for a busy helper, do it ourselves */
+      if (b->state == VLIB_COPY_BATCH_STATE_QUEUED && vlib_copy_batch_run (b))
+	ptd->n_stolen++;
+
+      while (clib_atomic_load_acq_n (&b->state) != VLIB_COPY_BATCH_STATE_DONE)
+	CLIB_PAUSE ();
+
+      if (b->callback)
+	b->callback (vm, b);
+
+      b->state = VLIB_COPY_BATCH_STATE_FREE;
+      vec_add1 (ptd->free_batches, b->index);
+    }
+
+  vec_reset_length (ptd->pending);
+}
+
+static void
+vlib_copy_helper_thread_fn (void *arg)
+{
+  vlib_copy_main_t *cm = &vlib_copy_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_worker_thread_t *w = arg;
+  vlib_copy_per_thread_t *ptd;
+  u32 i, tail, n_threads;
+
+  clib_mem_set_heap (w->thread_mheap);
+  if (vec_len (tm->thread_prefix) && w->registration->short_name)
+    {
+      w->name = format (0, "%v_%s_%d%c", tm->thread_prefix,
+			w->registration->short_name, w->instance_id, '\0');
+      vlib_set_thread_name ((char *) w->name);
+    }
+
+  n_threads = vec_len (cm->per_thread);
+  clib_atomic_fetch_add (&cm->n_helpers_started, 1);
+
+  /* each helper serves its share of the submitting threads */
+  while (1)
+    {
+      for (i = w->instance_id; i < n_threads; i += cm->n_helpers)
+	{
+	  ptd = vec_elt_at_index (cm->per_thread, i);
+	  tail = ptd->tail;
+	  while (tail != clib_atomic_load_acq_n (&ptd->head))
+	    {
+	      vlib_copy_batch_run (ptd->ring[tail & (VLIB_COPY_RING_SIZE - 1)]);
+	      clib_atomic_store_rel_n (&ptd->tail, ++tail);
+	    }
+	}
+      CLIB_PAUSE ();
+    }
+}
+
+VLIB_REGISTER_THREAD (vlib_copy_thread_reg, static) = {
+  .name = "copy",
+  .short_name = "copy",
+  .function = vlib_copy_helper_thread_fn,
+  .no_data_structure_clone = 1,
+};
+
+static clib_error_t *
+vlib_copy_init (vlib_main_t *vm)
+{
+  vlib_copy_main_t *cm = &vlib_copy_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_copy_per_thread_t *ptd;
+  u32 i;
+
+  cm->n_helpers = vlib_copy_thread_reg.count;
+
+  /* workers are not started yet, but their number is known */
+  vec_validate_aligned (cm->per_thread, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ptd, cm->per_thread)
+    {
+      vec_validate_aligned (ptd->batches, VLIB_COPY_RING_SIZE - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      for (i = 0; i < VLIB_COPY_RING_SIZE; i++)
+	{
+	  ptd->batches[i].index = i;
+	  vec_add1 (ptd->free_batches, VLIB_COPY_RING_SIZE - 1 - i);
+	}
+    }
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (vlib_copy_init);
+
+static clib_error_t *
+vlib_copy_config (vlib_main_t *vm, unformat_input_t *input)
+{
+  vlib_copy_main_t *cm = &vlib_copy_main;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "min-async-bytes %u", &cm->min_async_bytes))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  return 0;
+}
+
+VLIB_CONFIG_FUNCTION (vlib_copy_config, "async-copy");
+
+u8 *
+format_vlib_copy_main (u8 *s, va_list *args)
+{
+  vlib_copy_main_t *cm = va_arg (*args, vlib_copy_main_t *);
+  u32 indent = format_get_indent (s);
+  vlib_copy_per_thread_t *ptd;
+
+  s = format (s, "helpers %u started %u min-async-bytes %u", cm->n_helpers,
+	      cm->n_helpers_started, cm->min_async_bytes);
+
+  vec_foreach (ptd, cm->per_thread)
+    {
+      if (!ptd->n_async && !ptd->n_inline)
+	continue;
+      s = format (s,
+		  "\n%Uthread %u: async %lu (%lu bytes) stolen %lu "
+		  "inline %lu (%lu bytes)",
+		  format_white_space, indent + 2, ptd - cm->per_thread,
+		  ptd->n_async, ptd->n_async_bytes, ptd->n_stolen,
+		  ptd->n_inline, ptd->n_inline_bytes);
+    }
+
+  return s;
+}
+
+static clib_error_t *
+show_async_copy_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			    vlib_cli_command_t *cmd)
+{
+  vlib_cli_output (vm, "%U", format_vlib_copy_main, &vlib_copy_main);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_async_copy_command, static) = {
+  .path = "show async-copy",
+  .short_help = "show async-copy",
+  .function = show_async_copy_command_fn,
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
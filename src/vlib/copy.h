@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Asynchronous batched memory copies.
+ *
+ * A node collects the memory copies it needs in a batch, submits it and
+ * carries on with other work while the copies are done, eg. parsing the
+ * descriptors of the next queue. Copies are run by 'copy' helper threads
+ * (cpu { copy <n> } or cpu { corelist-copy <list> } in startup.conf).
+ * Without helpers, or for batches smaller than the async threshold, the
+ * copies are done inline at submit time.
+ *
+ * Batches complete in submission order: vlib_copy_wait_all() waits for
+ * all the batches submitted by the calling thread and runs their
+ * callbacks. As frames are only dispatched once the node function
+ * returns, a node can enqueue the destination buffers before the copies
+ * complete, as long as it calls vlib_copy_wait_all() before returning.
+ * Rings or descriptors must only be released to the producer from the
+ * callback.
+ */
+
+#ifndef included_vlib_copy_h
+#define included_vlib_copy_h
+
+#include <vlib/vlib.h>
+
+#define VLIB_COPY_RING_SIZE 64
+
+typedef enum
+{
+  VLIB_COPY_BATCH_STATE_FREE = 0,
+  VLIB_COPY_BATCH_STATE_QUEUED,
+  VLIB_COPY_BATCH_STATE_RUNNING,
+  VLIB_COPY_BATCH_STATE_DONE,
+} vlib_copy_batch_state_t;
+
+typedef struct
+{
+  void *dst;
+  void *src;
+  u32 len;
+} vlib_copy_op_t;
+
+struct vlib_copy_batch_t;
+typedef void (vlib_copy_callback_fn_t) (vlib_main_t *vm,
+					struct vlib_copy_batch_t *b);
+
+typedef struct vlib_copy_batch_t
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /* written by the thread running the copies */
+  volatile u32 state;
+
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  /* written by the submitting thread only */
+  vlib_copy_op_t *ops;
+  u32 n_bytes;
+  u32 index;
+  vlib_copy_callback_fn_t *callback;
+  /* opaque data for the callback */
+  uword cookie[4];
+} vlib_copy_batch_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /* batches queued to the helper, written by the submitting thread */
+  vlib_copy_batch_t *ring[VLIB_COPY_RING_SIZE];
+  volatile u32 head;
+
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  /* written by the helper thread */
+  volatile u32 tail;
+
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  /* private to the submitting thread */
+  vlib_copy_batch_t *batches;
+  u32 *free_batches;
+  u32 *pending;
+
+  /* statistics */
+  u64 n_async;
+  u64 n_inline;
+  u64 n_stolen;
+  u64 n_async_bytes;
+  u64 n_inline_bytes;
+} vlib_copy_per_thread_t;
+
+typedef struct
+{
+  vlib_copy_per_thread_t *per_thread;
+  /* smaller batches are copied inline at submit time */
+  u32 min_async_bytes;
+  u32 n_helpers;
+  u32 n_helpers_started;
+} vlib_copy_main_t;
+
+extern vlib_copy_main_t vlib_copy_main;
+
+/** Whether batches may be copied asynchronously. */
+static_always_inline int
+vlib_copy_is_async (void)
+{
+  return vlib_copy_main.n_helpers_started != 0;
+}
+
+static_always_inline void
+vlib_copy_ops (vlib_copy_op_t *op, u32 n_left)
+{
+  while (n_left >= 4)
+    {
+      if (PREDICT_TRUE (n_left >= 8))
+	{
+	  clib_prefetch_load (op[4].src);
+	  clib_prefetch_load (op[5].src);
+	  clib_prefetch_load (op[6].src);
+	  clib_prefetch_load (op[7].src);
+	}
+      clib_memcpy_fast (op[0].dst, op[0].src, op[0].len);
+      clib_memcpy_fast (op[1].dst, op[1].src, op[1].len);
+      clib_memcpy_fast (op[2].dst, op[2].src, op[2].len);
+      clib_memcpy_fast (op[3].dst, op[3].src, op[3].len);
+      op += 4;
+      n_left -= 4;
+    }
+  while (n_left)
+    {
+      clib_memcpy_fast (op[0].dst, op[0].src, op[0].len);
+      op += 1;
+      n_left -= 1;
+    }
+}
+
+void vlib_copy_batch_submit (vlib_main_t *vm, vlib_copy_batch_t *b);
+void vlib_copy_wait_all (vlib_main_t *vm);
+
+/**
+ * Get an empty batch. If all the batches of the thread are in flight, the
+ * pending ones are completed first.
+ */
+static_always_inline vlib_copy_batch_t *
+vlib_copy_batch_get (vlib_main_t *vm, vlib_copy_callback_fn_t *callback)
+{
+  vlib_copy_per_thread_t *ptd =
+    vec_elt_at_index (vlib_copy_main.per_thread, vm->thread_index);
+  vlib_copy_batch_t *b;
+
+  if (PREDICT_FALSE (vec_len (ptd->free_batches) == 0))
+    vlib_copy_wait_all (vm);
+
+  b = vec_elt_at_index (ptd->batches, vec_pop (ptd->free_batches));
+  vec_reset_length (b->ops);
+  b->n_bytes = 0;
+  b->callback = callback;
+  return b;
+}
+
+static_always_inline void
+vlib_copy_batch_add (vlib_copy_batch_t *b, void *dst, void *src, u32 len)
+{
+  vlib_copy_op_t *op;
+  vec_add2 (b->ops, op, 1);
+  op->dst = dst;
+  op->src = src;
+  op->len = len;
+  b->n_bytes += len;
+}
+
+format_function_t format_vlib_copy_main;
+
+#endif /* included_vlib_copy_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -187,6 +187,68 @@ vlib_free_combined_counter (vlib_combined_counter_main_t * cm)
   clib_mem_set_heap (oldheap);
 }
 
+void
+vlib_validate_histogram (vlib_histogram_main_t *hm, u32 index)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  int i, j, resized = 0;
+  void *oldheap = vlib_stats_push_heap (hm->counters);
+
+  ASSERT (hm->n_buckets > 0);
+
+  vec_validate (hm->counters, tm->n_vlib_mains - 1);
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    {
+      if (index >= vec_len (hm->counters[i]))
+	{
+	  vec_validate_aligned (hm->counters[i], index, CLIB_CACHE_LINE_BYTES);
+	  resized++;
+	}
+      for (j = 0; j < vec_len (hm->counters[i]); j++)
+	if (vec_len (hm->counters[i][j]) < hm->n_buckets)
+	  {
+	    vec_validate_aligned (hm->counters[i][j], hm->n_buckets - 1,
+				  CLIB_CACHE_LINE_BYTES);
+	    resized++;
+	  }
+    }
+
+  /* Avoid the epoch increase when there was no histogram resize. */
+  if (resized)
+    vlib_stats_pop_heap (hm, oldheap, index, 8 /* STAT_DIR_TYPE_HISTOGRAM */);
+  else
+    clib_mem_set_heap (oldheap);
+}
+
+void
+vlib_free_histogram (vlib_histogram_main_t *hm)
+{
+  int i, j;
+
+  vlib_stats_delete_cm (hm);
+
+  void *oldheap = vlib_stats_push_heap (hm->counters);
+  for (i = 0; i < vec_len (hm->counters); i++)
+    {
+      for (j = 0; j < vec_len (hm->counters[i]); j++)
+	vec_free (hm->counters[i][j]);
+      vec_free (hm->counters[i]);
+    }
+  vec_free (hm->counters);
+  clib_mem_set_heap (oldheap);
+}
+
+void
+vlib_clear_histograms (vlib_histogram_main_t *hm)
+{
+  uword i, j;
+
+  for (i = 0; i < vec_len (hm->counters); i++)
+    for (j = 0; j < vec_len (hm->counters[i]); j++)
+      clib_memset (hm->counters[i][j], 0,
+		   vec_len (hm->counters[i][j]) * sizeof (counter_t));
+}
+
 u32
 vlib_combined_counter_n_counters (const vlib_combined_counter_main_t * cm)
 {
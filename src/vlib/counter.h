@@ -332,6 +332,56 @@ int vlib_validate_combined_counter_will_expand
 
 void vlib_free_combined_counter (vlib_combined_counter_main_t * cm);
 
+/** A collection of histograms
+
+    Each object has a per-thread log-linear histogram of n_buckets bucket
+    counters, see vlib_histogram_bucket. Values past the last bucket are
+    counted in the last bucket.
+*/
+typedef struct
+{
+  counter_t ***counters;	/**< Per-thread, per-object bucket counters */
+  char *name;			/**< The histogram collection's name. */
+  char *stat_segment_name;	/**< Name in stat segment directory */
+  u32 n_buckets;		/**< Number of buckets of each histogram */
+} vlib_histogram_main_t;
+
+/** Add a value to a histogram
+    @param hm - (vlib_histogram_main_t *) histogram main pointer
+    @param thread_index - (u32) the current cpu index
+    @param index - (u32) index of the histogram
+    @param value - (u64) value to count
+*/
+always_inline void
+vlib_histogram_add (vlib_histogram_main_t *hm, u32 thread_index, u32 index,
+		    u64 value)
+{
+  counter_t *buckets = hm->counters[thread_index][index];
+
+  buckets[clib_min (vlib_histogram_bucket (value), hm->n_buckets - 1)]++;
+}
+
+/** Number of buckets needed to tell values up to max_value apart */
+always_inline u32
+vlib_histogram_n_buckets (u64 max_value)
+{
+  return vlib_histogram_bucket (max_value) + 1;
+}
+
+/** validate a histogram
+    Also grows the existing histograms of the collection when n_buckets was
+    increased.
+    @param hm - (vlib_histogram_main_t *) pointer to the histogram collection
+    @param index - (u32) index of the histogram to validate
+*/
+void vlib_validate_histogram (vlib_histogram_main_t *hm, u32 index);
+void vlib_free_histogram (vlib_histogram_main_t *hm);
+
+/** Clear a collection of histograms
+    @param hm - (vlib_histogram_main_t *) collection to clear
+*/
+void vlib_clear_histograms (vlib_histogram_main_t *hm);
+
 /** Obtain the number of simple or combined counters allocated.
     A macro which reduces to to vec_len(cm->maxi), the answer in either
     case.
@@ -29,4 +29,39 @@ typedef struct
   counter_t bytes;			/**< byte counter  */
 } vlib_counter_t;
 
+/** Histograms are log-linear (HDR style): values below twice the number of
+    sub-buckets have a bucket each, above that each power of two range is
+    split in 2^VLIB_HISTOGRAM_LOG2_SUB_BUCKETS buckets of equal width. A
+    value is then known within 1 / 2^VLIB_HISTOGRAM_LOG2_SUB_BUCKETS of
+    itself, whatever its magnitude.
+ */
+#define VLIB_HISTOGRAM_LOG2_SUB_BUCKETS 2
+
+/** Bucket a value is counted in */
+static inline uint32_t
+vlib_histogram_bucket (uint64_t value)
+{
+  uint32_t shift;
+
+  if (value < (2 << VLIB_HISTOGRAM_LOG2_SUB_BUCKETS))
+    return value;
+
+  shift = 63 - __builtin_clzll (value) - VLIB_HISTOGRAM_LOG2_SUB_BUCKETS;
+  return (shift << VLIB_HISTOGRAM_LOG2_SUB_BUCKETS) + (value >> shift);
+}
+
+/** Smallest value counted in a bucket */
+static inline uint64_t
+vlib_histogram_bucket_min (uint32_t bucket)
+{
+  uint32_t shift;
+
+  if (bucket < (2 << VLIB_HISTOGRAM_LOG2_SUB_BUCKETS))
+    return bucket;
+
+  shift = (bucket >> VLIB_HISTOGRAM_LOG2_SUB_BUCKETS) - 1;
+  return (uint64_t) (bucket - (shift << VLIB_HISTOGRAM_LOG2_SUB_BUCKETS))
+	 << shift;
+}
+
 #endif
@@ -1248,6 +1248,116 @@ dispatch_pending_node (vlib_main_t * vm, uword pending_frame_index,
   return last_time_stamp;
 }
 
+/* A frame deferred by the last main loop can only grow while the next
+   frame it was deferred for still owns it, the graph may have changed. */
+static_always_inline int
+deferred_frame_is_owned (vlib_node_main_t *nm, vlib_pending_frame_t *p)
+{
+  vlib_next_frame_t *nf;
+
+  if (p->next_frame_index >= vec_len (nm->next_frames))
+    return 0;
+  nf = nm->next_frames + p->next_frame_index;
+  return nf->frame == p->frame &&
+	 nf->node_runtime_index == p->node_runtime_index;
+}
+
+/* Dispatch the pending frames, leaving the small frames of batching nodes
+   pending to the next main loop. */
+static u64
+dispatch_pending_nodes_batching (vlib_main_t *vm, u64 cpu_time_now)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  u32 n_deferred = nm->n_deferred_frames;
+  vlib_node_batching_t *b;
+  vlib_pending_frame_t *p;
+  vlib_frame_t *f;
+  u64 since;
+  uword i;
+
+  vec_reset_length (nm->deferred_frames);
+
+  for (i = 0; i < _vec_len (nm->pending_frames); i++)
+    {
+      p = nm->pending_frames + i;
+      f = p->frame;
+
+      if (PREDICT_FALSE (i < n_deferred && !deferred_frame_is_owned (nm, p)))
+	{
+	  /* dispatch it now, as a frame no next frame refers to */
+	  vlib_node_runtime_t *n = vec_elt_at_index (
+	    nm->nodes_by_type[VLIB_NODE_TYPE_INTERNAL], p->node_runtime_index);
+	  p->next_frame_index = VLIB_PENDING_FRAME_NO_NEXT_FRAME;
+	  if (!(n->flags & VLIB_NODE_FLAG_FRAME_NO_FREE_AFTER_DISPATCH))
+	    f->frame_flags |= VLIB_FRAME_FREE_AFTER_DISPATCH;
+	}
+
+      /* nodes created since batching was set up don't batch */
+      if (PREDICT_FALSE (p->node_runtime_index >= vec_len (nm->node_batching)))
+	{
+	  cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
+	  continue;
+	}
+
+      b = nm->node_batching + p->node_runtime_index;
+
+      /* only a frame still owned by a next frame can grow */
+      if (f->n_vectors < b->min_vectors &&
+	  p->next_frame_index != VLIB_PENDING_FRAME_NO_NEXT_FRAME &&
+	  !(f->frame_flags & VLIB_FRAME_FREE_AFTER_DISPATCH))
+	{
+	  /* deferred frames lead the pending vector, their time is stored
+	   * at the same index; at most one time is stored per frame looked
+	   * at, so a time is always read before being overwritten */
+	  since = i < n_deferred ? nm->deferred_since[i] : cpu_time_now;
+	  if (cpu_time_now - since < b->max_delay_clocks)
+	    {
+	      vec_validate (nm->deferred_since, vec_len (nm->deferred_frames));
+	      nm->deferred_since[vec_len (nm->deferred_frames)] = since;
+	      vec_add1 (nm->deferred_frames, p[0]);
+	      b->n_deferred++;
+	      continue;
+	    }
+	  b->n_expired++;
+	}
+
+      vlib_histogram_add (&vlib_global_main.vector_size_histogram,
+			  vm->thread_index, p->node_runtime_index,
+			  f->n_vectors);
+      cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
+    }
+
+  _vec_len (nm->pending_frames) = 0;
+  nm->n_deferred_frames = vec_len (nm->deferred_frames);
+  if (nm->n_deferred_frames)
+    vec_append (nm->pending_frames, nm->deferred_frames);
+
+  return cpu_time_now;
+}
+
+/* Dispatch the frames left deferred before the worker parks at the
+   barrier, a node graph change reforks the next frames owning them. */
+static u64
+dispatch_deferred_frames (vlib_main_t *vm, u64 cpu_time_now)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_pending_frame_t *p;
+  uword i;
+
+  for (i = 0; i < _vec_len (nm->pending_frames); i++)
+    {
+      p = nm->pending_frames + i;
+      if (p->node_runtime_index < vec_len (nm->node_batching))
+	vlib_histogram_add (&vlib_global_main.vector_size_histogram,
+			    vm->thread_index, p->node_runtime_index,
+			    p->frame->n_vectors);
+      cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
+    }
+  _vec_len (nm->pending_frames) = 0;
+  nm->n_deferred_frames = 0;
+  return cpu_time_now;
+}
+
 always_inline uword
 vlib_process_stack_is_valid (vlib_process_t * p)
 {
@@ -1576,7 +1686,12 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 	}
 
       if (!is_main)
-	vlib_worker_thread_barrier_check ();
+	{
+	  if (PREDICT_FALSE (nm->n_deferred_frames &&
+			     *vlib_worker_threads->wait_at_barrier))
+	    cpu_time_now = dispatch_deferred_frames (vm, cpu_time_now);
+	  vlib_worker_thread_barrier_check ();
+	}
 
       if (PREDICT_FALSE (vm->check_frame_queues + frame_queue_check_counter))
 	{
@@ -1645,10 +1760,15 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       /* Input nodes may have added work to the pending vector.
          Process pending vector until there is nothing left.
          All pending vectors will be processed from input -> output. */
-      for (i = 0; i < _vec_len (nm->pending_frames); i++)
-	cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
-      /* Reset pending vector for next iteration. */
-      _vec_len (nm->pending_frames) = 0;
+      if (PREDICT_FALSE (vec_len (nm->node_batching)))
+	cpu_time_now = dispatch_pending_nodes_batching (vm, cpu_time_now);
+      else
+	{
+	  for (i = 0; i < _vec_len (nm->pending_frames); i++)
+	    cpu_time_now = dispatch_pending_node (vm, i, cpu_time_now);
+	  /* Reset pending vector for next iteration. */
+	  _vec_len (nm->pending_frames) = 0;
+	}
 
       if (is_main)
 	{
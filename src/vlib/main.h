@@ -314,6 +314,10 @@ typedef struct vlib_global_main_t
   /* Hash table to record which init functions have been called. */
   uword *init_functions_called;
 
+  /* Dispatches of the internal nodes by vector size, by node runtime
+     index, counted while a node batches or the histograms are on. */
+  vlib_histogram_main_t vector_size_histogram;
+
 } vlib_global_main_t;
 
 /* Global main structure. */
@@ -416,7 +420,8 @@ vlib_clear_internal_node_vector_rate (vlib_main_t * vm)
 always_inline void
 vlib_increment_main_loop_counter (vlib_main_t * vm)
 {
-  vm->main_loop_count++;
+  /* announces a quiescent state, see vlib_worker_call_after_quiescence */
+  clib_atomic_store_rel_n (&vm->main_loop_count, vm->main_loop_count + 1);
   vm->internal_node_last_vectors_per_main_loop = 0;
 
   if (PREDICT_FALSE (vm->main_loop_exit_now))
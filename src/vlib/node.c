@@ -852,6 +852,72 @@ vlib_node_set_march_variant (vlib_main_t *vm, u32 node_index,
     }
   return -1;
 }
+
+static void
+vlib_node_batching_update (vlib_node_main_t *nm)
+{
+  vlib_histogram_main_t *hm = &vlib_global_main.vector_size_histogram;
+  u32 n_nodes = vec_len (nm->nodes_by_type[VLIB_NODE_TYPE_INTERNAL]);
+
+  if (nm->n_batching_nodes || nm->vector_size_histograms)
+    {
+      vec_validate (nm->node_batching, n_nodes - 1);
+      hm->n_buckets = vlib_histogram_n_buckets (VLIB_FRAME_SIZE);
+      vlib_validate_histogram (hm, vec_len (nm->node_batching) - 1);
+      return;
+    }
+
+  /* the main loop dispatches the frames left deferred, if any */
+  vec_free (nm->node_batching);
+  nm->n_deferred_frames = 0;
+}
+
+/**
+ * Defer the dispatch of the node when its pending frames hold fewer than
+ * min_vectors vectors, for at most max_delay seconds, on all threads.
+ * Set min_vectors to 0 to dispatch right away again.
+ * @return 0 on success, -1 if the node is not an internal node.
+ */
+int
+vlib_node_set_batching (vlib_main_t *vm, u32 node_index, u32 min_vectors,
+			f64 max_delay)
+{
+  vlib_node_t *n = vlib_get_node (vm, node_index);
+  vlib_node_batching_t *b;
+  vlib_node_main_t *nm;
+
+  if (n->type != VLIB_NODE_TYPE_INTERNAL)
+    return -1;
+
+  foreach_vlib_main ()
+    {
+      nm = &this_vlib_main->node_main;
+      vec_validate (nm->node_batching, n->runtime_index);
+      b = vec_elt_at_index (nm->node_batching, n->runtime_index);
+
+      nm->n_batching_nodes -= b->min_vectors != 0;
+      nm->n_batching_nodes += min_vectors != 0;
+      b->min_vectors = min_vectors;
+      b->max_delay_clocks =
+	max_delay * this_vlib_main->clib_time.clocks_per_second;
+      vlib_node_batching_update (nm);
+    }
+  return 0;
+}
+
+/** Count the dispatches of the internal nodes by vector size. */
+void
+vlib_node_set_vector_size_histograms (vlib_main_t *vm, int enable)
+{
+  vlib_node_main_t *nm;
+
+  foreach_vlib_main ()
+    {
+      nm = &this_vlib_main->node_main;
+      nm->vector_size_histograms = enable != 0;
+      vlib_node_batching_update (nm);
+    }
+}
 /*
  * fd.io coding-style-patch-verification: ON
  *
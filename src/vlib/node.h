@@ -452,6 +452,24 @@ typedef struct
 #define VLIB_PENDING_FRAME_NO_NEXT_FRAME ((u32) ~0)
 } vlib_pending_frame_t;
 
+/* Dispatch batching of an internal node.
+   A pending frame smaller than min_vectors is left pending to the next
+   main loop, so the nodes feeding it keep appending to it, until it
+   holds min_vectors or has waited max_delay_clocks. */
+typedef struct
+{
+  /* Dispatch frames of at least this size right away, 0 to not defer. */
+  u32 min_vectors;
+
+  /* Longest a frame may be deferred. */
+  u64 max_delay_clocks;
+
+  /* Number of times a frame was deferred, and number of frames
+     dispatched because they reached max_delay_clocks. */
+  u64 n_deferred;
+  u64 n_expired;
+} vlib_node_batching_t;
+
 typedef struct vlib_node_runtime_t
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);	/**< cacheline mark */
@@ -694,6 +712,18 @@ typedef struct
   /* Vector of internal node's frames waiting to be called. */
   vlib_pending_frame_t *pending_frames;
 
+  /* Dispatch batching by internal node runtime index. Empty unless a
+     node batches or vector size histograms are on. */
+  vlib_node_batching_t *node_batching;
+  u32 n_batching_nodes;
+  u8 vector_size_histograms;
+
+  /* Frames deferred by the last main loop, they lead pending_frames,
+     with the cpu time they were first deferred. */
+  vlib_pending_frame_t *deferred_frames;
+  u64 *deferred_since;
+  u32 n_deferred_frames;
+
   /* Timing wheel for scheduling time-based node dispatch. */
   void *timing_wheel;
 
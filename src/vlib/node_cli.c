@@ -930,6 +930,212 @@ VLIB_CLI_COMMAND (set_node_fn_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_node_batching (vlib_main_t *vm, unformat_input_t *input,
+		   vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  u32 node_index = ~0, min_vectors = 0;
+  f64 max_delay_usec = 100;
+  clib_error_t *err = 0;
+  int enable = 1, is_histograms = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "please specify a node or histograms");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "histograms"))
+	is_histograms = 1;
+      else if (unformat (line_input, "min-vectors %u", &min_vectors))
+	;
+      else if (unformat (line_input, "max-delay %f", &max_delay_usec))
+	;
+      else if (unformat (line_input, "disable"))
+	enable = 0;
+      else if (unformat (line_input, "%U", unformat_vlib_node, vm,
+			 &node_index))
+	;
+      else
+	{
+	  err = clib_error_return (0, "unknown input `%U'",
+				   format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (is_histograms)
+    {
+      vlib_node_set_vector_size_histograms (vm, enable);
+      goto done;
+    }
+
+  if (node_index == ~0)
+    {
+      err = clib_error_return (0, "please specify valid node name");
+      goto done;
+    }
+
+  if (enable && (min_vectors < 2 || min_vectors > VLIB_FRAME_SIZE))
+    {
+      err = clib_error_return (0, "min-vectors must be within 2 and %u",
+			       VLIB_FRAME_SIZE);
+      goto done;
+    }
+
+  if (vlib_node_set_batching (vm, node_index, enable ? min_vectors : 0,
+			      max_delay_usec * 1e-6))
+    err = clib_error_return (0, "only internal nodes can batch");
+
+done:
+  unformat_free (line_input);
+  return err;
+}
+
+/*?
+ * Let the frames of an internal node accumulate over main loops before
+ * the node is dispatched. A frame holding fewer than min-vectors vectors
+ * is left pending, and the nodes feeding it keep appending to it, until
+ * it holds min-vectors vectors or has waited max-delay microseconds
+ * (100 by default). This trades latency for fewer, larger dispatches of
+ * the node when it only sees small vectors. The dispatches of internal
+ * nodes are counted by vector size while any node batches, or when
+ * histograms are enabled.
+ *
+ * @cliexpar
+ * @cliexcmd{set node batching ip4-lookup min-vectors 32 max-delay 50}
+ * @cliexcmd{set node batching ip4-lookup disable}
+ * @cliexcmd{set node batching histograms}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_node_batching_command, static) = {
+  .path = "set node batching",
+  .short_help = "set node batching <node-name> min-vectors <n> "
+		"[max-delay <usec>] | <node-name> disable | "
+		"histograms [disable]",
+  .function = set_node_batching,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_node_batching (vlib_main_t *vm, unformat_input_t *input,
+		    vlib_cli_command_t *cmd)
+{
+  vlib_histogram_main_t *hm = &vlib_global_main.vector_size_histogram;
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_node_batching_t *b, sum;
+  vlib_node_runtime_t *rt;
+  u64 n_dispatches, lo, hi;
+  u64 *buckets = 0;
+  counter_t *c;
+  u8 *s;
+  u32 ri;
+  int i;
+
+  if (!vec_len (nm->node_batching))
+    {
+      vlib_cli_output (vm, "no node batching nor vector size histograms");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "%-30s%8s%10s%12s%10s  %s", "Name", "Min", "Delay us",
+		   "Deferred", "Expired",
+		   "Dispatches by vector size, size:count");
+
+  vec_validate (buckets, hm->n_buckets - 1);
+  vec_foreach_index (ri, nm->node_batching)
+    {
+      clib_memset (&sum, 0, sizeof (sum));
+      vec_zero (buckets);
+      foreach_vlib_main ()
+	{
+	  if (ri >= vec_len (this_vlib_main->node_main.node_batching))
+	    continue;
+	  b = this_vlib_main->node_main.node_batching + ri;
+	  sum.n_deferred += b->n_deferred;
+	  sum.n_expired += b->n_expired;
+	  c = hm->counters[this_vlib_main->thread_index][ri];
+	  for (i = 0; i < hm->n_buckets; i++)
+	    buckets[i] += c[i];
+	}
+
+      b = nm->node_batching + ri;
+      n_dispatches = 0;
+      for (i = 0; i < hm->n_buckets; i++)
+	n_dispatches += buckets[i];
+      if (!b->min_vectors && !n_dispatches)
+	continue;
+
+      rt = vec_elt_at_index (nm->nodes_by_type[VLIB_NODE_TYPE_INTERNAL], ri);
+      s = format (0, "%-30U", format_vlib_node_name, vm, rt->node_index);
+      if (b->min_vectors)
+	s = format (s, "%8u%10.0f", b->min_vectors,
+		    b->max_delay_clocks * vm->clib_time.seconds_per_clock *
+		      1e6);
+      else
+	s = format (s, "%8s%10s", "-", "-");
+      s = format (s, "%12llu%10llu ", sum.n_deferred, sum.n_expired);
+      for (i = 0; i < hm->n_buckets; i++)
+	{
+	  if (!buckets[i])
+	    continue;
+	  /* the last bucket only counts full frames */
+	  lo = vlib_histogram_bucket_min (i);
+	  hi = i + 1 < hm->n_buckets ? vlib_histogram_bucket_min (i + 1) - 1 :
+					 lo;
+	  if (hi > lo)
+	    s = format (s, " %llu-%llu:%llu", lo, hi, buckets[i]);
+	  else
+	    s = format (s, " %llu:%llu", lo, buckets[i]);
+	}
+      vlib_cli_output (vm, "%v", s);
+      vec_free (s);
+    }
+
+  vec_free (buckets);
+  return 0;
+}
+
+/*?
+ * Show the nodes set to batch, with the number of deferred dispatches,
+ * the number of frames dispatched because they waited the whole delay,
+ * and the number of dispatches of each node by vector size summed over
+ * all threads. Each non-empty vector size bucket shows as size:count, or
+ * as min-max:count for a bucket holding several sizes.
+ *
+ * @cliexpar
+ * @cliexcmd{show node batching}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_node_batching_command, static) = {
+  .path = "show node batching",
+  .short_help = "show node batching",
+  .function = show_node_batching,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_node_batching (vlib_main_t *vm, unformat_input_t *input,
+		     vlib_cli_command_t *cmd)
+{
+  vlib_node_batching_t *b;
+
+  foreach_vlib_main ()
+    vec_foreach (b, this_vlib_main->node_main.node_batching)
+      b->n_deferred = b->n_expired = 0;
+  vlib_clear_histograms (&vlib_global_main.vector_size_histogram);
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (clear_node_batching_command, static) = {
+  .path = "clear node batching",
+  .short_help = "clear node batching",
+  .function = clear_node_batching,
+};
+/* *INDENT-ON* */
+
 /* Dummy function to get us linked in. */
 void
 vlib_node_cli_reference (void)
@@ -1272,6 +1272,10 @@ vlib_node_set_dispatch_wrapper (vlib_main_t *vm, vlib_node_function_t *fn)
 int vlib_node_set_march_variant (vlib_main_t *vm, u32 node_index,
 				 clib_march_variant_type_t march_variant);
 
+int vlib_node_set_batching (vlib_main_t *vm, u32 node_index, u32 min_vectors,
+			    f64 max_delay);
+void vlib_node_set_vector_size_histograms (vlib_main_t *vm, int enable);
+
 vlib_node_function_t *
 vlib_node_get_preferred_node_fn_variant (vlib_main_t *vm,
 					 vlib_node_fn_registration_t *regs);
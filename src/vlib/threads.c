@@ -25,6 +25,7 @@
 #include <vlib/threads.h>
 
 #include <vlib/stat_weak_inlines.h>
+#include <vlib/pci/pci.h>
 
 u32
 vl (void *p)
@@ -135,6 +136,34 @@ barrier_trace_release (f64 t_entry, f64 t_closed_total, f64 t_update_main)
   vlib_worker_threads[0].barrier_context = NULL;
 }
 
+static void
+barrier_stats_record (f64 t_closed)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_barrier_caller_stats_t *cs;
+  uword *p;
+
+  if (tm->barrier_hold_time.counters)
+    vlib_histogram_add (&tm->barrier_hold_time, 0, 0, t_closed * 1e9);
+
+  p = hash_get (tm->barrier_caller_by_name,
+		pointer_to_uword (tm->barrier_holder));
+  if (p)
+    cs = vec_elt_at_index (tm->barrier_callers, p[0]);
+  else
+    {
+      vec_add2 (tm->barrier_callers, cs, 1);
+      cs->caller = tm->barrier_holder;
+      hash_set (tm->barrier_caller_by_name,
+		pointer_to_uword (tm->barrier_holder),
+		cs - tm->barrier_callers);
+    }
+
+  cs->count++;
+  cs->total_time += t_closed;
+  cs->max_time = clib_max (cs->max_time, t_closed);
+}
+
 uword
 os_get_nthreads (void)
 {
@@ -166,6 +195,165 @@ sort_registrations_by_no_clone (void *a0, void *a1)
 	  - ((i32) ((*tr1)->no_data_structure_clone)));
 }
 
+static void
+vlib_cpu_topology_init (vlib_thread_main_t *tm)
+{
+  const char *sys_cpu_path = "/sys/devices/system/cpu/cpu";
+  const char *sys_node_path = "/sys/devices/system/node/node";
+  vlib_cpu_topology_t *t;
+  clib_bitmap_t *cpus = 0;
+  clib_error_t *err;
+  uword c, node;
+  u8 *p = 0;
+
+  if (!tm->cpu_core_bitmap)
+    return;
+
+  vec_validate (tm->cpu_topology, clib_bitmap_last_set (tm->cpu_core_bitmap));
+  vec_foreach (t, tm->cpu_topology)
+    t->core_id = t->package_id = t->numa_id = -1;
+
+  clib_bitmap_foreach (c, tm->cpu_core_bitmap)
+    {
+      t = vec_elt_at_index (tm->cpu_topology, c);
+
+      p = format (p, "%s%u/topology/core_id%c", sys_cpu_path, c, 0);
+      err = clib_sysfs_read ((char *) p, "%d", &t->core_id);
+      clib_error_free (err);
+      vec_reset_length (p);
+
+      p = format (p, "%s%u/topology/physical_package_id%c", sys_cpu_path, c,
+		  0);
+      err = clib_sysfs_read ((char *) p, "%d", &t->package_id);
+      clib_error_free (err);
+      vec_reset_length (p);
+
+      p = format (p, "%s%u/topology/thread_siblings_list%c", sys_cpu_path, c,
+		  0);
+      err = clib_sysfs_read ((char *) p, "%U", unformat_bitmap_list,
+			     &t->siblings);
+      clib_error_free (err);
+      vec_reset_length (p);
+      t->siblings = clib_bitmap_set (t->siblings, c, 1);
+    }
+
+  clib_bitmap_foreach (node, tm->cpu_socket_bitmap)
+    {
+      p = format (p, "%s%u/cpulist%c", sys_node_path, node, 0);
+      err = clib_sysfs_read ((char *) p, "%U", unformat_bitmap_list, &cpus);
+      clib_error_free (err);
+      vec_reset_length (p);
+
+      clib_bitmap_foreach (c, cpus)
+	if (c < vec_len (tm->cpu_topology))
+	  tm->cpu_topology[c].numa_id = node;
+      vec_reset_length (cpus);
+    }
+
+  vec_free (cpus);
+  vec_free (p);
+}
+
+/* PCI addresses given to the drivers as "dev <pci-addr>" in the startup
+   config, e.g. in the dpdk section. The drivers only bind them once the
+   workers are placed. */
+static vlib_pci_addr_t *
+vlib_thread_config_pci_addrs (vlib_main_t *vm)
+{
+  vlib_pci_addr_t addr, *addrs = 0;
+  unformat_input_t input;
+  u8 *s;
+
+  unformat_init_command_line (&input, (char **) vm->argv);
+  while (unformat_check_input (&input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (&input, "dev %U", unformat_vlib_pci_addr, &addr))
+	vec_add1 (addrs, addr);
+      else if (unformat (&input, "%s", &s))
+	vec_free (s);
+      else
+	break;
+    }
+  unformat_free (&input);
+  return addrs;
+}
+
+/* NUMA nodes of the ethernet NICs bound to a userspace driver or to be
+   bound by the startup config, read from sysfs whatever their driver */
+static uword *
+vlib_thread_nic_numa_nodes (vlib_main_t *vm)
+{
+  static char *drivers[] = { "vfio-pci", "uio_pci_generic", "igb_uio" };
+  vlib_pci_addr_t *addrs, *a, *config_addrs;
+  vlib_pci_device_info_t *di;
+  uword *numa = 0;
+  int i, use;
+
+  addrs = vlib_pci_get_all_dev_addrs ();
+  config_addrs = vlib_thread_config_pci_addrs (vm);
+  vec_foreach (a, addrs)
+    {
+      if (!(di = vlib_pci_get_device_info (vm, a, 0)))
+	continue;
+      use = 0;
+      for (i = 0; i < vec_len (config_addrs); i++)
+	use |= config_addrs[i].as_u32 == a->as_u32;
+      for (i = 0; i < ARRAY_LEN (drivers) && di->driver_name; i++)
+	use |= !strcmp ((char *) di->driver_name, drivers[i]);
+      if (use && di->device_class == PCI_CLASS_NETWORK_ETHERNET &&
+	  di->numa_node >= 0)
+	numa = clib_bitmap_set (numa, di->numa_node, 1);
+      vlib_pci_free_device_info (di);
+    }
+  vec_free (config_addrs);
+  vec_free (addrs);
+  return numa;
+}
+
+/*
+ * Pick the cpu of the next thread placed automatically. The physical cores
+ * of the preferred NUMA nodes come first, then their hyperthreads, then the
+ * cores and the hyperthreads of the other nodes; the cpus of the physical
+ * core of cpu 0 come last, they are left to the host and IRQs.
+ */
+uword
+vlib_thread_placement_next_cpu (vlib_cpu_topology_t *topology,
+				uword *numa_bitmap, uword *avail_cpu,
+				uword *busy_cpu)
+{
+  uword c, best = ~0;
+  int score, best_score = 0;
+  i32 numa;
+
+  clib_bitmap_foreach (c, avail_cpu)
+    {
+      numa = c < vec_len (topology) ? topology[c].numa_id : -1;
+      score = clib_bitmap_get (busy_cpu, c);
+      if (numa_bitmap && (numa < 0 || !clib_bitmap_get (numa_bitmap, numa)))
+	score += 2;
+      if (c == 0 ||
+	  (vec_len (topology) && clib_bitmap_get (topology[0].siblings, c)))
+	score += 4;
+
+      if (best == ~0 || score < best_score)
+	{
+	  best = c;
+	  best_score = score;
+	}
+    }
+
+  return best;
+}
+
+/* Mark the cpu and its hyperthreads as used */
+uword *
+vlib_thread_placement_busy (vlib_cpu_topology_t *topology, uword *busy_cpu,
+			    uword c)
+{
+  if (c < vec_len (topology))
+    return clib_bitmap_or (busy_cpu, topology[c].siblings);
+  return clib_bitmap_set (busy_cpu, c, 1);
+}
 
 /* Called early in the init sequence */
 
@@ -178,7 +366,7 @@ vlib_thread_init (vlib_main_t * vm)
   u32 n_vlib_mains = 1;
   u32 first_index = 1;
   u32 i;
-  uword *avail_cpu;
+  uword *avail_cpu, *busy_cpu = 0;
 
   /* get bitmaps of active cpu cores and sockets */
   tm->cpu_core_bitmap =
@@ -222,6 +410,19 @@ vlib_thread_init (vlib_main_t * vm)
   if (!tm->cpu_socket_bitmap)
     tm->cpu_socket_bitmap = clib_bitmap_set (0, 0, 1);
 
+  vlib_cpu_topology_init (tm);
+
+  if (tm->placement_auto)
+    {
+      if (tm->placement_numa != ~0)
+	tm->placement_numa_bitmap =
+	  clib_bitmap_set (0, tm->placement_numa, 1);
+      else
+	tm->placement_numa_bitmap = vlib_thread_nic_numa_nodes (vm);
+      busy_cpu = vlib_thread_placement_busy (tm->cpu_topology, busy_cpu,
+					     tm->main_lcore);
+    }
+
   /* pin main thread to main_lcore  */
   if (tm->cb.vlib_thread_set_lcore_cb)
     {
@@ -295,6 +496,24 @@ vlib_thread_init (vlib_main_t * vm)
           }
           /* *INDENT-ON* */
 	}
+      else if (tm->placement_auto)
+	{
+	  for (j = 0; j < tr->count; j++)
+	    {
+	      uword c = vlib_thread_placement_next_cpu (
+		tm->cpu_topology, tm->placement_numa_bitmap, avail_cpu,
+		busy_cpu);
+	      if (c == ~0)
+		return clib_error_return (0,
+					  "no available cpus to be used for"
+					  " the '%s' thread", tr->name);
+
+	      avail_cpu = clib_bitmap_set (avail_cpu, c, 0);
+	      busy_cpu = vlib_thread_placement_busy (tm->cpu_topology,
+						     busy_cpu, c);
+	      tr->coremask = clib_bitmap_set (tr->coremask, c, 1);
+	    }
+	}
       else
 	{
 	  for (j = 0; j < tr->count; j++)
@@ -324,6 +543,7 @@ vlib_thread_init (vlib_main_t * vm)
     }
 
   clib_bitmap_free (avail_cpu);
+  clib_bitmap_free (busy_cpu);
 
   tm->n_vlib_mains = n_vlib_mains;
 
@@ -414,9 +634,12 @@ vlib_worker_thread_bootstrap_fn (void *arg)
 
   __os_thread_index = w - vlib_worker_threads;
 
-  vm = vlib_global_main.vlib_mains[__os_thread_index];
+  /* threads registered with no_data_structure_clone have no vlib_main */
+  if (__os_thread_index < vec_len (vlib_global_main.vlib_mains))
+    vm = vlib_global_main.vlib_mains[__os_thread_index];
 
-  vlib_process_start_switch_stack (vm, 0);
+  if (vm)
+    vlib_process_start_switch_stack (vm, 0);
   rv = (void *) clib_calljmp
     ((uword (*)(uword)) w->thread_function,
      (uword) arg, w->thread_stack + VLIB_THREAD_STACK_SIZE);
@@ -1113,6 +1336,7 @@ cpu_config (vlib_main_t * vm, unformat_input_t * input)
   tm->sched_policy = ~0;
   tm->sched_priority = ~0;
   tm->main_lcore = ~0;
+  tm->placement_numa = ~0;
 
   tr = tm->next;
 
@@ -1132,6 +1356,11 @@ cpu_config (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "skip-cores %u", &tm->skip_cores))
 	;
+      else if (unformat (input, "placement auto numa %u",
+			 &tm->placement_numa))
+	tm->placement_auto = 1;
+      else if (unformat (input, "placement auto"))
+	tm->placement_auto = 1;
       else if (unformat (input, "numa-heap-size %U",
 			 unformat_memory_size, &tm->numa_heap_size))
 	;
@@ -1278,6 +1507,7 @@ vlib_worker_thread_barrier_held (void)
 void
 vlib_worker_thread_barrier_sync_int (vlib_main_t * vm, const char *func_name)
 {
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
   f64 deadline;
   f64 now;
   f64 t_entry;
@@ -1306,6 +1536,8 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm, const char *func_name)
       return;
     }
 
+  tm->barrier_holder = func_name;
+
   if (PREDICT_FALSE (vec_len (vm->barrier_perf_callbacks) != 0))
     clib_call_callbacks (vm->barrier_perf_callbacks, vm,
 			 vm->clib_time.last_cpu_time, 0 /* enter */ );
@@ -1462,6 +1694,8 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
   t_closed_total = now - vm->barrier_epoch;
 
+  barrier_stats_record (t_closed_total);
+
   minimum_open = t_closed_total * BARRIER_MINIMUM_OPEN_FACTOR;
 
   if (minimum_open > BARRIER_MINIMUM_OPEN_LIMIT)
@@ -1517,6 +1751,108 @@ vlib_worker_wait_one_loop (void)
   return;
 }
 
+/**
+ * Run the calls whose grace period is over, and start the grace period
+ * of the ones queued since.
+ * @return non-zero while calls are waiting
+ */
+static int
+vlib_worker_quiescent_calls_run (void)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_quiescent_call_t *calls, *c;
+  u32 i;
+
+  if (vec_len (tm->quiescent_calls_pending))
+    {
+      /* workers stopped at the barrier are quiescent too */
+      if (!vlib_worker_thread_barrier_held ())
+	for (i = 1; i < vlib_get_n_threads (); i++)
+	  if (tm->quiescent_loop_counts[i] ==
+	      clib_atomic_load_acq_n (
+		&vlib_get_main_by_index (i)->main_loop_count))
+	    return 1;
+
+      calls = tm->quiescent_calls_pending;
+      tm->quiescent_calls_pending = 0;
+      vec_foreach (c, calls)
+	c->fn (c->arg);
+      vec_free (calls);
+    }
+
+  if (vec_len (tm->quiescent_calls) == 0)
+    return 0;
+
+  /* the callers have unpublished what they pass before queueing the
+   * calls, any worker going once around from now cannot see it */
+  CLIB_MEMORY_BARRIER ();
+  vec_validate (tm->quiescent_loop_counts, vlib_get_n_threads () - 1);
+  for (i = 1; i < vlib_get_n_threads (); i++)
+    tm->quiescent_loop_counts[i] = clib_atomic_load_acq_n (
+      &vlib_get_main_by_index (i)->main_loop_count);
+
+  tm->quiescent_calls_pending = tm->quiescent_calls;
+  tm->quiescent_calls = 0;
+  return 1;
+}
+
+static uword
+vlib_worker_quiescent_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			       vlib_frame_t *f)
+{
+  while (1)
+    {
+      vlib_process_wait_for_event (vm);
+      vlib_process_get_events (vm, 0);
+
+      while (vlib_worker_quiescent_calls_run ())
+	vlib_process_suspend (vm, 1e-4);
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (vlib_worker_quiescent_process_node) = {
+  .function = vlib_worker_quiescent_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "worker-quiescent-process",
+};
+/* *INDENT-ON* */
+
+void
+vlib_worker_call_after_quiescence (vlib_quiescent_fn_t *fn, void *arg)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_quiescent_call_t *c;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (vlib_get_n_threads () < 2)
+    {
+      fn (arg);
+      return;
+    }
+
+  vec_add2 (tm->quiescent_calls, c, 1);
+  c->fn = fn;
+  c->arg = arg;
+  vlib_process_signal_event (vlib_get_main (),
+			     vlib_worker_quiescent_process_node.index, 0, 0);
+}
+
+static void
+vlib_worker_vec_free (void *v)
+{
+  vec_free (v);
+}
+
+void
+vlib_worker_vec_free_after_quiescence (void *v)
+{
+  if (v)
+    vlib_worker_call_after_quiescence (vlib_worker_vec_free, v);
+}
+
 void
 vlib_worker_thread_fn (void *arg)
 {
@@ -1585,6 +1921,13 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
       vec_add1 (fqm->vlib_frame_queues, fq);
     }
 
+  tm->handoff_queue_depth.name = "handoff queue depth";
+  tm->handoff_queue_depth.stat_segment_name = "/sys/handoff/queue-depth";
+  tm->handoff_queue_depth.n_buckets =
+    clib_max (tm->handoff_queue_depth.n_buckets,
+	      vlib_histogram_n_buckets (frame_queue_nelts));
+  vlib_validate_histogram (&tm->handoff_queue_depth, tm->n_vlib_mains - 1);
+
   return (fqm - tm->frame_queue_mains);
 }
 
@@ -1627,6 +1970,13 @@ vlib_rpc_call_main_thread (void *callback, u8 * args, u32 arg_size)
 clib_error_t *
 threads_init (vlib_main_t * vm)
 {
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+
+  tm->barrier_caller_by_name = hash_create (0, sizeof (uword));
+  tm->barrier_hold_time.name = "barrier-hold-time";
+  tm->barrier_hold_time.stat_segment_name = "/sys/barrier/hold-time";
+  tm->barrier_hold_time.n_buckets = vlib_histogram_n_buckets (1ULL << 34);
+  vlib_validate_histogram (&tm->barrier_hold_time, 0);
   return 0;
 }
 
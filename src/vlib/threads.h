@@ -183,6 +183,22 @@ void vlib_worker_thread_node_refork (void);
  */
 void vlib_worker_wait_one_loop (void);
 
+/**
+ * Deferred reclamation, the asynchronous vlib_worker_wait_one_loop.
+ *
+ * Workers hold no reference on shared data between two iterations of their
+ * main loop, each main_loop_count increment announces such a quiescent
+ * state. To update a data structure without a barrier, publish the new
+ * version with a single pointer store, then pass the old one to
+ * vlib_worker_call_after_quiescence: fn (arg) is called from the main
+ * thread once every worker has been through a quiescent state, when none
+ * of them can still be using the old version.
+ */
+typedef void (vlib_quiescent_fn_t) (void *arg);
+void vlib_worker_call_after_quiescence (vlib_quiescent_fn_t *fn, void *arg);
+/** Free a vector once the workers can no longer see it */
+void vlib_worker_vec_free_after_quiescence (void *v);
+
 static_always_inline uword
 vlib_get_thread_index (void)
 {
@@ -240,6 +256,32 @@ typedef struct
   clib_error_t *(*vlib_thread_set_lcore_cb) (u32 thread, u16 cpu);
 } vlib_thread_callbacks_t;
 
+typedef struct
+{
+  vlib_quiescent_fn_t *fn;
+  void *arg;
+} vlib_quiescent_call_t;
+
+typedef struct
+{
+  const char *caller;
+  u64 count;
+  f64 total_time;
+  f64 max_time;
+} vlib_barrier_caller_stats_t;
+
+/* Topology of a cpu, from sysfs; -1 when unknown */
+typedef struct
+{
+  /* Physical core in the package */
+  i32 core_id;
+  i32 package_id;
+  i32 numa_id;
+
+  /* Hyperthreads of the physical core, the cpu included */
+  clib_bitmap_t *siblings;
+} vlib_cpu_topology_t;
+
 typedef struct
 {
   /* Link list of registrations, built by constructors */
@@ -285,9 +327,27 @@ typedef struct
   /* Bitmap of available CPU sockets (NUMA nodes) */
   uword *cpu_socket_bitmap;
 
+  /* Topology of the available CPUs, by cpu id */
+  vlib_cpu_topology_t *cpu_topology;
+
+  /* Automatic placement: workers on distinct physical cores of the NUMA
+     nodes of the NICs, RX queues on workers of the NUMA node of their
+     interface */
+  u8 placement_auto;
+
+  /* NUMA node to place workers on, ~0 for the nodes of the NICs */
+  u32 placement_numa;
+
+  /* NUMA nodes the workers were preferably placed on */
+  uword *placement_numa_bitmap;
+
   /* Worker handoff queues */
   vlib_frame_queue_main_t *frame_queue_mains;
 
+  /* Depth of the handoff queues seen by the sending threads, per
+     destination thread */
+  vlib_histogram_main_t handoff_queue_depth;
+
   /* worker thread initialization barrier */
   volatile u32 worker_thread_release;
 
@@ -304,6 +364,20 @@ typedef struct
   /* NUMA-bound heap size */
   uword numa_heap_size;
 
+  /* Calls waiting for the workers quiescence: the ones queued since the
+     last grace period started, and the ones waiting for it to end */
+  vlib_quiescent_call_t *quiescent_calls;
+  vlib_quiescent_call_t *quiescent_calls_pending;
+  /* Worker main loop counts when the grace period started */
+  u32 *quiescent_loop_counts;
+
+  /* Barrier hold time histogram, in nanoseconds, and per outermost
+     caller stats, to find who keeps the workers stopped */
+  vlib_histogram_main_t barrier_hold_time;
+  vlib_barrier_caller_stats_t *barrier_callers;
+  uword *barrier_caller_by_name;
+  const char *barrier_holder;
+
 } vlib_thread_main_t;
 
 extern vlib_thread_main_t vlib_thread_main;
@@ -499,8 +573,26 @@ vlib_process_signal_event_mt_helper (vlib_process_signal_event_mt_args_t *
 				     args);
 void vlib_rpc_call_main_thread (void *function, u8 * args, u32 size);
 void vlib_get_thread_core_numa (vlib_worker_thread_t * w, unsigned cpu_id);
+
+/* NUMA node of a cpu, -1 if unknown */
+always_inline int
+vlib_cpu_get_numa (u32 cpu_id)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+
+  if (cpu_id >= vec_len (tm->cpu_topology))
+    return -1;
+  return tm->cpu_topology[cpu_id].numa_id;
+}
 vlib_thread_main_t *vlib_get_thread_main_not_inline (void);
 
+/* Automatic placement, see "cpu { placement auto }" */
+uword vlib_thread_placement_next_cpu (vlib_cpu_topology_t *topology,
+				      uword *numa_bitmap, uword *avail_cpu,
+				      uword *busy_cpu);
+uword *vlib_thread_placement_busy (vlib_cpu_topology_t *topology,
+				   uword *busy_cpu, uword cpu);
+
 #endif /* included_vlib_threads_h */
 
 /*
@@ -92,6 +92,128 @@ VLIB_CLI_COMMAND (show_threads_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_cpu_topology_fn (vlib_main_t *vm, unformat_input_t *input,
+		      vlib_cli_command_t *cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_cpu_topology_t *t;
+  vlib_worker_thread_t *w;
+  u8 *s = 0;
+  u32 cpu;
+
+  if (tm->placement_auto)
+    vlib_cli_output (vm, "placement auto, NUMA nodes %U",
+		     format_bitmap_list, tm->placement_numa_bitmap);
+  else
+    vlib_cli_output (vm, "placement manual");
+
+  vlib_cli_output (vm, "%-7s%-7s%-9s%-7s%-12s%s", "CPU", "Core", "Package",
+		   "NUMA", "Siblings", "Threads");
+
+  vec_foreach_index (cpu, tm->cpu_topology)
+    {
+      t = tm->cpu_topology + cpu;
+      if (!clib_bitmap_get (tm->cpu_core_bitmap, cpu))
+	continue;
+
+      s = format (s, "%-7u%-7d%-9d%-7d%-12U", cpu, t->core_id, t->package_id,
+		  t->numa_id, format_bitmap_list, t->siblings);
+      vec_foreach (w, vlib_worker_threads)
+	if (w->lwp && w->cpu_id == cpu)
+	  s = format (s, "%s ", w->name);
+      vlib_cli_output (vm, "%v", s);
+      vec_reset_length (s);
+    }
+
+  vec_free (s);
+  return 0;
+}
+
+/*?
+ * Show the online cpus with their physical core, package and NUMA node,
+ * their hyperthread siblings and the threads pinned to them, and how the
+ * workers were placed.
+ *
+ * @cliexpar
+ * @cliexcmd{show cpu topology}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_cpu_topology_command, static) = {
+  .path = "show cpu topology",
+  .short_help = "show cpu topology",
+  .function = show_cpu_topology_fn,
+};
+/* *INDENT-ON* */
+
+static int
+barrier_caller_cmp (void *a1, void *a2)
+{
+  vlib_barrier_caller_stats_t *c1 = a1, *c2 = a2;
+
+  /* longest total hold time first */
+  if (c1->total_time < c2->total_time)
+    return 1;
+  return c1->total_time > c2->total_time ? -1 : 0;
+}
+
+static clib_error_t *
+show_barrier_fn (vlib_main_t *vm, unformat_input_t *input,
+		 vlib_cli_command_t *cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_barrier_caller_stats_t *callers, *cs;
+
+  vlib_cli_output (vm, "%-40s%12s%14s%12s%12s", "Caller", "Count",
+		   "Total (ms)", "Avg (us)", "Max (us)");
+
+  callers = vec_dup (tm->barrier_callers);
+  vec_sort_with_function (callers, barrier_caller_cmp);
+  vec_foreach (cs, callers)
+    vlib_cli_output (vm, "%-40s%12llu%14.3f%12.1f%12.1f", cs->caller,
+		     cs->count, cs->total_time * 1e3,
+		     cs->total_time * 1e6 / cs->count, cs->max_time * 1e6);
+  vec_free (callers);
+
+  return 0;
+}
+
+/*?
+ * Show how long each caller of vlib_worker_thread_barrier_sync kept the
+ * workers stopped, longest total first. Recursive calls are accounted to
+ * the outermost caller. The distribution of all the hold times is in the
+ * stats segment, /sys/barrier/hold-time.
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_barrier_command, static) = {
+  .path = "show barrier",
+  .short_help = "show barrier",
+  .function = show_barrier_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_barrier_fn (vlib_main_t *vm, unformat_input_t *input,
+		  vlib_cli_command_t *cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+
+  vec_reset_length (tm->barrier_callers);
+  hash_free (tm->barrier_caller_by_name);
+  tm->barrier_caller_by_name = hash_create (0, sizeof (uword));
+  vlib_clear_histograms (&tm->barrier_hold_time);
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (clear_barrier_command, static) = {
+  .path = "clear barrier",
+  .short_help = "clear barrier",
+  .function = clear_barrier_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * Trigger threads to grab frame queue trace data
  */
@@ -82,6 +82,48 @@ add_next (vlib_main_t * vm,
   return ni;
 }
 
+/* Number of consecutive features from f which can be fused */
+static u32
+fused_run_length (vnet_config_main_t *cm, vnet_config_feature_t *f,
+		  vnet_config_feature_t *end, u32 end_node_index)
+{
+  u32 n = 0;
+
+  if (cm->fused_node_index == ~0)
+    return 0;
+
+  for (; f < end; f++, n++)
+    if (f->feature_index >= vec_len (cm->fused_fn_by_feature_index) ||
+	!cm->fused_fn_by_feature_index[f->feature_index] ||
+	vec_len (f->feature_config) || f->node_index == end_node_index)
+      break;
+
+  return n;
+}
+
+static u32
+fused_sequence_index (vnet_config_main_t *cm, vnet_config_feature_t *f,
+		      u32 n_features)
+{
+  u32 i, *sequence = 0;
+  uword *p;
+
+  for (i = 0; i < n_features; i++)
+    vec_add1 (sequence, f[i].feature_index);
+
+  p = hash_get_mem (cm->fused_sequence_index_by_features, sequence);
+  if (p)
+    {
+      vec_free (sequence);
+      return p[0];
+    }
+
+  vec_add1 (cm->fused_sequences, sequence);
+  hash_set_mem (cm->fused_sequence_index_by_features, sequence,
+		vec_len (cm->fused_sequences) - 1);
+  return vec_len (cm->fused_sequences) - 1;
+}
+
 static vnet_config_t *
 find_config_with_features (vlib_main_t * vm,
 			   vnet_config_main_t * cm,
@@ -90,7 +132,7 @@ find_config_with_features (vlib_main_t * vm,
 {
   u32 last_node_index = ~0;
   vnet_config_feature_t *f;
-  u32 *config_string;
+  u32 *config_string, n_fused, i;
   uword *p;
   vnet_config_t *c;
 
@@ -101,6 +143,23 @@ find_config_with_features (vlib_main_t * vm,
 
   vec_foreach (f, feature_vector)
   {
+    n_fused = fused_run_length (cm, f, vec_end (feature_vector),
+				end_node_index);
+    if (n_fused > 1)
+      {
+	/* Visit the fused node once for the whole run. */
+	f->next_index =
+	  add_next (vm, cm, last_node_index, cm->fused_node_index);
+	for (i = 1; i < n_fused; i++)
+	  f[i].next_index = f->next_index;
+	last_node_index = cm->fused_node_index;
+
+	vec_add1 (config_string, f->next_index);
+	vec_add1 (config_string, fused_sequence_index (cm, f, n_fused));
+	f += n_fused - 1;
+	continue;
+      }
+
     /* Connect node graph. */
     f->next_index = add_next (vm, cm, last_node_index, f->node_index);
     last_node_index = f->node_index;
@@ -180,6 +239,9 @@ vnet_config_init (vlib_main_t * vm,
     hash_create_vec (0,
 		     STRUCT_SIZE_OF (vnet_config_t, config_string_vector[0]),
 		     sizeof (uword));
+  cm->fused_node_index = ~0;
+  cm->fused_sequence_index_by_features =
+    hash_create_vec (0, sizeof (u32), sizeof (uword));
 
   ASSERT (n_feature_node_names >= 1);
 
@@ -303,6 +365,32 @@ vnet_config_modify_end_node (vlib_main_t * vm,
   return new->config_string_heap_index + 1;
 }
 
+u32
+vnet_config_rebuild (vlib_main_t *vm, vnet_config_main_t *cm,
+		     u32 config_string_heap_index)
+{
+  vnet_config_feature_t *new_features;
+  vnet_config_t *old, *new;
+  u32 end_node_index, *p;
+
+  p = vnet_get_config_heap (cm, config_string_heap_index);
+  old = pool_elt_at_index (cm->config_pool, p[-1]);
+  new_features = duplicate_feature_vector (old->features);
+  end_node_index =
+    cm->end_node_indices_by_user_index[config_string_heap_index];
+
+  remove_reference (cm, old);
+
+  new = find_config_with_features (vm, cm, new_features, end_node_index);
+  new->reference_count += 1;
+
+  vec_validate (cm->config_pool_index_by_user_index,
+		new->config_string_heap_index + 1);
+  cm->config_pool_index_by_user_index[new->config_string_heap_index + 1]
+    = new - cm->config_pool;
+  return new->config_string_heap_index + 1;
+}
+
 u32
 vnet_config_add_feature (vlib_main_t * vm,
 			 vnet_config_main_t * cm,
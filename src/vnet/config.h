@@ -59,6 +59,12 @@ typedef struct
   u32 *feature_config;
 } vnet_config_feature_t;
 
+/* The work of a feature node on a vector of buffers, without the dispatch
+   to the next feature: a fused feature always passes its buffers on. */
+typedef void (vnet_config_fused_fn_t) (vlib_main_t *vm,
+				       vlib_node_runtime_t *node,
+				       vlib_buffer_t **b, u32 n_buffers);
+
 always_inline void
 vnet_config_feature_free (vnet_config_feature_t * f)
 {
@@ -107,6 +113,15 @@ typedef struct
   /* Temporary vector for holding config strings.  Used to avoid continually
      allocating vectors. */
   u32 *config_string_temp;
+
+  /* Feature fusion, off when fused_node_index is ~0. Runs of two or more
+     consecutive features with a fused function and no feature config are
+     replaced by a single visit to fused_node_index. Its config data is
+     the index in fused_sequences of the feature indices of the run. */
+  u32 fused_node_index;
+  vnet_config_fused_fn_t **fused_fn_by_feature_index;
+  u32 **fused_sequences;
+  uword *fused_sequence_index_by_features;
 } vnet_config_main_t;
 
 always_inline void
@@ -169,6 +184,10 @@ u32 vnet_config_modify_end_node (vlib_main_t * vm,
 				 u32 config_string_heap_index,
 				 u32 end_node_index);
 
+/* Rebuild the config string of a config, after a fusion change */
+u32 vnet_config_rebuild (vlib_main_t *vm, vnet_config_main_t *cm,
+			 u32 config_string_heap_index);
+
 u8 *vnet_config_format_features (vlib_main_t * vm,
 				 vnet_config_main_t * cm,
 				 u32 config_index, u8 * s);
@@ -33,6 +33,7 @@
 #include <vnet/devices/netlink.h>
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/interface/rx_queue_funcs.h>
+#include <vnet/interface/tx_queue_funcs.h>
 
 #include <vnet/devices/af_packet/af_packet.h>
 
@@ -46,19 +47,19 @@ af_packet_main_t af_packet_main;
 #define AF_PACKET_TX_BLOCK_SIZE	 	(AF_PACKET_TX_FRAME_SIZE * \
 					 AF_PACKET_TX_FRAMES_PER_BLOCK)
 
-#define AF_PACKET_RX_FRAMES_PER_BLOCK	1024
+#define AF_PACKET_RX_FRAMES_PER_BLOCK	32
 #define AF_PACKET_RX_FRAME_SIZE	 	(2048 * 5)
-#define AF_PACKET_RX_BLOCK_NR		1
+#define AF_PACKET_RX_BLOCK_NR		32
 #define AF_PACKET_RX_FRAME_NR		(AF_PACKET_RX_BLOCK_NR * \
 					 AF_PACKET_RX_FRAMES_PER_BLOCK)
 #define AF_PACKET_RX_BLOCK_SIZE		(AF_PACKET_RX_FRAME_SIZE * \
 					 AF_PACKET_RX_FRAMES_PER_BLOCK)
+/* a partially filled block is handed over after this many ms */
+#define AF_PACKET_RX_BLOCK_TIMEOUT_MS	1
 
 /*defined in net/if.h but clashes with dpdk headers */
 unsigned int if_nametoindex (const char *ifname);
 
-typedef struct tpacket_req tpacket_req_t;
-
 static u32
 af_packet_eth_flag_change (vnet_main_t * vnm, vnet_hw_interface_t * hi,
 			   u32 flags)
@@ -106,16 +107,10 @@ af_packet_read_mtu (af_packet_if_t *apif)
 static clib_error_t *
 af_packet_fd_read_ready (clib_file_t * uf)
 {
-  af_packet_main_t *apm = &af_packet_main;
   vnet_main_t *vnm = vnet_get_main ();
-  u32 idx = uf->private_data;
-  af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, idx);
-
-  apm->pending_input_bitmap =
-    clib_bitmap_set (apm->pending_input_bitmap, idx, 1);
 
   /* Schedule the rx node */
-  vnet_hw_if_rx_queue_set_int_pending (vnm, apif->queue_index);
+  vnet_hw_if_rx_queue_set_int_pending (vnm, uf->private_data);
   return 0;
 }
 
@@ -138,17 +133,52 @@ is_bridge (const u8 * host_if_name)
   return -1;
 }
 
+static u32
+af_packet_req_ring_size (tpacket_req3_t *req)
+{
+  return req ? req->tp_block_size * req->tp_block_nr : 0;
+}
+
+/*
+ * The TPACKET_V3 tx ring needs Linux 4.11 or newer, older kernels refuse
+ * to set it up.
+ */
+static int
+af_packet_tx_v3_supported (void)
+{
+  tpacket_req3_t req = {
+    .tp_block_size = 1 << 16,
+    .tp_frame_size = 2048,
+    .tp_block_nr = 1,
+    .tp_frame_nr = (1 << 16) / 2048,
+  };
+  int fd, ver = TPACKET_V3, rv = 0;
+
+  if ((fd = socket (AF_PACKET, SOCK_RAW, 0)) < 0)
+    return 0;
+
+  if (setsockopt (fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof (ver)) == 0 &&
+      setsockopt (fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof (req)) == 0)
+    rv = 1;
+
+  close (fd);
+  return rv;
+}
+
 static int
-create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
-		       tpacket_req_t * tx_req, int *fd, u8 ** ring)
+create_packet_sock (int host_if_index, int ver, tpacket_req3_t *rx_req,
+		    tpacket_req3_t *tx_req, int *fd, u8 **ring, u32 fanout_id,
+		    int ignore_outgoing)
 {
   af_packet_main_t *apm = &af_packet_main;
   int ret;
   struct sockaddr_ll sll;
-  int ver = TPACKET_V2;
-  socklen_t req_sz = sizeof (struct tpacket_req);
-  u32 ring_sz = rx_req->tp_block_size * rx_req->tp_block_nr +
-    tx_req->tp_block_size * tx_req->tp_block_nr;
+  /* the V2 request is the head of the V3 one */
+  socklen_t req_sz = ver == TPACKET_V3 ? sizeof (tpacket_req3_t) :
+					 sizeof (struct tpacket_req);
+  u32 ring_sz;
+
+  ring_sz = af_packet_req_ring_size (rx_req) + af_packet_req_ring_size (tx_req);
 
   if ((*fd = socket (AF_PACKET, SOCK_RAW, htons (ETH_P_ALL))) < 0)
     {
@@ -159,10 +189,11 @@ create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
       goto error;
     }
 
-  /* bind before rx ring is cfged so we don't receive packets from other interfaces */
+  /* bind before rx ring is cfged so we don't receive packets from other
+   * interfaces, tx only sockets bind to no protocol and receive nothing */
   clib_memset (&sll, 0, sizeof (sll));
   sll.sll_family = PF_PACKET;
-  sll.sll_protocol = htons (ETH_P_ALL);
+  sll.sll_protocol = rx_req ? htons (ETH_P_ALL) : 0;
   sll.sll_ifindex = host_if_index;
   if (bind (*fd, (struct sockaddr *) &sll, sizeof (sll)) < 0)
     {
@@ -201,7 +232,20 @@ create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
 		      strerror (errno), errno);
     }
 
-  if (setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req, req_sz) < 0)
+#ifdef PACKET_IGNORE_OUTGOING
+  /* with several sockets, one must not receive what the others send */
+  if (ignore_outgoing &&
+      setsockopt (*fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &opt,
+		  sizeof (opt)) < 0)
+    {
+      vlib_log_debug (apm->log_class,
+		      "Failed to set ignore outgoing option: %s (errno %d)",
+		      strerror (errno), errno);
+    }
+#endif
+
+  if (rx_req &&
+      setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req, req_sz) < 0)
     {
       vlib_log_debug (apm->log_class,
 		      "Failed to set packet rx ring options: %s (errno %d)",
@@ -210,7 +254,8 @@ create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
       goto error;
     }
 
-  if (setsockopt (*fd, SOL_PACKET, PACKET_TX_RING, tx_req, req_sz) < 0)
+  if (tx_req &&
+      setsockopt (*fd, SOL_PACKET, PACKET_TX_RING, tx_req, req_sz) < 0)
     {
       vlib_log_debug (apm->log_class,
 		      "Failed to set packet tx ring options: %s (errno %d)",
@@ -219,6 +264,23 @@ create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
       goto error;
     }
 
+  if (rx_req && fanout_id)
+    {
+      /* spread flows across the rx sockets, rolling over to another
+       * socket when the ring of the selected one is full */
+      int fanout = fanout_id | ((PACKET_FANOUT_HASH |
+				 PACKET_FANOUT_FLAG_ROLLOVER) << 16);
+      if (setsockopt (*fd, SOL_PACKET, PACKET_FANOUT, &fanout,
+		      sizeof (fanout)) < 0)
+	{
+	  vlib_log_debug (apm->log_class,
+			  "Failed to set fanout options: %s (errno %d)",
+			  strerror (errno), errno);
+	  ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+	  goto error;
+	}
+    }
+
   *ring =
     mmap (NULL, ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, *fd,
 	  0);
@@ -237,52 +299,156 @@ error:
       close (*fd);
       *fd = -1;
     }
+  *ring = NULL;
   return ret;
 }
 
+static void
+af_packet_queue_free (af_packet_queue_t *q)
+{
+  af_packet_main_t *apm = &af_packet_main;
+  u32 ring_sz = af_packet_req_ring_size (q->rx_req);
+
+  /* a tx ring on a socket of its own has its own mapping */
+  if (q->tx_fd >= 0 && q->tx_fd != q->fd)
+    {
+      close (q->tx_fd);
+      if (q->tx_ring &&
+	  munmap (q->tx_ring, af_packet_req_ring_size (q->tx_req)))
+	vlib_log_warn (apm->log_class, "could not free tx ring of queue %u",
+		       q->queue_id);
+    }
+  else if (q->tx_ring)
+    ring_sz += af_packet_req_ring_size (q->tx_req);
+
+  if (q->clib_file_index != ~0)
+    {
+      clib_file_del (&file_main, file_main.file_pool + q->clib_file_index);
+      q->clib_file_index = ~0;
+    }
+  else if (q->fd >= 0)
+    close (q->fd);
+
+  u8 *ring = q->rx_ring ? q->rx_ring : q->tx_ring;
+  if (ring && munmap (ring, ring_sz))
+    vlib_log_warn (apm->log_class, "could not free rx/tx ring of queue %u",
+		   q->queue_id);
+  q->rx_ring = NULL;
+  q->tx_ring = NULL;
+  q->fd = -1;
+  q->tx_fd = -1;
+
+  vec_free (q->rx_req);
+  vec_free (q->tx_req);
+  clib_spinlock_free (&q->lockp);
+}
+
+static int
+af_packet_queue_init (af_packet_queue_t *q, int host_if_index, u16 queue_id,
+		      int is_rx, int is_tx, int tx_version, u32 fanout_id)
+{
+  u8 *ring = 0;
+  int ret;
+
+  clib_memset (q, 0, sizeof (*q));
+  q->queue_id = queue_id;
+  q->fd = -1;
+  q->tx_fd = -1;
+  q->clib_file_index = ~0;
+  q->rx_queue_index = ~0;
+  q->tx_queue_index = ~0;
+
+  if (is_rx)
+    {
+      vec_validate (q->rx_req, 0);
+      q->rx_req->tp_block_size = AF_PACKET_RX_BLOCK_SIZE;
+      q->rx_req->tp_frame_size = AF_PACKET_RX_FRAME_SIZE;
+      q->rx_req->tp_block_nr = AF_PACKET_RX_BLOCK_NR;
+      q->rx_req->tp_frame_nr = AF_PACKET_RX_FRAME_NR;
+      q->rx_req->tp_retire_blk_tov = AF_PACKET_RX_BLOCK_TIMEOUT_MS;
+    }
+
+  if (is_tx)
+    {
+      /* the kernel does not support tx blocks, only fixed size frames */
+      vec_validate (q->tx_req, 0);
+      q->tx_req->tp_block_size = AF_PACKET_TX_BLOCK_SIZE;
+      q->tx_req->tp_frame_size = AF_PACKET_TX_FRAME_SIZE;
+      q->tx_req->tp_block_nr = AF_PACKET_TX_BLOCK_NR;
+      q->tx_req->tp_frame_nr = AF_PACKET_TX_FRAME_NR;
+    }
+
+  if (is_rx && is_tx && tx_version != TPACKET_V3)
+    {
+      /* a socket has a single version, rx rings are always V3 */
+      ret = create_packet_sock (host_if_index, TPACKET_V3, q->rx_req, 0,
+				&q->fd, &q->rx_ring, fanout_id, 1);
+      if (ret == 0)
+	ret = create_packet_sock (host_if_index, tx_version, 0, q->tx_req,
+				  &q->tx_fd, &q->tx_ring, 0, 0);
+      if (ret != 0)
+	{
+	  af_packet_queue_free (q);
+	  return ret;
+	}
+    }
+  else
+    {
+      ret = create_packet_sock (host_if_index,
+				is_rx ? TPACKET_V3 : tx_version, q->rx_req,
+				q->tx_req, &q->fd, &ring, fanout_id,
+				fanout_id != 0);
+      if (ret != 0)
+	{
+	  vec_free (q->rx_req);
+	  vec_free (q->tx_req);
+	  return ret;
+	}
+
+      /* the rx ring, if any, comes first in the mapping */
+      q->tx_fd = is_tx ? q->fd : -1;
+      if (is_rx)
+	q->rx_ring = ring;
+      if (is_tx)
+	q->tx_ring = ring + af_packet_req_ring_size (q->rx_req);
+    }
+
+  clib_spinlock_init (&q->lockp);
+  return 0;
+}
+
 int
-af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
-		     u32 * sw_if_index)
+af_packet_create_if (vlib_main_t *vm, af_packet_create_if_arg_t *arg)
 {
   af_packet_main_t *apm = &af_packet_main;
-  int ret, fd = -1, fd2 = -1;
-  struct tpacket_req *rx_req = 0;
-  struct tpacket_req *tx_req = 0;
+  int ret, fd2 = -1;
   struct ifreq ifr;
-  u8 *ring = 0;
   af_packet_if_t *apif = 0;
+  af_packet_queue_t *q;
   u8 hw_addr[6];
   clib_error_t *error;
   vnet_sw_interface_t *sw;
   vnet_hw_interface_t *hw;
-  vlib_thread_main_t *tm = vlib_get_thread_main ();
   vnet_main_t *vnm = vnet_get_main ();
   uword *p;
   uword if_index;
   u8 *host_if_name_dup = 0;
   int host_if_index = -1;
+  int tx_version = TPACKET_V3;
+  u32 i, n_queues, fanout_id;
 
-  p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
+  p = mhash_get (&apm->if_index_by_host_if_name, arg->host_if_name);
   if (p)
     {
       apif = vec_elt_at_index (apm->interfaces, p[0]);
-      *sw_if_index = apif->sw_if_index;
+      arg->sw_if_index = apif->sw_if_index;
       return VNET_API_ERROR_IF_ALREADY_EXISTS;
     }
 
-  host_if_name_dup = vec_dup (host_if_name);
-
-  vec_validate (rx_req, 0);
-  rx_req->tp_block_size = AF_PACKET_RX_BLOCK_SIZE;
-  rx_req->tp_frame_size = AF_PACKET_RX_FRAME_SIZE;
-  rx_req->tp_block_nr = AF_PACKET_RX_BLOCK_NR;
-  rx_req->tp_frame_nr = AF_PACKET_RX_FRAME_NR;
+  if (arg->num_rxqs == 0 || arg->num_txqs == 0)
+    return VNET_API_ERROR_INVALID_VALUE;
 
-  vec_validate (tx_req, 0);
-  tx_req->tp_block_size = AF_PACKET_TX_BLOCK_SIZE;
-  tx_req->tp_frame_size = AF_PACKET_TX_FRAME_SIZE;
-  tx_req->tp_block_nr = AF_PACKET_TX_BLOCK_NR;
-  tx_req->tp_frame_nr = AF_PACKET_TX_FRAME_NR;
+  host_if_name_dup = vec_dup (arg->host_if_name);
 
   /*
    * make sure host side of interface is 'UP' before binding AF_PACKET
@@ -297,13 +463,13 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
       goto error;
     }
 
-  clib_memcpy (ifr.ifr_name, (const char *) host_if_name,
-	       vec_len (host_if_name));
+  clib_memcpy (ifr.ifr_name, (const char *) arg->host_if_name,
+	       vec_len (arg->host_if_name));
   if (ioctl (fd2, SIOCGIFINDEX, &ifr) < 0)
     {
       vlib_log_debug (apm->log_class,
 		      "Failed to retrieve the interface (%s) index: %s (errno %d)",
-		      host_if_name, strerror (errno), errno);
+		      arg->host_if_name, strerror (errno), errno);
       ret = VNET_API_ERROR_INVALID_INTERFACE;
       goto error;
     }
@@ -337,41 +503,57 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
       fd2 = -1;
     }
 
-  ret = create_packet_v2_sock (host_if_index, rx_req, tx_req, &fd, &ring);
+  /* So far everything looks good, let's create interface */
+  pool_get_zero (apm->interfaces, apif);
+  if_index = apif - apm->interfaces;
 
-  if (ret != 0)
-    goto error;
+  /* fanout group ids are global to the network namespace */
+  n_queues = clib_max (arg->num_rxqs, arg->num_txqs);
+  fanout_id = n_queues > 1 ? ((getpid () << 8) ^ if_index) & 0xffff : 0;
+  if (n_queues > 1 && fanout_id == 0)
+    fanout_id = 1;
+
+  if (arg->use_tx_ring_v2)
+    tx_version = TPACKET_V2;
+  else if (!af_packet_tx_v3_supported ())
+    {
+      vlib_log_debug (apm->log_class, "TPACKET_V3 tx ring not supported by "
+		      "the kernel, using TPACKET_V2");
+      tx_version = TPACKET_V2;
+    }
+
+  vec_validate_aligned (apif->queues, n_queues - 1, CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < n_queues; i++)
+    {
+      ret = af_packet_queue_init (vec_elt_at_index (apif->queues, i),
+				  host_if_index, i, i < arg->num_rxqs,
+				  i < arg->num_txqs, tx_version, fanout_id);
+      if (ret != 0)
+	{
+	  _vec_len (apif->queues) = i;
+	  goto error;
+	}
+    }
 
-  ret = is_bridge (host_if_name);
+  ret = is_bridge (arg->host_if_name);
 
   if (ret == 0)			/* is a bridge, ignore state */
     host_if_index = -1;
 
-  /* So far everything looks good, let's create interface */
-  pool_get (apm->interfaces, apif);
-  if_index = apif - apm->interfaces;
-
   apif->host_if_index = host_if_index;
-  apif->fd = fd;
-  apif->rx_ring = ring;
-  apif->tx_ring = ring + rx_req->tp_block_size * rx_req->tp_block_nr;
-  apif->rx_req = rx_req;
-  apif->tx_req = tx_req;
+  apif->num_rxqs = arg->num_rxqs;
+  apif->num_txqs = arg->num_txqs;
+  apif->tx_version = tx_version;
   apif->host_if_name = host_if_name_dup;
   apif->per_interface_next_index = ~0;
-  apif->next_tx_frame = 0;
-  apif->next_rx_frame = 0;
 
   ret = af_packet_read_mtu (apif);
   if (ret != 0)
     goto error;
 
-  if (tm->n_vlib_mains > 1)
-    clib_spinlock_init (&apif->lockp);
-
   /*use configured or generate random MAC address */
-  if (hw_addr_set)
-    clib_memcpy (hw_addr, hw_addr_set, 6);
+  if (arg->hw_addr)
+    clib_memcpy (hw_addr, arg->hw_addr, 6);
   else
     {
       f64 now = vlib_time_now (vm);
@@ -390,8 +572,6 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
 
   if (error)
     {
-      clib_memset (apif, 0, sizeof (*apif));
-      pool_put (apm->interfaces, apif);
       vlib_log_err (apm->log_class, "Unable to register interface: %U",
 		    format_clib_error, error);
       clib_error_free (error);
@@ -404,33 +584,49 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   apif->sw_if_index = sw->sw_if_index;
   vnet_hw_if_set_input_node (vnm, apif->hw_if_index,
 			     af_packet_input_node.index);
-  apif->queue_index = vnet_hw_if_register_rx_queue (vnm, apif->hw_if_index, 0,
-						    VNET_HW_IF_RXQ_THREAD_ANY);
 
   hw->caps |= VNET_HW_INTERFACE_CAP_SUPPORTS_INT_MODE;
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index,
 			       VNET_HW_INTERFACE_FLAG_LINK_UP);
 
-  vnet_hw_if_set_rx_queue_mode (vnm, apif->queue_index,
-				VNET_HW_IF_RX_MODE_INTERRUPT);
+  vec_foreach (q, apif->queues)
+    {
+      if (q->rx_req)
+	{
+	  clib_file_t template = { 0 };
+
+	  q->rx_queue_index = vnet_hw_if_register_rx_queue (
+	    vnm, apif->hw_if_index, q->queue_id, VNET_HW_IF_RXQ_THREAD_ANY);
+	  vnet_hw_if_set_rx_queue_mode (vnm, q->rx_queue_index,
+					VNET_HW_IF_RX_MODE_INTERRUPT);
+
+	  template.read_function = af_packet_fd_read_ready;
+	  template.file_descriptor = q->fd;
+	  template.private_data = q->rx_queue_index;
+	  template.flags = UNIX_FILE_EVENT_EDGE_TRIGGERED;
+	  template.description = format (0, "%U queue %u",
+					 format_af_packet_device_name,
+					 if_index, q->queue_id);
+	  q->clib_file_index = clib_file_add (&file_main, &template);
+	  vnet_hw_if_set_rx_queue_file_index (vnm, q->rx_queue_index,
+					      q->clib_file_index);
+	}
+      if (q->tx_req)
+	q->tx_queue_index =
+	  vnet_hw_if_register_tx_queue (vnm, apif->hw_if_index, q->queue_id);
+    }
+
+  for (i = 0; i < vlib_get_n_threads (); i++)
+    {
+      q = vec_elt_at_index (apif->queues, i % apif->num_txqs);
+      vnet_hw_if_tx_queue_assign_thread (vnm, q->tx_queue_index, i);
+    }
+
   vnet_hw_if_update_runtime_data (vnm, apif->hw_if_index);
-  {
-    clib_file_t template = { 0 };
-    template.read_function = af_packet_fd_read_ready;
-    template.file_descriptor = fd;
-    template.private_data = if_index;
-    template.flags = UNIX_FILE_EVENT_EDGE_TRIGGERED;
-    template.description =
-      format (0, "%U", format_af_packet_device_name, if_index);
-    apif->clib_file_index = clib_file_add (&file_main, &template);
-  }
-  vnet_hw_if_set_rx_queue_file_index (vnm, apif->queue_index,
-				      apif->clib_file_index);
 
   mhash_set_mem (&apm->if_index_by_host_if_name, host_if_name_dup, &if_index,
 		 0);
-  if (sw_if_index)
-    *sw_if_index = apif->sw_if_index;
+  arg->sw_if_index = apif->sw_if_index;
 
   return 0;
 
@@ -440,9 +636,15 @@ error:
       close (fd2);
       fd2 = -1;
     }
+  if (apif)
+    {
+      vec_foreach (q, apif->queues)
+	af_packet_queue_free (q);
+      vec_free (apif->queues);
+      clib_memset (apif, 0, sizeof (*apif));
+      pool_put (apm->interfaces, apif);
+    }
   vec_free (host_if_name_dup);
-  vec_free (rx_req);
-  vec_free (tx_req);
   return ret;
 }
 
@@ -452,9 +654,9 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
   vnet_main_t *vnm = vnet_get_main ();
   af_packet_main_t *apm = &af_packet_main;
   af_packet_if_t *apif;
+  af_packet_queue_t *q;
   uword *p;
   uword if_index;
-  u32 ring_sz;
 
   p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
   if (p == NULL)
@@ -470,28 +672,9 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index, 0);
 
   /* clean up */
-  if (apif->clib_file_index != ~0)
-    {
-      clib_file_del (&file_main, file_main.file_pool + apif->clib_file_index);
-      apif->clib_file_index = ~0;
-    }
-  else
-    close (apif->fd);
-
-  ring_sz = apif->rx_req->tp_block_size * apif->rx_req->tp_block_nr +
-    apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
-  if (munmap (apif->rx_ring, ring_sz))
-    vlib_log_warn (apm->log_class,
-		   "Host interface %s could not free rx/tx ring",
-		   host_if_name);
-  apif->rx_ring = NULL;
-  apif->tx_ring = NULL;
-  apif->fd = -1;
-
-  vec_free (apif->rx_req);
-  apif->rx_req = NULL;
-  vec_free (apif->tx_req);
-  apif->tx_req = NULL;
+  vec_foreach (q, apif->queues)
+    af_packet_queue_free (q);
+  vec_free (apif->queues);
 
   vec_free (apif->host_if_name);
   apif->host_if_name = NULL;
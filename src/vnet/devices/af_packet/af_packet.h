@@ -27,38 +27,76 @@ typedef struct
   u8 host_if_name[64];
 } af_packet_if_detail_t;
 
+typedef struct tpacket_req3 tpacket_req3_t;
+typedef struct tpacket3_hdr tpacket3_hdr_t;
+typedef struct tpacket2_hdr tpacket2_hdr_t;
+typedef struct tpacket_block_desc block_desc_t;
+
+/*
+ * One PACKET socket per queue. Queue i owns an rx ring if i < num_rxqs and
+ * a tx ring if i < num_txqs. The sockets of the rx queues are members of a
+ * fanout group so the kernel spreads the flows of the host interface across
+ * them. A TPACKET_V2 tx ring needs a socket of its own when the queue also
+ * has a (TPACKET_V3) rx ring.
+ */
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   clib_spinlock_t lockp;
-  u8 *host_if_name;
-  int host_if_index;
   int fd;
-  struct tpacket_req *rx_req;
-  struct tpacket_req *tx_req;
+  u16 queue_id;
+
+  /* TPACKET_V3 rx ring: blocks of variable sized frames */
+  tpacket_req3_t *rx_req;
   u8 *rx_ring;
-  u8 *tx_ring;
-  u32 hw_if_index;
-  u32 sw_if_index;
+  u32 next_rx_block;
+  u32 rx_frame_offset;
+  u32 num_rx_pkts;
+  u32 rx_queue_index;
   u32 clib_file_index;
 
-  u32 next_rx_frame;
+  /* TPACKET_V3 or V2 tx ring: fixed size frames */
+  tpacket_req3_t *tx_req;
+  u8 *tx_ring;
+  int tx_fd;
   u32 next_tx_frame;
+  u32 tx_queue_index;
+} af_packet_queue_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u8 *host_if_name;
+  int host_if_index;
+  af_packet_queue_t *queues;
+  u16 num_rxqs;
+  u16 num_txqs;
+  u8 tx_version;
+  u32 hw_if_index;
+  u32 sw_if_index;
 
   u32 per_interface_next_index;
   u8 is_admin_up;
-  u32 queue_index;
   u32 host_mtu;
 } af_packet_if_t;
 
+typedef struct
+{
+  u8 *host_if_name;
+  u8 *hw_addr;
+  u16 num_rxqs;
+  u16 num_txqs;
+  u8 use_tx_ring_v2;
+
+  /* return */
+  u32 sw_if_index;
+} af_packet_create_if_arg_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   af_packet_if_t *interfaces;
 
-  /* bitmap of pending rx interfaces */
-  uword *pending_input_bitmap;
-
   /* rx buffer cache */
   u32 **rx_buffers;
 
@@ -73,8 +111,7 @@ extern af_packet_main_t af_packet_main;
 extern vnet_device_class_t af_packet_device_class;
 extern vlib_node_registration_t af_packet_input_node;
 
-int af_packet_create_if (vlib_main_t * vm, u8 * host_if_name,
-			 u8 * hw_addr_set, u32 * sw_if_index);
+int af_packet_create_if (vlib_main_t *vm, af_packet_create_if_arg_t *arg);
 int af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name);
 int af_packet_set_l4_cksum_offload (vlib_main_t * vm, u32 sw_if_index,
 				    u8 set);
@@ -38,27 +38,53 @@ vl_api_af_packet_create_t_handler (vl_api_af_packet_create_t * mp)
 {
   vlib_main_t *vm = vlib_get_main ();
   vl_api_af_packet_create_reply_t *rmp;
+  af_packet_create_if_arg_t _arg, *arg = &_arg;
   int rv = 0;
-  u8 *host_if_name = NULL;
-  u32 sw_if_index;
 
-  host_if_name = format (0, "%s", mp->host_if_name);
-  vec_add1 (host_if_name, 0);
+  clib_memset (arg, 0, sizeof (*arg));
+  arg->host_if_name = format (0, "%s", mp->host_if_name);
+  vec_add1 (arg->host_if_name, 0);
+  arg->hw_addr = mp->use_random_hw_addr ? 0 : mp->hw_addr;
+  arg->num_rxqs = 1;
+  arg->num_txqs = 1;
 
-  rv = af_packet_create_if (vm, host_if_name,
-			    mp->use_random_hw_addr ? 0 : mp->hw_addr,
-			    &sw_if_index);
+  rv = af_packet_create_if (vm, arg);
 
-  vec_free (host_if_name);
+  vec_free (arg->host_if_name);
 
   /* *INDENT-OFF* */
   REPLY_MACRO2(VL_API_AF_PACKET_CREATE_REPLY,
   ({
-    rmp->sw_if_index = clib_host_to_net_u32(sw_if_index);
+    rmp->sw_if_index = clib_host_to_net_u32(arg->sw_if_index);
   }));
   /* *INDENT-ON* */
 }
 
+static void
+vl_api_af_packet_create_v2_t_handler (vl_api_af_packet_create_v2_t *mp)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vl_api_af_packet_create_v2_reply_t *rmp;
+  af_packet_create_if_arg_t _arg, *arg = &_arg;
+  int rv = 0;
+
+  clib_memset (arg, 0, sizeof (*arg));
+  arg->host_if_name = format (0, "%s", mp->host_if_name);
+  vec_add1 (arg->host_if_name, 0);
+  arg->hw_addr = mp->use_random_hw_addr ? 0 : mp->hw_addr;
+  arg->num_rxqs = clib_net_to_host_u16 (mp->num_rx_queues);
+  arg->num_txqs = clib_net_to_host_u16 (mp->num_tx_queues);
+  arg->use_tx_ring_v2 = mp->use_tx_ring_v2;
+
+  rv = af_packet_create_if (vm, arg);
+
+  vec_free (arg->host_if_name);
+
+  REPLY_MACRO2 (VL_API_AF_PACKET_CREATE_V2_REPLY, ({
+		  rmp->sw_if_index = clib_host_to_net_u32 (arg->sw_if_index);
+		}));
+}
+
 static void
 vl_api_af_packet_delete_t_handler (vl_api_af_packet_delete_t * mp)
 {
@@ -44,10 +44,9 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 			     vlib_cli_command_t * cmd)
 {
   unformat_input_t _line_input, *line_input = &_line_input;
-  u8 *host_if_name = NULL;
+  af_packet_create_if_arg_t _arg, *arg = &_arg;
   u8 hwaddr[6];
-  u8 *hw_addr_ptr = 0;
-  u32 sw_if_index;
+  u32 num_rxqs = 1, num_txqs = 1;
   int r;
   clib_error_t *error = NULL;
 
@@ -55,14 +54,22 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   if (!unformat_user (input, unformat_line_input, line_input))
     return 0;
 
+  clib_memset (arg, 0, sizeof (*arg));
+
   while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
     {
-      if (unformat (line_input, "name %s", &host_if_name))
+      if (unformat (line_input, "name %s", &arg->host_if_name))
 	;
       else
 	if (unformat
 	    (line_input, "hw-addr %U", unformat_ethernet_address, hwaddr))
-	hw_addr_ptr = hwaddr;
+	arg->hw_addr = hwaddr;
+      else if (unformat (line_input, "num-rx-queues %u", &num_rxqs))
+	;
+      else if (unformat (line_input, "num-tx-queues %u", &num_txqs))
+	;
+      else if (unformat (line_input, "tx-ring-v2"))
+	arg->use_tx_ring_v2 = 1;
       else
 	{
 	  error = clib_error_return (0, "unknown input `%U'",
@@ -71,13 +78,22 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	}
     }
 
-  if (host_if_name == NULL)
+  if (arg->host_if_name == NULL)
     {
       error = clib_error_return (0, "missing host interface name");
       goto done;
     }
 
-  r = af_packet_create_if (vm, host_if_name, hw_addr_ptr, &sw_if_index);
+  if (num_rxqs == 0 || num_rxqs > 0xffff || num_txqs == 0 ||
+      num_txqs > 0xffff)
+    {
+      error = clib_error_return (0, "invalid number of queues");
+      goto done;
+    }
+  arg->num_rxqs = num_rxqs;
+  arg->num_txqs = num_txqs;
+
+  r = af_packet_create_if (vm, arg);
 
   if (r == VNET_API_ERROR_SYSCALL_ERROR_1)
     {
@@ -98,10 +114,10 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
     }
 
   vlib_cli_output (vm, "%U\n", format_vnet_sw_if_index_name, vnet_get_main (),
-		   sw_if_index);
+		   arg->sw_if_index);
 
 done:
-  vec_free (host_if_name);
+  vec_free (arg->host_if_name);
   unformat_free (line_input);
 
   return error;
@@ -120,6 +136,18 @@ done:
  * - <b>hw-addr <mac-addr></b> - Optional ethernet address, can be in either
  * X:X:X:X:X:X unix or X.X.X cisco format.
  *
+ * - <b>num-rx-queues <n></b> - Number of rx queues (1 by default). Each
+ * queue has its own PACKET socket, and the kernel spreads the flows across
+ * them (PACKET_FANOUT). Use '<em>set interface rx-placement</em>' to poll
+ * them from different workers.
+ *
+ * - <b>num-tx-queues <n></b> - Number of tx queues (1 by default). The
+ * queues are spread across the threads, which share them only when there
+ * are fewer queues than threads.
+ *
+ * - <b>tx-ring-v2</b> - Use a TPACKET_V2 tx ring. By default the tx ring is
+ * TPACKET_V3, or TPACKET_V2 when the kernel is older than 4.11.
+ *
  * @cliexpar
  * Example of how to create a host interface tied to one side of an
  * existing linux veth pair named vpp1:
@@ -132,7 +160,8 @@ done:
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (af_packet_create_command, static) = {
   .path = "create host-interface",
-  .short_help = "create host-interface name <ifname> [hw-addr <mac-addr>]",
+  .short_help = "create host-interface name <ifname> [hw-addr <mac-addr>] "
+		"[num-rx-queues <n>] [num-tx-queues <n>] [tx-ring-v2]",
   .function = af_packet_create_command_fn,
 };
 /* *INDENT-ON* */
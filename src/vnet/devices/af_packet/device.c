@@ -51,6 +51,41 @@ static char *af_packet_tx_func_error_strings[] = {
 };
 
 
+/* tx frame headers differ between TPACKET_V3 and TPACKET_V2 */
+static_always_inline u32
+af_packet_tx_frame_status (u8 *frame, u8 tx_version)
+{
+  if (tx_version == TPACKET_V3)
+    return ((tpacket3_hdr_t *) frame)->tp_status;
+  return ((tpacket2_hdr_t *) frame)->tp_status;
+}
+
+static_always_inline u32
+af_packet_tx_frame_data_offset (u8 tx_version)
+{
+  if (tx_version == TPACKET_V3)
+    return TPACKET_ALIGN (sizeof (tpacket3_hdr_t));
+  return TPACKET_ALIGN (sizeof (tpacket2_hdr_t));
+}
+
+static_always_inline void
+af_packet_tx_frame_send_request (u8 *frame, u8 tx_version, u32 len)
+{
+  if (tx_version == TPACKET_V3)
+    {
+      tpacket3_hdr_t *tph = (tpacket3_hdr_t *) frame;
+      tph->tp_len = tph->tp_snaplen = len;
+      tph->tp_next_offset = 0;
+      tph->tp_status = TP_STATUS_SEND_REQUEST;
+    }
+  else
+    {
+      tpacket2_hdr_t *tph = (tpacket2_hdr_t *) frame;
+      tph->tp_len = tph->tp_snaplen = len;
+      tph->tp_status = TP_STATUS_SEND_REQUEST;
+    }
+}
+
 #ifndef CLIB_MARCH_VARIANT
 u8 *
 format_af_packet_device_name (u8 * s, va_list * args)
@@ -73,42 +108,73 @@ format_af_packet_device (u8 * s, va_list * args)
 
   af_packet_main_t *apm = &af_packet_main;
   af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, dev_instance);
-  clib_spinlock_lock_if_init (&apif->lockp);
-  u32 block_size = apif->tx_req->tp_block_size;
-  u32 frame_size = apif->tx_req->tp_frame_size;
-  u32 frame_num = apif->tx_req->tp_frame_nr;
-  int block = 0;
-  u8 *block_start = apif->tx_ring + block * block_size;
-  u32 tx_frame = apif->next_tx_frame;
-  struct tpacket2_hdr *tph;
-
-  s = format (s, "Linux PACKET socket interface\n");
-  s = format (s, "%Ublock:%d frame:%d\n", format_white_space, indent,
-	      block_size, frame_size);
-  s = format (s, "%Unext frame:%d\n", format_white_space, indent,
-	      apif->next_tx_frame);
-
-  int n_send_req = 0, n_avail = 0, n_sending = 0, n_tot = 0, n_wrong = 0;
-  do
+  af_packet_queue_t *q;
+
+  s = format (s, "Linux PACKET socket interface v3, tx ring v%u\n",
+	      apif->tx_version == TPACKET_V3 ? 3 : 2);
+  s = format (s, "%Unum rx queues %u, num tx queues %u\n",
+	      format_white_space, indent, apif->num_rxqs, apif->num_txqs);
+
+  vec_foreach (q, apif->queues)
     {
-      tph = (struct tpacket2_hdr *) (block_start + tx_frame * frame_size);
-      tx_frame = (tx_frame + 1) % frame_num;
-      if (tph->tp_status == 0)
-	n_avail++;
-      else if (tph->tp_status & TP_STATUS_SEND_REQUEST)
-	n_send_req++;
-      else if (tph->tp_status & TP_STATUS_SENDING)
-	n_sending++;
-      else
-	n_wrong++;
-      n_tot++;
+      if (q->rx_req)
+	{
+	  u32 block_size = q->rx_req->tp_block_size;
+	  u32 block_nr = q->rx_req->tp_block_nr;
+	  u32 block, n_user = 0;
+
+	  for (block = 0; block < block_nr; block++)
+	    {
+	      block_desc_t *bd =
+		(block_desc_t *) (q->rx_ring + block * block_size);
+	      n_user += (bd->hdr.bh1.block_status & TP_STATUS_USER) != 0;
+	    }
+	  s = format (s,
+		      "%Urx queue %u:\n%Ublock size:%d nr:%d frame size:%d "
+		      "next block:%d ready blocks:%d\n",
+		      format_white_space, indent, q->queue_id,
+		      format_white_space, indent + 2, block_size, block_nr,
+		      q->rx_req->tp_frame_size, q->next_rx_block, n_user);
+	}
+
+      if (q->tx_req)
+	{
+	  clib_spinlock_lock (&q->lockp);
+	  u32 frame_size = q->tx_req->tp_frame_size;
+	  u32 frame_num = q->tx_req->tp_frame_nr;
+	  u32 tx_frame = q->next_tx_frame;
+	  u32 status;
+	  int n_send_req = 0, n_avail = 0, n_sending = 0, n_tot = 0,
+	      n_wrong = 0;
+
+	  s = format (s, "%Utx queue %u:\n%Uframe size:%d next frame:%d\n",
+		      format_white_space, indent, q->queue_id,
+		      format_white_space, indent + 2, frame_size,
+		      q->next_tx_frame);
+	  do
+	    {
+	      status = af_packet_tx_frame_status (
+		q->tx_ring + tx_frame * frame_size, apif->tx_version);
+	      tx_frame = (tx_frame + 1) % frame_num;
+	      if (status == 0)
+		n_avail++;
+	      else if (status & TP_STATUS_SEND_REQUEST)
+		n_send_req++;
+	      else if (status & TP_STATUS_SENDING)
+		n_sending++;
+	      else
+		n_wrong++;
+	      n_tot++;
+	    }
+	  while (tx_frame != q->next_tx_frame);
+	  s = format (
+	    s, "%Uavailable:%d request:%d sending:%d wrong:%d total:%d\n",
+	    format_white_space, indent + 2, n_avail, n_send_req, n_sending,
+	    n_wrong, n_tot);
+	  clib_spinlock_unlock (&q->lockp);
+	}
     }
-  while (tx_frame != apif->next_tx_frame);
-  s = format (s, "%Uavailable:%d request:%d sending:%d wrong:%d total:%d\n",
-	      format_white_space, indent, n_avail, n_send_req, n_sending,
-	      n_wrong, n_tot);
 
-  clib_spinlock_unlock_if_init (&apif->lockp);
   return s;
 }
 
@@ -124,22 +190,27 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
 						  vlib_frame_t * frame)
 {
   af_packet_main_t *apm = &af_packet_main;
+  vnet_hw_if_tx_frame_t *tf = vlib_frame_scalar_args (frame);
   u32 *buffers = vlib_frame_vector_args (frame);
   u32 n_left = frame->n_vectors;
   u32 n_sent = 0;
   vnet_interface_output_runtime_t *rd = (void *) node->runtime_data;
   af_packet_if_t *apif =
     pool_elt_at_index (apm->interfaces, rd->dev_instance);
-  clib_spinlock_lock_if_init (&apif->lockp);
-  int block = 0;
-  u32 block_size = apif->tx_req->tp_block_size;
-  u32 frame_size = apif->tx_req->tp_frame_size;
-  u32 frame_num = apif->tx_req->tp_frame_nr;
-  u8 *block_start = apif->tx_ring + block * block_size;
-  u32 tx_frame = apif->next_tx_frame;
-  struct tpacket2_hdr *tph;
+  af_packet_queue_t *tx_queue = vec_elt_at_index (apif->queues, tf->queue_id);
+  u32 frame_size, frame_num, tx_frame, data_offset;
+  u8 tx_version = apif->tx_version;
+  u8 *tx_frame_p;
   u32 frame_not_ready = 0;
 
+  if (tf->shared_queue)
+    clib_spinlock_lock (&tx_queue->lockp);
+
+  frame_size = tx_queue->tx_req->tp_frame_size;
+  frame_num = tx_queue->tx_req->tp_frame_nr;
+  tx_frame = tx_queue->next_tx_frame;
+  data_offset = af_packet_tx_frame_data_offset (tx_version);
+
   while (n_left)
     {
       u32 len;
@@ -149,8 +220,8 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
       u32 bi = buffers[0];
       buffers++;
 
-      tph = (struct tpacket2_hdr *) (block_start + tx_frame * frame_size);
-      if (PREDICT_FALSE (tph->tp_status &
+      tx_frame_p = tx_queue->tx_ring + tx_frame * frame_size;
+      if (PREDICT_FALSE (af_packet_tx_frame_status (tx_frame_p, tx_version) &
 			 (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)))
 	{
 	  frame_not_ready++;
@@ -161,16 +232,14 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
 	{
 	  b0 = vlib_get_buffer (vm, bi);
 	  len = b0->current_length;
-	  clib_memcpy_fast ((u8 *) tph +
-			    TPACKET_ALIGN (sizeof (struct tpacket2_hdr)) +
-			    offset, vlib_buffer_get_current (b0), len);
+	  clib_memcpy_fast (tx_frame_p + data_offset + offset,
+			    vlib_buffer_get_current (b0), len);
 	  offset += len;
 	}
       while ((bi =
 	      (b0->flags & VLIB_BUFFER_NEXT_PRESENT) ? b0->next_buffer : 0));
 
-      tph->tp_len = tph->tp_snaplen = offset;
-      tph->tp_status = TP_STATUS_SEND_REQUEST;
+      af_packet_tx_frame_send_request (tx_frame_p, tx_version, offset);
       n_sent++;
 
       tx_frame = (tx_frame + 1) % frame_num;
@@ -183,12 +252,13 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
 
   CLIB_MEMORY_BARRIER ();
 
+  /* a single system call hands the whole vector over to the kernel */
   if (PREDICT_TRUE (n_sent))
     {
-      apif->next_tx_frame = tx_frame;
+      tx_queue->next_tx_frame = tx_frame;
 
-      if (PREDICT_FALSE (sendto (apif->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) ==
-			 -1))
+      if (PREDICT_FALSE (sendto (tx_queue->tx_fd, NULL, 0, MSG_DONTWAIT, NULL,
+				 0) == -1))
 	{
 	  /* Uh-oh, drop & move on, but count whether it was fatal or not.
 	   * Note that we have no reliable way to properly determine the
@@ -202,7 +272,8 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
 	}
     }
 
-  clib_spinlock_unlock_if_init (&apif->lockp);
+  if (tf->shared_queue)
+    clib_spinlock_unlock (&tx_queue->lockp);
 
   if (PREDICT_FALSE (frame_not_ready))
     vlib_error_count (vm, node->node_index,
@@ -50,8 +50,10 @@ typedef struct
 {
   u32 next_index;
   u32 hw_if_index;
-  int block;
-  struct tpacket2_hdr tph;
+  u16 queue_id;
+  u32 block;
+  u32 pkt_num;
+  struct tpacket3_hdr tph;
 } af_packet_input_trace_t;
 
 static u8 *
@@ -62,29 +64,32 @@ format_af_packet_input_trace (u8 * s, va_list * args)
   af_packet_input_trace_t *t = va_arg (*args, af_packet_input_trace_t *);
   u32 indent = format_get_indent (s);
 
-  s = format (s, "af_packet: hw_if_index %d next-index %d",
-	      t->hw_if_index, t->next_index);
+  s = format (s, "af_packet: hw_if_index %d rx-queue %u next-index %d",
+	      t->hw_if_index, t->queue_id, t->next_index);
 
   s =
     format (s,
-	    "\n%Utpacket2_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
+	    "\n%Ublock %u:\n%Upkt %u:"
+	    "\n%Utpacket3_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
 	    "\n%Usec 0x%x nsec 0x%x vlan %U"
 #ifdef TP_STATUS_VLAN_TPID_VALID
 	    " vlan_tpid %u"
 #endif
 	    ,
-	    format_white_space, indent + 2,
-	    format_white_space, indent + 4,
+	    format_white_space, indent + 2, t->block,
+	    format_white_space, indent + 4, t->pkt_num,
+	    format_white_space, indent + 6,
+	    format_white_space, indent + 8,
 	    t->tph.tp_status,
 	    t->tph.tp_len,
 	    t->tph.tp_snaplen,
 	    t->tph.tp_mac,
 	    t->tph.tp_net,
-	    format_white_space, indent + 4,
+	    format_white_space, indent + 8,
 	    t->tph.tp_sec,
-	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.tp_vlan_tci
+	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.hv1.tp_vlan_tci
 #ifdef TP_STATUS_VLAN_TPID_VALID
-	    , t->tph.tp_vlan_tpid
+	    , t->tph.hv1.tp_vlan_tpid
 #endif
     );
   return s;
@@ -193,26 +198,28 @@ mark_tcp_udp_cksum_calc (vlib_buffer_t *b, u8 *l4_hdr_sz)
 }
 
 always_inline uword
-af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
-			   vlib_frame_t * frame, af_packet_if_t * apif)
+af_packet_device_input_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
+			   vlib_frame_t *frame, af_packet_if_t *apif,
+			   u16 queue_id)
 {
   af_packet_main_t *apm = &af_packet_main;
-  struct tpacket2_hdr *tph;
+  af_packet_queue_t *rx_queue = vec_elt_at_index (apif->queues, queue_id);
+  tpacket3_hdr_t *tph;
   u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
-  u32 block = 0;
-  u32 rx_frame;
+  u32 block = rx_queue->next_rx_block;
+  u32 block_size = rx_queue->rx_req->tp_block_size;
+  u32 block_nr = rx_queue->rx_req->tp_block_nr;
   u32 n_free_bufs;
   u32 n_rx_packets = 0;
   u32 n_rx_bytes = 0;
   u32 *to_next = 0;
-  u32 block_size = apif->rx_req->tp_block_size;
-  u32 frame_size = apif->rx_req->tp_frame_size;
-  u32 frame_num = apif->rx_req->tp_frame_nr;
-  u8 *block_start = apif->rx_ring + block * block_size;
+  u32 num_pkts = rx_queue->num_rx_pkts;
+  u32 rx_frame_offset = rx_queue->rx_frame_offset;
   uword n_trace = vlib_get_trace_count (vm, node);
   u32 thread_index = vm->thread_index;
   u32 n_buffer_bytes = vlib_buffer_get_default_data_size (vm);
-  u32 min_bufs = apif->rx_req->tp_frame_size / n_buffer_bytes;
+  u32 n_left_to_next = 0;
+  block_desc_t *bd;
 
   n_free_bufs = vec_len (apm->rx_buffers[thread_index]);
   if (PREDICT_FALSE (n_free_bufs < VLIB_FRAME_SIZE))
@@ -225,23 +232,35 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
       _vec_len (apm->rx_buffers[thread_index]) = n_free_bufs;
     }
 
-  rx_frame = apif->next_rx_frame;
-  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
-  while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs))
+  vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+
+  /* walk the blocks handed over by the kernel, resuming where the previous
+   * call stopped when it ran out of buffers or frame space mid-block */
+  bd = (block_desc_t *) (rx_queue->rx_ring + block * block_size);
+  while ((bd->hdr.bh1.block_status & TP_STATUS_USER) && n_left_to_next)
     {
-      vlib_buffer_t *b0 = 0, *first_b0 = 0;
-      u32 next0 = next_index;
+      if (num_pkts == 0)
+	{
+	  num_pkts = bd->hdr.bh1.num_pkts;
+	  rx_frame_offset = bd->hdr.bh1.offset_to_first_pkt;
+	}
 
-      u32 n_left_to_next;
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-      while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs) &&
-	     n_left_to_next)
+      while (num_pkts && n_left_to_next)
 	{
-	  u32 data_len = tph->tp_snaplen;
-	  u32 offset = 0;
+	  vlib_buffer_t *b0 = 0, *first_b0 = 0;
+	  u32 next0 = next_index;
+	  u32 data_len, offset = 0;
 	  u32 bi0 = 0, first_bi0 = 0, prev_bi0;
 	  u8 l4_hdr_sz = 0;
 
+	  tph = (tpacket3_hdr_t *) ((u8 *) bd + rx_frame_offset);
+	  data_len = tph->tp_snaplen;
+
+	  /* the whole packet must fit in the free buffers */
+	  if (PREDICT_FALSE ((data_len + n_buffer_bytes - 1) / n_buffer_bytes >
+			     n_free_bufs))
+	    goto done;
+
 	  while (data_len)
 	    {
 	      /* grab free buffer */
@@ -271,7 +290,7 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      ethernet_vlan_header_t *vlan =
 			(ethernet_vlan_header_t *) (eth + 1);
 		      vlan->priority_cfi_and_id =
-			clib_host_to_net_u16 (tph->tp_vlan_tci);
+			clib_host_to_net_u16 (tph->hv1.tp_vlan_tci);
 		      vlan->type = eth->type;
 		      eth->type = clib_host_to_net_u16 (ETHERNET_TYPE_VLAN);
 		      vlan_len = sizeof (ethernet_vlan_header_t);
@@ -341,7 +360,10 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      tr = vlib_add_trace (vm, node, first_b0, sizeof (*tr));
 	      tr->next_index = next0;
 	      tr->hw_if_index = apif->hw_if_index;
-	      clib_memcpy_fast (&tr->tph, tph, sizeof (struct tpacket2_hdr));
+	      tr->queue_id = queue_id;
+	      tr->block = block;
+	      tr->pkt_num = bd->hdr.bh1.num_pkts - num_pkts;
+	      clib_memcpy_fast (&tr->tph, tph, sizeof (tpacket3_hdr_t));
 	    }
 
 	  /* enque and take next packet */
@@ -349,15 +371,31 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 					   n_left_to_next, first_bi0, next0);
 
 	  /* next packet */
-	  tph->tp_status = TP_STATUS_KERNEL;
-	  rx_frame = (rx_frame + 1) % frame_num;
-	  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
+	  num_pkts--;
+	  rx_frame_offset += tph->tp_next_offset;
 	}
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      if (num_pkts)
+	break;
+
+      /* the whole block was consumed, hand it back to the kernel */
+      bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+      block = (block + 1) % block_nr;
+      bd = (block_desc_t *) (rx_queue->rx_ring + block * block_size);
     }
 
-  apif->next_rx_frame = rx_frame;
+done:
+  vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+
+  rx_queue->next_rx_block = block;
+  rx_queue->num_rx_pkts = num_pkts;
+  rx_queue->rx_frame_offset = rx_frame_offset;
+
+  /* with edge triggered events, the kernel will not signal blocks which are
+   * already filled, so come back for them */
+  if (bd->hdr.bh1.block_status & TP_STATUS_USER)
+    vnet_hw_if_rx_queue_set_int_pending (vnet_get_main (),
+					 rx_queue->rx_queue_index);
 
   vlib_increment_combined_counter
     (vnet_get_main ()->interface_main.combined_sw_if_counters
@@ -381,7 +419,8 @@ VLIB_NODE_FN (af_packet_input_node) (vlib_main_t * vm,
       af_packet_if_t *apif;
       apif = vec_elt_at_index (apm->interfaces, pv[i].dev_instance);
       if (apif->is_admin_up)
-	n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif);
+	n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif,
+						   pv[i].queue_id);
     }
 
   return n_rx_packets;
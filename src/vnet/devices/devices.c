@@ -120,6 +120,26 @@ vnet_device_init (vlib_main_t * vm)
       vdm->next_worker_thread_index = tr->first_index;
       vdm->last_worker_thread_index = tr->first_index + tr->count - 1;
     }
+
+  if (tm->placement_auto && tr && tr->count > 0 && !tm->use_pthreads &&
+      !tr->use_pthreads)
+    {
+      u32 thread_index = tr->first_index;
+      uword c;
+      int numa;
+
+      /* workers are started in the order of their cpus */
+      clib_bitmap_foreach (c, tr->coremask)
+	{
+	  if ((numa = vlib_cpu_get_numa (c)) >= 0)
+	    {
+	      vec_validate (vdm->workers_by_numa, numa);
+	      vec_validate (vdm->next_worker_by_numa, numa);
+	      vec_add1 (vdm->workers_by_numa[numa], thread_index);
+	    }
+	  thread_index++;
+	}
+    }
   return 0;
 }
 
@@ -63,6 +63,11 @@ typedef struct
   uword first_worker_thread_index;
   uword last_worker_thread_index;
   uword next_worker_thread_index;
+
+  /* With automatic placement, RX queues go round robin over the workers
+     of the NUMA node of their interface */
+  u32 **workers_by_numa;
+  u32 *next_worker_by_numa;
 } vnet_device_main_t;
 
 extern vnet_device_main_t vnet_device_main;
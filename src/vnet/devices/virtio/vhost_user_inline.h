@@ -407,6 +407,33 @@ vhost_user_packed_desc_available (vhost_user_vring_t * vring, u16 idx)
 	   vring->avail_wrap_counter));
 }
 
+/*
+ * Return 1 if the 4 descriptors starting at idx, which must not cross the
+ * end of the ring, are available and are neither chained nor indirect,
+ * i.e. each holds a whole packet.
+ */
+static_always_inline int
+vhost_user_packed_desc_available_x4 (vhost_user_vring_t *vring, u16 idx)
+{
+  vring_packed_desc_t *d = vring->packed_desc + idx;
+  u16 mask = VRING_DESC_F_AVAIL | VRING_DESC_F_NEXT | VRING_DESC_F_INDIRECT;
+  u16 avail = vring->avail_wrap_counter;
+
+#ifdef CLIB_HAVE_VEC256
+  /* flags are the upper 16 bits of the second quadword of a descriptor */
+  u64x4 m = { 0, (u64) mask << 48, 0, (u64) mask << 48 };
+  u64x4 a = { 0, (u64) avail << 48, 0, (u64) avail << 48 };
+  u64x4 d01 = u64x4_load_unaligned (d);
+  u64x4 d23 = u64x4_load_unaligned (d + 2);
+
+  return u64x4_is_all_zero (((d01 & m) ^ a) | ((d23 & m) ^ a));
+#else
+  return (((d[0].flags & mask) ^ avail) | ((d[1].flags & mask) ^ avail) |
+	  ((d[2].flags & mask) ^ avail) | ((d[3].flags & mask) ^ avail)) ==
+	 0;
+#endif
+}
+
 static_always_inline void
 vhost_user_advance_last_avail_idx (vhost_user_vring_t * vring)
 {
@@ -418,6 +445,19 @@ vhost_user_advance_last_avail_idx (vhost_user_vring_t * vring)
     }
 }
 
+static_always_inline void
+vhost_user_advance_last_avail_idx_n (vhost_user_vring_t *vring, u16 n)
+{
+  u32 idx = vring->last_avail_idx + n;
+
+  if (PREDICT_FALSE (idx > vring->qsz_mask))
+    {
+      vring->avail_wrap_counter ^= VRING_DESC_F_AVAIL;
+      idx -= vring->qsz_mask + 1;
+    }
+  vring->last_avail_idx = idx;
+}
+
 static_always_inline void
 vhost_user_advance_last_avail_table_idx (vhost_user_intf_t * vui,
 					 vhost_user_vring_t * vring,
@@ -482,6 +522,19 @@ vhost_user_advance_last_used_idx (vhost_user_vring_t * vring)
     }
 }
 
+static_always_inline void
+vhost_user_advance_last_used_idx_n (vhost_user_vring_t *vring, u16 n)
+{
+  u32 idx = vring->last_used_idx + n;
+
+  if (PREDICT_FALSE (idx > vring->qsz_mask))
+    {
+      vring->used_wrap_counter ^= 1;
+      idx -= vring->qsz_mask + 1;
+    }
+  vring->last_used_idx = idx;
+}
+
 #endif
 
 /*
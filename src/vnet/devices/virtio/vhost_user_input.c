@@ -31,6 +31,7 @@
 #include <linux/if_tun.h>
 
 #include <vlib/vlib.h>
+#include <vlib/copy.h>
 #include <vlib/unix/unix.h>
 
 #include <vnet/ethernet/ethernet.h>
@@ -183,6 +184,56 @@ vhost_user_input_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
   return 0;
 }
 
+static_always_inline u32
+vhost_user_input_copy_async (vhost_user_intf_t *vui, vhost_copy_t *cpy,
+			     u16 copy_len, u32 *map_hint,
+			     vlib_copy_batch_t *cb)
+{
+  void *src;
+
+  while (copy_len)
+    {
+      if (PREDICT_FALSE (!(src = map_guest_mem (vui, cpy->src, map_hint))))
+	return 1;
+      vlib_copy_batch_add (cb, (void *) cpy->dst, src, cpy->len);
+      copy_len -= 1;
+      cpy += 1;
+    }
+  return 0;
+}
+
+static_always_inline void
+vhost_user_input_give_back (vlib_main_t *vm, vhost_user_main_t *vum,
+			    vhost_user_intf_t *vui, vhost_user_vring_t *txvq,
+			    u16 n_rx_packets)
+{
+  /* give buffers back to driver */
+  CLIB_MEMORY_STORE_BARRIER ();
+  txvq->used->idx = txvq->last_used_idx;
+  vhost_user_log_dirty_ring (vui, txvq, idx);
+
+  /* interrupt (call) handling */
+  if ((txvq->callfd_idx != ~0) &&
+      !(txvq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
+    {
+      txvq->n_since_last_int += n_rx_packets;
+
+      if (txvq->n_since_last_int > vum->coalesce_frames)
+	vhost_user_send_call (vm, vui, txvq);
+    }
+}
+
+static void
+vhost_user_input_copy_done (vlib_main_t *vm, vlib_copy_batch_t *b)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  vhost_user_intf_t *vui =
+    pool_elt_at_index (vum->vhost_user_interfaces, b->cookie[0]);
+  vhost_user_vring_t *txvq = &vui->vrings[VHOST_VRING_IDX_TX (b->cookie[1])];
+
+  vhost_user_input_give_back (vm, vum, vui, txvq, b->cookie[2]);
+}
+
 /**
  * Try to discard packets from the tx ring (VPP RX path).
  * Returns the number of discarded packets.
@@ -400,6 +451,7 @@ vhost_user_if_input (vlib_main_t *vm, vhost_user_main_t *vum,
   u8 feature_arc_idx = fm->device_input_feature_arc_index;
   u32 current_config_index = ~(u32) 0;
   u16 mask = txvq->qsz_mask;
+  vlib_copy_batch_t *cb = 0;
 
   /* The descriptor table is not ready yet */
   if (PREDICT_FALSE (txvq->avail == 0))
@@ -467,6 +519,14 @@ vhost_user_if_input (vlib_main_t *vm, vhost_user_main_t *vum,
   if (n_left > VLIB_FRAME_SIZE)
     n_left = VLIB_FRAME_SIZE;
 
+  /*
+   * With async copies, the copies are only collected here and run while we
+   * process the other queues. Descriptors are given back to the driver
+   * once they complete, before the node returns.
+   */
+  if (vlib_copy_is_async ())
+    cb = vlib_copy_batch_get (vm, vhost_user_input_copy_done);
+
   /*
    * For small packets (<2kB), we will not need more than one vlib buffer
    * per packet. In case packets are bigger, we will just yield at some point
@@ -708,6 +768,16 @@ vhost_user_if_input (vlib_main_t *vm, vhost_user_main_t *vum,
        */
       if (PREDICT_FALSE (copy_len >= VHOST_USER_RX_COPY_THRESHOLD))
 	{
+	  if (cb)
+	    {
+	      if (PREDICT_FALSE (vhost_user_input_copy_async (
+		    vui, cpu->copy, copy_len, &map_hint, cb)))
+		vlib_error_count (vm, node->node_index,
+				  VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+	      copy_len = 0;
+	      continue;
+	    }
+
 	  if (PREDICT_FALSE (vhost_user_input_copy (vui, cpu->copy,
 						    copy_len, &map_hint)))
 	    {
@@ -728,27 +798,28 @@ stop:
   txvq->last_used_idx = last_used_idx;
   txvq->last_avail_idx = last_avail_idx;
 
-  /* Do the memory copies */
-  if (PREDICT_FALSE (vhost_user_input_copy (vui, cpu->copy, copy_len,
-					    &map_hint)))
+  if (cb)
     {
-      vlib_error_count (vm, node->node_index,
-			VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+      if (PREDICT_FALSE (vhost_user_input_copy_async (vui, cpu->copy,
+						      copy_len, &map_hint, cb)))
+	vlib_error_count (vm, node->node_index,
+			  VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+      cb->cookie[0] = vui - vum->vhost_user_interfaces;
+      cb->cookie[1] = qid;
+      cb->cookie[2] = n_rx_packets;
+      vlib_copy_batch_submit (vm, cb);
     }
-
-  /* give buffers back to driver */
-  CLIB_MEMORY_STORE_BARRIER ();
-  txvq->used->idx = txvq->last_used_idx;
-  vhost_user_log_dirty_ring (vui, txvq, idx);
-
-  /* interrupt (call) handling */
-  if ((txvq->callfd_idx != ~0) &&
-      !(txvq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
+  else
     {
-      txvq->n_since_last_int += n_rx_packets;
+      /* Do the memory copies */
+      if (PREDICT_FALSE (vhost_user_input_copy (vui, cpu->copy, copy_len,
+						&map_hint)))
+	{
+	  vlib_error_count (vm, node->node_index,
+			    VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+	}
 
-      if (txvq->n_since_last_int > vum->coalesce_frames)
-	vhost_user_send_call (vm, vui, txvq);
+      vhost_user_input_give_back (vm, vum, vui, txvq, n_rx_packets);
     }
 
   /* increase rx counters */
@@ -769,19 +840,33 @@ vhost_user_mark_desc_consumed (vhost_user_intf_t * vui,
 			       u16 n_descs_processed)
 {
   vring_packed_desc_t *desc_table = txvq->packed_desc;
-  u16 desc_idx;
+  u16 flags_mask = VRING_DESC_F_AVAIL | VRING_DESC_F_USED;
   u16 mask = txvq->qsz_mask;
+  u16 used, desc_idx, i;
 
-  for (desc_idx = 0; desc_idx < n_descs_processed; desc_idx++)
+  if (PREDICT_FALSE (n_descs_processed == 0))
+    return;
+
+  used = txvq->used_wrap_counter ? flags_mask : 0;
+  for (i = 1; i < n_descs_processed; i++)
     {
-      if (txvq->used_wrap_counter)
-	desc_table[(desc_head + desc_idx) & mask].flags |=
-	  (VRING_DESC_F_AVAIL | VRING_DESC_F_USED);
-      else
-	desc_table[(desc_head + desc_idx) & mask].flags &=
-	  ~(VRING_DESC_F_AVAIL | VRING_DESC_F_USED);
-      vhost_user_advance_last_used_idx (txvq);
+      desc_idx = (desc_head + i) & mask;
+      if (PREDICT_FALSE (desc_idx == 0))
+	used ^= flags_mask;
+      desc_table[desc_idx].flags =
+	(desc_table[desc_idx].flags & ~flags_mask) | used;
     }
+
+  /*
+   * The driver polls the descriptors in order, so release the head last
+   * to hand the whole batch back at once.
+   */
+  used = txvq->used_wrap_counter ? flags_mask : 0;
+  CLIB_MEMORY_STORE_BARRIER ();
+  desc_table[desc_head].flags =
+    (desc_table[desc_head].flags & ~flags_mask) | used;
+
+  vhost_user_advance_last_used_idx_n (txvq, n_descs_processed);
 }
 
 static_always_inline void
@@ -956,6 +1041,46 @@ vhost_user_do_offload (vhost_user_intf_t * vui,
   return rc;
 }
 
+static_always_inline int
+vhost_user_do_offload_x4 (vhost_user_intf_t *vui,
+			  vring_packed_desc_t *desc_table, u16 desc_current,
+			  u16 mask, vlib_buffer_t **b, u32 *map_hint)
+{
+  u32 rv;
+
+  rv = vhost_user_do_offload (vui, desc_table, desc_current, mask, b[0],
+			      map_hint);
+  rv |= vhost_user_do_offload (vui, desc_table, desc_current + 1, mask, b[1],
+			       map_hint);
+  rv |= vhost_user_do_offload (vui, desc_table, desc_current + 2, mask, b[2],
+			       map_hint);
+  rv |= vhost_user_do_offload (vui, desc_table, desc_current + 3, mask, b[3],
+			       map_hint);
+
+  /* on error, the packets are processed one by one to be accounted for */
+  return rv == VHOST_USER_INPUT_FUNC_ERROR_NO_ERROR;
+}
+
+/*
+ * Return 1 if each of the 4 descriptors at d holds a whole packet which
+ * fits in a single buffer.
+ */
+static_always_inline int
+vhost_user_packed_desc_fit_x4 (vring_packed_desc_t *d, u32 hdr_sz,
+			       u32 buffer_data_size)
+{
+  u16 flags = d[0].flags | d[1].flags | d[2].flags | d[3].flags;
+
+  if (flags & (VRING_DESC_F_NEXT | VRING_DESC_F_INDIRECT))
+    return 0;
+
+  /* hdr_sz < len <= hdr_sz + buffer_data_size */
+  return ((d[0].len - hdr_sz - 1 < buffer_data_size) &
+	  (d[1].len - hdr_sz - 1 < buffer_data_size) &
+	  (d[2].len - hdr_sz - 1 < buffer_data_size) &
+	  (d[3].len - hdr_sz - 1 < buffer_data_size));
+}
+
 static_always_inline u32
 vhost_user_compute_buffers_required (u32 desc_len, u32 buffer_data_size)
 {
@@ -982,6 +1107,16 @@ vhost_user_compute_buffers_required (u32 desc_len, u32 buffer_data_size)
   return (buffers_required);
 }
 
+static_always_inline u32
+vhost_user_compute_simple_desc_len (vhost_user_intf_t *vui,
+				    u32 buffer_data_size, u32 desc_len)
+{
+  if (PREDICT_TRUE (desc_len > vui->virtio_net_hdr_sz))
+    desc_len -= vui->virtio_net_hdr_sz;
+
+  return vhost_user_compute_buffers_required (desc_len, buffer_data_size);
+}
+
 static_always_inline u32
 vhost_user_compute_indirect_desc_len (vhost_user_intf_t * vui,
 				      vhost_user_vring_t * txvq,
@@ -1176,7 +1311,23 @@ vhost_user_if_input_packed (vlib_main_t *vm, vhost_user_main_t *vum,
   while (vhost_user_packed_desc_available (txvq, current) &&
 	 (n_left < VLIB_FRAME_SIZE))
     {
-      if (desc_table[current].flags & VRING_DESC_F_INDIRECT)
+      /* the common case, 4 packets in a descriptor each */
+      if (n_left + 4 <= VLIB_FRAME_SIZE && current + 4 <= mask + 1 &&
+	  vhost_user_packed_desc_available_x4 (txvq, current))
+	{
+	  buffers_required += vhost_user_compute_simple_desc_len (
+	    vui, buffer_data_size, desc_table[current].len);
+	  buffers_required += vhost_user_compute_simple_desc_len (
+	    vui, buffer_data_size, desc_table[current + 1].len);
+	  buffers_required += vhost_user_compute_simple_desc_len (
+	    vui, buffer_data_size, desc_table[current + 2].len);
+	  buffers_required += vhost_user_compute_simple_desc_len (
+	    vui, buffer_data_size, desc_table[current + 3].len);
+	  n_left += 4;
+	  current = (current + 4) & mask;
+	  vhost_user_advance_last_avail_idx_n (txvq, 4);
+	}
+      else if (desc_table[current].flags & VRING_DESC_F_INDIRECT)
 	{
 	  buffers_required +=
 	    vhost_user_compute_indirect_desc_len (vui, txvq, buffer_data_size,
@@ -1225,9 +1376,58 @@ vhost_user_if_input_packed (vlib_main_t *vm, vhost_user_main_t *vum,
       u32 bi_current;
       u32 desc_data_offset;
       u16 desc_idx = desc_current;
-      u32 n_descs;
+      u32 n_descs, i;
 
       desc_table = txvq->packed_desc;
+
+      if (n_left >= 4 && desc_current + 4 <= mask + 1 &&
+	  vhost_user_packed_desc_fit_x4 (desc_table + desc_current,
+					 vui->virtio_net_hdr_sz,
+					 buffer_data_size) &&
+	  (!enable_csum ||
+	   vhost_user_do_offload_x4 (vui, desc_table, desc_current, mask, b,
+				     &map_hint)))
+	{
+	  /* 4 packets each fitting in a single buffer, no chaining */
+	  for (i = 0; i < 4; i++)
+	    {
+	      vring_packed_desc_t *d = desc_table + desc_current + i;
+	      u32 len = d->len - vui->virtio_net_hdr_sz;
+	      vhost_copy_t *cpy = &cpu->copy[copy_len++];
+
+	      b_head = b[i];
+	      to_next[i] = next[i];
+	      b_head->current_length = len;
+	      b_head->total_length_not_including_first_buffer = 0;
+	      b_head->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+
+	      cpy->len = len;
+	      cpy->dst = (uword) vlib_buffer_get_current (b_head);
+	      cpy->src = d->addr + vui->virtio_net_hdr_sz;
+
+	      vnet_buffer (b_head)->sw_if_index[VLIB_RX] = vui->sw_if_index;
+	      vnet_buffer (b_head)->sw_if_index[VLIB_TX] = ~0;
+	      b_head->error = 0;
+
+	      if (current_config_index != ~0)
+		{
+		  b_head->current_config_index = current_config_index;
+		  vnet_buffer (b_head)->feature_arc_index = feature_arc_idx;
+		}
+	      n_rx_bytes += len;
+	    }
+
+	  to_next += 4;
+	  next += 4;
+	  b += 4;
+	  buffers_used += 4;
+	  ASSERT (buffers_used <= buffers_required);
+	  n_left_to_next -= 4;
+	  n_rx_packets += 4;
+	  n_descs_to_process = 4;
+	  goto out;
+	}
+
       to_next[0] = bi_current = next[0];
       b_head = b_current = b[0];
       b++;
@@ -1443,6 +1643,9 @@ VLIB_NODE_FN (vhost_user_input_node) (vlib_main_t * vm,
 	}
     }
 
+  if (vlib_copy_is_async ())
+    vlib_copy_wait_all (vm);
+
   return n_rx_packets;
 }
 
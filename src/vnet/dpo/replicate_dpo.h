@@ -34,8 +34,9 @@ typedef struct replicate_main_t_
 {
     vlib_combined_counter_main_t repm_counters;
 
-    /* per-cpu vector of cloned packets */
+    /* per-cpu vector of cloned packets and their next node */
     u32 **clones;
+    u16 **nexts;
 } replicate_main_t;
 
 extern replicate_main_t replicate_main;
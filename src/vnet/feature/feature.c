@@ -180,6 +180,13 @@ vnet_feature_init (vlib_main_t * vm)
 	{
 	  hash_set_mem (fm->next_feature_by_name[arc_index],
 			freg->node_name, pointer_to_uword (freg));
+	  if (freg->fused_function)
+	    {
+	      vec_validate (vcm->fused_fn_by_feature_index,
+			    freg->feature_index);
+	      vcm->fused_fn_by_feature_index[freg->feature_index] =
+		freg->fused_function;
+	    }
 	  freg = freg->next_in_arc;
 	}
 
@@ -403,6 +410,35 @@ vnet_feature_modify_end_node (u8 arc_index,
   return ci;
 }
 
+/**
+ * Turn feature fusion on or off on an arc, and rebuild the feature
+ * configs of the interfaces accordingly.
+ */
+int
+vnet_feature_arc_fuse (u8 arc_index, int enable)
+{
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_config_main_t *cm;
+  u32 sw_if_index, ci;
+
+  if (arc_index >= vec_len (fm->feature_config_mains))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  cm = &fm->feature_config_mains[arc_index];
+  cm->config_main.fused_node_index =
+    enable ? vnet_feature_fused_node.index : ~0;
+
+  vec_foreach_index (sw_if_index, cm->config_index_by_sw_if_index)
+    {
+      ci = cm->config_index_by_sw_if_index[sw_if_index];
+      if (ci != ~0)
+	cm->config_index_by_sw_if_index[sw_if_index] =
+	  vnet_config_rebuild (vlib_get_main (), &cm->config_main, ci);
+    }
+
+  return 0;
+}
+
 static int
 feature_cmp (void *a1, void *a2)
 {
@@ -434,11 +470,15 @@ show_features_command_fn (vlib_main_t * vm,
   areg = fm->next_arc;
   while (areg)
     {
+      vnet_config_main_t *vcm =
+	&fm->feature_config_mains[areg->feature_arc_index].config_main;
+      char *fused = vcm->fused_node_index != ~0 ? " (fused)" : "";
+
       if (verbose)
-	vlib_cli_output (vm, "[%2d] %s:", areg->feature_arc_index,
-			 areg->arc_name);
+	vlib_cli_output (vm, "[%2d] %s:%s", areg->feature_arc_index,
+			 areg->arc_name, fused);
       else
-	vlib_cli_output (vm, "%s:", areg->arc_name);
+	vlib_cli_output (vm, "%s:%s", areg->arc_name, fused);
 
       freg = fm->next_feature_by_arc[areg->feature_arc_index];
       while (freg)
@@ -452,8 +492,9 @@ show_features_command_fn (vlib_main_t * vm,
       vec_foreach (freg, feature_regs)
       {
 	if (verbose)
-	  vlib_cli_output (vm, "  [%2d]: %s\n", freg->feature_index,
-			   freg->node_name);
+	  vlib_cli_output (vm, "  [%2d]: %s%s\n", freg->feature_index,
+			   freg->node_name,
+			   freg->fused_function ? " (fusable)" : "");
 	else
 	  vlib_cli_output (vm, "  %s\n", freg->node_name);
       }
@@ -697,6 +738,59 @@ vnet_feature_add_del_sw_interface (vnet_main_t * vnm, u32 sw_if_index,
 VNET_SW_INTERFACE_ADD_DEL_FUNCTION_PRIO (vnet_feature_add_del_sw_interface,
 					 VNET_ITF_FUNC_PRIORITY_HIGH);
 
+static clib_error_t *
+set_feature_arc_fusion_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  u8 *arc_name = 0, arc_index;
+  int enable = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "disable"))
+	enable = 0;
+      else if (!arc_name && unformat (input, "%s", &arc_name))
+	;
+      else
+	return unformat_parse_error (input);
+    }
+
+  if (!arc_name)
+    return clib_error_return (0, "arc name required");
+
+  vec_add1 (arc_name, 0);
+  arc_index = vnet_get_feature_arc_index ((const char *) arc_name);
+  if (arc_index == (u8) ~0)
+    {
+      clib_error_t *error =
+	clib_error_return (0, "Unknown arc name (%s)...", arc_name);
+      vec_free (arc_name);
+      return error;
+    }
+
+  vnet_feature_arc_fuse (arc_index, enable);
+  vec_free (arc_name);
+  return 0;
+}
+
+/*?
+ * Fuse the features of an arc: consecutive fusable features enabled on an
+ * interface (see 'show features verbose') are run one after the other by
+ * the feature-fused node, instead of each being a node visit with its own
+ * frame. Meant for interfaces whose set of features is stable.
+ *
+ * @cliexpar
+ * @cliexcmd{set feature-arc fusion device-input}
+ * @cliexcmd{set feature-arc fusion device-input disable}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_feature_arc_fusion_command, static) = {
+  .path = "set feature-arc fusion",
+  .short_help = "set feature-arc fusion <arc_name> [disable]",
+  .function = set_feature_arc_fusion_command_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -60,6 +60,12 @@ typedef struct _vnet_feature_registration
 
   /** Function to enable/disable feature  **/
   vnet_feature_enable_disable_function_t *enable_disable_cb;
+
+  /** Optional, the feature work without the dispatch to the next feature.
+      On an arc with fusion on, consecutive fused features are run one
+      after the other by the feature-fused node. Only for features which
+      always continue to the next feature and take no feature config. */
+  vnet_config_fused_fn_t *fused_function;
 } vnet_feature_registration_t;
 
 /** constraint registration object */
@@ -118,6 +124,8 @@ typedef struct
 
 extern vnet_feature_main_t feature_main;
 
+extern vlib_node_registration_t vnet_feature_fused_node;
+
 #ifndef CLIB_MARCH_VARIANT
 #define VNET_FEATURE_ARC_INIT(x,...)				\
   __VA_ARGS__ vnet_feature_arc_registration_t vnet_feat_arc_##x;\
@@ -222,6 +230,8 @@ vnet_feature_enable_disable (const char *arc_name, const char *node_name,
 u32
 vnet_feature_modify_end_node (u8 arc_index, u32 sw_if_index, u32 node_index);
 
+int vnet_feature_arc_fuse (u8 arc_index, int enable);
+
 static_always_inline u32
 vnet_get_feature_count (u8 arc, u32 sw_if_index)
 {
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Fused features.
+ *
+ * On an arc with fusion on, a run of consecutive fusable features in a
+ * feature config is replaced by a single visit to this node. The config
+ * data of the node is the index of the run in the fused sequences of the
+ * arc; the node runs the fused functions of the sequence on the buffers,
+ * then sends them to the feature following the run. The features of a run
+ * cost one frame and one config string step instead of one each.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+
+typedef struct
+{
+  u8 arc_index;
+  u32 sequence_index;
+  u32 next_index;
+} vnet_feature_fused_trace_t;
+
+static u8 *
+format_vnet_feature_fused_trace (u8 *s, va_list *args)
+{
+  vlib_main_t *vm = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  vnet_feature_fused_trace_t *t = va_arg (*args, vnet_feature_fused_trace_t *);
+  vnet_config_main_t *cm;
+  u32 *fi;
+
+  cm = &vnet_feature_get_config_main (t->arc_index)->config_main;
+  s = format (s, "fused sequence %u, next %u:", t->sequence_index,
+	      t->next_index);
+  vec_foreach (fi, cm->fused_sequences[t->sequence_index])
+    s = format (s, " %U", format_vlib_node_name, vm,
+		cm->node_index_by_feature_index[fi[0]]);
+  return s;
+}
+
+VLIB_NODE_FN (vnet_feature_fused_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u64 keys[VLIB_FRAME_SIZE];
+  u16 nexts[VLIB_FRAME_SIZE];
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_buffers = frame->n_vectors;
+  vnet_config_main_t *cm;
+  u32 i, n, next, *fi;
+  u8 arc;
+
+  vlib_get_buffers (vm, from, bufs, n_buffers);
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      arc = vnet_buffer (b[i])->feature_arc_index;
+      cm = &vnet_feature_get_config_main (arc)->config_main;
+      keys[i] = (u64) arc << 32 |
+		*(u32 *) vnet_get_config_data (cm, &b[i]->current_config_index,
+					       &next, sizeof (u32));
+      nexts[i] = next;
+    }
+
+  /* the buffers of a frame usually share their config, run the fused
+   * functions on each run of buffers of the same sequence */
+  for (i = 0; i < n_buffers; i += n)
+    {
+      for (n = 1; i + n < n_buffers && keys[i + n] == keys[i]; n++)
+	;
+
+      cm = &vnet_feature_get_config_main (keys[i] >> 32)->config_main;
+      vec_foreach (fi, cm->fused_sequences[(u32) keys[i]])
+	cm->fused_fn_by_feature_index[fi[0]](vm, node, b + i, n);
+    }
+
+  if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
+    for (i = 0; i < n_buffers; i++)
+      if (b[i]->flags & VLIB_BUFFER_IS_TRACED)
+	{
+	  vnet_feature_fused_trace_t *t =
+	    vlib_add_trace (vm, node, b[i], sizeof (*t));
+	  t->arc_index = keys[i] >> 32;
+	  t->sequence_index = (u32) keys[i];
+	  t->next_index = nexts[i];
+	}
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, n_buffers);
+  return n_buffers;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (vnet_feature_fused_node) = {
+  .name = "feature-fused",
+  .vector_size = sizeof (u32),
+  .format_trace = format_vnet_feature_fused_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
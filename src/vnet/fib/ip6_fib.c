@@ -273,10 +273,9 @@ compute_prefix_lengths_in_search_order (ip6_fib_table_instance_t *table)
     table->prefix_lengths_in_search_order = prefix_lengths_in_search_order;
 
     /*
-     * let the workers go once round the track before we free the old set
+     * free the old set once the workers have been round the track
      */
-    vlib_worker_wait_one_loop();
-    vec_free(old);
+    vlib_worker_vec_free_after_quiescence(old);
 }
 
 void
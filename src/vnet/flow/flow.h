@@ -42,7 +42,8 @@
   _(IP4_VXLAN, ip4_vxlan, "ipv4-vxlan") \
   _(IP6_VXLAN, ip6_vxlan, "ipv6-vxlan") \
   _(IP4_GTPC, ip4_gtpc, "ipv4-gtpc") \
-  _(IP4_GTPU, ip4_gtpu, "ipv4-gtpu")
+  _(IP4_GTPU, ip4_gtpu, "ipv4-gtpu") \
+  _(IP4_GENEVE, ip4_geneve, "ipv4-geneve")
 
 #define foreach_flow_entry_ethernet \
   _fe(ethernet_header_t, eth_hdr)
@@ -103,6 +104,10 @@
   foreach_flow_entry_ip4_n_tuple \
   _fe(u32, teid)
 
+#define foreach_flow_entry_ip4_geneve \
+  foreach_flow_entry_ip4_n_tuple \
+  _fe(u32, vni)
+
 #define foreach_flow_action \
   _(0, COUNT, "count") \
   _(1, MARK, "mark") \
@@ -269,6 +274,23 @@ int vnet_flow_disable (vnet_main_t * vnm, u32 flow_index, u32 hw_if_index);
 int vnet_flow_del (vnet_main_t * vnm, u32 flow_index);
 vnet_flow_t *vnet_get_flow (u32 flow_index);
 
+/**
+ * Tunnel decaps reserve a range of flow ids with vnet_flow_get_range(),
+ * one per tunnel, and offload flows marking the packets of a tunnel with
+ * its id. The decap node then gets the tunnel from the mark rather than
+ * looking it up.
+ * @return the index of the flow id in the range [start, start + count),
+ *         or ~0 if the buffer is not marked by a flow of the range.
+ */
+static_always_inline u32
+vnet_flow_mark_to_index (u32 flow_id, u32 start, u32 count)
+{
+  u32 index = flow_id - start;
+
+  /* unmarked buffers have flow id 0, below any range */
+  return index < count ? index : ~0;
+}
+
 typedef struct
 {
   u32 start;
@@ -367,6 +367,7 @@ test_flow (vlib_main_t * vm, unformat_input_t * input,
   bool gtpc_set = false;
   bool gtpu_set = false;
   bool vni_set = false;
+  bool geneve_set = false;
   bool l2tpv3oip_set = false;
   bool ipsec_esp_set = false, ipsec_ah_set = false;
   u8 *rss_type[3] = { };
@@ -421,6 +422,8 @@ test_flow (vlib_main_t * vm, unformat_input_t * input,
 	gtpu_set = true;
       else if (unformat (line_input, "vxlan vni %u", &vni))
 	vni_set = true;
+      else if (unformat (line_input, "geneve vni %u", &vni))
+	geneve_set = true;
       else if (unformat (line_input, "session id %u", &session_id))
 	{
 	  if (protocol.prot == IP_PROTOCOL_L2TP)
@@ -552,6 +555,11 @@ test_flow (vlib_main_t * vm, unformat_input_t * input,
 	      type = VNET_FLOW_TYPE_IP4_VXLAN;
 	      protocol.prot = IP_PROTOCOL_UDP;
 	    }
+	  else if (geneve_set)
+	    {
+	      type = VNET_FLOW_TYPE_IP4_GENEVE;
+	      protocol.prot = IP_PROTOCOL_UDP;
+	    }
 	  else if (l2tpv3oip_set)
 	    type = VNET_FLOW_TYPE_IP4_L2TPV3OIP;
 	  else if (ipsec_esp_set)
@@ -613,6 +621,8 @@ test_flow (vlib_main_t * vm, unformat_input_t * input,
 		flow.ip4_gtpu.teid = teid;
 	      else if (type == VNET_FLOW_TYPE_IP4_VXLAN)
 		flow.ip4_vxlan.vni = vni;
+	      else if (type == VNET_FLOW_TYPE_IP4_GENEVE)
+		flow.ip4_geneve.vni = vni;
 	      break;
 	    case IP_PROTOCOL_L2TP:
 	      flow.ip4_l2tpv3oip.session_id = session_id;
@@ -696,6 +706,7 @@ VLIB_CLI_COMMAND (test_flow_command, static) = {
         "[src-port <port/mask>] [dst-port <port/mask>] "
         "[proto <ip-proto>] "
         "[gtpc teid <teid>] [gtpu teid <teid>] [vxlan <vni>] "
+        "[geneve vni <vni>] "
         "[session id <session>] [spi <spi>]"
         "[next-node <node>] [mark <id>] [buffer-advance <len>] "
         "[redirect-to-queue <queue>] [drop] "
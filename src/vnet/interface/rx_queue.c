@@ -27,7 +27,8 @@ VLIB_REGISTER_LOG_CLASS (if_rxq_log, static) = {
 #define log_err(fmt, ...)   vlib_log_err (if_rxq_log.class, fmt, __VA_ARGS__)
 
 static u32
-next_thread_index (vnet_main_t *vnm, u32 thread_index)
+next_thread_index (vnet_main_t *vnm, vnet_hw_interface_t *hi,
+		   u32 thread_index)
 {
   vnet_device_main_t *vdm = &vnet_device_main;
   if (vdm->first_worker_thread_index == 0)
@@ -36,6 +37,17 @@ next_thread_index (vnet_main_t *vnm, u32 thread_index)
   if (thread_index != 0 && (thread_index < vdm->first_worker_thread_index ||
 			    thread_index > vdm->last_worker_thread_index))
     {
+      if (hi->numa_node < vec_len (vdm->workers_by_numa) &&
+	  vec_len (vdm->workers_by_numa[hi->numa_node]))
+	{
+	  u32 *workers = vdm->workers_by_numa[hi->numa_node];
+	  u32 *next = vdm->next_worker_by_numa + hi->numa_node;
+
+	  thread_index = workers[next[0]];
+	  next[0] = (next[0] + 1) % vec_len (workers);
+	  return thread_index;
+	}
+
       thread_index = vdm->next_worker_thread_index++;
       if (vdm->next_worker_thread_index > vdm->last_worker_thread_index)
 	vdm->next_worker_thread_index = vdm->first_worker_thread_index;
@@ -75,7 +87,7 @@ vnet_hw_if_register_rx_queue (vnet_main_t *vnm, u32 hw_if_index, u32 queue_id,
 		"interface %v\n",
 		queue_id, hi->name);
 
-  thread_index = next_thread_index (vnm, thread_index);
+  thread_index = next_thread_index (vnm, hi, thread_index);
 
   pool_get_zero (im->hw_if_rx_queues, rxq);
   queue_index = rxq - im->hw_if_rx_queues;
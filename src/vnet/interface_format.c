@@ -705,6 +705,10 @@ format_vnet_buffer_opaque2 (u8 * s, va_list * args)
   s = format (s, "pg_replay_timestamp: %llu", (u32) (o->pg_replay_timestamp));
   vec_add1 (s, '\n');
 
+  s = format (s, "latency_rx_time: %llu, latency_rx_sw_if_index: %d",
+	      o->latency_rx_time, o->latency_rx_sw_if_index);
+  vec_add1 (s, '\n');
+
   for (i = 0; i < vec_len (im->buffer_opaque2_format_helpers); i++)
     {
       helper_fp = im->buffer_opaque2_format_helpers[i];
@@ -438,6 +438,9 @@ int vnet_sw_interface_update_unnumbered (u32 sw_if_index, u32 ip_sw_if_index,
 
 int vnet_sw_interface_stats_collect_enable_disable (u32 sw_if_index,
 						    u8 enable);
+int vnet_sw_interface_latency_sample_enable_disable (u32 sw_if_index,
+						     u8 enable);
+void vnet_latency_sample_set_interval (u32 interval);
 void vnet_sw_interface_ip_directed_broadcast (vnet_main_t * vnm,
 					      u32 sw_if_index, u8 enable);
 
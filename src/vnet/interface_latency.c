@@ -0,0 +1,502 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Per-packet latency sampling.
+ *
+ * One packet in every 'interval' received on a sampling interface is
+ * stamped with the time it entered the graph and its rx interface. When a
+ * stamped packet leaves through a sampling interface, the time it spent in
+ * the graph is added to the latency histogram of its (rx, tx) interface
+ * pair, published in the stats segment as /if/latency/<rx>/<tx>, in
+ * nanoseconds. Interfaces not sampling see no cost at all, and the
+ * sampling ones pay for a flag test per transmitted packet.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+#include <vppinfra/bihash_8_8.h>
+
+/* ~68s, anything slower lands in the last bucket */
+#define LATENCY_SAMPLE_MAX_NS (1ULL << 36)
+#define LATENCY_SAMPLE_DEFAULT_INTERVAL 1024
+
+typedef struct
+{
+  vlib_histogram_main_t hist;
+  u32 rx_sw_if_index;
+  u32 tx_sw_if_index;
+} latency_sample_pair_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /* packets to skip before stamping the next one */
+  u32 countdown;
+} latency_sample_per_thread_t;
+
+typedef struct
+{
+  latency_sample_per_thread_t *per_thread_data;
+  u32 interval;
+
+  /* pair by rx sw_if_index << 32 | tx sw_if_index. Pairs are allocated one
+   * by one so workers can hold on to them while the main thread adds more.
+   */
+  clib_bihash_8_8_t pair_by_key;
+  latency_sample_pair_t **pairs;
+} latency_sample_main_t;
+
+extern latency_sample_main_t latency_sample_main;
+
+void latency_sample_pair_add (u64 *key);
+
+#ifndef CLIB_MARCH_VARIANT
+latency_sample_main_t latency_sample_main;
+#endif /* CLIB_MARCH_VARIANT */
+
+static_always_inline void
+latency_sample_rx_buffers (vlib_main_t *vm, vlib_buffer_t **b, u32 n_buffers)
+{
+  latency_sample_main_t *lm = &latency_sample_main;
+  latency_sample_per_thread_t *ptd =
+    vec_elt_at_index (lm->per_thread_data, vm->thread_index);
+  u32 i;
+
+  /* the dispatch time of this node is close enough to the rx time */
+  for (i = ptd->countdown; i < n_buffers; i += lm->interval)
+    {
+      b[i]->flags |= VNET_BUFFER_F_LATENCY_SAMPLE;
+      vnet_buffer2 (b[i])->latency_rx_time = vm->cpu_time_last_node_dispatch;
+      vnet_buffer2 (b[i])->latency_rx_sw_if_index =
+	vnet_buffer (b[i])->sw_if_index[VLIB_RX];
+    }
+  ptd->countdown = i - n_buffers;
+}
+
+static_always_inline void
+latency_sample_tx_buffers (vlib_main_t *vm, vlib_buffer_t **b, u32 n_left)
+{
+  latency_sample_main_t *lm = &latency_sample_main;
+  latency_sample_pair_t *pair = 0;
+  clib_bihash_kv_8_8_t kv;
+  u64 now = 0, key = ~0ULL;
+  f64 ns;
+
+  while (n_left)
+    {
+      if (PREDICT_FALSE (b[0]->flags & VNET_BUFFER_F_LATENCY_SAMPLE))
+	{
+	  b[0]->flags &= ~VNET_BUFFER_F_LATENCY_SAMPLE;
+	  if (now == 0)
+	    now = clib_cpu_time_now ();
+
+	  kv.key = (u64) vnet_buffer2 (b[0])->latency_rx_sw_if_index << 32 |
+		   vnet_buffer (b[0])->sw_if_index[VLIB_TX];
+	  if (kv.key != key)
+	    {
+	      key = kv.key;
+	      if (clib_bihash_search_inline_8_8 (&lm->pair_by_key, &kv))
+		{
+		  /* the first samples of a pair create it and are lost */
+		  vlib_rpc_call_main_thread (latency_sample_pair_add,
+					     (u8 *) &key, sizeof (key));
+		  key = ~0ULL;
+		  pair = 0;
+		}
+	      else
+		pair = uword_to_pointer (kv.value, latency_sample_pair_t *);
+	    }
+
+	  if (pair)
+	    {
+	      ns = 0;
+	      if (now > vnet_buffer2 (b[0])->latency_rx_time)
+		ns = (now - vnet_buffer2 (b[0])->latency_rx_time) *
+		     vm->clib_time.seconds_per_clock * 1e9;
+	      vlib_histogram_add (&pair->hist, vm->thread_index, 0, ns);
+	    }
+	}
+
+      b += 1;
+      n_left -= 1;
+    }
+}
+
+static_always_inline uword
+latency_sample_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+		       vlib_frame_t *frame, vlib_rx_or_tx_t rxtx)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_left = frame->n_vectors;
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  if (VLIB_RX == rxtx)
+    latency_sample_rx_buffers (vm, b, n_left);
+  else
+    latency_sample_tx_buffers (vm, b, n_left);
+
+  while (n_left)
+    {
+      vnet_feature_next_u16 (next, b[0]);
+      b += 1;
+      next += 1;
+      n_left -= 1;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+  return frame->n_vectors;
+}
+
+VLIB_NODE_FN (latency_sample_rx_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  return latency_sample_inline (vm, node, frame, VLIB_RX);
+}
+
+VLIB_NODE_FN (latency_sample_tx_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  return latency_sample_inline (vm, node, frame, VLIB_TX);
+}
+
+static void
+latency_sample_rx_fused (vlib_main_t *vm, vlib_node_runtime_t *node,
+			 vlib_buffer_t **b, u32 n_buffers)
+{
+  latency_sample_rx_buffers (vm, b, n_buffers);
+}
+
+static void
+latency_sample_tx_fused (vlib_main_t *vm, vlib_node_runtime_t *node,
+			 vlib_buffer_t **b, u32 n_buffers)
+{
+  latency_sample_tx_buffers (vm, b, n_buffers);
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (latency_sample_rx_node) = {
+  .name = "latency-sample-rx",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+};
+
+VLIB_REGISTER_NODE (latency_sample_tx_node) = {
+  .name = "latency-sample-tx",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+};
+
+VNET_FEATURE_INIT (latency_sample_rx_node, static) = {
+  .arc_name = "device-input",
+  .node_name = "latency-sample-rx",
+  .runs_before = VNET_FEATURES ("ethernet-input"),
+  .fused_function = latency_sample_rx_fused,
+};
+
+VNET_FEATURE_INIT (latency_sample_tx_node, static) = {
+  .arc_name = "interface-output",
+  .node_name = "latency-sample-tx",
+  .runs_before = VNET_FEATURES ("interface-output-arc-end"),
+  .fused_function = latency_sample_tx_fused,
+};
+/* *INDENT-ON* */
+
+#ifndef CLIB_MARCH_VARIANT
+/* the stats directory uses '/' as separator, mangle it the way the
+ * /interfaces symlinks do */
+static u8 *
+format_latency_sample_if_name (u8 *s, va_list *args)
+{
+  vnet_main_t *vnm = va_arg (*args, vnet_main_t *);
+  u32 sw_if_index = va_arg (*args, u32);
+  u32 i = vec_len (s);
+
+  s = format (s, "%U", format_vnet_sw_if_index_name, vnm, sw_if_index);
+  for (; i < vec_len (s); i++)
+    if (s[i] == '/')
+      s[i] = '_';
+  return s;
+}
+
+void
+latency_sample_pair_add (u64 *key)
+{
+  latency_sample_main_t *lm = &latency_sample_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  latency_sample_pair_t *pair;
+  clib_bihash_kv_8_8_t kv;
+  u32 rx_sw_if_index, tx_sw_if_index;
+
+  kv.key = *key;
+  /* several samples may have asked for the same pair */
+  if (!clib_bihash_search_8_8 (&lm->pair_by_key, &kv, &kv))
+    return;
+
+  /* an interface may have gone while the sample was in flight */
+  rx_sw_if_index = kv.key >> 32;
+  tx_sw_if_index = (u32) kv.key;
+  if (!vnet_sw_interface_is_valid (vnm, rx_sw_if_index) ||
+      !vnet_sw_interface_is_valid (vnm, tx_sw_if_index))
+    return;
+
+  pair = clib_mem_alloc (sizeof (*pair));
+  clib_memset (pair, 0, sizeof (*pair));
+  pair->rx_sw_if_index = rx_sw_if_index;
+  pair->tx_sw_if_index = tx_sw_if_index;
+  pair->hist.stat_segment_name = (char *) format (
+    0, "/if/latency/%U/%U%c", format_latency_sample_if_name, vnm,
+    rx_sw_if_index, format_latency_sample_if_name, vnm, tx_sw_if_index, 0);
+  pair->hist.n_buckets = vlib_histogram_n_buckets (LATENCY_SAMPLE_MAX_NS);
+  vlib_validate_histogram (&pair->hist, 0);
+
+  kv.value = pointer_to_uword (pair);
+  clib_bihash_add_del_8_8 (&lm->pair_by_key, &kv, 1 /* is_add */);
+  vec_add1 (lm->pairs, pair);
+}
+
+static clib_error_t *
+latency_sample_sw_interface_add_del (vnet_main_t *vnm, u32 sw_if_index,
+				     u32 is_add)
+{
+  latency_sample_main_t *lm = &latency_sample_main;
+  latency_sample_pair_t *pair;
+  clib_bihash_kv_8_8_t kv;
+  int i;
+
+  if (is_add)
+    return 0;
+
+  /* the workers are stopped, no one holds a pair */
+  vec_foreach_index_backwards (i, lm->pairs)
+    {
+      pair = lm->pairs[i];
+      if (pair->rx_sw_if_index != sw_if_index &&
+	  pair->tx_sw_if_index != sw_if_index)
+	continue;
+
+      kv.key = (u64) pair->rx_sw_if_index << 32 | pair->tx_sw_if_index;
+      clib_bihash_add_del_8_8 (&lm->pair_by_key, &kv, 0 /* is_add */);
+      vlib_free_histogram (&pair->hist);
+      vec_free (pair->hist.stat_segment_name);
+      clib_mem_free (pair);
+      vec_del1 (lm->pairs, i);
+    }
+
+  return 0;
+}
+
+VNET_SW_INTERFACE_ADD_DEL_FUNCTION (latency_sample_sw_interface_add_del);
+
+int
+vnet_sw_interface_latency_sample_enable_disable (u32 sw_if_index, u8 enable)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+
+  if (!vnet_sw_interface_is_valid (vnm, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  vnet_feature_enable_disable ("device-input", "latency-sample-rx",
+			       sw_if_index, enable, 0, 0);
+  vnet_feature_enable_disable ("interface-output", "latency-sample-tx",
+			       sw_if_index, enable, 0, 0);
+  return 0;
+}
+
+void
+vnet_latency_sample_set_interval (u32 interval)
+{
+  latency_sample_main_t *lm = &latency_sample_main;
+  latency_sample_per_thread_t *ptd;
+
+  lm->interval = clib_max (interval, 1);
+  vec_foreach (ptd, lm->per_thread_data)
+    ptd->countdown = 0;
+}
+
+static clib_error_t *
+set_interface_latency_sampling_command_fn (vlib_main_t *vm,
+					   unformat_input_t *input,
+					   vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, interval = 0;
+  clib_error_t *error = 0;
+  u8 enable = 1;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "expected interface name");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "interval %u", &interval))
+	;
+      else if (unformat (line_input, "disable"))
+	enable = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0)
+    {
+      error = clib_error_return (0, "expected interface name");
+      goto done;
+    }
+
+  if (interval)
+    vnet_latency_sample_set_interval (interval);
+
+  rv = vnet_sw_interface_latency_sample_enable_disable (sw_if_index, enable);
+  if (rv)
+    error = clib_error_return (0, "failed with error %d", rv);
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Sample the time packets spend in the graph between their rx and tx
+ * interfaces. One packet in every <interval> received on the interface is
+ * sampled, 1024 by default; the interval is shared by all the sampling
+ * interfaces. Samples are only taken between two sampling interfaces.
+ * The latency histograms of the interface pairs are in the stats segment
+ * as /if/latency/<rx>/<tx>, in nanoseconds.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface latency-sampling GigabitEthernet2/0/0 interval 64}
+ * @cliexcmd{set interface latency-sampling GigabitEthernet2/0/0 disable}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_interface_latency_sampling_command, static) = {
+  .path = "set interface latency-sampling",
+  .short_help = "set interface latency-sampling <interface> "
+		"[interval <n>] [disable]",
+  .function = set_interface_latency_sampling_command_fn,
+};
+/* *INDENT-ON* */
+
+static u64
+latency_sample_percentile (counter_t *buckets, u64 total, u32 p)
+{
+  u64 sum = 0, target = (total * p + 99) / 100;
+  u32 i;
+
+  for (i = 0; i < vec_len (buckets) - 1; i++)
+    {
+      sum += buckets[i];
+      if (sum >= target)
+	break;
+    }
+  return vlib_histogram_bucket_min (i);
+}
+
+static clib_error_t *
+show_interface_latency_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  latency_sample_main_t *lm = &latency_sample_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  latency_sample_pair_t **pairp, *pair;
+  counter_t *buckets = 0;
+  u64 total;
+  int i, j;
+
+  vlib_cli_output (vm, "sampling 1 packet in %u", lm->interval);
+  if (vec_len (lm->pairs) == 0)
+    return 0;
+
+  vlib_cli_output (vm, "%-24s %-24s %12s %10s %10s %10s %10s", "rx", "tx",
+		   "samples", "p50 ns", "p90 ns", "p99 ns", "max ns");
+
+  vec_foreach (pairp, lm->pairs)
+    {
+      pair = pairp[0];
+      vec_validate_init_empty (buckets, pair->hist.n_buckets - 1, 0);
+      clib_memset (buckets, 0, vec_len (buckets) * sizeof (buckets[0]));
+      total = 0;
+      for (i = 0; i < vec_len (pair->hist.counters); i++)
+	for (j = 0; j < vec_len (pair->hist.counters[i][0]); j++)
+	  {
+	    buckets[j] += pair->hist.counters[i][0][j];
+	    total += pair->hist.counters[i][0][j];
+	  }
+
+      if (total == 0)
+	continue;
+
+      vlib_cli_output (
+	vm, "%-24U %-24U %12llu %10llu %10llu %10llu %10llu",
+	format_vnet_sw_if_index_name, vnm, pair->rx_sw_if_index,
+	format_vnet_sw_if_index_name, vnm, pair->tx_sw_if_index, total,
+	latency_sample_percentile (buckets, total, 50),
+	latency_sample_percentile (buckets, total, 90),
+	latency_sample_percentile (buckets, total, 99),
+	latency_sample_percentile (buckets, total, 100));
+    }
+
+  vec_free (buckets);
+  return 0;
+}
+
+/*?
+ * Show the latency sampled between interface pairs, see
+ * 'set interface latency-sampling'. Latencies are the lower bound of
+ * their histogram bucket.
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_interface_latency_command, static) = {
+  .path = "show interface latency",
+  .short_help = "show interface latency",
+  .function = show_interface_latency_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+latency_sample_init (vlib_main_t *vm)
+{
+  latency_sample_main_t *lm = &latency_sample_main;
+
+  vec_validate_aligned (lm->per_thread_data, vlib_num_workers (),
+			CLIB_CACHE_LINE_BYTES);
+  lm->interval = LATENCY_SAMPLE_DEFAULT_INTERVAL;
+  clib_bihash_init_8_8 (&lm->pair_by_key, "latency sample pairs", 64,
+			64 << 10);
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (latency_sample_init);
+#endif /* CLIB_MARCH_VARIANT */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -66,93 +66,96 @@ format_stats_collect_trace (u8 * s, va_list * args)
   return s;
 }
 
-#define inc_counter(ctype, rx_tx)                               \
-{                                                               \
+static_always_inline void
+stats_collect_flush (u32 thread_index, u32 sw_if_index, u32 *n_packets,
+		     u64 *n_bytes, vlib_rx_or_tx_t rxtx)
+{
+  vnet_interface_counter_type_t ct;
+
+  if (VLIB_RX == rxtx)
+    {
+      foreach_rx_combined_interface_counter (ct)
+      {
+	vlib_increment_combined_counter
+	  (vnet_main.interface_main.combined_sw_if_counters + ct,
+	   thread_index, sw_if_index, n_packets[ct], n_bytes[ct]);
+      }
+    }
+  else
+    {
+      foreach_tx_combined_interface_counter (ct)
+      {
+	vlib_increment_combined_counter
+	  (vnet_main.interface_main.combined_sw_if_counters + ct,
+	   thread_index, sw_if_index, n_packets[ct], n_bytes[ct]);
+      }
+    }
+
+  clib_memset (n_packets, 0, VNET_N_COMBINED_INTERFACE_COUNTER *
+	       sizeof (n_packets[0]));
+  clib_memset (n_bytes, 0, VNET_N_COMBINED_INTERFACE_COUNTER *
+	       sizeof (n_bytes[0]));
 }
 
-static_always_inline uword
-stats_collect_inline (vlib_main_t * vm,
-		      vlib_node_runtime_t * node,
-		      vlib_frame_t * frame, vlib_rx_or_tx_t rxtx)
+static_always_inline void
+stats_collect_buffers (vlib_main_t *vm, vlib_buffer_t **b, u32 n_left,
+		       vlib_rx_or_tx_t rxtx)
 {
-  vnet_interface_counter_type_t ct;
-  u32 n_left_from, *from, *to_next;
-  u32 next_index;
-  u32 sw_if_index = 0;
   u32 stats_n_packets[VNET_N_COMBINED_INTERFACE_COUNTER] = { 0 };
   u64 stats_n_bytes[VNET_N_COMBINED_INTERFACE_COUNTER] = { 0 };
+  u32 sw_if_index, last_sw_if_index = ~0;
+  int b0_ctype;
 
-  from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
-
-  while (n_left_from > 0)
+  while (n_left > 0)
     {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      sw_if_index = vnet_buffer (b[0])->sw_if_index[rxtx];
+      if (sw_if_index != last_sw_if_index)
 	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
-	  u32 next0 = 0;
-	  int b0_ctype;
-
-	  /* speculatively enqueue b0 to the current next frame */
-	  to_next[0] = bi0 = from[0];
-	  to_next += 1;
-	  n_left_to_next -= 1;
-	  from += 1;
-	  n_left_from -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  sw_if_index = vnet_buffer (b0)->sw_if_index[rxtx];
-
-	  if (VLIB_RX == rxtx)
-	    {
-	      b0_ctype =
-		eh_dst_addr_to_rx_ctype (vlib_buffer_get_current (b0));
-	    }
-	  else
-	    {
-	      b0_ctype =
-		eh_dst_addr_to_tx_ctype (vlib_buffer_get_current (b0));
-	    }
-
-	  stats_n_bytes[b0_ctype] += vlib_buffer_length_in_chain (vm, b0);
-	  stats_n_packets[b0_ctype] += 1;
-
-	  vnet_feature_next (&next0, b0);
-
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
-					   n_left_to_next, bi0, next0);
+	  if (last_sw_if_index != ~0)
+	    stats_collect_flush (vm->thread_index, last_sw_if_index,
+				 stats_n_packets, stats_n_bytes, rxtx);
+	  last_sw_if_index = sw_if_index;
 	}
 
       if (VLIB_RX == rxtx)
-	{
-	  foreach_rx_combined_interface_counter (ct)
-	  {
-	    vlib_increment_combined_counter
-	      (vnet_main.interface_main.combined_sw_if_counters + ct,
-	       vlib_get_thread_index (),
-	       sw_if_index, stats_n_packets[ct], stats_n_bytes[ct]);
-	  }
-	}
+	b0_ctype = eh_dst_addr_to_rx_ctype (vlib_buffer_get_current (b[0]));
       else
-	{
-	  foreach_tx_combined_interface_counter (ct)
-	  {
-	    vlib_increment_combined_counter
-	      (vnet_main.interface_main.combined_sw_if_counters + ct,
-	       vlib_get_thread_index (),
-	       sw_if_index, stats_n_packets[ct], stats_n_bytes[ct]);
-	  }
-	}
+	b0_ctype = eh_dst_addr_to_tx_ctype (vlib_buffer_get_current (b[0]));
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      stats_n_bytes[b0_ctype] += vlib_buffer_length_in_chain (vm, b[0]);
+      stats_n_packets[b0_ctype] += 1;
+
+      b += 1;
+      n_left -= 1;
     }
 
+  if (last_sw_if_index != ~0)
+    stats_collect_flush (vm->thread_index, last_sw_if_index, stats_n_packets,
+			 stats_n_bytes, rxtx);
+}
+
+static_always_inline uword
+stats_collect_inline (vlib_main_t * vm,
+		      vlib_node_runtime_t * node,
+		      vlib_frame_t * frame, vlib_rx_or_tx_t rxtx)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_left = frame->n_vectors;
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+  stats_collect_buffers (vm, b, n_left, rxtx);
+
+  while (n_left > 0)
+    {
+      vnet_feature_next_u16 (next, b[0]);
+      b += 1;
+      next += 1;
+      n_left -= 1;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
   return frame->n_vectors;
 }
 
@@ -170,6 +173,20 @@ VLIB_NODE_FN (stats_collect_tx_node) (vlib_main_t * vm,
   return stats_collect_inline (vm, node, frame, VLIB_TX);
 }
 
+static void
+stats_collect_rx_fused (vlib_main_t *vm, vlib_node_runtime_t *node,
+			vlib_buffer_t **b, u32 n_buffers)
+{
+  stats_collect_buffers (vm, b, n_buffers, VLIB_RX);
+}
+
+static void
+stats_collect_tx_fused (vlib_main_t *vm, vlib_node_runtime_t *node,
+			vlib_buffer_t **b, u32 n_buffers)
+{
+  stats_collect_buffers (vm, b, n_buffers, VLIB_TX);
+}
+
 /* *INDENT-OFF* */
 VLIB_REGISTER_NODE (stats_collect_rx_node) = {
   .vector_size = sizeof (u32),
@@ -193,12 +210,14 @@ VNET_FEATURE_INIT (stats_collect_rx_node, static) = {
   .arc_name = "device-input",
   .node_name = "stats-collect-rx",
   .runs_before = VNET_FEATURES ("ethernet-input"),
+  .fused_function = stats_collect_rx_fused,
 };
 
 VNET_FEATURE_INIT (stats_collect_tx_node, static) = {
   .arc_name = "interface-output",
   .node_name = "stats-collect-tx",
   .runs_before = VNET_FEATURES ("interface-output-arc-end"),
+  .fused_function = stats_collect_tx_fused,
 };
 
 /* *INDENT-ON* */
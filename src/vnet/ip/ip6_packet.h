@@ -557,7 +557,7 @@ vlib_object_within_buffer_data (vlib_main_t * vm, vlib_buffer_t * b,
 {
   u8 *o = obj;
   if (o < b->data ||
-      o + len > b->data + vlib_buffer_get_default_data_size (vm))
+      o + len > b->data + vlib_buffer_get_data_size (vm, b))
     return 0;
   return 1;
 }
@@ -83,10 +83,197 @@ frag_buffer_alloc (vlib_buffer_t * org_b, u32 * bi)
 }
 
 /*
- * Limitation: Does follow buffer chains in the packet to fragment,
- * but does not generate buffer chains. I.e. a fragment is always
- * contained with in a single buffer and limited to the max buffer
- * size.
+ * Chained packets are fragmented without copying most of the payload:
+ * the buffers following the first one are moved to the fragments,
+ * trimmed to the part of the payload each fragment carries, and chained
+ * to a fresh buffer holding the fragment headers. Where a buffer
+ * straddles two fragments the smaller side is copied. The first buffer,
+ * which holds the original headers, is copied and left to the caller,
+ * unchained, to free.
+ */
+typedef struct
+{
+  vlib_buffer_t *b;
+  u8 *data;
+  u16 ptr;
+  u16 left;
+  u8 can_move;
+  u8 is_moved;
+  u8 has_next;
+  u32 next_bi;
+} frag_chain_src_t;
+
+static int
+frag_chain_is_possible (vlib_main_t * vm, vlib_buffer_t * b)
+{
+  if (!(b->flags & VLIB_BUFFER_NEXT_PRESENT))
+    return 0;
+
+  /* buffers shared with clones can't be trimmed */
+  while (1)
+    {
+      if (b->ref_count != 1)
+	return 0;
+      if (!(b->flags & VLIB_BUFFER_NEXT_PRESENT))
+	return 1;
+      b = vlib_get_buffer (vm, b->next_buffer);
+    }
+}
+
+static void
+frag_chain_src_init (frag_chain_src_t * src, vlib_buffer_t * first_b,
+		     u16 hdr_len)
+{
+  src->b = first_b;
+  src->data = vlib_buffer_get_current (first_b) + hdr_len;
+  src->ptr = 0;
+  src->left = first_b->current_length - hdr_len;
+  src->can_move = 0;
+  src->is_moved = 1;
+  src->has_next = 1;
+  src->next_bi = first_b->next_buffer;
+}
+
+/*
+ * Upper bound of the buffers needed for n_frags fragments. A fragment
+ * copies at most two runs of payload: the tail of a buffer moved to the
+ * previous fragment, after the headers, and the head of a buffer
+ * straddling the next fragment, in a buffer of its own. Each run may
+ * overflow into more buffers when the fragment is larger than a buffer.
+ */
+static int
+frag_chain_alloc (vlib_main_t * vm, u16 rem, u16 max, u16 hdr_len,
+		  u32 ** spare)
+{
+  u32 data_size = vlib_buffer_get_default_data_size (vm);
+  u32 n_frags, n_per_frag, n;
+
+  if (max == 0)
+    return -1;
+
+  n_frags = (rem + max - 1) / max;
+  n_per_frag = 1 + (hdr_len + max + data_size - 1) / data_size;
+  vec_validate (*spare, n_frags * n_per_frag - 1);
+  n = vlib_buffer_alloc (vm, *spare, n_frags * n_per_frag);
+  if (n != n_frags * n_per_frag)
+    {
+      vlib_buffer_free (vm, *spare, n);
+      vec_free (*spare);
+      return -1;
+    }
+  return 0;
+}
+
+/*
+ * Append len bytes of payload from src to to_b, which holds the fragment
+ * headers.
+ */
+static void
+frag_chain_payload (vlib_main_t * vm, vlib_buffer_t * to_b,
+		    frag_chain_src_t * src, u16 len, u32 ** spare)
+{
+  vlib_buffer_t *last = to_b;
+  u8 can_copy_to_last = 1;
+  u16 n;
+
+  to_b->total_length_not_including_first_buffer = 0;
+  to_b->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+
+  while (len)
+    {
+      if (src->left == 0)
+	{
+	  /* empty buffers in the middle of the chain are not moved */
+	  if (!src->is_moved)
+	    {
+	      src->b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+	      vlib_buffer_free_one (vm, vlib_get_buffer_index (vm, src->b));
+	    }
+
+	  /* the malformed case is ruled out by the caller */
+	  src->b = vlib_get_buffer (vm, src->next_bi);
+	  src->data = vlib_buffer_get_current (src->b);
+	  src->ptr = 0;
+	  src->left = src->b->current_length;
+	  src->can_move = 1;
+	  src->is_moved = 0;
+	  src->has_next = !!(src->b->flags & VLIB_BUFFER_NEXT_PRESENT);
+	  src->next_bi = src->b->next_buffer;
+	  continue;
+	}
+
+      n = clib_min (len, src->left);
+      if (src->can_move && (n == src->left || n > src->left - n))
+	{
+	  vlib_buffer_t *b = src->b;
+
+	  /* what is left past n, if any, is copied to the next fragment */
+	  b->current_data += src->ptr;
+	  b->current_length = n;
+	  b->flags &= ~VLIB_BUFFER_IS_TRACED;
+	  src->can_move = 0;
+	  src->is_moved = 1;
+
+	  last->next_buffer = vlib_get_buffer_index (vm, b);
+	  last->flags |= VLIB_BUFFER_NEXT_PRESENT;
+	  last = b;
+	  can_copy_to_last = 0;
+	}
+      else
+	{
+	  if (!can_copy_to_last ||
+	      vlib_buffer_space_left_at_end (vm, last) == 0)
+	    {
+	      u32 bi = vec_pop (*spare);
+	      vlib_buffer_t *b = vlib_get_buffer (vm, bi);
+
+	      b->current_length = 0;
+	      last->next_buffer = bi;
+	      last->flags |= VLIB_BUFFER_NEXT_PRESENT;
+	      last = b;
+	      can_copy_to_last = 1;
+	    }
+	  /* the rest goes to the next buffer */
+	  n = clib_min (n, vlib_buffer_space_left_at_end (vm, last));
+	  clib_memcpy_fast (vlib_buffer_get_tail (last), src->data + src->ptr,
+			    n);
+	  last->current_length += n;
+	}
+
+      if (last != to_b)
+	to_b->total_length_not_including_first_buffer += n;
+      src->ptr += n;
+      src->left -= n;
+      len -= n;
+    }
+
+  last->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+}
+
+/*
+ * Free what the fragments did not take from the original chain, i.e. the
+ * padding past the end of the ip packet, and unchain the first buffer.
+ */
+static void
+frag_chain_done (vlib_main_t * vm, vlib_buffer_t * first_b,
+		 frag_chain_src_t * src, u32 ** spare)
+{
+  if (!src->is_moved)
+    {
+      src->b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+      vlib_buffer_free_one (vm, vlib_get_buffer_index (vm, src->b));
+    }
+  if (src->has_next)
+    vlib_buffer_free_one (vm, src->next_bi);
+
+  first_b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+  vlib_buffer_free (vm, *spare, vec_len (*spare));
+  vec_free (*spare);
+}
+
+/*
+ * Unchained packets are copied: a fragment is always contained in a
+ * single buffer and limited to the max buffer size.
  * from_bi: current pointer must point to IPv4 header
  */
 ip_frag_error_t
@@ -145,6 +332,19 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
   u16 left_in_from_buffer =
     from_b->current_length - (l2unfragmentablesize + sizeof (ip4_header_t));
   u16 ptr = 0;
+  frag_chain_src_t src;
+  u32 *spare = 0;
+  int chain = frag_chain_is_possible (vm, from_b);
+
+  if (chain)
+    {
+      if (frag_chain_alloc (vm, rem, max,
+			    l2unfragmentablesize + sizeof (ip4_header_t),
+			    &spare))
+	return IP_FRAG_ERROR_MEMORY;
+      frag_chain_src_init (&src, from_b,
+			   l2unfragmentablesize + sizeof (ip4_header_t));
+    }
 
   /* Do the actual fragmentation */
   while (rem)
@@ -157,7 +357,13 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
       len = (rem > max ? max : rem);
       if (len != rem)		/* Last fragment does not need to divisible by 8 */
 	len &= ~0x7;
-      if ((to_b = frag_buffer_alloc (org_from_b, &to_bi)) == 0)
+      if (chain)
+	{
+	  to_bi = vec_pop (spare);
+	  to_b = vlib_get_buffer (vm, to_bi);
+	  vlib_buffer_copy_trace_flag (vm, org_from_b, to_bi);
+	}
+      else if ((to_b = frag_buffer_alloc (org_from_b, &to_bi)) == 0)
 	{
 	  return IP_FRAG_ERROR_MEMORY;
 	}
@@ -183,6 +389,13 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
 	  to_b->flags |= VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
 	}
 
+      if (chain)
+	{
+	  to_b->current_length = l2unfragmentablesize + sizeof (ip4_header_t);
+	  frag_chain_payload (vm, to_b, &src, len, &spare);
+	  goto ip4_header;
+	}
+
       /* Spin through from buffers filling up the to buffer */
       u16 left_in_to_buffer = len, to_ptr = 0;
       while (1)
@@ -212,10 +425,11 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
 	  to_ptr += bytes_to_copy;
 	}
 
-      to_b->flags |= VNET_BUFFER_F_IS_IP4;
       to_b->current_length =
 	len + sizeof (ip4_header_t) + l2unfragmentablesize;
 
+    ip4_header:
+      to_b->flags |= VNET_BUFFER_F_IS_IP4;
       to_ip4->fragment_id = ip_frag_id;
       to_ip4->flags_and_fragment_offset =
 	clib_host_to_net_u16 ((fo >> 3) + ip_frag_offset);
@@ -231,6 +445,9 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
       fo += len;
     }
 
+  if (chain)
+    frag_chain_done (vm, org_from_b, &src, &spare);
+
   return IP_FRAG_ERROR_NONE;
 }
 
@@ -411,6 +628,19 @@ ip6_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
   u16 left_in_from_buffer =
     from_b->current_length - (l2unfragmentablesize + sizeof (ip6_header_t));
   u16 ptr = 0;
+  frag_chain_src_t src;
+  u32 *spare = 0;
+  int chain = frag_chain_is_possible (vm, from_b);
+
+  if (chain)
+    {
+      if (frag_chain_alloc (vm, rem, max,
+			    sizeof (ip6_header_t) + sizeof (ip6_frag_hdr_t),
+			    &spare))
+	return IP_FRAG_ERROR_MEMORY;
+      frag_chain_src_init (&src, from_b,
+			   l2unfragmentablesize + sizeof (ip6_header_t));
+    }
 
   ip_frag_id = ++running_fragment_id;	// Fix
 
@@ -428,7 +658,13 @@ ip6_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
 	 (mtu - sizeof (ip6_header_t) - sizeof (ip6_frag_hdr_t)) ? max : rem);
       if (len != rem)		/* Last fragment does not need to divisible by 8 */
 	len &= ~0x7;
-      if ((to_b = frag_buffer_alloc (org_from_b, &to_bi)) == 0)
+      if (chain)
+	{
+	  to_bi = vec_pop (spare);
+	  to_b = vlib_get_buffer (vm, to_bi);
+	  vlib_buffer_copy_trace_flag (vm, org_from_b, to_bi);
+	}
+      else if ((to_b = frag_buffer_alloc (org_from_b, &to_bi)) == 0)
 	{
 	  return IP_FRAG_ERROR_MEMORY;
 	}
@@ -455,6 +691,14 @@ ip6_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
 	}
       to_b->flags |= VNET_BUFFER_F_IS_IP6;
 
+      if (chain)
+	{
+	  to_b->current_length =
+	    sizeof (ip6_header_t) + sizeof (ip6_frag_hdr_t);
+	  frag_chain_payload (vm, to_b, &src, len, &spare);
+	  goto ip6_header;
+	}
+
       /* Spin through from buffers filling up the to buffer */
       u16 left_in_to_buffer = len, to_ptr = 0;
       while (1)
@@ -486,6 +730,8 @@ ip6_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
 
       to_b->current_length =
 	len + sizeof (ip6_header_t) + sizeof (ip6_frag_hdr_t);
+
+    ip6_header:
       to_ip6->payload_length =
 	clib_host_to_net_u16 (len + sizeof (ip6_frag_hdr_t));
       to_ip6->protocol = IP_PROTOCOL_IPV6_FRAGMENTATION;
@@ -499,6 +745,9 @@ ip6_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
       fo += len;
     }
 
+  if (chain)
+    frag_chain_done (vm, org_from_b, &src, &spare);
+
   return IP_FRAG_ERROR_NONE;
 }
 
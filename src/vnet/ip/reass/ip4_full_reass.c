@@ -34,6 +34,10 @@
 #define IP4_REASS_MAX_REASSEMBLIES_DEFAULT 1024
 #define IP4_REASS_MAX_REASSEMBLY_LENGTH_DEFAULT 3
 #define IP4_REASS_HT_LOAD_FACTOR (0.75)
+/* payload bytes after the ip header which must be contiguous in the
+ * first buffer of a reassembled packet for the upper layers to parse
+ * their headers, packets with less are compacted */
+#define IP4_REASS_MIN_FIRST_BUFFER_PAYLOAD 128
 
 #define IP4_REASS_DEBUG_BUFFERS 0
 #if IP4_REASS_DEBUG_BUFFERS
@@ -186,6 +190,11 @@ typedef struct
   u32 fq_feature_index;
   u32 fq_custom_index;
 
+  // steer the fragments of a datagram to a worker chosen from its key
+  u8 steering;
+  u32 steering_first_worker_index;
+  u32 steering_n_workers;
+
   // reference count for enabling/disabling feature - per interface
   u32 *feature_use_refcount_per_intf;
 } ip4_full_reass_main_t;
@@ -243,6 +252,7 @@ typedef struct
   u32 fragment_first;
   u32 fragment_last;
   u32 total_data_len;
+  u32 n_buffers;
   bool is_after_handoff;
   ip4_header_t ip4_header;
 } ip4_full_reass_trace_t;
@@ -322,7 +332,8 @@ format_ip4_full_reass_trace (u8 * s, va_list * args)
 		  format_ip4_full_reass_range_trace, &t->trace_range);
       break;
     case FINALIZE:
-      s = format (s, "\n%Ufinalize reassembly", format_white_space, indent);
+      s = format (s, "\n%Ufinalize reassembly, %u buffers", format_white_space,
+		  indent, t->n_buffers);
       break;
     case HANDOFF:
       s =
@@ -382,6 +393,12 @@ ip4_full_reass_add_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
   t->thread_id_to = thread_id_to;
   t->fragment_first = vnb->ip.reass.fragment_first;
   t->fragment_last = vnb->ip.reass.fragment_last;
+  t->n_buffers = 1;
+  while (b->flags & VLIB_BUFFER_NEXT_PRESENT)
+    {
+      b = vlib_get_buffer (vm, b->next_buffer);
+      t->n_buffers++;
+    }
 #if 0
   static u8 *s = NULL;
   s = format (s, "%U", format_ip4_full_reass_trace, NULL, NULL, t);
@@ -708,7 +725,10 @@ ip4_full_reass_finalize (vlib_main_t * vm, vlib_node_runtime_t * node,
   ip->flags_and_fragment_offset = 0;
   ip->length = clib_host_to_net_u16 (first_b->current_length + total_length);
   ip->checksum = ip4_header_checksum (ip);
-  if (!vlib_buffer_chain_linearize (vm, first_b))
+  /* the fragments stay chained unless the first one is too short */
+  if (first_b->current_length <
+	ip4_header_bytes (ip) + IP4_REASS_MIN_FIRST_BUFFER_PAYLOAD &&
+      !vlib_buffer_chain_linearize (vm, first_b))
     {
       return IP4_REASS_RC_NO_BUF;
     }
@@ -1089,6 +1109,14 @@ ip4_full_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
   return rc;
 }
 
+always_inline u32
+ip4_full_reass_steering_thread_index (ip4_full_reass_main_t *rm,
+				      ip4_full_reass_kv_t *kv)
+{
+  u64 hash = clib_xxhash (kv->k.as_u64[0] ^ kv->k.as_u64[1]);
+  return rm->steering_first_worker_index + hash % rm->steering_n_workers;
+}
+
 always_inline uword
 ip4_full_reass_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		       vlib_frame_t * frame, ip4_full_reass_node_type_t type)
@@ -1150,6 +1178,19 @@ ip4_full_reass_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	    (u64) ip0->dst_address.
 	    as_u32 | (u64) ip0->fragment_id << 32 | (u64) ip0->protocol << 48;
 
+	  if (PREDICT_FALSE (rm->steering))
+	    {
+	      /* all the fragments go to the worker owning the context, which
+	       * also sends the reassembled packet out */
+	      u32 ti = ip4_full_reass_steering_thread_index (rm, &kv);
+	      if (ti != vm->thread_index)
+		{
+		  next0 = IP4_FULL_REASS_NEXT_HANDOFF;
+		  vnet_buffer (b0)->ip.reass.owner_thread_index = ti;
+		  goto packet_enqueue;
+		}
+	    }
+
 	  ip4_full_reass_t *reass =
 	    ip4_full_reass_find_or_create (vm, node, rm, rt, &kv,
 					   &do_handoff);
@@ -1453,6 +1494,31 @@ ip4_full_reass_set (u32 timeout_ms, u32 max_reassemblies,
   return 0;
 }
 
+void
+ip4_full_reass_steering_enable_disable (u8 enable_disable)
+{
+  ip4_full_reass_main_t *rm = &ip4_full_reass_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_thread_registration_t *tr = 0;
+  uword *p;
+
+  p = hash_get_mem (tm->thread_registrations_by_name, "workers");
+  if (p)
+    tr = (vlib_thread_registration_t *) p[0];
+
+  if (tr && tr->count)
+    {
+      rm->steering_first_worker_index = tr->first_index;
+      rm->steering_n_workers = tr->count;
+    }
+  else
+    {
+      rm->steering_first_worker_index = 0;
+      rm->steering_n_workers = 1;
+    }
+  rm->steering = enable_disable;
+}
+
 vnet_api_error_t
 ip4_full_reass_get (u32 * timeout_ms, u32 * max_reassemblies,
 		    u32 * max_reassembly_length,
@@ -1691,6 +1757,8 @@ show_ip4_reass (vlib_main_t * vm,
   vlib_cli_output (vm,
 		   "Maximum configured full IP4 reassembly expire walk interval: %lums\n",
 		   (long unsigned) rm->expire_walk_interval_ms);
+  vlib_cli_output (vm, "Fragment steering to workers: %s\n",
+		   rm->steering ? "on" : "off");
   return 0;
 }
 
@@ -1700,6 +1768,26 @@ VLIB_CLI_COMMAND (show_ip4_full_reass_cmd, static) = {
     .function = show_ip4_reass,
 };
 
+static clib_error_t *
+set_ip4_full_reass_steering (vlib_main_t *vm, unformat_input_t *input,
+		    CLIB_UNUSED (vlib_cli_command_t *lmd))
+{
+  if (unformat (input, "on"))
+    ip4_full_reass_steering_enable_disable (1);
+  else if (unformat (input, "off"))
+    ip4_full_reass_steering_enable_disable (0);
+  else
+    return clib_error_return (0, "unknown input `%U'",
+			      format_unformat_error, input);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (set_ip4_full_reass_steering_cmd, static) = {
+    .path = "set ip4-full-reassembly steering",
+    .short_help = "set ip4-full-reassembly steering <on|off>",
+    .function = set_ip4_full_reass_steering,
+};
+
 #ifndef CLIB_MARCH_VARIANT
 vnet_api_error_t
 ip4_full_reass_enable_disable (u32 sw_if_index, u8 enable_disable)
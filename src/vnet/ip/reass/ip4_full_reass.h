@@ -46,6 +46,16 @@ vnet_api_error_t ip4_full_reass_enable_disable (u32 sw_if_index,
 int ip4_full_reass_enable_disable_with_refcnt (u32 sw_if_index,
 					       int is_enable);
 
+/**
+ * @brief steer all the fragments of a datagram to the same worker
+ *
+ * The worker is chosen from a hash of the reassembly key, so fragments
+ * received by different workers meet on the owner of the context without
+ * having to look it up first, and the reassembled packet is sent out by
+ * that worker.
+ */
+void ip4_full_reass_steering_enable_disable (u8 enable_disable);
+
 uword ip4_full_reass_custom_register_next_node (uword node_index);
 #endif /* __included_ip4_full_reass_h__ */
 
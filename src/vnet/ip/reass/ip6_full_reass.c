@@ -32,6 +32,10 @@
 #define IP6_FULL_REASS_MAX_REASSEMBLIES_DEFAULT 1024
 #define IP6_FULL_REASS_MAX_REASSEMBLY_LENGTH_DEFAULT 3
 #define IP6_FULL_REASS_HT_LOAD_FACTOR (0.75)
+/* payload bytes after the ip header(s) which must be contiguous in the
+ * first buffer of a reassembled packet for the upper layers to parse
+ * their headers, packets with less are compacted */
+#define IP6_FULL_REASS_MIN_FIRST_BUFFER_PAYLOAD 128
 
 typedef enum
 {
@@ -164,6 +168,11 @@ typedef struct
   u32 fq_index;
   u32 fq_feature_index;
 
+  // steer the fragments of a datagram to a worker chosen from its key
+  u8 steering;
+  u32 steering_first_worker_index;
+  u32 steering_n_workers;
+
   // reference count for enabling/disabling feature - per interface
   u32 *feature_use_refcount_per_intf;
 } ip6_full_reass_main_t;
@@ -215,6 +224,7 @@ typedef struct
   u32 total_data_len;
   u32 thread_id;
   u32 thread_id_to;
+  u32 n_buffers;
   bool is_after_handoff;
   ip6_header_t ip6_header;
   ip6_frag_hdr_t ip6_frag_header;
@@ -297,7 +307,8 @@ format_ip6_full_reass_trace (u8 * s, va_list * args)
 		  format_white_space, indent);
       break;
     case FINALIZE:
-      s = format (s, "\n%Ufinalize reassembly", format_white_space, indent);
+      s = format (s, "\n%Ufinalize reassembly, %u buffers", format_white_space,
+		  indent, t->n_buffers);
       break;
     case HANDOFF:
       s =
@@ -363,6 +374,12 @@ ip6_full_reass_add_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
   ip6_full_reass_trace_details (vm, bi, &t->trace_range);
   t->fragment_first = vnb->ip.reass.fragment_first;
   t->fragment_last = vnb->ip.reass.fragment_last;
+  t->n_buffers = 1;
+  while (b->flags & VLIB_BUFFER_NEXT_PRESENT)
+    {
+      b = vlib_get_buffer (vm, b->next_buffer);
+      t->n_buffers++;
+    }
 #if 0
   static u8 *s = NULL;
   s = format (s, "%U", format_ip6_full_reass_trace, NULL, NULL, t);
@@ -753,7 +770,10 @@ ip6_full_reass_finalize (vlib_main_t * vm, vlib_node_runtime_t * node,
   ip->payload_length =
     clib_host_to_net_u16 (total_length + first_b->current_length -
 			  sizeof (*ip));
-  if (!vlib_buffer_chain_linearize (vm, first_b))
+  /* the fragments stay chained unless the first one is too short */
+  if (first_b->current_length <
+	ip6_frag_hdr_offset + IP6_FULL_REASS_MIN_FIRST_BUFFER_PAYLOAD &&
+      !vlib_buffer_chain_linearize (vm, first_b))
     {
       rv = IP6_FULL_REASS_RC_NO_BUF;
       goto free_buffers_and_return;
@@ -1046,6 +1066,16 @@ ip6_full_reass_verify_packet_size_lt_64k (vlib_main_t * vm,
   return true;
 }
 
+always_inline u32
+ip6_full_reass_steering_thread_index (ip6_full_reass_main_t *rm,
+				      ip6_full_reass_kv_t *kv)
+{
+  u64 hash = clib_xxhash (kv->k.as_u64[0] ^ kv->k.as_u64[1] ^
+			  kv->k.as_u64[2] ^ kv->k.as_u64[3] ^
+			  kv->k.as_u64[4] ^ kv->k.as_u64[5]);
+  return rm->steering_first_worker_index + hash % rm->steering_n_workers;
+}
+
 always_inline uword
 ip6_full_reassembly_inline (vlib_main_t * vm,
 			    vlib_node_runtime_t * node,
@@ -1123,6 +1153,19 @@ ip6_full_reassembly_inline (vlib_main_t * vm,
 	    (u64) frag_hdr->identification;
 	  kv.k.as_u64[5] = ip0->protocol;
 
+	  if (PREDICT_FALSE (rm->steering))
+	    {
+	      /* all the fragments go to the worker owning the context, which
+	       * also sends the reassembled packet out */
+	      u32 ti = ip6_full_reass_steering_thread_index (rm, &kv);
+	      if (ti != vm->thread_index)
+		{
+		  next0 = IP6_FULL_REASSEMBLY_NEXT_HANDOFF;
+		  vnet_buffer (b0)->ip.reass.owner_thread_index = ti;
+		  goto skip_reass;
+		}
+	    }
+
 	  ip6_full_reass_t *reass =
 	    ip6_full_reass_find_or_create (vm, node, rm, rt, &kv, &icmp_bi,
 					   &do_handoff);
@@ -1403,6 +1446,31 @@ ip6_full_reass_set (u32 timeout_ms, u32 max_reassemblies,
   return 0;
 }
 
+void
+ip6_full_reass_steering_enable_disable (u8 enable_disable)
+{
+  ip6_full_reass_main_t *rm = &ip6_full_reass_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_thread_registration_t *tr = 0;
+  uword *p;
+
+  p = hash_get_mem (tm->thread_registrations_by_name, "workers");
+  if (p)
+    tr = (vlib_thread_registration_t *) p[0];
+
+  if (tr && tr->count)
+    {
+      rm->steering_first_worker_index = tr->first_index;
+      rm->steering_n_workers = tr->count;
+    }
+  else
+    {
+      rm->steering_first_worker_index = 0;
+      rm->steering_n_workers = 1;
+    }
+  rm->steering = enable_disable;
+}
+
 vnet_api_error_t
 ip6_full_reass_get (u32 * timeout_ms, u32 * max_reassemblies,
 		    u32 * max_reassembly_length,
@@ -1673,6 +1741,8 @@ show_ip6_full_reass (vlib_main_t * vm, unformat_input_t * input,
   vlib_cli_output (vm,
 		   "Maximum configured full IP6 reassembly expire walk interval: %lums\n",
 		   (long unsigned) rm->expire_walk_interval_ms);
+  vlib_cli_output (vm, "Fragment steering to workers: %s\n",
+		   rm->steering ? "on" : "off");
   vlib_cli_output (vm, "Buffers in use: %lu\n",
 		   (long unsigned) sum_buffers_n);
   return 0;
@@ -1684,6 +1754,26 @@ VLIB_CLI_COMMAND (show_ip6_full_reassembly_cmd, static) = {
     .function = show_ip6_full_reass,
 };
 
+static clib_error_t *
+set_ip6_full_reass_steering (vlib_main_t *vm, unformat_input_t *input,
+		    CLIB_UNUSED (vlib_cli_command_t *lmd))
+{
+  if (unformat (input, "on"))
+    ip6_full_reass_steering_enable_disable (1);
+  else if (unformat (input, "off"))
+    ip6_full_reass_steering_enable_disable (0);
+  else
+    return clib_error_return (0, "unknown input `%U'",
+			      format_unformat_error, input);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (set_ip6_full_reass_steering_cmd, static) = {
+    .path = "set ip6-full-reassembly steering",
+    .short_help = "set ip6-full-reassembly steering <on|off>",
+    .function = set_ip6_full_reass_steering,
+};
+
 #ifndef CLIB_MARCH_VARIANT
 vnet_api_error_t
 ip6_full_reass_enable_disable (u32 sw_if_index, u8 enable_disable)
@@ -40,6 +40,16 @@ vnet_api_error_t ip6_full_reass_get (u32 * timeout_ms, u32 * max_reassemblies,
 				     u32 * max_reassembly_length,
 				     u32 * expire_walk_interval_ms);
 
+/**
+ * @brief steer all the fragments of a datagram to the same worker
+ *
+ * The worker is chosen from a hash of the reassembly key, so fragments
+ * received by different workers meet on the owner of the context without
+ * having to look it up first, and the reassembled packet is sent out by
+ * that worker.
+ */
+void ip6_full_reass_steering_enable_disable (u8 enable_disable);
+
 vnet_api_error_t ip6_full_reass_enable_disable (u32 sw_if_index,
 						u8 enable_disable);
 
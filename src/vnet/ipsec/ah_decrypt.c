@@ -140,7 +140,6 @@ ah_decrypt_inline (vlib_main_t * vm,
 {
   u32 n_left, *from;
   u32 thread_index = vm->thread_index;
-  u16 buffer_data_size = vlib_buffer_get_default_data_size (vm);
   ah_decrypt_packet_data_t pkt_data[VLIB_FRAME_SIZE], *pd = pkt_data;
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
   u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
@@ -239,7 +238,8 @@ ah_decrypt_inline (vlib_main_t * vm,
 	{
 	  if (PREDICT_FALSE (ipsec_sa_is_set_USE_ESN (sa0) &&
 			     pd->current_data + b[0]->current_length
-			     + sizeof (u32) > buffer_data_size))
+			     + sizeof (u32) >
+			     vlib_buffer_get_data_size (vm, b[0])))
 	    {
 	      b[0]->error = node->errors[AH_DECRYPT_ERROR_NO_TAIL_SPACE];
 	      next[0] = AH_DECRYPT_NEXT_DROP;
@@ -474,6 +474,7 @@ l2fib_add_entry (const u8 * mac, u32 bd_index,
 	    lm->global_learn_count--;
 	  if (bd_config->learn_count)
 	    bd_config->learn_count--;
+	  l2fib_age_scan_count_update (key.raw, bd_index, -1);
 	}
     }
 
@@ -769,6 +770,7 @@ l2fib_del_entry (const u8 * mac, u32 bd_index, u32 sw_if_index)
 	l2learn_main.global_learn_count--;
       if (bd_config->learn_count)
 	bd_config->learn_count--;
+      l2fib_age_scan_count_update (kv.key, bd_index, -1);
     }
 
   /* Remove entry from hash table */
@@ -1080,32 +1082,63 @@ allocate_mac_evt_buf (u32 client, u32 client_index)
   return mp;
 }
 
+/**
+ * Scan n_buckets buckets of the MAC table starting at first_bucket, send
+ * MAC events and, unless event_only, age out MACs.
+ * An event scan recounts the learned MACs of the whole table. An ager
+ * scan adds the MACs of its buckets to the counts of the ager pass in
+ * progress, advancing the pass cursor as it goes, and publishes them
+ * when the cursor wraps back to bucket 0. MACs it ages out are taken off
+ * the published learn counts right away so they stay live meanwhile.
+ */
 static_always_inline f64
-l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
+l2fib_scan (vlib_main_t *vm, f64 start_time, u8 event_only, u32 first_bucket,
+	    u32 n_buckets)
 {
   l2fib_main_t *fm = &l2fib_main;
   l2learn_main_t *lm = &l2learn_main;
 
   BVT (clib_bihash) * h = &fm->mac_table;
-  int i, j, k;
+  u32 i, last_bucket;
+  int j, k;
   f64 last_start = start_time;
   f64 accum_t = 0;
   f64 delta_t = 0;
   u32 evt_idx = 0;
-  u32 learn_count = 0;
   u32 client = lm->client_pid;
   u32 cl_idx = lm->client_index;
   vl_api_l2_macs_event_t *mp = 0;
   vl_api_registration_t *reg = 0;
   u32 bd_index;
-  static u32 *bd_learn_counts = 0;
+  static u32 scan_learn_count;
+  static u32 *scan_bd_learn_counts = 0;
+  u32 *learn_count;
+  u32 **bd_learn_counts;
 
   /* Don't scan the l2 fib if it hasn't been instantiated yet */
   if (alloc_arena (h) == 0)
     return 0.0;
 
-  vec_reset_length (bd_learn_counts);
-  vec_validate (bd_learn_counts, vec_len (l2input_main.bd_configs) - 1);
+  last_bucket = clib_min (first_bucket + n_buckets, h->nbuckets);
+
+  if (event_only)
+    {
+      learn_count = &scan_learn_count;
+      bd_learn_counts = &scan_bd_learn_counts;
+    }
+  else
+    {
+      learn_count = &fm->age_scan_learn_count;
+      bd_learn_counts = &fm->age_scan_bd_learn_counts;
+    }
+
+  /* a new pass starts counting from scratch */
+  if (first_bucket == 0)
+    {
+      *learn_count = 0;
+      vec_reset_length (*bd_learn_counts);
+    }
+  vec_validate (*bd_learn_counts, vec_len (l2input_main.bd_configs) - 1);
 
   if (client)
     {
@@ -1113,21 +1146,25 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
       reg = vl_api_client_index_to_registration (lm->client_index);
     }
 
-  for (i = 0; i < h->nbuckets; i++)
+  for (i = first_bucket; i < last_bucket; i++)
     {
       /* allow no more than 20us without a pause */
       delta_t = vlib_time_now (vm) - last_start;
       if (delta_t > 20e-6)
 	{
+	  /* MACs learned or deleted behind the cursor while suspended
+	   * update the pass counts themselves */
+	  if (!event_only)
+	    fm->age_scan_next_bucket = i;
 	  vlib_process_suspend (vm, 100e-6);	/* suspend for 100 us */
 	  /* in case a new bd was created while sleeping */
-	  vec_validate (bd_learn_counts,
+	  vec_validate (*bd_learn_counts,
 			vec_len (l2input_main.bd_configs) - 1);
 	  last_start = vlib_time_now (vm);
 	  accum_t += delta_t;
 	}
 
-      if (i < (h->nbuckets - 3))
+      if (i + 3 < last_bucket)
 	{
 	  BVT (clib_bihash_bucket) * b =
 	    BV (clib_bihash_get_bucket) (h, i + 3);
@@ -1157,8 +1194,8 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 
 	      if (!l2fib_entry_result_is_set_AGE_NOT (&result))
 		{
-		  learn_count++;
-		  vec_elt (bd_learn_counts, key.fields.bd_index)++;
+		  (*learn_count)++;
+		  vec_elt (*bd_learn_counts, key.fields.bd_index)++;
 		}
 
 	      if (client)
@@ -1246,8 +1283,14 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	      BVT (clib_bihash_kv) kv;
 	      kv.key = key.raw;
 	      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 0);
-	      learn_count--;
-	      vec_elt (bd_learn_counts, key.fields.bd_index)--;
+	      (*learn_count)--;
+	      vec_elt (*bd_learn_counts, key.fields.bd_index)--;
+	      /* the stale mac path jumps past its initialisation */
+	      bd_config = vec_elt_at_index (l2input_main.bd_configs, bd_index);
+	      if (lm->global_learn_count)
+		lm->global_learn_count--;
+	      if (bd_config->learn_count)
+		bd_config->learn_count--;
 	      /*
 	       * Note: we may have just freed the bucket's backing
 	       * storage, so check right here...
@@ -1261,12 +1304,19 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
       ;
     }
 
-  /* keep learn count consistent */
-  l2learn_main.global_learn_count = learn_count;
-  vec_foreach_index (bd_index, l2input_main.bd_configs)
+  if (!event_only)
+    fm->age_scan_next_bucket = last_bucket == h->nbuckets ? 0 : last_bucket;
+
+  /* keep learn count consistent once the whole table has been counted */
+  if (last_bucket == h->nbuckets)
     {
-      vec_elt (l2input_main.bd_configs, bd_index).learn_count =
-	vec_elt (bd_learn_counts, bd_index);
+      vec_validate (*bd_learn_counts, vec_len (l2input_main.bd_configs) - 1);
+      l2learn_main.global_learn_count = *learn_count;
+      vec_foreach_index (bd_index, l2input_main.bd_configs)
+	{
+	  vec_elt (l2input_main.bd_configs, bd_index).learn_count =
+	    vec_elt (*bd_learn_counts, bd_index);
+	}
     }
 
   if (mp)
@@ -1300,8 +1350,10 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
   uword event_type, *event_data = 0;
   l2fib_main_t *fm = &l2fib_main;
   l2learn_main_t *lm = &l2learn_main;
+  BVT (clib_bihash) * h = &fm->mac_table;
   bool enabled = 0;
   f64 start_time, next_age_scan_time = CLIB_TIME_MAX;
+  u32 n_buckets;
 
   while (1)
     {
@@ -1320,13 +1372,20 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 
       start_time = vlib_time_now (vm);
       enum
-      { SCAN_MAC_AGE, SCAN_MAC_EVENT, SCAN_DISABLE } scan = SCAN_MAC_AGE;
+      {
+	SCAN_MAC_AGE,
+	SCAN_MAC_AGE_SLICE,
+	SCAN_MAC_EVENT,
+	SCAN_DISABLE
+      } scan = SCAN_MAC_AGE;
 
       switch (event_type)
 	{
 	case ~0:		/* timer expired */
 	  if (lm->client_pid != 0 && start_time < next_age_scan_time)
 	    scan = SCAN_MAC_EVENT;
+	  else
+	    scan = SCAN_MAC_AGE_SLICE;
 	  break;
 
 	case L2_MAC_AGE_PROCESS_EVENT_START:
@@ -1346,19 +1405,40 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	}
 
       if (scan == SCAN_MAC_EVENT)
-	l2fib_main.evt_scan_duration = l2fib_scan (vm, start_time, 1);
+	fm->evt_scan_duration = l2fib_scan (vm, start_time, 1, 0, ~0);
       else
 	{
 	  if (scan == SCAN_MAC_AGE)
-	    l2fib_main.age_scan_duration = l2fib_scan (vm, start_time, 0);
+	    {
+	      /* a full pass restarts the sliced one */
+	      fm->age_scan_duration = l2fib_scan (vm, start_time, 0, 0, ~0);
+	      fm->age_scan_pass_duration = 0;
+	    }
+	  if (scan == SCAN_MAC_AGE_SLICE && h->nbuckets)
+	    {
+	      /* spread the pass over the scan interval so large tables
+	       * don't get aged in one burst */
+	      n_buckets = (h->nbuckets + fm->age_scan_n_slices - 1) /
+			  fm->age_scan_n_slices;
+	      fm->age_scan_pass_duration += l2fib_scan (
+		vm, start_time, 0, fm->age_scan_next_bucket, n_buckets);
+	      if (fm->age_scan_next_bucket == 0)
+		{
+		  fm->age_scan_duration = fm->age_scan_pass_duration;
+		  fm->age_scan_pass_duration = 0;
+		}
+	    }
 	  if (scan == SCAN_DISABLE)
 	    {
-	      l2fib_main.age_scan_duration = 0;
-	      l2fib_main.evt_scan_duration = 0;
+	      fm->age_scan_duration = 0;
+	      fm->evt_scan_duration = 0;
+	      fm->age_scan_pass_duration = 0;
+	      fm->age_scan_next_bucket = 0;
 	    }
 	  /* schedule next scan */
 	  if (enabled)
-	    next_age_scan_time = start_time + L2FIB_AGE_SCAN_INTERVAL;
+	    next_age_scan_time =
+	      start_time + L2FIB_AGE_SCAN_INTERVAL / fm->age_scan_n_slices;
 	  else
 	    next_age_scan_time = CLIB_TIME_MAX;
 	}
@@ -1387,6 +1467,8 @@ l2fib_init (vlib_main_t * vm)
     mp->mac_table_n_buckets = L2FIB_NUM_BUCKETS;
   if (mp->mac_table_memory_size == 0)
     mp->mac_table_memory_size = L2FIB_MEMORY_SIZE;
+  if (mp->age_scan_n_slices == 0)
+    mp->age_scan_n_slices = L2FIB_AGE_SCAN_SLICES_DEFAULT;
   mp->mac_table_initialized = 0;
 
   /* verify the key constructor is good, since it is endian-sensitive */
@@ -1408,6 +1490,7 @@ lfib_config (vlib_main_t * vm, unformat_input_t * input)
   l2fib_main_t *lm = &l2fib_main;
   uword table_size = ~0;
   u32 n_buckets = ~0;
+  u32 n_slices = ~0;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -1416,6 +1499,8 @@ lfib_config (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "num-buckets %u", &n_buckets))
 	;
+      else if (unformat (input, "age-scan-slices %u", &n_slices))
+	;
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
@@ -1430,6 +1515,13 @@ lfib_config (vlib_main_t * vm, unformat_input_t * input)
 
   if (table_size != ~0)
     lm->mac_table_memory_size = table_size;
+
+  if (n_slices != ~0)
+    {
+      if (n_slices == 0)
+	return clib_error_return (0, "age-scan-slices must be at least 1");
+      lm->age_scan_n_slices = n_slices;
+    }
   return 0;
 }
 
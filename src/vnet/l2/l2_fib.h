@@ -30,6 +30,9 @@
 /* Ager scan interval is 1 minute for aging */
 #define L2FIB_AGE_SCAN_INTERVAL		(60.0)
 
+/* The ager scans 1/60th of the table every second unless configured */
+#define L2FIB_AGE_SCAN_SLICES_DEFAULT	(60)
+
 /* MAC event scan delay is 100 msec unless specified by MAC event client */
 #define L2FIB_EVENT_SCAN_DELAY_DEFAULT	(0.1)
 
@@ -58,6 +61,19 @@ typedef struct
   f64 evt_scan_duration;
   f64 age_scan_duration;
 
+  /* number of slices an ager pass over the table is spread over */
+  u32 age_scan_n_slices;
+
+  /* incremental ager state: next bucket to scan and duration of the
+   * pass in progress */
+  u32 age_scan_next_bucket;
+  f64 age_scan_pass_duration;
+
+  /* learned MACs counted so far by the pass in progress, published to
+   * the learn counts when the slice cursor wraps */
+  u32 age_scan_learn_count;
+  u32 *age_scan_bd_learn_counts;
+
   /* delay between event scans, default to 100 msec */
   f64 event_scan_delay;
 
@@ -265,7 +281,31 @@ l2fib_make_key (const u8 * mac_address, u16 bd_index)
   return temp;
 }
 
-
+/**
+ * Keep the counts of the ager pass in progress in step with a learned MAC
+ * added (delta 1) or removed (delta -1) in a bucket the slice cursor has
+ * already passed, so the counts published when it wraps stay exact.
+ */
+always_inline void
+l2fib_age_scan_count_update (u64 key, u32 bd_index, int delta)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  BVT (clib_bihash_kv) kv = { .key = key };
+  u32 bucket;
+
+  if (PREDICT_TRUE (fm->age_scan_next_bucket == 0))
+    return;
+
+  bucket = BV (clib_bihash_hash) (&kv) & (fm->mac_table.nbuckets - 1);
+  if (bucket >= fm->age_scan_next_bucket)
+    return;
+
+  if (delta > 0 || fm->age_scan_learn_count)
+    fm->age_scan_learn_count += delta;
+  if (bd_index < vec_len (fm->age_scan_bd_learn_counts) &&
+      (delta > 0 || fm->age_scan_bd_learn_counts[bd_index]))
+    fm->age_scan_bd_learn_counts[bd_index] += delta;
+}
 
 /**
  * Lookup the entry for mac and bd_index in the mac table for 1 packet.
@@ -57,8 +57,9 @@ typedef struct
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
 
-  /* per-cpu vector of cloned packets */
+  /* per-cpu vector of cloned packets and their next node */
   u32 **clones;
+  u16 **nexts;
   l2_flood_member_t ***members;
 } l2flood_main_t;
 
@@ -138,167 +139,111 @@ typedef enum
 VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
 			     vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
-  u32 n_left_from, *from, *to_next;
-  l2flood_next_t next_index;
+  u32 n_left_from, *from;
   l2flood_main_t *msm = &l2flood_main;
   u32 thread_index = vm->thread_index;
+  u32 *clones = msm->clones[thread_index];
+  u16 *nexts = msm->nexts[thread_index];
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
 
+  /*
+   * The copies of all the packets of the frame are collected with their
+   * next node and enqueued in one go once the frame is done.
+   */
   while (n_left_from > 0)
     {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      u16 n_clones, n_cloned, clone0;
+      l2_bridge_domain_t *bd_config;
+      u32 sw_if_index0, bi0, ci0, n_done;
+      l2_flood_member_t *member;
+      vlib_buffer_t *b0, *c0;
+      u16 next0;
+      u8 in_shg;
+      i32 mi;
+
+      bi0 = from[0];
+      from += 1;
+      n_left_from -= 1;
+
+      b0 = vlib_get_buffer (vm, bi0);
+
+      /* Get config for the bridge domain interface */
+      bd_config = vec_elt_at_index (l2input_main.bd_configs,
+				    vnet_buffer (b0)->l2.bd_index);
+      in_shg = vnet_buffer (b0)->l2.shg;
+      sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
+
+      vec_validate (msm->members[thread_index],
+		    vec_len (bd_config->members));
+
+      vec_reset_length (msm->members[thread_index]);
+
+      /* Find first members that passes the reflection and SHG checks */
+      for (mi = bd_config->flood_count - 1; mi >= 0; mi--)
 	{
-	  u16 n_clones, n_cloned, clone0;
-	  l2_bridge_domain_t *bd_config;
-	  u32 sw_if_index0, bi0, ci0;
-	  l2_flood_member_t *member;
-	  vlib_buffer_t *b0, *c0;
-	  u16 next0;
-	  u8 in_shg;
-	  i32 mi;
-
-	  /* speculatively enqueue b0 to the current next frame */
-	  bi0 = from[0];
-	  from += 1;
-	  n_left_from -= 1;
-	  next0 = L2FLOOD_NEXT_L2_OUTPUT;
+	  member = &bd_config->members[mi];
+	  if ((member->sw_if_index != sw_if_index0) &&
+	      (!in_shg || (member->shg != in_shg)))
+	    {
+	      vec_add1 (msm->members[thread_index], member);
+	    }
+	}
 
-	  b0 = vlib_get_buffer (vm, bi0);
+      n_clones = vec_len (msm->members[thread_index]);
+      n_done = vec_len (clones);
 
-	  /* Get config for the bridge domain interface */
-	  bd_config = vec_elt_at_index (l2input_main.bd_configs,
-					vnet_buffer (b0)->l2.bd_index);
-	  in_shg = vnet_buffer (b0)->l2.shg;
-	  sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
+      if (0 == n_clones)
+	{
+	  /* No members to flood to */
+	  b0->error = node->errors[L2FLOOD_ERROR_NO_MEMBERS];
+	  vec_add1 (clones, bi0);
+	  vec_add1 (nexts, L2FLOOD_NEXT_DROP);
+	  continue;
+	}
 
-	  vec_validate (msm->members[thread_index],
-			vec_len (bd_config->members));
+      vec_validate (clones, n_done + n_clones - 1);
+      vec_validate (nexts, n_done + n_clones - 1);
 
-	  vec_reset_length (msm->members[thread_index]);
+      if (n_clones > 1)
+	{
+	  /*
+	   * the header offset needs to be large enough to incorporate
+	   * all the L3 headers that could be touched when doing BVI
+	   * processing. So take the current l2 length plus 2 * IPv6
+	   * headers (for tunnel encap)
+	   */
+	  n_cloned = vlib_buffer_clone (vm, bi0, clones + n_done, n_clones,
+					VLIB_BUFFER_CLONE_HEAD_SIZE);
 
-	  /* Find first members that passes the reflection and SHG checks */
-	  for (mi = bd_config->flood_count - 1; mi >= 0; mi--)
+	  if (PREDICT_FALSE (n_cloned != n_clones))
 	    {
-	      member = &bd_config->members[mi];
-	      if ((member->sw_if_index != sw_if_index0) &&
-		  (!in_shg || (member->shg != in_shg)))
+	      b0->error = node->errors[L2FLOOD_ERROR_REPL_FAIL];
+	      /* Worst-case, no clones, consume the original buf */
+	      if (n_cloned == 0)
 		{
-		  vec_add1 (msm->members[thread_index], member);
+		  clones[n_done] = bi0;
+		  n_cloned = 1;
 		}
 	    }
+	}
+      else
+	{
+	  /* one clone */
+	  clones[n_done] = bi0;
+	  n_cloned = 1;
+	}
 
-	  n_clones = vec_len (msm->members[thread_index]);
-
-	  if (0 == n_clones)
-	    {
-	      /* No members to flood to */
-	      to_next[0] = bi0;
-	      to_next += 1;
-	      n_left_to_next -= 1;
-
-	      b0->error = node->errors[L2FLOOD_ERROR_NO_MEMBERS];
-	      vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					       to_next, n_left_to_next,
-					       bi0, L2FLOOD_NEXT_DROP);
-	      continue;
-	    }
-	  else if (n_clones > 1)
-	    {
-	      vec_validate (msm->clones[thread_index], n_clones);
-
-	      /*
-	       * the header offset needs to be large enough to incorporate
-	       * all the L3 headers that could be touched when doing BVI
-	       * processing. So take the current l2 length plus 2 * IPv6
-	       * headers (for tunnel encap)
-	       */
-	      n_cloned = vlib_buffer_clone (vm, bi0,
-					    msm->clones[thread_index],
-					    n_clones,
-					    VLIB_BUFFER_CLONE_HEAD_SIZE);
-
-	      vec_set_len (msm->clones[thread_index], n_cloned);
-
-	      if (PREDICT_FALSE (n_cloned != n_clones))
-		{
-		  b0->error = node->errors[L2FLOOD_ERROR_REPL_FAIL];
-		  /* Worst-case, no clones, consume the original buf */
-		  if (n_cloned == 0)
-		    {
-		      ci0 = bi0;
-		      member = msm->members[thread_index][0];
-		      goto use_original_buffer;
-		    }
-		}
-
-	      /*
-	       * for all but the last clone, these are not BVI bound
-	       */
-	      for (clone0 = 0; clone0 < n_cloned - 1; clone0++)
-		{
-		  member = msm->members[thread_index][clone0];
-		  ci0 = msm->clones[thread_index][clone0];
-		  c0 = vlib_get_buffer (vm, ci0);
-
-		  to_next[0] = ci0;
-		  to_next += 1;
-		  n_left_to_next -= 1;
-
-		  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
-				     (b0->flags & VLIB_BUFFER_IS_TRACED)))
-		    {
-		      ethernet_header_t *h0;
-		      l2flood_trace_t *t;
-
-		      t = vlib_add_trace (vm, node, c0, sizeof (*t));
-		      h0 = vlib_buffer_get_current (c0);
-		      t->sw_if_index = sw_if_index0;
-		      t->bd_index = vnet_buffer (c0)->l2.bd_index;
-		      clib_memcpy_fast (t->src, h0->src_address, 6);
-		      clib_memcpy_fast (t->dst, h0->dst_address, 6);
-		    }
-
-		  /* Do normal L2 forwarding */
-		  vnet_buffer (c0)->sw_if_index[VLIB_TX] =
-		    member->sw_if_index;
+      vec_set_len (clones, n_done + n_cloned);
+      vec_set_len (nexts, n_done + n_cloned);
 
-		  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-						   to_next, n_left_to_next,
-						   ci0, next0);
-		  if (PREDICT_FALSE (0 == n_left_to_next))
-		    {
-		      vlib_put_next_frame (vm, node, next_index,
-					   n_left_to_next);
-		      vlib_get_next_frame (vm, node, next_index, to_next,
-					   n_left_to_next);
-		    }
-		}
-	      member = msm->members[thread_index][clone0];
-	      ci0 = msm->clones[thread_index][clone0];
-	    }
-	  else
-	    {
-	      /* one clone */
-	      ci0 = bi0;
-	      member = msm->members[thread_index][0];
-	    }
-
-	use_original_buffer:
-	  /*
-	   * the last clone that might go to a BVI
-	   */
+      for (clone0 = 0; clone0 < n_cloned; clone0++)
+	{
+	  member = msm->members[thread_index][clone0];
+	  ci0 = clones[n_done + clone0];
 	  c0 = vlib_get_buffer (vm, ci0);
-
-	  to_next[0] = ci0;
-	  to_next += 1;
-	  n_left_to_next -= 1;
+	  next0 = L2FLOOD_NEXT_L2_OUTPUT;
 
 	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
 			     (b0->flags & VLIB_BUFFER_IS_TRACED)))
@@ -313,8 +258,12 @@ VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
 	      clib_memcpy_fast (t->src, h0->src_address, 6);
 	      clib_memcpy_fast (t->dst, h0->dst_address, 6);
 	    }
-	  /* Forward packet to the current member */
-	  if (PREDICT_FALSE (member->flags & L2_FLOOD_MEMBER_BVI))
+
+	  /*
+	   * only the last clone might go to a BVI
+	   */
+	  if (PREDICT_FALSE (clone0 == n_cloned - 1 &&
+			     (member->flags & L2_FLOOD_MEMBER_BVI)))
 	    {
 	      /* Do BVI processing */
 	      u32 rc;
@@ -341,20 +290,17 @@ VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
 	      vnet_buffer (c0)->sw_if_index[VLIB_TX] = member->sw_if_index;
 	    }
 
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   ci0, next0);
-	  if (PREDICT_FALSE (0 == n_left_to_next))
-	    {
-	      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-	      vlib_get_next_frame (vm, node, next_index,
-				   to_next, n_left_to_next);
-	    }
+	  nexts[n_done + clone0] = next0;
 	}
-
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, clones, nexts, vec_len (clones));
+
+  vec_reset_length (clones);
+  vec_reset_length (nexts);
+  msm->clones[thread_index] = clones;
+  msm->nexts[thread_index] = nexts;
+
   vlib_node_increment_counter (vm, node->node_index,
 			       L2FLOOD_ERROR_L2FLOOD, frame->n_vectors);
 
@@ -392,6 +338,7 @@ l2flood_init (vlib_main_t * vm)
   mp->vnet_main = vnet_get_main ();
 
   vec_validate (mp->clones, vlib_num_workers ());
+  vec_validate (mp->nexts, vlib_num_workers ());
   vec_validate (mp->members, vlib_num_workers ());
 
   /* Initialize the feature next-node indexes */
@@ -116,15 +116,23 @@ l2learn_process (vlib_node_runtime_t * node,
 		 u32 sw_if_index0,
 		 l2fib_entry_key_t * key0,
 		 l2fib_entry_key_t * cached_key,
+		 l2fib_entry_result_t * cached_result,
 		 u32 * count,
-		 l2fib_entry_result_t * result0, u16 * next0, u8 timestamp)
+		 l2fib_entry_result_t * result0, u16 * next0, u8 timestamp,
+		 BVT (clib_bihash_kv) * refresh, u32 * n_refresh)
 {
   l2_bridge_domain_t *bd_config =
     vec_elt_at_index (l2input_main.bd_configs, vnet_buffer (b0)->l2.bd_index);
+  u32 i;
   /* Set up the default next node (typically L2FWD) */
   *next0 = vnet_l2_feature_next (b0, msm->feat_next_node_index,
 				 L2INPUT_FEAT_LEARN);
 
+  /* The entry may have been updated by a previous packet of the same
+   * lookup batch */
+  if (key0->raw == cached_key->raw)
+    result0->raw = cached_result->raw;
+
   /* Check mac table lookup result */
   if (PREDICT_TRUE (result0->fields.sw_if_index == sw_if_index0))
     {
@@ -150,6 +158,17 @@ l2learn_process (vlib_node_runtime_t * node,
 
       counter_base[L2LEARN_ERROR_HIT_UPDATE] += 1;
       *count += 1;
+
+      /* Only the timestamp or sn changes, defer the write to the end of
+       * the frame and serve further lookups from the cache */
+      result0->fields.timestamp = timestamp;
+      result0->fields.sn = vnet_buffer (b0)->l2.l2fib_sn;
+      refresh[*n_refresh].key = key0->raw;
+      refresh[*n_refresh].value = result0->raw;
+      *n_refresh += 1;
+      cached_key->raw = key0->raw;
+      cached_result->raw = result0->raw;
+      return;
     }
   else if (result0->raw == ~0)
     {
@@ -179,6 +198,7 @@ l2learn_process (vlib_node_runtime_t * node,
       /* l2fib_scan is call every 2sec fixing potential inaccuracy */
       msm->global_learn_count++;
       bd_config->learn_count++;
+      l2fib_age_scan_count_update (key0->raw, key0->fields.bd_index, 1);
       result0->raw = 0;		/* clear all fields */
       result0->fields.sw_if_index = sw_if_index0;
       if (msm->client_pid != 0)
@@ -222,6 +242,7 @@ l2learn_process (vlib_node_runtime_t * node,
 	  /* l2fib_scan is call every 2sec fixing potential inaccuracy */
 	  msm->global_learn_count++;
 	  bd_config->learn_count++;
+	  l2fib_age_scan_count_update (key0->raw, key0->fields.bd_index, 1);
 
 	  l2fib_entry_result_clear_AGE_NOT (result0);
 	}
@@ -240,13 +261,95 @@ l2learn_process (vlib_node_runtime_t * node,
   result0->fields.timestamp = timestamp;
   result0->fields.sn = vnet_buffer (b0)->l2.l2fib_sn;
 
+  /* Drop refreshes of the entry pending from earlier in the frame */
+  for (i = 0; i < *n_refresh; i++)
+    if (refresh[i].key == key0->raw)
+      refresh[i].value = ~0ULL;
+
   BVT (clib_bihash_kv) kv;
   kv.key = key0->raw;
   kv.value = result0->raw;
   BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
 
-  /* Invalidate the cache */
-  cached_key->raw = ~0;
+  /* Update the cache */
+  cached_key->raw = key0->raw;
+  cached_result->raw = result0->raw;
+}
+
+/*
+ * Refresh the timestamp and sn of an entry in place. The bucket lock
+ * keeps the entry from being moved by a concurrent split while it is
+ * written; an entry that is gone, moved or made static since the lookup,
+ * e.g. by another worker or the control plane, is left alone.
+ */
+static_always_inline void
+l2learn_refresh_entry (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * kv)
+{
+  static const BVT (clib_bihash_bucket) mask = { .linear_search = 1,
+						  .log2_pages = -1 };
+  BVT (clib_bihash_bucket) * b;
+  BVT (clib_bihash_value) * v;
+  l2fib_entry_result_t result, refreshed;
+  u64 hash = BV (clib_bihash_hash) (kv);
+  int i, limit;
+
+  b = BV (clib_bihash_get_bucket) (h, hash);
+  BV (clib_bihash_lock_bucket) (b);
+
+  if (BV (clib_bihash_bucket_is_empty) (b))
+    goto done;
+
+  v = BV (clib_bihash_get_value) (h, b->offset);
+  limit = BIHASH_KVP_PER_PAGE;
+  if (PREDICT_FALSE (b->as_u64 & mask.as_u64))
+    {
+      if (PREDICT_FALSE (b->linear_search))
+	limit <<= b->log2_pages;
+      else
+	v += extract_bits (hash, h->log2_nbuckets, b->log2_pages);
+    }
+
+  for (i = 0; i < limit; i++)
+    {
+      if (v->kvp[i].key != kv->key)
+	continue;
+      result.raw = v->kvp[i].value;
+      refreshed.raw = kv->value;
+      if (result.fields.sw_if_index == refreshed.fields.sw_if_index &&
+	  !l2fib_entry_result_is_set_AGE_NOT (&result))
+	{
+	  result.fields.timestamp = refreshed.fields.timestamp;
+	  result.fields.sn = refreshed.fields.sn;
+	  v->kvp[i].value = result.raw;
+	}
+      break;
+    }
+
+done:
+  BV (clib_bihash_unlock_bucket) (b);
+}
+
+static_always_inline void
+l2learn_refresh_flush (l2learn_main_t * msm, BVT (clib_bihash_kv) * kv,
+		       u32 n_left)
+{
+  BVT (clib_bihash) * h = msm->mac_table;
+  u32 i;
+
+  for (i = 0; i < clib_min (n_left, 4); i++)
+    BV (clib_bihash_prefetch_bucket) (h, BV (clib_bihash_hash) (kv + i));
+
+  for (i = 0; i < n_left; i++)
+    {
+      if (i + 4 < n_left)
+	BV (clib_bihash_prefetch_bucket) (h,
+					  BV (clib_bihash_hash) (kv + i + 4));
+      /* superseded by a learn or move */
+      if (kv[i].value == ~0ULL)
+	continue;
+
+      l2learn_refresh_entry (h, kv + i);
+    }
 }
 
 
@@ -263,6 +366,8 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   l2fib_entry_result_t cached_result;
   u8 timestamp = (u8) (vlib_time_now (vm) / 60);
   u32 count = 0;
+  BVT (clib_bihash_kv) refresh[VLIB_FRAME_SIZE];
+  u32 n_refresh = 0;
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
   u16 nexts[VLIB_FRAME_SIZE], *next;
 
@@ -369,19 +474,23 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[0], sw_if_index0, &key0, &cached_key,
-		       &count, &result0, next, timestamp);
+		       &cached_result, &count, &result0, next, timestamp,
+		       refresh, &n_refresh);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[1], sw_if_index1, &key1, &cached_key,
-		       &count, &result1, next + 1, timestamp);
+		       &cached_result, &count, &result1, next + 1, timestamp,
+		       refresh, &n_refresh);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[2], sw_if_index2, &key2, &cached_key,
-		       &count, &result2, next + 2, timestamp);
+		       &cached_result, &count, &result2, next + 2, timestamp,
+		       refresh, &n_refresh);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[3], sw_if_index3, &key3, &cached_key,
-		       &count, &result3, next + 3, timestamp);
+		       &cached_result, &count, &result3, next + 3, timestamp,
+		       refresh, &n_refresh);
 
       next += 4;
       b += 4;
@@ -419,13 +528,17 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[0], sw_if_index0, &key0, &cached_key,
-		       &count, &result0, next, timestamp);
+		       &cached_result, &count, &result0, next, timestamp,
+		       refresh, &n_refresh);
 
       next += 1;
       b += 1;
       n_left -= 1;
     }
 
+  if (n_refresh)
+    l2learn_refresh_flush (msm, refresh, n_refresh);
+
   vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
 
   return frame->n_vectors;
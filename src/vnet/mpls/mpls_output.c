@@ -408,7 +408,7 @@ mpls_frag (vlib_main_t * vm,
             ip_adjacency_t * adj0;
             vlib_buffer_t * p0;
             mpls_frag_next_t next0;
-            u32 pi0, adj_index0;
+            u32 pi0, adj_index0, pkt_size0;
             ip_frag_error_t error0 = IP_FRAG_ERROR_NONE;
             i16 encap_size;
             u8 is_ip4;
@@ -425,6 +425,9 @@ mpls_frag (vlib_main_t * vm,
             /* the size of the MPLS stack */
             encap_size = vnet_buffer(p0)->l3_hdr_offset - p0->current_data;
 
+            /* fragmentation unchains the original buffers */
+            pkt_size0 = vlib_buffer_length_in_chain (vm, p0);
+
             /* IP fragmentation */
             if (is_ip4)
                 error0 = ip4_frag_do_fragment (vm, pi0,
@@ -440,7 +443,7 @@ mpls_frag (vlib_main_t * vm,
                 mpls_frag_trace_t *tr =
                     vlib_add_trace (vm, node, p0, sizeof (*tr));
                  tr->mtu = adj0->rewrite_header.max_l3_packet_bytes;
-                 tr->pkt_size = vlib_buffer_length_in_chain(vm, p0);
+                 tr->pkt_size = pkt_size0;
 	    }
 
             if (PREDICT_TRUE(error0 == IP_FRAG_ERROR_NONE))
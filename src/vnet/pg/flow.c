@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Software flow offload for packet-generator interfaces.
+ *
+ * The flows enabled on a pg interface are matched against the packets the
+ * interface generates, in the order the flows were enabled, and the
+ * actions of the first matching flow are applied the way a NIC would:
+ * MARK sets the buffer flow id, BUFFER_ADVANCE moves the buffer start,
+ * REDIRECT_TO_NODE and DROP pick the next node of pg-input. This lets the
+ * flow offload paths of the tunnel decaps be exercised without hardware.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/pg/pg.h>
+#include <vnet/flow/flow.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ip/ip4_packet.h>
+#include <vnet/udp/udp_packet.h>
+#include <vnet/udp/udp_local.h>
+#include <vnet/devices/devices.h>
+
+#define PG_FLOW_ACTIONS                                                       \
+  (VNET_FLOW_ACTION_MARK | VNET_FLOW_ACTION_BUFFER_ADVANCE |                  \
+   VNET_FLOW_ACTION_REDIRECT_TO_NODE | VNET_FLOW_ACTION_DROP)
+
+static_always_inline int
+pg_flow_match_ip4_addr (ip4_address_and_mask_t *am, ip4_address_t *a)
+{
+  return ((a->as_u32 ^ am->addr.as_u32) & am->mask.as_u32) == 0;
+}
+
+static_always_inline int
+pg_flow_match_port (ip_port_and_mask_t *pm, u16 port, u16 dflt)
+{
+  /* tunnel flows match the well known port of the tunnel by default */
+  if (pm->mask == 0)
+    return dflt == 0 || port == dflt;
+  return ((port ^ pm->port) & pm->mask) == 0;
+}
+
+static int
+pg_flow_match (vnet_flow_t *f, u8 *data, u32 len)
+{
+  ethernet_header_t *e = (ethernet_header_t *) data;
+  vnet_flow_ip4_n_tuple_t *t = &f->ip4_n_tuple;
+  ip4_header_t *ip;
+  udp_header_t *udp;
+  u32 *l4, ip_len;
+  u16 dflt_port = 0;
+
+  if (len < sizeof (*e))
+    return 0;
+
+  if (f->type == VNET_FLOW_TYPE_ETHERNET)
+    return e->type == clib_host_to_net_u16 (f->ethernet.eth_hdr.type);
+
+  ip = (ip4_header_t *) (e + 1);
+  if (e->type != clib_host_to_net_u16 (ETHERNET_TYPE_IP4) ||
+      len < sizeof (*e) + sizeof (*ip))
+    return 0;
+
+  if (!pg_flow_match_ip4_addr (&t->src_addr, &ip->src_address) ||
+      !pg_flow_match_ip4_addr (&t->dst_addr, &ip->dst_address))
+    return 0;
+
+  if (f->type == VNET_FLOW_TYPE_IP4)
+    return ((ip->protocol ^ t->protocol.prot) & t->protocol.mask) == 0;
+
+  if (ip->protocol != t->protocol.prot)
+    return 0;
+
+  /* l4 header and the 8 bytes following it */
+  ip_len = ip4_header_bytes (ip);
+  if (len < sizeof (*e) + ip_len + 16)
+    return 0;
+
+  udp = (udp_header_t *) ((u8 *) ip + ip_len);
+  l4 = (u32 *) (udp + 1);
+
+  switch (f->type)
+    {
+    case VNET_FLOW_TYPE_IP4_IPSEC_ESP:
+      return clib_net_to_host_u32 (((u32 *) udp)[0]) == f->ip4_ipsec_esp.spi;
+    case VNET_FLOW_TYPE_IP4_IPSEC_AH:
+      return clib_net_to_host_u32 (((u32 *) udp)[1]) == f->ip4_ipsec_ah.spi;
+    case VNET_FLOW_TYPE_IP4_N_TUPLE:
+      break;
+    case VNET_FLOW_TYPE_IP4_VXLAN:
+      dflt_port = UDP_DST_PORT_vxlan;
+      break;
+    case VNET_FLOW_TYPE_IP4_GENEVE:
+      dflt_port = UDP_DST_PORT_geneve;
+      break;
+    case VNET_FLOW_TYPE_IP4_GTPU:
+      dflt_port = UDP_DST_PORT_GTPU;
+      break;
+    default:
+      return 0;
+    }
+
+  if (!pg_flow_match_port (&t->src_port,
+			   clib_net_to_host_u16 (udp->src_port), 0) ||
+      !pg_flow_match_port (&t->dst_port,
+			   clib_net_to_host_u16 (udp->dst_port), dflt_port))
+    return 0;
+
+  /* VXLAN and GENEVE VNIs are the 24 high bits of the second word of their
+   * header, the GTP-U TEID is the second word */
+  switch (f->type)
+    {
+    case VNET_FLOW_TYPE_IP4_VXLAN:
+      return clib_net_to_host_u32 (l4[1]) >> 8 == f->ip4_vxlan.vni;
+    case VNET_FLOW_TYPE_IP4_GENEVE:
+      return clib_net_to_host_u32 (l4[1]) >> 8 == f->ip4_geneve.vni;
+    case VNET_FLOW_TYPE_IP4_GTPU:
+      return clib_net_to_host_u32 (l4[1]) == f->ip4_gtpu.teid;
+    default:
+      return 1;
+    }
+}
+
+u32
+pg_flow_steer (vlib_main_t *vm, vlib_node_runtime_t *node, pg_interface_t *pi,
+	       u32 next_index, u32 *buffers, u32 n_buffers)
+{
+  u32 redirect[VLIB_FRAME_SIZE];
+  u16 nexts[VLIB_FRAME_SIZE];
+  u32 i, *fi, next, n_kept = 0, n_redirect = 0;
+  vlib_buffer_t *b;
+  vnet_flow_t *f;
+
+  ASSERT (n_buffers <= VLIB_FRAME_SIZE);
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      b = vlib_get_buffer (vm, buffers[i]);
+      next = next_index;
+      /* as a NIC, don't leave the mark of a previous use of the buffer */
+      b->flow_id = 0;
+
+      vec_foreach (fi, pi->flows)
+	{
+	  f = vnet_get_flow (fi[0]);
+	  if (!pg_flow_match (f, vlib_buffer_get_current (b),
+			      b->current_length))
+	    continue;
+
+	  if (f->actions & VNET_FLOW_ACTION_MARK)
+	    b->flow_id = f->mark_flow_id;
+	  if (f->actions & VNET_FLOW_ACTION_BUFFER_ADVANCE)
+	    vlib_buffer_advance (b, f->buffer_advance);
+	  if (f->actions & VNET_FLOW_ACTION_REDIRECT_TO_NODE)
+	    next = f->redirect_device_input_next_index;
+	  if (f->actions & VNET_FLOW_ACTION_DROP)
+	    next = VNET_DEVICE_INPUT_NEXT_DROP;
+	  break;
+	}
+
+      if (next == next_index)
+	buffers[n_kept++] = buffers[i];
+      else
+	{
+	  redirect[n_redirect] = buffers[i];
+	  nexts[n_redirect++] = next;
+	}
+    }
+
+  if (n_redirect)
+    vlib_buffer_enqueue_to_next (vm, node, redirect, nexts, n_redirect);
+
+  return n_kept;
+}
+
+int
+pg_flow_ops_fn (vnet_main_t *vnm, vnet_flow_dev_op_t op, u32 dev_instance,
+		u32 flow_index, uword *private_data)
+{
+  pg_main_t *pg = &pg_main;
+  pg_interface_t *pi = pool_elt_at_index (pg->interfaces, dev_instance);
+  vnet_flow_t *f = vnet_get_flow (flow_index);
+  u32 pos;
+
+  switch (op)
+    {
+    case VNET_FLOW_DEV_OP_ADD_FLOW:
+      if (pi->mode != PG_MODE_ETHERNET || (f->actions & ~PG_FLOW_ACTIONS))
+	return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+      switch (f->type)
+	{
+	case VNET_FLOW_TYPE_ETHERNET:
+	case VNET_FLOW_TYPE_IP4:
+	case VNET_FLOW_TYPE_IP4_N_TUPLE:
+	case VNET_FLOW_TYPE_IP4_IPSEC_ESP:
+	case VNET_FLOW_TYPE_IP4_IPSEC_AH:
+	case VNET_FLOW_TYPE_IP4_VXLAN:
+	case VNET_FLOW_TYPE_IP4_GENEVE:
+	case VNET_FLOW_TYPE_IP4_GTPU:
+	  break;
+	default:
+	  return VNET_FLOW_ERROR_NOT_SUPPORTED;
+	}
+
+      vec_add1 (pi->flows, flow_index);
+      *private_data = flow_index;
+      return 0;
+
+    case VNET_FLOW_DEV_OP_DEL_FLOW:
+      pos = vec_search (pi->flows, flow_index);
+      if (pos == ~0)
+	return VNET_FLOW_ERROR_NO_SUCH_ENTRY;
+      /* first match wins, keep the enable order */
+      vec_delete (pi->flows, 1, pos);
+      return 0;
+
+    default:
+      return VNET_FLOW_ERROR_NOT_SUPPORTED;
+    }
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
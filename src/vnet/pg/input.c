@@ -1627,7 +1627,7 @@ pg_generate_packets (vlib_node_runtime_t * node,
 		     pg_stream_t * s, uword n_packets_to_generate)
 {
   vlib_main_t *vm = vlib_get_main ();
-  u32 *to_next, n_this_frame, n_left, n_trace, n_packets_in_fifo;
+  u32 *to_next, n_this_frame, n_left, n_trace, n_packets_in_fifo, n_enq;
   uword n_packets_generated;
   pg_buffer_index_t *bi, *bi0;
   u32 next_index = s->next_index;
@@ -1732,15 +1732,21 @@ pg_generate_packets (vlib_node_runtime_t * node,
 			    n_this_frame, n_trace);
 	  vlib_set_trace_count (vm, node, n_trace);
 	}
+
+      /* packets redirected by flows are enqueued elsewhere */
+      n_enq = n_this_frame;
+      if (PREDICT_FALSE (vec_len (pi->flows) > 0))
+	n_enq = pg_flow_steer (vm, node, pi, next_index, to_next, n_this_frame);
+
       n_packets_to_generate -= n_this_frame;
       n_packets_generated += n_this_frame;
-      n_left -= n_this_frame;
+      n_left -= n_enq;
       if (CLIB_DEBUG > 0)
 	{
 	  int i;
 	  vlib_buffer_t *b;
 
-	  for (i = 0; i < n_this_frame; i++)
+	  for (i = 0; i < n_enq; i++)
 	    {
 	      b = vlib_get_buffer (vm, to_next[i]);
 	      ASSERT ((b->flags & VLIB_BUFFER_NEXT_PRESENT) == 0 ||
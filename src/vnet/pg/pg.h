@@ -326,6 +326,9 @@ typedef struct
   pg_interface_mode_t mode;
 
   mac_address_t *allowed_mcast_macs;
+
+  /* flows enabled on the interface, in the order they are matched */
+  u32 *flows;
 } pg_interface_t;
 
 /* Per VLIB node data. */
@@ -382,6 +385,12 @@ void pg_stream_enable_disable (pg_main_t * pg, pg_stream_t * s,
 void pg_interface_enable_disable_coalesce (pg_interface_t * pi, u8 enable,
 					   u32 tx_node_index);
 
+/* Software flow offload */
+vnet_flow_dev_ops_function_t pg_flow_ops_fn;
+u32 pg_flow_steer (vlib_main_t *vm, vlib_node_runtime_t *node,
+		   pg_interface_t *pi, u32 next_index, u32 *buffers,
+		   u32 n_buffers);
+
 /* Find/create free packet-generator interface index. */
 u32 pg_interface_add_or_get (pg_main_t *pg, uword stream_index, u8 gso_enabled,
 			     u32 gso_size, u8 coalesce_enabled,
@@ -43,6 +43,7 @@
 #include <vnet/ip/ip.h>
 #include <vnet/mpls/mpls.h>
 #include <vnet/devices/devices.h>
+#include <vnet/interface/rx_queue_funcs.h>
 
 /* Mark stream active or inactive. */
 void
@@ -179,6 +180,7 @@ VNET_DEVICE_CLASS (pg_dev_class) = {
   .format_tx_trace = format_pg_output_trace,
   .admin_up_down_function = pg_interface_admin_up_down,
   .mac_addr_add_del_function = pg_add_del_mac_address,
+  .flow_ops_function = pg_flow_ops_fn,
 };
 /* *INDENT-ON* */
 
@@ -295,6 +297,8 @@ pg_interface_add_or_get (pg_main_t *pg, uword if_id, u8 gso_enabled,
 	    vnm, pg_dev_class.index, i, pg_tun_hw_interface_class.index, i);
 	  break;
 	}
+      /* flows redirect from pg-input */
+      vnet_hw_if_set_input_node (vnm, pi->hw_if_index, pg_input_node.index);
       hi = vnet_get_hw_interface (vnm, pi->hw_if_index);
       if (gso_enabled)
 	{
@@ -351,6 +351,14 @@ tcp_reuse_buffer (vlib_main_t * vm, vlib_buffer_t * b)
 }
 
 #ifndef CLIB_MARCH_VARIANT
+/* Control segments carry headers only, take them from the smallest buffer
+ * size class that fits the headroom */
+static_always_inline u32
+tcp_alloc_ctrl_buffer (vlib_main_t *vm, u32 *bi)
+{
+  return vlib_buffer_alloc_for_size (vm, bi, 1, TRANSPORT_MAX_HDRS_LEN);
+}
+
 static void *
 tcp_init_buffer (vlib_main_t * vm, vlib_buffer_t * b)
 {
@@ -665,7 +673,7 @@ tcp_send_reset_w_pkt (tcp_connection_t * tc, vlib_buffer_t * pkt,
   ip4_header_t *ih4, *pkt_ih4;
   ip6_header_t *ih6, *pkt_ih6;
 
-  if (PREDICT_FALSE (!vlib_buffer_alloc (vm, &bi, 1)))
+  if (PREDICT_FALSE (!tcp_alloc_ctrl_buffer (vm, &bi)))
     {
       tcp_worker_stats_inc (wrk, no_buffer, 1);
       return;
@@ -746,7 +754,7 @@ tcp_send_reset (tcp_connection_t * tc)
   u16 tcp_hdr_opts_len, advertise_wnd, opts_write_len;
   u8 flags;
 
-  if (PREDICT_FALSE (!vlib_buffer_alloc (vm, &bi, 1)))
+  if (PREDICT_FALSE (!tcp_alloc_ctrl_buffer (vm, &bi)))
     {
       tcp_worker_stats_inc (wrk, no_buffer, 1);
       return;
@@ -794,7 +802,7 @@ tcp_send_syn (tcp_connection_t * tc)
   tcp_timer_update (&wrk->timer_wheel, tc, TCP_TIMER_RETRANSMIT_SYN,
 		    tc->rto * TCP_TO_TIMER_TICK);
 
-  if (PREDICT_FALSE (!vlib_buffer_alloc (vm, &bi, 1)))
+  if (PREDICT_FALSE (!tcp_alloc_ctrl_buffer (vm, &bi)))
     {
       tcp_timer_update (&wrk->timer_wheel, tc, TCP_TIMER_RETRANSMIT_SYN,
 			tcp_cfg.alloc_err_timeout);
@@ -826,7 +834,7 @@ tcp_send_synack (tcp_connection_t * tc)
   ASSERT (tc->snd_una != tc->snd_nxt);
   tcp_retransmit_timer_update (&wrk->timer_wheel, tc);
 
-  if (PREDICT_FALSE (!vlib_buffer_alloc (vm, &bi, 1)))
+  if (PREDICT_FALSE (!tcp_alloc_ctrl_buffer (vm, &bi)))
     {
       tcp_timer_update (&wrk->timer_wheel, tc, TCP_TIMER_RETRANSMIT,
 			tcp_cfg.alloc_err_timeout);
@@ -858,7 +866,7 @@ tcp_send_fin (tcp_connection_t * tc)
   if (fin_snt)
     tc->snd_nxt -= 1;
 
-  if (PREDICT_FALSE (!vlib_buffer_alloc (vm, &bi, 1)))
+  if (PREDICT_FALSE (!tcp_alloc_ctrl_buffer (vm, &bi)))
     {
       /* Out of buffers so program fin retransmit ASAP */
       tcp_timer_update (&wrk->timer_wheel, tc, TCP_TIMER_RETRANSMIT,
@@ -1003,7 +1011,7 @@ tcp_send_ack (tcp_connection_t * tc)
   vlib_buffer_t *b;
   u32 bi;
 
-  if (PREDICT_FALSE (!vlib_buffer_alloc (vm, &bi, 1)))
+  if (PREDICT_FALSE (!tcp_alloc_ctrl_buffer (vm, &bi)))
     {
       tcp_update_rcv_wnd (tc);
       tcp_worker_stats_inc (wrk, no_buffer, 1);
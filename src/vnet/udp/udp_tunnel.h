@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Tunnel lookup keys shared by the UDP tunnel decaps (VXLAN, VXLAN-GBP,
+ * GENEVE, GTP-U), and a decap loop built on them.
+ *
+ * IPv4 tunnels are kept in a clib_bihash_16_8 table keyed on
+ *   key[0]: local address << 32 | remote address
+ *   key[1]: udp port << 48 | fib index << 32 | tunnel id
+ * and IPv6 tunnels in a clib_bihash_24_8 table keyed on
+ *   key[0-1]: remote address
+ *   key[2]:   udp port << 48 | fib index << 32 | tunnel id
+ *
+ * Addresses, port and tunnel id (VNI, TEID...) are in network byte order,
+ * the fib index in host byte order. An encap leaves the fields it does
+ * not key on to 0. The value is owned by the encap, usually the tunnel
+ * index.
+ */
+
+#ifndef included_udp_tunnel_h
+#define included_udp_tunnel_h
+
+#include <vlib/vlib.h>
+#include <vlib/buffer_node.h>
+#include <vnet/ip/ip6_packet.h>
+#include <vppinfra/bihash_16_8.h>
+#include <vppinfra/bihash_24_8.h>
+
+typedef clib_bihash_kv_16_8_t udp_tunnel4_key_t;
+typedef clib_bihash_kv_24_8_t udp_tunnel6_key_t;
+
+static_always_inline void
+udp_tunnel4_key_init (udp_tunnel4_key_t *k, u32 local, u32 remote, u16 port,
+		      u32 fib_index, u32 id)
+{
+  k->key[0] = ((u64) local << 32) | remote;
+  k->key[1] = ((u64) port << 48) | ((u64) fib_index << 32) | id;
+}
+
+static_always_inline void
+udp_tunnel6_key_init (udp_tunnel6_key_t *k, const ip6_address_t *remote,
+		      u16 port, u32 fib_index, u32 id)
+{
+  k->key[0] = remote->as_u64[0];
+  k->key[1] = remote->as_u64[1];
+  k->key[2] = ((u64) port << 48) | ((u64) fib_index << 32) | id;
+}
+
+/** Invalidate a one-entry lookup cache. */
+static_always_inline void
+udp_tunnel4_key_cache_init (udp_tunnel4_key_t *cache)
+{
+  clib_memset (cache, 0xff, sizeof (*cache));
+}
+
+static_always_inline void
+udp_tunnel6_key_cache_init (udp_tunnel6_key_t *cache)
+{
+  clib_memset (cache, 0xff, sizeof (*cache));
+}
+
+/**
+ * Look a key up, trying the one-entry cache of the node first. Decap
+ * nodes see long trains of packets of the same tunnel, so most lookups
+ * are a two word compare.
+ * @return 0 and the key value set if found, -1 otherwise.
+ */
+static_always_inline int
+udp_tunnel4_key_search (clib_bihash_16_8_t *h, udp_tunnel4_key_t *cache,
+			udp_tunnel4_key_t *k)
+{
+  if (PREDICT_TRUE (k->key[0] == cache->key[0] && k->key[1] == cache->key[1]))
+    {
+      k->value = cache->value;
+      return 0;
+    }
+
+  if (clib_bihash_search_inline_16_8 (h, k))
+    return -1;
+
+  *cache = *k;
+  return 0;
+}
+
+static_always_inline int
+udp_tunnel6_key_search (clib_bihash_24_8_t *h, udp_tunnel6_key_t *cache,
+			udp_tunnel6_key_t *k)
+{
+  if (PREDICT_TRUE (clib_bihash_key_compare_24_8 (k->key, cache->key)))
+    {
+      k->value = cache->value;
+      return 0;
+    }
+
+  if (clib_bihash_search_inline_24_8 (h, k))
+    return -1;
+
+  *cache = *k;
+  return 0;
+}
+
+/**
+ * Shared decap loop of the UDP tunnel encaps.
+ *
+ * The encap provides two callbacks:
+ *   key_fn builds the tunnel key of a packet. The udp node leaves
+ *   current_data at the tunnel header.
+ *   decap_fn decaps a packet and returns its next index. It gets the key
+ *   with the value found, or UDP_TUNNEL_KEY_NOT_FOUND, and can try other
+ *   keys itself, e.g. multicast ones.
+ *
+ * The keys are built and hashed UDP_TUNNEL_DECAP_PREFETCH packets ahead
+ * of their search, and the bihash bucket prefetched at that point. The
+ * one-entry cache still turns the search of a train of packets of the
+ * same tunnel into a compare.
+ */
+#define UDP_TUNNEL_KEY_NOT_FOUND ((u64) ~0)
+#define UDP_TUNNEL_DECAP_PREFETCH 4
+#define UDP_TUNNEL_DECAP_RING (2 * UDP_TUNNEL_DECAP_PREFETCH)
+
+typedef void (udp_tunnel4_key_fn_t) (vlib_buffer_t *b, udp_tunnel4_key_t *k);
+typedef void (udp_tunnel6_key_fn_t) (vlib_buffer_t *b, udp_tunnel6_key_t *k);
+typedef u16 (udp_tunnel_decap_fn_t) (vlib_main_t *vm,
+				     vlib_node_runtime_t *node,
+				     vlib_buffer_t *b, void *key, void *ctx);
+
+static_always_inline uword
+udp_tunnel_decap_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+			 vlib_frame_t *frame, void *table, int is_ip4,
+			 udp_tunnel4_key_fn_t *key4_fn,
+			 udp_tunnel6_key_fn_t *key6_fn,
+			 udp_tunnel_decap_fn_t *decap_fn, void *ctx)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE];
+  udp_tunnel4_key_t keys4[UDP_TUNNEL_DECAP_RING], cache4;
+  udp_tunnel6_key_t keys6[UDP_TUNNEL_DECAP_RING], cache6;
+  u64 hashes[UDP_TUNNEL_DECAP_RING];
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_vectors = frame->n_vectors;
+  u32 i, j;
+
+  if (is_ip4)
+    udp_tunnel4_key_cache_init (&cache4);
+  else
+    udp_tunnel6_key_cache_init (&cache6);
+
+  vlib_get_buffers (vm, from, bufs, n_vectors);
+
+  for (i = 0; i < n_vectors + UDP_TUNNEL_DECAP_PREFETCH; i++)
+    {
+      /* key, hash and prefetch ahead */
+      if (i < n_vectors)
+	{
+	  if (i + UDP_TUNNEL_DECAP_PREFETCH < n_vectors)
+	    {
+	      vlib_buffer_t *p = b[i + UDP_TUNNEL_DECAP_PREFETCH];
+	      vlib_prefetch_buffer_header (p, LOAD);
+	      CLIB_PREFETCH (p->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
+	    }
+
+	  j = i % UDP_TUNNEL_DECAP_RING;
+	  if (is_ip4)
+	    {
+	      key4_fn (b[i], &keys4[j]);
+	      hashes[j] = clib_bihash_hash_16_8 (&keys4[j]);
+	      clib_bihash_prefetch_bucket_16_8 (table, hashes[j]);
+	    }
+	  else
+	    {
+	      key6_fn (b[i], &keys6[j]);
+	      hashes[j] = clib_bihash_hash_24_8 (&keys6[j]);
+	      clib_bihash_prefetch_bucket_24_8 (table, hashes[j]);
+	    }
+	}
+
+      if (i < UDP_TUNNEL_DECAP_PREFETCH)
+	continue;
+
+      /* search and decap */
+      u32 k = i - UDP_TUNNEL_DECAP_PREFETCH;
+      j = k % UDP_TUNNEL_DECAP_RING;
+      if (is_ip4)
+	{
+	  udp_tunnel4_key_t *kv = &keys4[j];
+	  if (PREDICT_TRUE (kv->key[0] == cache4.key[0] &&
+			    kv->key[1] == cache4.key[1]))
+	    kv->value = cache4.value;
+	  else if (clib_bihash_search_inline_with_hash_16_8 (table, hashes[j],
+							     kv) == 0)
+	    cache4 = *kv;
+	  else
+	    kv->value = UDP_TUNNEL_KEY_NOT_FOUND;
+	  nexts[k] = decap_fn (vm, node, b[k], kv, ctx);
+	}
+      else
+	{
+	  udp_tunnel6_key_t *kv = &keys6[j];
+	  if (PREDICT_TRUE (clib_bihash_key_compare_24_8 (kv->key,
+							  cache6.key)))
+	    kv->value = cache6.value;
+	  else if (clib_bihash_search_inline_with_hash_24_8 (table, hashes[j],
+							     kv) == 0)
+	    cache6 = *kv;
+	  else
+	    kv->value = UDP_TUNNEL_KEY_NOT_FOUND;
+	  nexts[k] = decap_fn (vm, node, b[k], kv, ctx);
+	}
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, n_vectors);
+
+  return n_vectors;
+}
+
+#endif /* included_udp_tunnel_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
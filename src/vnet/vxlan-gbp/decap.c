@@ -62,86 +62,72 @@ buf_fib_index (vlib_buffer_t * b, u32 is_ip4)
   return vec_elt (fib_index_by_sw_if_index, sw_if_index);
 }
 
-typedef vxlan4_gbp_tunnel_key_t last_tunnel_cache4;
+always_inline u32
+vxlan_gbp_key_vni (vxlan_gbp_header_t * vxlan_gbp0)
+{
+  return vxlan_gbp0->vni_reserved & clib_host_to_net_u32 (0xffffff00);
+}
+
+static_always_inline void
+vxlan4_gbp_key (vlib_buffer_t * b0, vxlan4_gbp_tunnel_key_t * key4)
+{
+  /* udp leaves current_data pointing at the vxlan_gbp header */
+  vxlan_gbp_header_t *vxlan_gbp0 = vlib_buffer_get_current (b0);
+  ip4_header_t *ip4_0 = (void *) vxlan_gbp0 - sizeof (udp_header_t) -
+    sizeof (ip4_header_t);
+
+  udp_tunnel4_key_init (key4, ip4_0->dst_address.as_u32,
+			ip4_0->src_address.as_u32, 0, buf_fib_index (b0, 1),
+			vxlan_gbp_key_vni (vxlan_gbp0));
+}
+
+static_always_inline void
+vxlan6_gbp_key (vlib_buffer_t * b0, vxlan6_gbp_tunnel_key_t * key6)
+{
+  vxlan_gbp_header_t *vxlan_gbp0 = vlib_buffer_get_current (b0);
+  ip6_header_t *ip6_0 = (void *) vxlan_gbp0 - sizeof (udp_header_t) -
+    sizeof (ip6_header_t);
+
+  udp_tunnel6_key_init (key6, &ip6_0->src_address, 0, buf_fib_index (b0, 0),
+			vxlan_gbp_key_vni (vxlan_gbp0));
+}
 
 always_inline vxlan_gbp_tunnel_t *
-vxlan4_gbp_find_tunnel (vxlan_gbp_main_t * vxm, last_tunnel_cache4 * cache,
-			u32 fib_index, ip4_header_t * ip4_0,
+vxlan4_gbp_find_tunnel (vxlan_gbp_main_t * vxm, vlib_buffer_t * b0,
+			vxlan4_gbp_tunnel_key_t * key4, ip4_header_t * ip4_0,
 			vxlan_gbp_header_t * vxlan_gbp0)
 {
   /*
    * Check unicast first since that's where most of the traffic comes from
    *  Make sure VXLAN_GBP tunnel exist according to packet SIP, DIP and VNI
    */
-  vxlan4_gbp_tunnel_key_t key4;
-  int rv;
-
-  key4.key[1] = (((u64) fib_index << 32) |
-		 (vxlan_gbp0->vni_reserved &
-		  clib_host_to_net_u32 (0xffffff00)));
-  key4.key[0] =
-    (((u64) ip4_0->dst_address.as_u32 << 32) | ip4_0->src_address.as_u32);
-
-  if (PREDICT_FALSE (key4.key[0] != cache->key[0] ||
-		     key4.key[1] != cache->key[1]))
-    {
-      rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_gbp_tunnel_by_key,
-					   &key4);
-      if (PREDICT_FALSE (rv == 0))
-	{
-	  *cache = key4;
-	  return (pool_elt_at_index (vxm->tunnels, cache->value));
-	}
-    }
-  else
-    {
-      return (pool_elt_at_index (vxm->tunnels, cache->value));
-    }
+  if (PREDICT_TRUE (key4->value != UDP_TUNNEL_KEY_NOT_FOUND))
+    return (pool_elt_at_index (vxm->tunnels, key4->value));
 
   /* No unicast match - try multicast */
   if (PREDICT_TRUE (!ip4_address_is_multicast (&ip4_0->dst_address)))
     return (NULL);
 
-  key4.key[0] = ip4_0->dst_address.as_u32;
+  udp_tunnel4_key_init (key4, 0, ip4_0->dst_address.as_u32, 0,
+			buf_fib_index (b0, 1), vxlan_gbp_key_vni (vxlan_gbp0));
   /* Make sure mcast VXLAN_GBP tunnel exist by packet DIP and VNI */
-  rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_gbp_tunnel_by_key, &key4);
-
-  if (PREDICT_FALSE (rv != 0))
+  if (PREDICT_FALSE (clib_bihash_search_inline_16_8
+		     (&vxm->vxlan4_gbp_tunnel_by_key, key4) != 0))
     return (NULL);
 
-  return (pool_elt_at_index (vxm->tunnels, key4.value));
+  return (pool_elt_at_index (vxm->tunnels, key4->value));
 }
 
-typedef vxlan6_gbp_tunnel_key_t last_tunnel_cache6;
-
 always_inline vxlan_gbp_tunnel_t *
-vxlan6_gbp_find_tunnel (vxlan_gbp_main_t * vxm, last_tunnel_cache6 * cache,
-			u32 fib_index, ip6_header_t * ip6_0,
+vxlan6_gbp_find_tunnel (vxlan_gbp_main_t * vxm, vlib_buffer_t * b0,
+			vxlan6_gbp_tunnel_key_t * key6, ip6_header_t * ip6_0,
 			vxlan_gbp_header_t * vxlan_gbp0)
 {
   /* Make sure VXLAN_GBP tunnel exist according to packet SIP and VNI */
-  vxlan6_gbp_tunnel_key_t key6 = {
-    .key = {
-	    [0] = ip6_0->src_address.as_u64[0],
-	    [1] = ip6_0->src_address.as_u64[1],
-	    [2] = ((((u64) fib_index) << 32) |
-		   (vxlan_gbp0->vni_reserved &
-		    clib_host_to_net_u32 (0xffffff00))),
-	    }
-  };
-  int rv;
-
-  if (PREDICT_FALSE
-      (clib_bihash_key_compare_24_8 (key6.key, cache->key) == 0))
-    {
-      rv = clib_bihash_search_inline_24_8 (&vxm->vxlan6_gbp_tunnel_by_key,
-					   &key6);
-      if (PREDICT_FALSE (rv != 0))
-	return NULL;
+  if (PREDICT_FALSE (key6->value == UDP_TUNNEL_KEY_NOT_FOUND))
+    return NULL;
 
-      *cache = key6;
-    }
-  vxlan_gbp_tunnel_t *t0 = pool_elt_at_index (vxm->tunnels, cache->value);
+  vxlan_gbp_tunnel_t *t0 = pool_elt_at_index (vxm->tunnels, key6->value);
 
   /* Validate VXLAN_GBP tunnel SIP against packet DIP */
   if (PREDICT_FALSE
@@ -152,13 +138,12 @@ vxlan6_gbp_find_tunnel (vxlan_gbp_main_t * vxm, last_tunnel_cache6 * cache,
 	return 0;
 
       /* Make sure mcast VXLAN_GBP tunnel exist by packet DIP and VNI */
-      key6.key[0] = ip6_0->dst_address.as_u64[0];
-      key6.key[1] = ip6_0->dst_address.as_u64[1];
-      rv = clib_bihash_search_inline_24_8 (&vxm->vxlan6_gbp_tunnel_by_key,
-					   &key6);
-      if (PREDICT_FALSE (rv != 0))
+      udp_tunnel6_key_init (key6, &ip6_0->dst_address, 0,
+			    buf_fib_index (b0, 0),
+			    vxlan_gbp_key_vni (vxlan_gbp0));
+      if (PREDICT_FALSE (clib_bihash_search_inline_24_8
+			 (&vxm->vxlan6_gbp_tunnel_by_key, key6) != 0))
 	return 0;
-
     }
 
   return t0;
@@ -188,330 +173,140 @@ vxlan_gbp_tunnel_get_next (const vxlan_gbp_tunnel_t * t, vlib_buffer_t * b0)
   return (VXLAN_GBP_INPUT_NEXT_DROP);
 }
 
-always_inline uword
-vxlan_gbp_input (vlib_main_t * vm,
-		 vlib_node_runtime_t * node,
-		 vlib_frame_t * from_frame, u8 is_ip4)
+typedef struct
+{
+  vlib_combined_counter_main_t *rx_counter;
+  vlib_combined_counter_main_t *drop_counter;
+  u32 thread_index;
+  u32 pkts_decapsulated;
+} vxlan_gbp_decap_ctx_t;
+
+static_always_inline u16
+vxlan_gbp_decap_one (vlib_main_t * vm, vlib_node_runtime_t * node,
+		     vlib_buffer_t * b0, void *key, void *arg, u8 is_ip4)
 {
   vxlan_gbp_main_t *vxm = &vxlan_gbp_main;
-  vnet_main_t *vnm = vxm->vnet_main;
-  vnet_interface_main_t *im = &vnm->interface_main;
-  vlib_combined_counter_main_t *rx_counter =
-    im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX;
-  vlib_combined_counter_main_t *drop_counter =
-    im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_DROP;
-  last_tunnel_cache4 last4;
-  last_tunnel_cache6 last6;
-  u32 pkts_decapsulated = 0;
-  u32 thread_index = vlib_get_thread_index ();
+  vxlan_gbp_decap_ctx_t *ctx = arg;
+
+  /* udp leaves current_data pointing at the vxlan_gbp header */
+  void *cur0 = vlib_buffer_get_current (b0);
+  vxlan_gbp_header_t *vxlan_gbp0 = cur0;
 
+  vxlan_gbp_tunnel_t *t0;
   if (is_ip4)
-    clib_memset (&last4, 0xff, sizeof last4);
+    t0 = vxlan4_gbp_find_tunnel (vxm, b0, key, cur0 - sizeof (udp_header_t) -
+				 sizeof (ip4_header_t), vxlan_gbp0);
   else
-    clib_memset (&last6, 0xff, sizeof last6);
-
-  u32 next_index = node->cached_next_index;
-
-  u32 *from = vlib_frame_vector_args (from_frame);
-  u32 n_left_from = from_frame->n_vectors;
-
-  while (n_left_from > 0)
-    {
-      u32 *to_next, n_left_to_next;
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from >= 4 && n_left_to_next >= 2)
-	{
-	  /* Prefetch next iteration. */
-	  {
-	    vlib_buffer_t *p2, *p3;
-
-	    p2 = vlib_get_buffer (vm, from[2]);
-	    p3 = vlib_get_buffer (vm, from[3]);
-
-	    vlib_prefetch_buffer_header (p2, LOAD);
-	    vlib_prefetch_buffer_header (p3, LOAD);
-
-	    CLIB_PREFETCH (p2->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
-	    CLIB_PREFETCH (p3->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
-	  }
-
-	  u32 bi0 = to_next[0] = from[0];
-	  u32 bi1 = to_next[1] = from[1];
-	  from += 2;
-	  to_next += 2;
-	  n_left_to_next -= 2;
-	  n_left_from -= 2;
-
-	  vlib_buffer_t *b0, *b1;
-	  b0 = vlib_get_buffer (vm, bi0);
-	  b1 = vlib_get_buffer (vm, bi1);
-
-	  /* udp leaves current_data pointing at the vxlan_gbp header */
-	  void *cur0 = vlib_buffer_get_current (b0);
-	  void *cur1 = vlib_buffer_get_current (b1);
-	  vxlan_gbp_header_t *vxlan_gbp0 = cur0;
-	  vxlan_gbp_header_t *vxlan_gbp1 = cur1;
-
-	  ip4_header_t *ip4_0, *ip4_1;
-	  ip6_header_t *ip6_0, *ip6_1;
-	  if (is_ip4)
-	    {
-	      ip4_0 = cur0 - sizeof (udp_header_t) - sizeof (ip4_header_t);
-	      ip4_1 = cur1 - sizeof (udp_header_t) - sizeof (ip4_header_t);
-	    }
-	  else
-	    {
-	      ip6_0 = cur0 - sizeof (udp_header_t) - sizeof (ip6_header_t);
-	      ip6_1 = cur1 - sizeof (udp_header_t) - sizeof (ip6_header_t);
-	    }
-
-	  u32 fi0 = buf_fib_index (b0, is_ip4);
-	  u32 fi1 = buf_fib_index (b1, is_ip4);
-
-	  vxlan_gbp_tunnel_t *t0, *t1;
-	  if (is_ip4)
-	    {
-	      t0 =
-		vxlan4_gbp_find_tunnel (vxm, &last4, fi0, ip4_0, vxlan_gbp0);
-	      t1 =
-		vxlan4_gbp_find_tunnel (vxm, &last4, fi1, ip4_1, vxlan_gbp1);
-	    }
-	  else
-	    {
-	      t0 =
-		vxlan6_gbp_find_tunnel (vxm, &last6, fi0, ip6_0, vxlan_gbp0);
-	      t1 =
-		vxlan6_gbp_find_tunnel (vxm, &last6, fi1, ip6_1, vxlan_gbp1);
-	    }
-
-	  u32 len0 = vlib_buffer_length_in_chain (vm, b0);
-	  u32 len1 = vlib_buffer_length_in_chain (vm, b1);
-
-	  vxlan_gbp_input_next_t next0, next1;
-	  u8 error0 = 0, error1 = 0;
-	  u8 flags0 = vxlan_gbp_get_flags (vxlan_gbp0);
-	  u8 flags1 = vxlan_gbp_get_flags (vxlan_gbp1);
-	  /* Required to make the l2 tag push / pop code work on l2 subifs */
-	  /* pop vxlan_gbp */
-	  vlib_buffer_advance (b0, sizeof *vxlan_gbp0);
-	  vlib_buffer_advance (b1, sizeof *vxlan_gbp1);
-
-	  u8 i_and_g0 = ((flags0 & VXLAN_GBP_FLAGS_GI) == VXLAN_GBP_FLAGS_GI);
-	  u8 i_and_g1 = ((flags1 & VXLAN_GBP_FLAGS_GI) == VXLAN_GBP_FLAGS_GI);
-
-	  /* Validate VXLAN_GBP tunnel encap-fib index against packet */
-	  if (PREDICT_FALSE (t0 == NULL || !i_and_g0))
-	    {
-	      if (t0 != NULL && !i_and_g0)
-		{
-		  error0 = VXLAN_GBP_ERROR_BAD_FLAGS;
-		  vlib_increment_combined_counter
-		    (drop_counter, thread_index, t0->sw_if_index, 1, len0);
-		  next0 = VXLAN_GBP_INPUT_NEXT_DROP;
-		}
-	      else
-		{
-		  error0 = VXLAN_GBP_ERROR_NO_SUCH_TUNNEL;
-		  next0 = VXLAN_GBP_INPUT_NEXT_PUNT;
-		  if (is_ip4)
-		    b0->punt_reason =
-		      vxm->punt_no_such_tunnel[FIB_PROTOCOL_IP4];
-		  else
-		    b0->punt_reason =
-		      vxm->punt_no_such_tunnel[FIB_PROTOCOL_IP6];
-		}
-	      b0->error = node->errors[error0];
-	    }
-	  else
-	    {
-	      next0 = vxlan_gbp_tunnel_get_next (t0, b0);
-
-	      /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
-	      vnet_buffer (b0)->sw_if_index[VLIB_RX] = t0->sw_if_index;
-	      vlib_increment_combined_counter
-		(rx_counter, thread_index, t0->sw_if_index, 1, len0);
-	      pkts_decapsulated++;
-	    }
-
-	  vnet_buffer2 (b0)->gbp.flags = (vxlan_gbp_get_gpflags (vxlan_gbp0) |
-					  VXLAN_GBP_GPFLAGS_R);
-	  vnet_buffer2 (b0)->gbp.sclass = vxlan_gbp_get_sclass (vxlan_gbp0);
-
-
-	  if (PREDICT_FALSE (t1 == NULL || !i_and_g1))
-	    {
-	      if (t1 != NULL && !i_and_g1)
-		{
-		  error1 = VXLAN_GBP_ERROR_BAD_FLAGS;
-		  vlib_increment_combined_counter
-		    (drop_counter, thread_index, t1->sw_if_index, 1, len1);
-		  next1 = VXLAN_GBP_INPUT_NEXT_DROP;
-		}
-	      else
-		{
-		  error1 = VXLAN_GBP_ERROR_NO_SUCH_TUNNEL;
-		  next1 = VXLAN_GBP_INPUT_NEXT_PUNT;
-		  if (is_ip4)
-		    b1->punt_reason =
-		      vxm->punt_no_such_tunnel[FIB_PROTOCOL_IP4];
-		  else
-		    b1->punt_reason =
-		      vxm->punt_no_such_tunnel[FIB_PROTOCOL_IP6];
-		}
-	      b1->error = node->errors[error1];
-	    }
-	  else
-	    {
-	      next1 = vxlan_gbp_tunnel_get_next (t1, b1);
-
-	      /* Set packet input sw_if_index to unicast VXLAN_GBP tunnel for learning */
-	      vnet_buffer (b1)->sw_if_index[VLIB_RX] = t1->sw_if_index;
-	      pkts_decapsulated++;
+    t0 = vxlan6_gbp_find_tunnel (vxm, b0, key, cur0 - sizeof (udp_header_t) -
+				 sizeof (ip6_header_t), vxlan_gbp0);
 
-	      vlib_increment_combined_counter
-		(rx_counter, thread_index, t1->sw_if_index, 1, len1);
-	    }
+  uword len0 = vlib_buffer_length_in_chain (vm, b0);
 
-	  vnet_buffer2 (b1)->gbp.flags = (vxlan_gbp_get_gpflags (vxlan_gbp1) |
-					  VXLAN_GBP_GPFLAGS_R);
+  vxlan_gbp_input_next_t next0;
+  u8 error0 = 0;
+  u8 flags0 = vxlan_gbp_get_flags (vxlan_gbp0);
 
-	  vnet_buffer2 (b1)->gbp.sclass = vxlan_gbp_get_sclass (vxlan_gbp1);
+  /* pop (ip, udp, vxlan_gbp) */
+  vlib_buffer_advance (b0, sizeof (*vxlan_gbp0));
 
-	  vnet_update_l2_len (b0);
-	  vnet_update_l2_len (b1);
+  u8 i_and_g0 = ((flags0 & VXLAN_GBP_FLAGS_GI) == VXLAN_GBP_FLAGS_GI);
 
-	  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
-	    {
-	      vxlan_gbp_rx_trace_t *tr =
-		vlib_add_trace (vm, node, b0, sizeof (*tr));
-	      tr->next_index = next0;
-	      tr->error = error0;
-	      tr->tunnel_index = t0 == 0 ? ~0 : t0 - vxm->tunnels;
-	      tr->vni = vxlan_gbp_get_vni (vxlan_gbp0);
-	      tr->sclass = vxlan_gbp_get_sclass (vxlan_gbp0);
-	      tr->flags = vxlan_gbp_get_gpflags (vxlan_gbp0);
-	    }
-	  if (PREDICT_FALSE (b1->flags & VLIB_BUFFER_IS_TRACED))
-	    {
-	      vxlan_gbp_rx_trace_t *tr =
-		vlib_add_trace (vm, node, b1, sizeof (*tr));
-	      tr->next_index = next1;
-	      tr->error = error1;
-	      tr->tunnel_index = t1 == 0 ? ~0 : t1 - vxm->tunnels;
-	      tr->vni = vxlan_gbp_get_vni (vxlan_gbp1);
-	      tr->sclass = vxlan_gbp_get_sclass (vxlan_gbp1);
-	      tr->flags = vxlan_gbp_get_gpflags (vxlan_gbp1);
-	    }
-
-	  vlib_validate_buffer_enqueue_x2 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, bi1, next0, next1);
+  /* Validate VXLAN_GBP tunnel encap-fib index against packet */
+  if (PREDICT_FALSE (t0 == NULL || !i_and_g0))
+    {
+      if (t0 != NULL && !i_and_g0)
+	{
+	  error0 = VXLAN_GBP_ERROR_BAD_FLAGS;
+	  vlib_increment_combined_counter
+	    (ctx->drop_counter, ctx->thread_index, t0->sw_if_index, 1, len0);
+	  next0 = VXLAN_GBP_INPUT_NEXT_DROP;
 	}
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      else
 	{
-	  u32 bi0 = to_next[0] = from[0];
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  vlib_buffer_t *b0 = vlib_get_buffer (vm, bi0);
-
-	  /* udp leaves current_data pointing at the vxlan_gbp header */
-	  void *cur0 = vlib_buffer_get_current (b0);
-	  vxlan_gbp_header_t *vxlan_gbp0 = cur0;
-	  ip4_header_t *ip4_0;
-	  ip6_header_t *ip6_0;
-	  if (is_ip4)
-	    ip4_0 = cur0 - sizeof (udp_header_t) - sizeof (ip4_header_t);
-	  else
-	    ip6_0 = cur0 - sizeof (udp_header_t) - sizeof (ip6_header_t);
-
-	  u32 fi0 = buf_fib_index (b0, is_ip4);
-
-	  vxlan_gbp_tunnel_t *t0;
+	  error0 = VXLAN_GBP_ERROR_NO_SUCH_TUNNEL;
+	  next0 = VXLAN_GBP_INPUT_NEXT_PUNT;
 	  if (is_ip4)
-	    t0 = vxlan4_gbp_find_tunnel (vxm, &last4, fi0, ip4_0, vxlan_gbp0);
+	    b0->punt_reason = vxm->punt_no_such_tunnel[FIB_PROTOCOL_IP4];
 	  else
-	    t0 = vxlan6_gbp_find_tunnel (vxm, &last6, fi0, ip6_0, vxlan_gbp0);
-
-	  uword len0 = vlib_buffer_length_in_chain (vm, b0);
+	    b0->punt_reason = vxm->punt_no_such_tunnel[FIB_PROTOCOL_IP6];
+	}
+      b0->error = node->errors[error0];
+    }
+  else
+    {
+      next0 = vxlan_gbp_tunnel_get_next (t0, b0);
+      /* Set packet input sw_if_index to unicast VXLAN_GBP tunnel for
+       * learning */
+      vnet_buffer (b0)->sw_if_index[VLIB_RX] = t0->sw_if_index;
+      ctx->pkts_decapsulated++;
+
+      vlib_increment_combined_counter
+	(ctx->rx_counter, ctx->thread_index, t0->sw_if_index, 1, len0);
+    }
+  vnet_buffer2 (b0)->gbp.flags = (vxlan_gbp_get_gpflags (vxlan_gbp0) |
+				  VXLAN_GBP_GPFLAGS_R);
 
-	  vxlan_gbp_input_next_t next0;
-	  u8 error0 = 0;
-	  u8 flags0 = vxlan_gbp_get_flags (vxlan_gbp0);
+  vnet_buffer2 (b0)->gbp.sclass = vxlan_gbp_get_sclass (vxlan_gbp0);
 
-	  /* pop (ip, udp, vxlan_gbp) */
-	  vlib_buffer_advance (b0, sizeof (*vxlan_gbp0));
+  /* Required to make the l2 tag push / pop code work on l2 subifs */
+  vnet_update_l2_len (b0);
 
-	  u8 i_and_g0 = ((flags0 & VXLAN_GBP_FLAGS_GI) == VXLAN_GBP_FLAGS_GI);
+  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+    {
+      vxlan_gbp_rx_trace_t *tr = vlib_add_trace (vm, node, b0, sizeof (*tr));
+      tr->next_index = next0;
+      tr->error = error0;
+      tr->tunnel_index = t0 == 0 ? ~0 : t0 - vxm->tunnels;
+      tr->vni = vxlan_gbp_get_vni (vxlan_gbp0);
+      tr->sclass = vxlan_gbp_get_sclass (vxlan_gbp0);
+      tr->flags = vxlan_gbp_get_gpflags (vxlan_gbp0);
+    }
 
-	  /* Validate VXLAN_GBP tunnel encap-fib index against packet */
-	  if (PREDICT_FALSE (t0 == NULL || !i_and_g0))
-	    {
-	      if (t0 != NULL && !i_and_g0)
-		{
-		  error0 = VXLAN_GBP_ERROR_BAD_FLAGS;
-		  vlib_increment_combined_counter
-		    (drop_counter, thread_index, t0->sw_if_index, 1, len0);
-		  next0 = VXLAN_GBP_INPUT_NEXT_DROP;
-		}
-	      else
-		{
-		  error0 = VXLAN_GBP_ERROR_NO_SUCH_TUNNEL;
-		  next0 = VXLAN_GBP_INPUT_NEXT_PUNT;
-		  if (is_ip4)
-		    b0->punt_reason =
-		      vxm->punt_no_such_tunnel[FIB_PROTOCOL_IP4];
-		  else
-		    b0->punt_reason =
-		      vxm->punt_no_such_tunnel[FIB_PROTOCOL_IP6];
-		}
-	      b0->error = node->errors[error0];
-	    }
-	  else
-	    {
-	      next0 = vxlan_gbp_tunnel_get_next (t0, b0);
-	      /* Set packet input sw_if_index to unicast VXLAN_GBP tunnel for learning */
-	      vnet_buffer (b0)->sw_if_index[VLIB_RX] = t0->sw_if_index;
-	      pkts_decapsulated++;
+  return next0;
+}
 
-	      vlib_increment_combined_counter
-		(rx_counter, thread_index, t0->sw_if_index, 1, len0);
-	    }
-	  vnet_buffer2 (b0)->gbp.flags = (vxlan_gbp_get_gpflags (vxlan_gbp0) |
-					  VXLAN_GBP_GPFLAGS_R);
+static_always_inline u16
+vxlan4_gbp_decap (vlib_main_t * vm, vlib_node_runtime_t * node,
+		  vlib_buffer_t * b0, void *key, void *ctx)
+{
+  return vxlan_gbp_decap_one (vm, node, b0, key, ctx, /* is_ip4 */ 1);
+}
 
-	  vnet_buffer2 (b0)->gbp.sclass = vxlan_gbp_get_sclass (vxlan_gbp0);
+static_always_inline u16
+vxlan6_gbp_decap (vlib_main_t * vm, vlib_node_runtime_t * node,
+		  vlib_buffer_t * b0, void *key, void *ctx)
+{
+  return vxlan_gbp_decap_one (vm, node, b0, key, ctx, /* is_ip4 */ 0);
+}
 
-	  /* Required to make the l2 tag push / pop code work on l2 subifs */
-	  vnet_update_l2_len (b0);
+always_inline uword
+vxlan_gbp_input (vlib_main_t * vm,
+		 vlib_node_runtime_t * node,
+		 vlib_frame_t * from_frame, u8 is_ip4)
+{
+  vxlan_gbp_main_t *vxm = &vxlan_gbp_main;
+  vnet_interface_main_t *im = &vxm->vnet_main->interface_main;
+  vxlan_gbp_decap_ctx_t ctx = {
+    .rx_counter = im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
+    .drop_counter =
+      im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_DROP,
+    .thread_index = vm->thread_index,
+  };
 
-	  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
-	    {
-	      vxlan_gbp_rx_trace_t *tr
-		= vlib_add_trace (vm, node, b0, sizeof (*tr));
-	      tr->next_index = next0;
-	      tr->error = error0;
-	      tr->tunnel_index = t0 == 0 ? ~0 : t0 - vxm->tunnels;
-	      tr->vni = vxlan_gbp_get_vni (vxlan_gbp0);
-	      tr->sclass = vxlan_gbp_get_sclass (vxlan_gbp0);
-	      tr->flags = vxlan_gbp_get_gpflags (vxlan_gbp0);
-	    }
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
-	}
+  if (is_ip4)
+    udp_tunnel_decap_inline (vm, node, from_frame,
+			     &vxm->vxlan4_gbp_tunnel_by_key, /* is_ip4 */ 1,
+			     vxlan4_gbp_key, 0, vxlan4_gbp_decap, &ctx);
+  else
+    udp_tunnel_decap_inline (vm, node, from_frame,
+			     &vxm->vxlan6_gbp_tunnel_by_key, /* is_ip4 */ 0,
+			     0, vxlan6_gbp_key, vxlan6_gbp_decap, &ctx);
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-    }
   /* Do we still need this now that tunnel tx stats is kept? */
   u32 node_idx =
     is_ip4 ? vxlan4_gbp_input_node.index : vxlan6_gbp_input_node.index;
   vlib_node_increment_counter (vm, node_idx, VXLAN_GBP_ERROR_DECAPSULATED,
-			       pkts_decapsulated);
+			       ctx.pkts_decapsulated);
 
   return from_frame->n_vectors;
 }
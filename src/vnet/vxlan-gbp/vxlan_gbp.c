@@ -396,11 +396,11 @@ int vnet_vxlan_gbp_tunnel_add_del
   int not_found;
   if (!is_ip6)
     {
-      key4.key[0] = ip46_address_is_multicast (&a->dst) ?
-	a->dst.ip4.as_u32 :
-	a->dst.ip4.as_u32 | (((u64) a->src.ip4.as_u32) << 32);
-      key4.key[1] = (((u64) a->encap_fib_index) << 32)
-	| clib_host_to_net_u32 (a->vni << 8);
+      udp_tunnel4_key_init (&key4,
+			    ip46_address_is_multicast (&a->dst) ?
+			    0 : a->src.ip4.as_u32,
+			    a->dst.ip4.as_u32, 0, a->encap_fib_index,
+			    clib_host_to_net_u32 (a->vni << 8));
       not_found =
 	clib_bihash_search_inline_16_8 (&vxm->vxlan4_gbp_tunnel_by_key,
 					&key4);
@@ -408,10 +408,8 @@ int vnet_vxlan_gbp_tunnel_add_del
     }
   else
     {
-      key6.key[0] = a->dst.ip6.as_u64[0];
-      key6.key[1] = a->dst.ip6.as_u64[1];
-      key6.key[2] = (((u64) a->encap_fib_index) << 32)
-	| clib_host_to_net_u32 (a->vni << 8);
+      udp_tunnel6_key_init (&key6, &a->dst.ip6, 0, a->encap_fib_index,
+			    clib_host_to_net_u32 (a->vni << 8));
       not_found =
 	clib_bihash_search_inline_24_8 (&vxm->vxlan6_gbp_tunnel_by_key,
 					&key6);
@@ -17,8 +17,7 @@
 
 #include <vppinfra/error.h>
 #include <vppinfra/hash.h>
-#include <vppinfra/bihash_16_8.h>
-#include <vppinfra/bihash_24_8.h>
+#include <vnet/udp/udp_tunnel.h>
 #include <vnet/vnet.h>
 #include <vnet/ip/ip.h>
 #include <vnet/l2/l2_input.h>
@@ -51,14 +50,14 @@ typedef CLIB_PACKED (struct {
 * Key fields: remote ip, vni on incoming VXLAN packet
 * all fields in NET byte order
 */
-typedef clib_bihash_kv_16_8_t vxlan4_gbp_tunnel_key_t;
+typedef udp_tunnel4_key_t vxlan4_gbp_tunnel_key_t;
 
 /*
 * Key fields: remote ip, vni and fib index on incoming VXLAN packet
 * ip, vni fields in NET byte order
 * fib index field in host byte order
 */
-typedef clib_bihash_kv_24_8_t vxlan6_gbp_tunnel_key_t;
+typedef udp_tunnel6_key_t vxlan6_gbp_tunnel_key_t;
 
 typedef enum vxlan_gbp_tunnel_mode_t_
 {
@@ -47,6 +47,7 @@ format_vxlan_rx_trace (u8 * s, va_list * args)
 }
 
 typedef vxlan4_tunnel_key_t last_tunnel_cache4;
+typedef vxlan6_tunnel_key_t last_tunnel_cache6;
 
 static const vxlan_decap_info_t decap_not_found = {
   .sw_if_index = ~0,
@@ -60,39 +61,53 @@ static const vxlan_decap_info_t decap_bad_flags = {
   .error = VXLAN_ERROR_BAD_FLAGS
 };
 
-always_inline vxlan_decap_info_t
-vxlan4_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache4 * cache,
-		    u32 fib_index, ip4_header_t * ip4_0,
-		    vxlan_header_t * vxlan0, u32 * stats_sw_if_index)
+static_always_inline void
+vxlan4_key (vlib_buffer_t * b0, vxlan4_tunnel_key_t * key4)
 {
-  if (PREDICT_FALSE (vxlan0->flags != VXLAN_FLAGS_I))
-    return decap_bad_flags;
+  /* udp leaves current_data pointing at the vxlan header */
+  vxlan_header_t *vxlan0 = vlib_buffer_get_current (b0);
+  ip4_header_t *ip4_0 = (void *) vxlan0 - sizeof (udp_header_t) -
+    sizeof (ip4_header_t);
+  udp_header_t *udp = ip4_next_header (ip4_0);
 
   /* Make sure VXLAN tunnel exist according to packet S/D IP, UDP port, VRF,
    * and VNI */
-  u32 dst = ip4_0->dst_address.as_u32;
-  u32 src = ip4_0->src_address.as_u32;
-  udp_header_t *udp = ip4_next_header (ip4_0);
-  vxlan4_tunnel_key_t key4 = {
-    .key[0] = ((u64) dst << 32) | src,
-    .key[1] = ((u64) udp->dst_port << 48) | ((u64) fib_index << 32) |
-	      vxlan0->vni_reserved,
-  };
+  udp_tunnel4_key_init (key4, ip4_0->dst_address.as_u32,
+			ip4_0->src_address.as_u32, udp->dst_port,
+			vlib_buffer_get_ip_fib_index (b0, 1),
+			vxlan0->vni_reserved);
+}
 
-  if (PREDICT_TRUE
-      (key4.key[0] == cache->key[0] && key4.key[1] == cache->key[1]))
-    {
-      /* cache hit */
-      vxlan_decap_info_t di = {.as_u64 = cache->value };
-      *stats_sw_if_index = di.sw_if_index;
-      return di;
-    }
+static_always_inline void
+vxlan6_key (vlib_buffer_t * b0, vxlan6_tunnel_key_t * key6)
+{
+  vxlan_header_t *vxlan0 = vlib_buffer_get_current (b0);
+  ip6_header_t *ip6_0 = (void *) vxlan0 - sizeof (udp_header_t) -
+    sizeof (ip6_header_t);
+  udp_header_t *udp = ip6_next_header (ip6_0);
 
-  int rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, &key4);
-  if (PREDICT_TRUE (rv == 0))
+  /* Make sure VXLAN tunnel exist according to packet SIP, UDP port, VRF, and
+   * VNI */
+  udp_tunnel6_key_init (key6, &ip6_0->src_address, udp->dst_port,
+			vlib_buffer_get_ip_fib_index (b0, 0),
+			vxlan0->vni_reserved);
+}
+
+/**
+ * Decap info of a packet given its tunnel key, looked up with the value
+ * found or UDP_TUNNEL_KEY_NOT_FOUND. Falls back to the multicast tunnels.
+ */
+always_inline vxlan_decap_info_t
+vxlan4_key_decap_info (vxlan_main_t * vxm, vxlan4_tunnel_key_t * key4,
+		       u32 fib_index, ip4_header_t * ip4_0,
+		       vxlan_header_t * vxlan0, u32 * stats_sw_if_index)
+{
+  if (PREDICT_FALSE (vxlan0->flags != VXLAN_FLAGS_I))
+    return decap_bad_flags;
+
+  if (PREDICT_TRUE (key4->value != UDP_TUNNEL_KEY_NOT_FOUND))
     {
-      *cache = key4;
-      vxlan_decap_info_t di = {.as_u64 = key4.value };
+      vxlan_decap_info_t di = {.as_u64 = key4->value };
       *stats_sw_if_index = di.sw_if_index;
       return di;
     }
@@ -102,55 +117,41 @@ vxlan4_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache4 * cache,
     return decap_not_found;
 
   /* search for mcast decap info by mcast address */
-  key4.key[0] = dst;
-  rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, &key4);
+  u32 dst = ip4_0->dst_address.as_u32;
+  u32 src = ip4_0->src_address.as_u32;
+  udp_header_t *udp = ip4_next_header (ip4_0);
+  udp_tunnel4_key_init (key4, 0, dst, udp->dst_port, fib_index,
+			vxlan0->vni_reserved);
+  int rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, key4);
   if (rv != 0)
     return decap_not_found;
 
   /* search for unicast tunnel using the mcast tunnel local(src) ip */
-  vxlan_decap_info_t mdi = {.as_u64 = key4.value };
-  key4.key[0] = ((u64) mdi.local_ip.as_u32 << 32) | src;
-  rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, &key4);
+  vxlan_decap_info_t mdi = {.as_u64 = key4->value };
+  udp_tunnel4_key_init (key4, mdi.local_ip.as_u32, src, udp->dst_port,
+			fib_index, vxlan0->vni_reserved);
+  rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, key4);
   if (PREDICT_FALSE (rv != 0))
     return decap_not_found;
 
   /* mcast traffic does not update the cache */
   *stats_sw_if_index = mdi.sw_if_index;
-  vxlan_decap_info_t di = {.as_u64 = key4.value };
+  vxlan_decap_info_t di = {.as_u64 = key4->value };
   return di;
 }
 
-typedef vxlan6_tunnel_key_t last_tunnel_cache6;
-
 always_inline vxlan_decap_info_t
-vxlan6_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache6 * cache,
-		    u32 fib_index, ip6_header_t * ip6_0,
-		    vxlan_header_t * vxlan0, u32 * stats_sw_if_index)
+vxlan6_key_decap_info (vxlan_main_t * vxm, vxlan6_tunnel_key_t * key6,
+		       u32 fib_index, ip6_header_t * ip6_0,
+		       vxlan_header_t * vxlan0, u32 * stats_sw_if_index)
 {
   if (PREDICT_FALSE (vxlan0->flags != VXLAN_FLAGS_I))
     return decap_bad_flags;
 
-  /* Make sure VXLAN tunnel exist according to packet SIP, UDP port, VRF, and
-   * VNI */
-  udp_header_t *udp = ip6_next_header (ip6_0);
-  vxlan6_tunnel_key_t key6 = {
-    .key[0] = ip6_0->src_address.as_u64[0],
-    .key[1] = ip6_0->src_address.as_u64[1],
-    .key[2] = ((u64) udp->dst_port << 48) | ((u64) fib_index << 32) |
-	      vxlan0->vni_reserved,
-  };
-
-  if (PREDICT_FALSE
-      (clib_bihash_key_compare_24_8 (key6.key, cache->key) == 0))
-    {
-      int rv =
-	clib_bihash_search_inline_24_8 (&vxm->vxlan6_tunnel_by_key, &key6);
-      if (PREDICT_FALSE (rv != 0))
-	return decap_not_found;
+  if (PREDICT_FALSE (key6->value == UDP_TUNNEL_KEY_NOT_FOUND))
+    return decap_not_found;
 
-      *cache = key6;
-    }
-  vxlan_tunnel_t *t0 = pool_elt_at_index (vxm->tunnels, cache->value);
+  vxlan_tunnel_t *t0 = pool_elt_at_index (vxm->tunnels, key6->value);
 
   /* Validate VXLAN tunnel SIP against packet DIP */
   if (PREDICT_TRUE (ip6_address_is_equal (&ip6_0->dst_address, &t0->src.ip6)))
@@ -162,14 +163,15 @@ vxlan6_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache6 * cache,
 	return decap_not_found;
 
       /* Make sure mcast VXLAN tunnel exist by packet DIP and VNI */
-      key6.key[0] = ip6_0->dst_address.as_u64[0];
-      key6.key[1] = ip6_0->dst_address.as_u64[1];
+      udp_header_t *udp = ip6_next_header (ip6_0);
+      udp_tunnel6_key_init (key6, &ip6_0->dst_address, udp->dst_port,
+			    fib_index, vxlan0->vni_reserved);
       int rv =
-	clib_bihash_search_inline_24_8 (&vxm->vxlan6_tunnel_by_key, &key6);
+	clib_bihash_search_inline_24_8 (&vxm->vxlan6_tunnel_by_key, key6);
       if (PREDICT_FALSE (rv != 0))
 	return decap_not_found;
 
-      vxlan_tunnel_t *mcast_t0 = pool_elt_at_index (vxm->tunnels, key6.value);
+      vxlan_tunnel_t *mcast_t0 = pool_elt_at_index (vxm->tunnels, key6->value);
       *stats_sw_if_index = mcast_t0->sw_if_index;
     }
 
@@ -180,214 +182,140 @@ vxlan6_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache6 * cache,
   return di;
 }
 
-always_inline uword
-vxlan_input (vlib_main_t * vm,
-	     vlib_node_runtime_t * node,
-	     vlib_frame_t * from_frame, u32 is_ip4)
+always_inline vxlan_decap_info_t
+vxlan4_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache4 * cache,
+		    u32 fib_index, ip4_header_t * ip4_0,
+		    vxlan_header_t * vxlan0, u32 * stats_sw_if_index)
 {
-  vxlan_main_t *vxm = &vxlan_main;
-  vnet_main_t *vnm = vxm->vnet_main;
-  vnet_interface_main_t *im = &vnm->interface_main;
-  vlib_combined_counter_main_t *rx_counter =
-    im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX;
-  last_tunnel_cache4 last4;
-  last_tunnel_cache6 last6;
-  u32 pkts_dropped = 0;
-  u32 thread_index = vlib_get_thread_index ();
-
-  if (is_ip4)
-    clib_memset (&last4, 0xff, sizeof last4);
-  else
-    clib_memset (&last6, 0xff, sizeof last6);
-
-  u32 *from = vlib_frame_vector_args (from_frame);
-  u32 n_left_from = from_frame->n_vectors;
-
-  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
-  vlib_get_buffers (vm, from, bufs, n_left_from);
+  udp_header_t *udp = ip4_next_header (ip4_0);
+  vxlan4_tunnel_key_t key4;
 
-  u32 stats_if0 = ~0, stats_if1 = ~0;
-  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
-  while (n_left_from >= 4)
-    {
-      /* Prefetch next iteration. */
-      vlib_prefetch_buffer_header (b[2], LOAD);
-      vlib_prefetch_buffer_header (b[3], LOAD);
+  udp_tunnel4_key_init (&key4, ip4_0->dst_address.as_u32,
+			ip4_0->src_address.as_u32, udp->dst_port, fib_index,
+			vxlan0->vni_reserved);
+  if (udp_tunnel4_key_search (&vxm->vxlan4_tunnel_by_key, cache, &key4))
+    key4.value = UDP_TUNNEL_KEY_NOT_FOUND;
 
-      /* udp leaves current_data pointing at the vxlan header */
-      void *cur0 = vlib_buffer_get_current (b[0]);
-      void *cur1 = vlib_buffer_get_current (b[1]);
-      vxlan_header_t *vxlan0 = cur0;
-      vxlan_header_t *vxlan1 = cur1;
+  return vxlan4_key_decap_info (vxm, &key4, fib_index, ip4_0, vxlan0,
+				stats_sw_if_index);
+}
 
+always_inline vxlan_decap_info_t
+vxlan6_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache6 * cache,
+		    u32 fib_index, ip6_header_t * ip6_0,
+		    vxlan_header_t * vxlan0, u32 * stats_sw_if_index)
+{
+  udp_header_t *udp = ip6_next_header (ip6_0);
+  vxlan6_tunnel_key_t key6;
 
-      ip4_header_t *ip4_0, *ip4_1;
-      ip6_header_t *ip6_0, *ip6_1;
-      if (is_ip4)
-	{
-	  ip4_0 = cur0 - sizeof (udp_header_t) - sizeof (ip4_header_t);
-	  ip4_1 = cur1 - sizeof (udp_header_t) - sizeof (ip4_header_t);
-	}
-      else
-	{
-	  ip6_0 = cur0 - sizeof (udp_header_t) - sizeof (ip6_header_t);
-	  ip6_1 = cur1 - sizeof (udp_header_t) - sizeof (ip6_header_t);
-	}
+  udp_tunnel6_key_init (&key6, &ip6_0->src_address, udp->dst_port,
+			fib_index, vxlan0->vni_reserved);
+  if (udp_tunnel6_key_search (&vxm->vxlan6_tunnel_by_key, cache, &key6))
+    key6.value = UDP_TUNNEL_KEY_NOT_FOUND;
 
-      /* pop vxlan */
-      vlib_buffer_advance (b[0], sizeof *vxlan0);
-      vlib_buffer_advance (b[1], sizeof *vxlan1);
+  return vxlan6_key_decap_info (vxm, &key6, fib_index, ip6_0, vxlan0,
+				stats_sw_if_index);
+}
 
-      u32 fi0 = vlib_buffer_get_ip_fib_index (b[0], is_ip4);
-      u32 fi1 = vlib_buffer_get_ip_fib_index (b[1], is_ip4);
+typedef struct
+{
+  vlib_combined_counter_main_t *rx_counter;
+  u32 thread_index;
+  u32 pkts_dropped;
+} vxlan_decap_ctx_t;
+
+static_always_inline u16
+vxlan_decap_one (vlib_main_t * vm, vlib_node_runtime_t * node,
+		 vlib_buffer_t * b0, void *key, void *arg, u8 is_ip4)
+{
+  vxlan_main_t *vxm = &vxlan_main;
+  vxlan_decap_ctx_t *ctx = arg;
+  u32 stats_if0 = ~0;
 
-      vxlan_decap_info_t di0 = is_ip4 ?
-	vxlan4_find_tunnel (vxm, &last4, fi0, ip4_0, vxlan0, &stats_if0) :
-	vxlan6_find_tunnel (vxm, &last6, fi0, ip6_0, vxlan0, &stats_if0);
-      vxlan_decap_info_t di1 = is_ip4 ?
-	vxlan4_find_tunnel (vxm, &last4, fi1, ip4_1, vxlan1, &stats_if1) :
-	vxlan6_find_tunnel (vxm, &last6, fi1, ip6_1, vxlan1, &stats_if1);
+  /* udp leaves current_data pointing at the vxlan header */
+  void *cur0 = vlib_buffer_get_current (b0);
+  vxlan_header_t *vxlan0 = cur0;
 
-      /* Prefetch next iteration. */
-      clib_prefetch_load (b[2]->data);
-      clib_prefetch_load (b[3]->data);
+  /* pop (ip, udp, vxlan) */
+  vlib_buffer_advance (b0, sizeof (*vxlan0));
 
-      u32 len0 = vlib_buffer_length_in_chain (vm, b[0]);
-      u32 len1 = vlib_buffer_length_in_chain (vm, b[1]);
+  u32 fi0 = vlib_buffer_get_ip_fib_index (b0, is_ip4);
 
-      next[0] = di0.next_index;
-      next[1] = di1.next_index;
+  vxlan_decap_info_t di0 = is_ip4 ?
+    vxlan4_key_decap_info (vxm, key, fi0, cur0 - sizeof (udp_header_t) -
+			   sizeof (ip4_header_t), vxlan0, &stats_if0) :
+    vxlan6_key_decap_info (vxm, key, fi0, cur0 - sizeof (udp_header_t) -
+			   sizeof (ip6_header_t), vxlan0, &stats_if0);
 
-      u8 any_error = di0.error | di1.error;
-      if (PREDICT_TRUE (any_error == 0))
-	{
-	  /* Required to make the l2 tag push / pop code work on l2 subifs */
-	  vnet_update_l2_len (b[0]);
-	  vnet_update_l2_len (b[1]);
-	  /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
-	  vnet_buffer (b[0])->sw_if_index[VLIB_RX] = di0.sw_if_index;
-	  vnet_buffer (b[1])->sw_if_index[VLIB_RX] = di1.sw_if_index;
-	  vlib_increment_combined_counter (rx_counter, thread_index,
-					   stats_if0, 1, len0);
-	  vlib_increment_combined_counter (rx_counter, thread_index,
-					   stats_if1, 1, len1);
-	}
-      else
-	{
-	  if (di0.error == 0)
-	    {
-	      vnet_update_l2_len (b[0]);
-	      vnet_buffer (b[0])->sw_if_index[VLIB_RX] = di0.sw_if_index;
-	      vlib_increment_combined_counter (rx_counter, thread_index,
-					       stats_if0, 1, len0);
-	    }
-	  else
-	    {
-	      b[0]->error = node->errors[di0.error];
-	      pkts_dropped++;
-	    }
+  /* Validate VXLAN tunnel encap-fib index against packet */
+  if (di0.error == 0)
+    {
+      /* Required to make the l2 tag push / pop code work on l2 subifs */
+      vnet_update_l2_len (b0);
 
-	  if (di1.error == 0)
-	    {
-	      vnet_update_l2_len (b[1]);
-	      vnet_buffer (b[1])->sw_if_index[VLIB_RX] = di1.sw_if_index;
-	      vlib_increment_combined_counter (rx_counter, thread_index,
-					       stats_if1, 1, len1);
-	    }
-	  else
-	    {
-	      b[1]->error = node->errors[di1.error];
-	      pkts_dropped++;
-	    }
-	}
+      /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
+      vnet_buffer (b0)->sw_if_index[VLIB_RX] = di0.sw_if_index;
 
-      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
-	{
-	  vxlan_rx_trace_t *tr =
-	    vlib_add_trace (vm, node, b[0], sizeof (*tr));
-	  tr->next_index = next[0];
-	  tr->error = di0.error;
-	  tr->tunnel_index = di0.sw_if_index == ~0 ?
-	    ~0 : vxm->tunnel_index_by_sw_if_index[di0.sw_if_index];
-	  tr->vni = vnet_get_vni (vxlan0);
-	}
-      if (PREDICT_FALSE (b[1]->flags & VLIB_BUFFER_IS_TRACED))
-	{
-	  vxlan_rx_trace_t *tr =
-	    vlib_add_trace (vm, node, b[1], sizeof (*tr));
-	  tr->next_index = next[1];
-	  tr->error = di1.error;
-	  tr->tunnel_index = di1.sw_if_index == ~0 ?
-	    ~0 : vxm->tunnel_index_by_sw_if_index[di1.sw_if_index];
-	  tr->vni = vnet_get_vni (vxlan1);
-	}
-      b += 2;
-      next += 2;
-      n_left_from -= 2;
+      vlib_increment_combined_counter (ctx->rx_counter, ctx->thread_index,
+				       stats_if0, 1,
+				       vlib_buffer_length_in_chain (vm, b0));
     }
-
-  while (n_left_from > 0)
+  else
     {
-      /* udp leaves current_data pointing at the vxlan header */
-      void *cur0 = vlib_buffer_get_current (b[0]);
-      vxlan_header_t *vxlan0 = cur0;
-      ip4_header_t *ip4_0;
-      ip6_header_t *ip6_0;
-      if (is_ip4)
-	ip4_0 = cur0 - sizeof (udp_header_t) - sizeof (ip4_header_t);
-      else
-	ip6_0 = cur0 - sizeof (udp_header_t) - sizeof (ip6_header_t);
-
-      /* pop (ip, udp, vxlan) */
-      vlib_buffer_advance (b[0], sizeof (*vxlan0));
-
-      u32 fi0 = vlib_buffer_get_ip_fib_index (b[0], is_ip4);
+      b0->error = node->errors[di0.error];
+      ctx->pkts_dropped++;
+    }
 
-      vxlan_decap_info_t di0 = is_ip4 ?
-	vxlan4_find_tunnel (vxm, &last4, fi0, ip4_0, vxlan0, &stats_if0) :
-	vxlan6_find_tunnel (vxm, &last6, fi0, ip6_0, vxlan0, &stats_if0);
+  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+    {
+      vxlan_rx_trace_t *tr = vlib_add_trace (vm, node, b0, sizeof (*tr));
+      tr->next_index = di0.next_index;
+      tr->error = di0.error;
+      tr->tunnel_index = di0.sw_if_index == ~0 ?
+	~0 : vxm->tunnel_index_by_sw_if_index[di0.sw_if_index];
+      tr->vni = vnet_get_vni (vxlan0);
+    }
 
-      uword len0 = vlib_buffer_length_in_chain (vm, b[0]);
+  return di0.next_index;
+}
 
-      next[0] = di0.next_index;
+static_always_inline u16
+vxlan4_decap (vlib_main_t * vm, vlib_node_runtime_t * node,
+	      vlib_buffer_t * b0, void *key, void *ctx)
+{
+  return vxlan_decap_one (vm, node, b0, key, ctx, /* is_ip4 */ 1);
+}
 
-      /* Validate VXLAN tunnel encap-fib index against packet */
-      if (di0.error == 0)
-	{
-	  /* Required to make the l2 tag push / pop code work on l2 subifs */
-	  vnet_update_l2_len (b[0]);
+static_always_inline u16
+vxlan6_decap (vlib_main_t * vm, vlib_node_runtime_t * node,
+	      vlib_buffer_t * b0, void *key, void *ctx)
+{
+  return vxlan_decap_one (vm, node, b0, key, ctx, /* is_ip4 */ 0);
+}
 
-	  /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
-	  vnet_buffer (b[0])->sw_if_index[VLIB_RX] = di0.sw_if_index;
+always_inline uword
+vxlan_input (vlib_main_t * vm,
+	     vlib_node_runtime_t * node,
+	     vlib_frame_t * from_frame, u32 is_ip4)
+{
+  vxlan_main_t *vxm = &vxlan_main;
+  vnet_interface_main_t *im = &vxm->vnet_main->interface_main;
+  vxlan_decap_ctx_t ctx = {
+    .rx_counter = im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX,
+    .thread_index = vm->thread_index,
+  };
 
-	  vlib_increment_combined_counter (rx_counter, thread_index,
-					   stats_if0, 1, len0);
-	}
-      else
-	{
-	  b[0]->error = node->errors[di0.error];
-	  pkts_dropped++;
-	}
+  if (is_ip4)
+    udp_tunnel_decap_inline (vm, node, from_frame, &vxm->vxlan4_tunnel_by_key,
+			     /* is_ip4 */ 1, vxlan4_key, 0, vxlan4_decap, &ctx);
+  else
+    udp_tunnel_decap_inline (vm, node, from_frame, &vxm->vxlan6_tunnel_by_key,
+			     /* is_ip4 */ 0, 0, vxlan6_key, vxlan6_decap, &ctx);
 
-      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
-	{
-	  vxlan_rx_trace_t *tr
-	    = vlib_add_trace (vm, node, b[0], sizeof (*tr));
-	  tr->next_index = next[0];
-	  tr->error = di0.error;
-	  tr->tunnel_index = di0.sw_if_index == ~0 ?
-	    ~0 : vxm->tunnel_index_by_sw_if_index[di0.sw_if_index];
-	  tr->vni = vnet_get_vni (vxlan0);
-	}
-      b += 1;
-      next += 1;
-      n_left_from -= 1;
-    }
-  vlib_buffer_enqueue_to_next (vm, node, from, nexts, from_frame->n_vectors);
   /* Do we still need this now that tunnel tx stats is kept? */
   u32 node_idx = is_ip4 ? vxlan4_input_node.index : vxlan6_input_node.index;
   vlib_node_increment_counter (vm, node_idx, VXLAN_ERROR_DECAPSULATED,
-			       from_frame->n_vectors - pkts_dropped);
+			       from_frame->n_vectors - ctx.pkts_dropped);
 
   return from_frame->n_vectors;
 }
@@ -378,23 +378,20 @@ int vnet_vxlan_add_del_tunnel
   if (!is_ip6)
     {
       /* ip4 mcast is indexed by mcast addr only */
-      key4.key[0] = ip46_address_is_multicast (&a->dst) ?
-		      a->dst.ip4.as_u32 :
-		      a->dst.ip4.as_u32 | (((u64) a->src.ip4.as_u32) << 32);
-      key4.key[1] = ((u64) clib_host_to_net_u16 (a->src_port) << 48) |
-		    (((u64) a->encap_fib_index) << 32) |
-		    clib_host_to_net_u32 (a->vni << 8);
+      udp_tunnel4_key_init (
+	&key4, ip46_address_is_multicast (&a->dst) ? 0 : a->src.ip4.as_u32,
+	a->dst.ip4.as_u32, clib_host_to_net_u16 (a->src_port),
+	a->encap_fib_index, clib_host_to_net_u32 (a->vni << 8));
       not_found =
 	clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, &key4);
       p = (void *) &key4.value;
     }
   else
     {
-      key6.key[0] = a->dst.ip6.as_u64[0];
-      key6.key[1] = a->dst.ip6.as_u64[1];
-      key6.key[2] = (((u64) clib_host_to_net_u16 (a->src_port) << 48) |
-		     ((u64) a->encap_fib_index) << 32) |
-		    clib_host_to_net_u32 (a->vni << 8);
+      udp_tunnel6_key_init (&key6, &a->dst.ip6,
+			    clib_host_to_net_u16 (a->src_port),
+			    a->encap_fib_index,
+			    clib_host_to_net_u32 (a->vni << 8));
       not_found =
 	clib_bihash_search_inline_24_8 (&vxm->vxlan6_tunnel_by_key, &key6);
       p = (void *) &key6.value;
@@ -141,6 +141,15 @@ stat_segment_connect_r (const char *socket_name, stat_client_main_t * sm)
   close (mfd);
   sm->memory_size = st.st_size;
   sm->shared_header = memaddr;
+
+  if (sm->shared_header->version != STAT_SEGMENT_VERSION)
+    {
+      fprintf (stderr, "Incompatible stat segment version %lu\n",
+	       (unsigned long) sm->shared_header->version);
+      munmap (memaddr, st.st_size);
+      sm->shared_header = 0;
+      return -6;
+    }
   sm->directory_vector =
     stat_segment_adjust (sm, (void *) sm->shared_header->directory_vector);
 
@@ -218,6 +227,41 @@ stat_vec_combined_init (vlib_counter_t c)
   return v;
 }
 
+/*
+ * Copy the sums of an aggregate changed since generation, into the single
+ * thread counter vector of result.
+ */
+static void
+copy_aggregate (stat_segment_data_t *result, stat_segment_aggregate_t *a,
+		uint64_t generation, stat_client_main_t *sm)
+{
+  uint64_t *generations = stat_segment_adjust (sm, a->generations);
+  int i, n = vec_len (generations);
+
+  if (a->type == STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE)
+    {
+      counter_t *sums = stat_segment_adjust (sm, a->counters);
+      vec_validate (result->simple_counter_vec, 0);
+      if (n == 0 || !sums)
+	return;
+      vec_validate (result->simple_counter_vec[0], n - 1);
+      for (i = 0; i < n; i++)
+	if (generations[i] > generation)
+	  result->simple_counter_vec[0][i] = sums[i];
+    }
+  else
+    {
+      vlib_counter_t *sums = stat_segment_adjust (sm, a->counters);
+      vec_validate (result->combined_counter_vec, 0);
+      if (n == 0 || !sums)
+	return;
+      vec_validate (result->combined_counter_vec[0], n - 1);
+      for (i = 0; i < n; i++)
+	if (generations[i] > generation)
+	  result->combined_counter_vec[0][i] = sums[i];
+    }
+}
+
 /*
  * If index2 is specified copy out the column (the indexed value across all
  * threads), otherwise copy out all values.
@@ -230,6 +274,8 @@ copy_data (stat_segment_directory_entry_t *ep, u32 index2, char *name,
   int i;
   vlib_counter_t **combined_c;	/* Combined counter */
   counter_t **simple_c;		/* Simple counter */
+  counter_t ***histogram_c;	/* Histogram */
+  stat_segment_aggregate_t *aggregate;
   uint64_t *error_vector;
 
   assert (sm->shared_header);
@@ -270,6 +316,39 @@ copy_data (stat_segment_directory_entry_t *ep, u32 index2, char *name,
 	}
       break;
 
+    case STAT_DIR_TYPE_HISTOGRAM:
+      if (ep->data == 0)
+	break;
+      histogram_c = stat_segment_adjust (sm, ep->data);
+      result.histogram_vec = stat_vec_dup (sm, histogram_c);
+      for (i = 0; i < vec_len (histogram_c); i++)
+	{
+	  counter_t **hb = stat_segment_adjust (sm, histogram_c[i]);
+	  int j, first = 0, last = vec_len (hb);
+
+	  if (index2 != ~0)
+	    {
+	      first = index2;
+	      last = index2 + 1;
+	    }
+	  result.histogram_vec[i] = 0;
+	  for (j = first; j < last; j++)
+	    {
+	      counter_t *b = stat_segment_adjust (sm, hb[j]);
+	      vec_add1 (result.histogram_vec[i], stat_vec_dup (sm, b));
+	    }
+	}
+      break;
+
+    case STAT_DIR_TYPE_AGGREGATE:
+      /* the sums over threads, as a counter vector of a single thread */
+      aggregate = stat_segment_adjust (sm, ep->data);
+      if (!aggregate)
+	break;
+      result.type = aggregate->type;
+      copy_aggregate (&result, aggregate, 0, sm);
+      break;
+
     case STAT_DIR_TYPE_ERROR_INDEX:
       /* Gather errors from all threads into a vector */
       error_vector =
@@ -311,42 +390,86 @@ copy_data (stat_segment_directory_entry_t *ep, u32 index2, char *name,
   return result;
 }
 
-void
-stat_segment_data_free (stat_segment_data_t * res)
+static void
+stat_segment_data_free_one (stat_segment_data_t *res)
 {
-  int i, j;
-  for (i = 0; i < vec_len (res); i++)
+  int j;
+
+  switch (res->type)
     {
-      switch (res[i].type)
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+      for (j = 0; j < vec_len (res->simple_counter_vec); j++)
+	vec_free (res->simple_counter_vec[j]);
+      vec_free (res->simple_counter_vec);
+      break;
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      for (j = 0; j < vec_len (res->combined_counter_vec); j++)
+	vec_free (res->combined_counter_vec[j]);
+      vec_free (res->combined_counter_vec);
+      break;
+    case STAT_DIR_TYPE_HISTOGRAM:
+      for (j = 0; j < vec_len (res->histogram_vec); j++)
 	{
-	case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
-	  for (j = 0; j < vec_len (res[i].simple_counter_vec); j++)
-	    vec_free (res[i].simple_counter_vec[j]);
-	  vec_free (res[i].simple_counter_vec);
-	  break;
-	case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
-	  for (j = 0; j < vec_len (res[i].combined_counter_vec); j++)
-	    vec_free (res[i].combined_counter_vec[j]);
-	  vec_free (res[i].combined_counter_vec);
-	  break;
-	case STAT_DIR_TYPE_NAME_VECTOR:
-	  for (j = 0; j < vec_len (res[i].name_vector); j++)
-	    vec_free (res[i].name_vector[j]);
-	  vec_free (res[i].name_vector);
-	  break;
-	case STAT_DIR_TYPE_ERROR_INDEX:
-	  vec_free (res[i].error_vector);
-	  break;
-	case STAT_DIR_TYPE_SCALAR_INDEX:
-	  break;
-	default:
-	  assert (0);
+	  int k;
+	  for (k = 0; k < vec_len (res->histogram_vec[j]); k++)
+	    vec_free (res->histogram_vec[j][k]);
+	  vec_free (res->histogram_vec[j]);
 	}
-      free (res[i].name);
+      vec_free (res->histogram_vec);
+      break;
+    case STAT_DIR_TYPE_NAME_VECTOR:
+      for (j = 0; j < vec_len (res->name_vector); j++)
+	vec_free (res->name_vector[j]);
+      vec_free (res->name_vector);
+      break;
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      vec_free (res->error_vector);
+      break;
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+    case STAT_DIR_TYPE_EMPTY:
+    case STAT_DIR_TYPE_ILLEGAL: /* never copied */
+      break;
+    default:
+      assert (0);
     }
+  free (res->name);
+}
+
+void
+stat_segment_data_free (stat_segment_data_t * res)
+{
+  int i;
+  for (i = 0; i < vec_len (res); i++)
+    stat_segment_data_free_one (&res[i]);
   vec_free (res);
 }
 
+/*
+ * Copy out an entry, copying it again while its data is updated in place.
+ * Returns 0 on success, -1 on failure (timeout)
+ */
+static int
+copy_entry (stat_segment_data_t *result, stat_segment_directory_entry_t *ep,
+	    stat_client_main_t *sm)
+{
+  stat_segment_directory_entry_t *dp = ep;
+  uint32_t seq;
+
+  /* the data of a symlink is the data of the entry it points to */
+  if (ep->type == STAT_DIR_TYPE_SYMLINK)
+    dp = vec_elt_at_index (sm->directory_vector, ep->index1);
+
+  while (1)
+    {
+      if (stat_segment_entry_access_start (&seq, dp, sm))
+	return -1;
+      *result = copy_data (ep, ~0, 0, sm);
+      if (stat_segment_entry_access_end (seq, dp))
+	return 0;
+      stat_segment_data_free_one (result);
+    }
+}
+
 uint32_t *
 stat_segment_ls_r (uint8_t ** patterns, stat_client_main_t * sm)
 {
@@ -398,6 +521,7 @@ stat_segment_ls_r (uint8_t ** patterns, stat_client_main_t * sm)
 
   /* Update last version */
   sm->current_epoch = sa.epoch;
+  sm->current_directory_len = vec_len (counter_vec);
   return dir;
 }
 
@@ -413,7 +537,7 @@ stat_segment_dump_r (uint32_t * stats, stat_client_main_t * sm)
 {
   int i;
   stat_segment_directory_entry_t *ep;
-  stat_segment_data_t *res = 0;
+  stat_segment_data_t *res = 0, *data;
   stat_segment_access_t sa;
 
   /* Has directory been update? */
@@ -427,7 +551,13 @@ stat_segment_dump_r (uint32_t * stats, stat_client_main_t * sm)
     {
       /* Collect counter */
       ep = vec_elt_at_index (sm->directory_vector, stats[i]);
-      vec_add1 (res, copy_data (ep, ~0, 0, sm));
+      vec_add2 (res, data, 1);
+      if (copy_entry (data, ep, sm))
+	{
+	  _vec_len (res) -= 1;
+	  stat_segment_data_free (res);
+	  return 0;
+	}
     }
 
   if (stat_segment_access_end (&sa, sm))
@@ -435,6 +565,7 @@ stat_segment_dump_r (uint32_t * stats, stat_client_main_t * sm)
 
   fprintf (stderr, "Epoch changed while reading, invalid results\n");
   // TODO increase counter
+  stat_segment_data_free (res);
   return 0;
 }
 
@@ -445,6 +576,104 @@ stat_segment_dump (uint32_t * stats)
   return stat_segment_dump_r (stats, sm);
 }
 
+/*
+ * Refresh *res, the result of the previous call for the same stats, with
+ * the counters changed since *generation, the generation returned by that
+ * call. Aggregates are copied in part, only their sums changed since then,
+ * the other entries in full. Start with *res 0 and *generation 0, and
+ * start over like that after listing the stats again.
+ * Returns 0 on success, -1 when the directory changed (ls again) or on
+ * timeout, *res is freed then.
+ */
+int
+stat_segment_dump_changed_r (uint32_t *stats, stat_segment_data_t **res,
+			     uint64_t *generation, stat_client_main_t *sm)
+{
+  stat_segment_data_t *r = *res;
+  stat_segment_directory_entry_t *ep;
+  stat_segment_aggregate_t *a;
+  stat_segment_access_t sa;
+  uint64_t completed;
+  uint32_t seq;
+  int i;
+
+  /* Has directory been update? */
+  if (sm->shared_header->epoch != sm->current_epoch)
+    goto fail;
+
+  if (stat_segment_access_start (&sa, sm))
+    goto fail;
+
+  /* the sums changed after this are copied now or next time */
+  completed = __atomic_load_n (&sm->shared_header->aggregate_generation,
+			       __ATOMIC_ACQUIRE);
+
+  if (*generation == 0 || vec_len (r) != vec_len (stats))
+    {
+      stat_segment_data_free (r);
+      r = 0;
+      *generation = 0;
+      if (vec_len (stats))
+	vec_validate (r, vec_len (stats) - 1);
+    }
+
+  for (i = 0; i < vec_len (stats); i++)
+    {
+      ep = vec_elt_at_index (sm->directory_vector, stats[i]);
+      if (ep->type != STAT_DIR_TYPE_AGGREGATE)
+	{
+	  stat_segment_data_free_one (&r[i]);
+	  if (copy_entry (&r[i], ep, sm))
+	    {
+	      r[i].type = STAT_DIR_TYPE_ILLEGAL;
+	      r[i].name = 0;
+	      goto fail;
+	    }
+	  continue;
+	}
+
+      a = stat_segment_adjust (sm, ep->data);
+      if (!a)
+	goto fail;
+      if (r[i].name == 0)
+	{
+	  r[i].name = strdup (ep->name);
+	  r[i].type = a->type;
+	}
+      else if (a->generation <= *generation)
+	continue;
+
+      do
+	{
+	  if (stat_segment_entry_access_start (&seq, ep, sm))
+	    goto fail;
+	  copy_aggregate (&r[i], a, *generation, sm);
+	}
+      while (!stat_segment_entry_access_end (seq, ep));
+    }
+
+  if (!stat_segment_access_end (&sa, sm))
+    goto fail;
+
+  *res = r;
+  *generation = completed;
+  return 0;
+
+fail:
+  stat_segment_data_free (r);
+  *res = 0;
+  *generation = 0;
+  return -1;
+}
+
+int
+stat_segment_dump_changed (uint32_t *stats, stat_segment_data_t **res,
+			   uint64_t *generation)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  return stat_segment_dump_changed_r (stats, res, generation, sm);
+}
+
 /* Wrapper for accessing vectors from other languages */
 int
 stat_segment_vec_len (void *vec)
@@ -474,7 +703,7 @@ stat_segment_data_t *
 stat_segment_dump_entry_r (uint32_t index, stat_client_main_t * sm)
 {
   stat_segment_directory_entry_t *ep;
-  stat_segment_data_t *res = 0;
+  stat_segment_data_t *res = 0, *data;
   stat_segment_access_t sa;
 
   /* Has directory been update? */
@@ -486,10 +715,16 @@ stat_segment_dump_entry_r (uint32_t index, stat_client_main_t * sm)
 
   /* Collect counter */
   ep = vec_elt_at_index (sm->directory_vector, index);
-  vec_add1 (res, copy_data (ep, ~0, 0, sm));
+  vec_add2 (res, data, 1);
+  if (copy_entry (data, ep, sm))
+    {
+      vec_free (res);
+      return 0;
+    }
 
   if (stat_segment_access_end (&sa, sm))
     return res;
+  stat_segment_data_free (res);
   return 0;
 }
 
@@ -500,6 +735,31 @@ stat_segment_dump_entry (uint32_t index)
   return stat_segment_dump_entry_r (index, sm);
 }
 
+/*
+ * Entries added since the last ls do not change the epoch, pollers
+ * listing counters by pattern ls again when this returns true.
+ */
+bool
+stat_segment_directory_grown_r (stat_client_main_t *sm)
+{
+  stat_segment_access_t sa;
+  uint64_t len;
+
+  if (stat_segment_access_start (&sa, sm))
+    return false;
+  len = vec_len (get_stat_vector_r (sm));
+  if (!stat_segment_access_end (&sa, sm))
+    return false;
+  return len != sm->current_directory_len;
+}
+
+bool
+stat_segment_directory_grown (void)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  return stat_segment_directory_grown_r (sm);
+}
+
 char *
 stat_segment_index_to_name_r (uint32_t index, stat_client_main_t * sm)
 {
@@ -18,7 +18,7 @@
 #define included_stat_client_h
 
 #define STAT_VERSION_MAJOR     1
-#define STAT_VERSION_MINOR     2
+#define STAT_VERSION_MINOR     5
 
 #include <stdint.h>
 #include <unistd.h>
@@ -43,6 +43,7 @@ typedef struct
     counter_t **simple_counter_vec;
     vlib_counter_t **combined_counter_vec;
     uint8_t **name_vector;
+    counter_t ***histogram_vec;
   };
 } stat_segment_data_t;
 
@@ -53,6 +54,8 @@ typedef struct
   stat_segment_directory_entry_t *directory_vector;
   ssize_t memory_size;
   uint64_t timeout;
+  /* directory length at the last ls, entries are appended in an epoch */
+  uint64_t current_directory_len;
 } stat_client_main_t;
 
 extern stat_client_main_t stat_client_main;
@@ -72,6 +75,11 @@ uint32_t *stat_segment_ls (uint8_t ** pattern);
 stat_segment_data_t *stat_segment_dump_r (uint32_t * stats,
 					  stat_client_main_t * sm);
 stat_segment_data_t *stat_segment_dump (uint32_t * counter_vec);
+int stat_segment_dump_changed_r (uint32_t *stats, stat_segment_data_t **res,
+				 uint64_t *generation,
+				 stat_client_main_t *sm);
+int stat_segment_dump_changed (uint32_t *stats, stat_segment_data_t **res,
+			       uint64_t *generation);
 stat_segment_data_t *stat_segment_dump_entry_r (uint32_t index,
 						stat_client_main_t * sm);
 stat_segment_data_t *stat_segment_dump_entry (uint32_t index);
@@ -80,6 +88,9 @@ void stat_segment_data_free (stat_segment_data_t * res);
 double stat_segment_heartbeat_r (stat_client_main_t * sm);
 double stat_segment_heartbeat (void);
 
+bool stat_segment_directory_grown_r (stat_client_main_t *sm);
+bool stat_segment_directory_grown (void);
+
 char *stat_segment_index_to_name_r (uint32_t index, stat_client_main_t * sm);
 char *stat_segment_index_to_name (uint32_t index);
 uint64_t stat_segment_version (void);
@@ -171,6 +182,34 @@ stat_segment_access_end (stat_segment_access_t * sa, stat_client_main_t * sm)
   return true;
 }
 
+/*
+ * Within an access, the data of an entry may be updated in place, the
+ * sequence number of the entry is odd meanwhile. Copy the entry between
+ * stat_segment_entry_access_start and stat_segment_entry_access_end, and
+ * copy it again if the latter fails.
+ * Returns 0 on success, -1 on failure (timeout)
+ */
+static inline int
+stat_segment_entry_access_start (uint32_t *seq,
+				 stat_segment_directory_entry_t *ep,
+				 stat_client_main_t *sm)
+{
+  uint64_t max_time = sm->timeout ? _time_now_nsec () + sm->timeout : 0;
+
+  while ((*seq = __atomic_load_n (&ep->seq, __ATOMIC_ACQUIRE)) & 1)
+    if (max_time && _time_now_nsec () >= max_time)
+      return -1;
+  return 0;
+}
+
+static inline bool
+stat_segment_entry_access_end (uint32_t seq,
+			       stat_segment_directory_entry_t *ep)
+{
+  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+  return __atomic_load_n (&ep->seq, __ATOMIC_RELAXED) == seq;
+}
+
 #endif /* included_stat_client_h */
 
 /*
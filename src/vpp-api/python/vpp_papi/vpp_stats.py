@@ -106,7 +106,7 @@ class StatsVector:
 class VPPStats():
     '''Main class implementing Python access to the VPP statistics segment'''
     # pylint: disable=too-many-instance-attributes
-    shared_headerfmt = Struct('QPQQPP')
+    shared_headerfmt = Struct('QPQQPPQ')
     default_socketname = '/run/vpp/stats.sock'
 
     def __init__(self, socketname=default_socketname, timeout=10):
@@ -117,6 +117,7 @@ class VPPStats():
         self.connected = False
         self.size = 0
         self.last_epoch = 0
+        self.last_directory_len = 0
         self.error_vectors = 0
         self.statseg = 0
 
@@ -135,7 +136,7 @@ class VPPStats():
         os.close(mfd)
 
         self.size = stat_result.st_size
-        if self.version != 2:
+        if self.version != 3:
             raise Exception('Incompatbile stat segment version {}'
                             .format(self.version))
 
@@ -178,23 +179,54 @@ class VPPStats():
         '''Get pointer of error vector'''
         return self.shared_headerfmt.unpack_from(self.statseg)[5]
 
-    elementfmt = 'IQ128s'
+    @property
+    def aggregate_generation(self):
+        '''Get the last completed collector pass over the aggregates'''
+        return self.shared_headerfmt.unpack_from(self.statseg)[6]
+
+    @property
+    def directory_len(self):
+        '''Get number of entries in the directory vector'''
+        return get_vec_len(self, self.directory_vector - self.base)
+
+    elementfmt = 'IIQ128s'
+    ELEMENT = Struct(elementfmt)
+
+    def stale(self):
+        '''Epoch changed or entries were appended since the last refresh'''
+        return (self.last_epoch != self.epoch or
+                self.last_directory_len != self.directory_len)
 
     def refresh(self, blocking=True):
-        '''Refresh directory vector cache (epoch changed)'''
-        directory = {}
-        directory_by_idx = {}
+        '''Refresh directory vector cache (epoch changed or entries added)'''
         while True:
             try:
                 with self.lock:
+                    # within an epoch the directory only grows
+                    if self.last_epoch == self.epoch:
+                        first = self.last_directory_len
+                        directory = self.directory
+                        directory_by_idx = self.directory_by_idx
+                    else:
+                        first = 0
+                        directory = {}
+                        directory_by_idx = {}
                     self.last_epoch = self.epoch
-                    for i, direntry in enumerate(StatsVector(self, self.directory_vector, self.elementfmt)):
-                        path_raw = direntry[2].find(b'\x00')
-                        path = direntry[2][:path_raw].decode('ascii')
-                        directory[path] = StatsEntry(direntry[0], direntry[1])
+                    vector = StatsVector(self, self.directory_vector,
+                                         self.elementfmt)
+                    start = vector.vec_start + first * vector.elementsize
+                    end = vector.vec_start + vector.vec_len * vector.elementsize
+                    for i, direntry in enumerate(
+                            self.ELEMENT.iter_unpack(self.statseg[start:end]),
+                            first):
+                        path_raw = direntry[3].find(b'\x00')
+                        path = direntry[3][:path_raw].decode('ascii')
+                        directory[path] = StatsEntry(direntry[0], direntry[2],
+                                                     i)
                         directory_by_idx[i] = path
                     self.directory = directory
                     self.directory_by_idx = directory_by_idx
+                    self.last_directory_len = vector.vec_len
 
                     # Cache the error index vectors
                     self.error_vectors = []
@@ -205,15 +237,32 @@ class VPPStats():
                 if not blocking:
                     raise
 
+    def entry_seq(self, index):
+        '''Get the sequence number of a directory entry'''
+        return self.ELEMENT.unpack_from(
+            self.statseg, self.directory_vector - self.base +
+            index * self.ELEMENT.size)[1]
+
     def __getitem__(self, item, blocking=True):
         if not self.connected:
             self.connect()
         while True:
             try:
-                if self.last_epoch != self.epoch:
+                if self.stale():
                     self.refresh(blocking)
                 with self.lock:
-                    return self.directory[item].get_counter(self)
+                    # the data of an entry may be updated in place, read
+                    # the entry again and retry if it changed meanwhile
+                    index = self.directory[item].index
+                    direntry = StatsVector(self, self.directory_vector,
+                                           self.elementfmt)[index]
+                    if direntry[1] & 1:
+                        raise IOError('Entry update in progress, retry')
+                    entry = StatsEntry(direntry[0], direntry[2], index)
+                    counter = entry.get_counter(self)
+                    if self.entry_seq(index) != direntry[1]:
+                        raise IOError('Entry changed while reading, retry')
+                    return counter
             except IOError:
                 if not blocking:
                     raise
@@ -221,6 +270,32 @@ class VPPStats():
     def __iter__(self):
         return iter(self.directory.items())
 
+    def dump_changed(self, name, generation, blocking=True):
+        '''Return the sums of aggregate name changed since generation, by
+        index, and the generation to pass next time. Start with 0.'''
+        if not self.connected:
+            self.connect()
+        while True:
+            try:
+                if self.stale():
+                    self.refresh(blocking)
+                with self.lock:
+                    # sums changed after this are returned now or next time
+                    completed = self.aggregate_generation
+                    index = self.directory[name].index
+                    direntry = StatsVector(self, self.directory_vector,
+                                           self.elementfmt)[index]
+                    if direntry[1] & 1:
+                        raise IOError('Entry update in progress, retry')
+                    entry = StatsEntry(direntry[0], direntry[2], index)
+                    changed = entry.aggregate_changed(self, generation)
+                    if self.entry_seq(index) != direntry[1]:
+                        raise IOError('Entry changed while reading, retry')
+                    return changed, completed
+            except IOError:
+                if not blocking:
+                    raise
+
     def set_errors(self, blocking=True):
         '''Return dictionary of error counters > 0'''
         if not self.connected:
@@ -230,7 +305,7 @@ class VPPStats():
         result = {}
         while True:
             try:
-                if self.last_epoch != self.epoch:
+                if self.stale():
                     self.refresh(blocking)
                 with self.lock:
                     for k, entry in errors.items():
@@ -264,7 +339,7 @@ class VPPStats():
         if name.startswith("/err/"):
             while True:
                 try:
-                    if self.last_epoch != self.epoch:
+                    if self.stale():
                         self.refresh(blocking)
                     with self.lock:
                         return sum(self.directory[name].get_counter(self))
@@ -280,7 +355,7 @@ class VPPStats():
         if not isinstance(patterns, list):
             patterns = [patterns]
         regex = [re.compile(i) for i in patterns]
-        if self.last_epoch != self.epoch:
+        if self.stale():
             self.refresh()
 
         return [k for k, v in self.directory.items()
@@ -392,13 +467,63 @@ class SimpleList(list):
         '''Sum the vector'''
         return sum(self)
 
+HISTOGRAM_LOG2_SUB_BUCKETS = 2
+
+def histogram_bucket_min(bucket):
+    '''Smallest value counted in a histogram bucket, see
+    vlib_histogram_bucket_min()'''
+    if bucket < (2 << HISTOGRAM_LOG2_SUB_BUCKETS):
+        return bucket
+    shift = (bucket >> HISTOGRAM_LOG2_SUB_BUCKETS) - 1
+    return (bucket - (shift << HISTOGRAM_LOG2_SUB_BUCKETS)) << shift
+
+class StatsHistogramList(list):
+    '''Histograms 2-dimensional by thread by index of bucket counts'''
+
+    def __getitem__(self, item):
+        '''Supports partial numpy style 2d support. Slice by column [:,1]'''
+        if isinstance(item, int):
+            return list.__getitem__(self, item)
+        return HistogramColumn([row[item[1]] for row in self])
+
+class HistogramColumn(list):
+    '''The histograms of an index, for all threads'''
+
+    def sum(self):
+        '''Merge the histograms of all threads'''
+        merged = HistogramList()
+        for hist in self:
+            if len(merged) < len(hist):
+                merged.extend([0] * (len(hist) - len(merged)))
+            for i, count in enumerate(hist):
+                merged[i] += count
+        return merged
+
+class HistogramList(list):
+    '''Bucket counts of a log-linear histogram'''
+
+    def total(self):
+        '''Number of values counted'''
+        return sum(self)
+
+    def percentile(self, percent):
+        '''Lower bound of the bucket holding the given percentile'''
+        rank = self.total() * percent / 100.0
+        seen = 0
+        for bucket, count in enumerate(self):
+            seen += count
+            if count and seen >= rank:
+                return histogram_bucket_min(bucket)
+        return None
+
 class StatsEntry():
     '''An individual stats entry'''
     # pylint: disable=unused-argument,no-self-use
 
-    def __init__(self, stattype, statvalue):
+    def __init__(self, stattype, statvalue, index=None):
         self.type = stattype
         self.value = statvalue
+        self.index = index
 
         if stattype == 1:
             self.function = self.scalar
@@ -412,6 +537,10 @@ class StatsEntry():
             self.function = self.name
         elif stattype == 7:
             self.function = self.symlink
+        elif stattype == 8:
+            self.function = self.histogram
+        elif stattype == 9:
+            self.function = self.aggregate
         else:
             self.function = self.illegal
 
@@ -463,6 +592,42 @@ class StatsEntry():
         name = stats.directory_by_idx[index1]
         return stats[name][:,index2]
 
+    def histogram(self, stats):
+        '''Histogram'''
+        counter = StatsHistogramList()
+        if not self.value:
+            return counter
+        for threads in StatsVector(stats, self.value, 'P'):
+            hlist = [HistogramList(v[0] for v in StatsVector(stats, h[0], 'Q'))
+                     for h in StatsVector(stats, threads[0], 'P')]
+            counter.append(hlist)
+        return counter
+
+    AGGREGATE_FMT = Struct('IIQPP')
+    def aggregate(self, stats):
+        '''Sums over threads of a simple or combined counter'''
+        offset = self.value - stats.base
+        if offset + self.AGGREGATE_FMT.size >= stats.size:
+            raise IOError('Aggregate overruns stats segment')
+        stattype, _, _, counters, _ = self.AGGREGATE_FMT.unpack_from(
+            stats.statseg, offset)
+        if stattype == 2:
+            return SimpleList(v[0] for v in StatsVector(stats, counters, 'Q'))
+        return CombinedList(StatsTuple(v)
+                            for v in StatsVector(stats, counters, 'QQ'))
+
+    def aggregate_changed(self, stats, generation):
+        '''Sums of an aggregate changed since generation, by index'''
+        if self.type != 9:
+            raise KeyError('Not an aggregate')
+        offset = self.value - stats.base
+        generations = self.AGGREGATE_FMT.unpack_from(stats.statseg,
+                                                     offset)[4]
+        sums = self.aggregate(stats)
+        return {i: sums[i]
+                for i, g in enumerate(StatsVector(stats, generations, 'Q'))
+                if g[0] > generation}
+
     def get_counter(self, stats):
         '''Return a list of counters'''
         if stats:
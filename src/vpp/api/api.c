@@ -84,6 +84,7 @@ _(GET_NODE_INDEX, get_node_index)                                       \
 _(ADD_NODE_NEXT, add_node_next)						                    \
 _(SHOW_VERSION, show_version)						                    \
 _(SHOW_THREADS, show_threads)						                    \
+_(SHOW_CPU_TOPOLOGY, show_cpu_topology)                                 \
 _(GET_NODE_GRAPH, get_node_graph)                                       \
 _(GET_NEXT_INDEX, get_next_index)                                       \
 _(LOG_DUMP, log_dump)                                                   \
@@ -325,6 +326,60 @@ vl_api_show_threads_t_handler (vl_api_show_threads_t * mp)
 #endif
 }
 
+static void
+vl_api_show_cpu_topology_t_handler (vl_api_show_cpu_topology_t *mp)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vl_api_show_cpu_topology_reply_t *rmp;
+  vl_api_registration_t *reg;
+  vl_api_cpu_topology_t *ct;
+  vlib_cpu_topology_t *t;
+  vlib_worker_thread_t *w;
+  u32 cpu, count, thread_index;
+  int msg_size;
+
+  reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!reg)
+    return;
+
+  count = clib_bitmap_count_set_bits (tm->cpu_core_bitmap);
+  msg_size = sizeof (*rmp) + sizeof (rmp->cpus[0]) * count;
+  rmp = vl_msg_api_alloc (msg_size);
+  clib_memset (rmp, 0, msg_size);
+  rmp->_vl_msg_id = htons (VL_API_SHOW_CPU_TOPOLOGY_REPLY);
+  rmp->context = mp->context;
+  rmp->placement_auto = tm->placement_auto;
+  ct = rmp->cpus;
+
+  count = 0;
+  vec_foreach_index (cpu, tm->cpu_topology)
+    {
+      t = tm->cpu_topology + cpu;
+      if (!clib_bitmap_get (tm->cpu_core_bitmap, cpu))
+	continue;
+
+      thread_index = ~0;
+      vec_foreach (w, vlib_worker_threads)
+	if (w->lwp && w->cpu_id == cpu)
+	  {
+	    thread_index = w - vlib_worker_threads;
+	    break;
+	  }
+
+      ct->cpu_id = htonl (cpu);
+      ct->core = htonl (t->core_id);
+      ct->package = htonl (t->package_id);
+      ct->numa_node = htonl (t->numa_id);
+      ct->n_siblings = htonl (clib_bitmap_count_set_bits (t->siblings));
+      ct->thread_index = htonl (thread_index);
+      ct++;
+      count++;
+    }
+  rmp->count = htonl (count);
+
+  vl_api_send_msg (reg, (u8 *) rmp);
+}
+
 static void
 vl_api_get_node_index_t_handler (vl_api_get_node_index_t * mp)
 {
@@ -53,6 +53,11 @@ stat_poll_loop (u8 ** patterns)
 	}
 
       printf ("\033[H");	/* Cursor top left corner */
+      if (stat_segment_directory_grown ())
+	{
+	  vec_free (stats);
+	  stats = stat_segment_ls (patterns);
+	}
       res = stat_segment_dump (stats);
       if (!res)
 	{
@@ -227,6 +232,21 @@ reconnect:
 	      fformat (stdout, "%.2f %s\n", res[i].scalar_value, res[i].name);
 	      break;
 
+	    case STAT_DIR_TYPE_HISTOGRAM:
+	      for (k = 0; k < vec_len (res[i].histogram_vec); k++)
+		for (j = 0; j < vec_len (res[i].histogram_vec[k]); j++)
+		  {
+		    counter_t *h = res[i].histogram_vec[k][j];
+		    int b;
+
+		    for (b = 0; b < vec_len (h); b++)
+		      if (h[b])
+			fformat (stdout, "[%d @ %d]: %llu values >= %llu %s\n",
+				 j, k, h[b], vlib_histogram_bucket_min (b),
+				 res[i].name);
+		  }
+	      break;
+
 	    case STAT_DIR_TYPE_NAME_VECTOR:
 	      if (res[i].name_vector == 0)
 		continue;
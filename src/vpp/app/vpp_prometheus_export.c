@@ -51,16 +51,24 @@ prom_string (char *s)
 static void
 dump_metrics (FILE * stream, u8 ** patterns)
 {
-  stat_segment_data_t *res;
   int i, j, k;
   static u32 *stats = 0;
+  /* the previous scrape, refreshed with the counters changed since */
+  static stat_segment_data_t *res = 0;
+  static u64 generation = 0;
+
+  /* pick up the counters created since the last scrape */
+  if (stats == 0 || stat_segment_directory_grown ())
+    {
+      vec_free (stats);
+      stats = stat_segment_ls (patterns);
+      generation = 0;
+    }
 
 retry:
-  res = stat_segment_dump (stats);
-  if (res == 0)
+  if (stat_segment_dump_changed (stats, &res, &generation))
     {				/* Memory layout has changed */
-      if (stats)
-	vec_free (stats);
+      vec_free (stats);
       stats = stat_segment_ls (patterns);
       goto retry;
     }
@@ -96,6 +104,35 @@ retry:
 			 res[i].combined_counter_vec[k][j].bytes);
 	      }
 	  break;
+	case STAT_DIR_TYPE_HISTOGRAM:
+	  fformat (stream, "# TYPE %s histogram\n", prom_string (res[i].name));
+	  for (k = 0; k < vec_len (res[i].histogram_vec); k++)
+	    for (j = 0; j < vec_len (res[i].histogram_vec[k]); j++)
+	      {
+		counter_t *h = res[i].histogram_vec[k][j];
+		counter_t count = 0;
+		int b;
+
+		/* cumulative counts, at the upper bound of the used buckets */
+		for (b = 0; b < vec_len (h); b++)
+		  {
+		    count += h[b];
+		    if (h[b] && b < vec_len (h) - 1)
+		      fformat (stream,
+			       "%s_bucket{thread=\"%d\",index=\"%d\","
+			       "le=\"%lld\"} %lld\n",
+			       prom_string (res[i].name), k, j,
+			       vlib_histogram_bucket_min (b + 1) - 1, count);
+		  }
+		fformat (stream,
+			 "%s_bucket{thread=\"%d\",index=\"%d\",le=\"+Inf\"} "
+			 "%lld\n",
+			 prom_string (res[i].name), k, j, count);
+		fformat (stream, "%s_count{thread=\"%d\",index=\"%d\"} %lld\n",
+			 prom_string (res[i].name), k, j, count);
+	      }
+	  break;
+
 	case STAT_DIR_TYPE_ERROR_INDEX:
 	  for (j = 0; j < vec_len (res[i].error_vector); j++)
 	    {
@@ -120,8 +157,6 @@ retry:
 	  ;
 	}
     }
-  stat_segment_data_free (res);
-
 }
 
 
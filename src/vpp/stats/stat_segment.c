@@ -31,18 +31,40 @@ vlib_stat_segment_lock (void)
 {
   stat_segment_main_t *sm = &stat_segment_main;
   clib_spinlock_lock (sm->stat_segment_lockp);
-  sm->shared_header->in_progress = 1;
 }
 
 void
 vlib_stat_segment_unlock (void)
 {
   stat_segment_main_t *sm = &stat_segment_main;
-  sm->shared_header->epoch++;
-  sm->shared_header->in_progress = 0;
+
+  if (sm->directory_changed)
+    {
+      sm->shared_header->epoch++;
+      clib_atomic_fence_rel ();
+      sm->shared_header->in_progress = 0;
+      sm->directory_changed = 0;
+    }
   clib_spinlock_unlock (sm->stat_segment_lockp);
 }
 
+/*
+ * Announce a directory change readers cannot follow entry by entry,
+ * before making it, with the lock held. Appending an entry in place or
+ * updating the data of an entry in place does not need it.
+ */
+void
+vlib_stat_segment_directory_change (void)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+
+  if (sm->directory_changed)
+    return;
+  sm->directory_changed = 1;
+  sm->shared_header->in_progress = 1;
+  clib_atomic_fence_rel ();
+}
+
 /*
  * Change heap to the stats shared memory segment
  */
@@ -86,44 +108,68 @@ create_hash_index (u8 * name, u32 index)
   hash_set (sm->directory_vector_by_name, format (0, "%s%c", name, 0), index);
 }
 
-static u32
-vlib_stats_get_next_vector_index ()
-{
-  stat_segment_main_t *sm = &stat_segment_main;
-  u32 next_vector_index = vec_len (sm->directory_vector);
-
-  ssize_t i;
-  vec_foreach_index_backwards (i, sm->directory_vector)
-  {
-    if (sm->directory_vector[i].type == STAT_DIR_TYPE_EMPTY)
-      {
-	next_vector_index = i;
-	break;
-      }
-  }
-
-  return next_vector_index;
-}
-
+/*
+ * Entries are appended within the capacity of the directory vector, the
+ * entry is written before the vector length makes it visible to readers.
+ * Deleted entries are only reused, and the vector only grows, when the
+ * directory changes anyway.
+ */
 static u32
 vlib_stats_create_counter (stat_segment_directory_entry_t * e, void *oldheap)
 {
   stat_segment_main_t *sm = &stat_segment_main;
+  u32 index;
 
   ASSERT (clib_mem_get_heap () == sm->heap);
 
-  u32 index = vlib_stats_get_next_vector_index ();
+  e->seq = 0;
+  if (!vec_resize_will_expand (sm->directory_vector, 1))
+    {
+      index = vec_len (sm->directory_vector);
+      CLIB_MEM_UNPOISON (sm->directory_vector + index, sizeof (*e));
+      sm->directory_vector[index] = *e;
+      clib_atomic_store_rel_n (&_vec_len (sm->directory_vector), index + 1);
+    }
+  else
+    {
+      vlib_stat_segment_directory_change ();
+      if (vec_len (sm->directory_empty_slots))
+	{
+	  index = vec_pop (sm->directory_empty_slots);
+	  e->seq = sm->directory_vector[index].seq;
+	}
+      else
+	index = vec_len (sm->directory_vector);
+      vec_validate (sm->directory_vector, index);
+      sm->directory_vector[index] = *e;
+      sm->shared_header->directory_vector = sm->directory_vector;
+    }
 
   clib_mem_set_heap (oldheap);
   create_hash_index ((u8 *) e->name, index);
   clib_mem_set_heap (sm->heap);
 
-  vec_validate (sm->directory_vector, index);
-  sm->directory_vector[index] = *e;
-
   return index;
 }
 
+static void
+vlib_stats_empty_entry (u32 index)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  stat_segment_directory_entry_t *e = &sm->directory_vector[index];
+  u32 seq = e->seq;
+  void *oldheap;
+
+  vlib_stat_segment_directory_change ();
+  memset (e, 0, sizeof (*e));
+  e->type = STAT_DIR_TYPE_EMPTY;
+  e->seq = seq;
+
+  oldheap = clib_mem_set_heap (sm->heap);
+  vec_add1 (sm->directory_empty_slots, index);
+  clib_mem_set_heap (oldheap);
+}
+
 static void
 vlib_stats_delete_counter (u32 index, void *oldheap)
 {
@@ -141,8 +187,7 @@ vlib_stats_delete_counter (u32 index, void *oldheap)
   hash_unset (sm->directory_vector_by_name, &e->name);
   clib_mem_set_heap (sm->heap);
 
-  memset (e, 0, sizeof (*e));
-  e->type = STAT_DIR_TYPE_EMPTY;
+  vlib_stats_empty_entry (index);
 }
 
 /*
@@ -170,11 +215,7 @@ vlib_stats_delete_cm (void *cm_arg)
   e = &sm->directory_vector[index];
   hash_unset (sm->directory_vector_by_name, &e->name);
 
-  void *oldheap = clib_mem_set_heap (sm->heap);	/* Enter stats segment */
-  clib_mem_set_heap (oldheap);	/* Exit stats segment */
-
-  memset (e, 0, sizeof (*e));
-  e->type = STAT_DIR_TYPE_EMPTY;
+  vlib_stats_empty_entry (index);
 
   vlib_stat_segment_unlock ();
 }
@@ -215,14 +256,18 @@ vlib_stats_pop_heap (void *cm_arg, void *oldheap, u32 cindex,
     {				/* New */
       strncpy (e.name, stat_segment_name, 128 - 1);
       e.type = type;
-      vector_index = vlib_stats_create_counter (&e, oldheap);
+      e.data = cm->counters;
+      vlib_stats_create_counter (&e, oldheap);
+    }
+  else
+    {
+      /* the per-thread counter vectors moved, readers copy them again */
+      stat_segment_directory_entry_t *ep =
+	&sm->directory_vector[vector_index];
+      stat_segment_entry_update_start (ep);
+      ep->data = cm->counters;
+      stat_segment_entry_update_end (ep);
     }
-
-  stat_segment_directory_entry_t *ep = &sm->directory_vector[vector_index];
-  ep->data = cm->counters;
-
-  /* Reset the client hash table pointer, since it WILL change! */
-  shared_header->directory_vector = sm->directory_vector;
 
   vlib_stat_segment_unlock ();
   clib_mem_set_heap (oldheap);
@@ -269,10 +314,7 @@ vlib_stats_register_symlink (void *oldheap, u8 *name, u32 index1, u32 index2,
       e.type = STAT_DIR_TYPE_SYMLINK;
       e.index1 = index1;
       e.index2 = index2;
-      vector_index = vlib_stats_create_counter (&e, oldheap);
-
-      /* Warn clients to refresh any pointers they might be holding */
-      shared_header->directory_vector = sm->directory_vector;
+      vlib_stats_create_counter (&e, oldheap);
     }
 
   if (lock)
@@ -296,6 +338,7 @@ vlib_stats_rename_symlink (void *oldheap, u64 index, u8 *new_name)
   hash_unset (sm->directory_vector_by_name, &e->name);
   clib_mem_set_heap (sm->heap);
 
+  vlib_stat_segment_directory_change ();
   strncpy (e->name, (char *) new_name, 128 - 1);
   clib_mem_set_heap (oldheap);
   hash_set (sm->directory_vector_by_name, &e->name, index);
@@ -324,10 +367,7 @@ vlib_stats_register_error_index (void *oldheap, u8 * name, u64 * em_vec,
       e.name[vec_len (name)] = '\0';
       e.type = STAT_DIR_TYPE_ERROR_INDEX;
       e.index = index;
-      vector_index = vlib_stats_create_counter (&e, oldheap);
-
-      /* Warn clients to refresh any pointers they might be holding */
-      shared_header->directory_vector = sm->directory_vector;
+      vlib_stats_create_counter (&e, oldheap);
     }
 
   vlib_stat_segment_unlock ();
@@ -344,11 +384,14 @@ stat_validate_counter_vector2 (stat_segment_directory_entry_t *ep, u32 max1,
 {
   counter_t **counters = ep->data;
   int i;
+
+  stat_segment_entry_update_start (ep);
   vec_validate_aligned (counters, max1, CLIB_CACHE_LINE_BYTES);
   for (i = 0; i <= max1; i++)
     vec_validate_aligned (counters[i], max2, CLIB_CACHE_LINE_BYTES);
 
   ep->data = counters;
+  stat_segment_entry_update_end (ep);
 }
 
 static void
@@ -371,12 +414,16 @@ vlib_stats_pop_heap2 (u64 * error_vector, u32 thread_index, void *oldheap,
   if (lock)
     vlib_stat_segment_lock ();
 
-  /* Reset the client hash table pointer, since it WILL change! */
-  vec_validate (sm->error_vector, thread_index);
-  sm->error_vector[thread_index] = error_vector;
-
-  shared_header->error_vector = sm->error_vector;
-  shared_header->directory_vector = sm->directory_vector;
+  /* Error counters growing in place are read by index, moved ones are
+   * only safe to read in a new epoch */
+  if (thread_index >= vec_len (sm->error_vector) ||
+      sm->error_vector[thread_index] != error_vector)
+    {
+      vlib_stat_segment_directory_change ();
+      vec_validate (sm->error_vector, thread_index);
+      sm->error_vector[thread_index] = error_vector;
+      shared_header->error_vector = sm->error_vector;
+    }
 
   if (lock)
     vlib_stat_segment_unlock ();
@@ -410,9 +457,6 @@ stat_segment_new_entry (u8 *name, stat_directory_type_t t)
   oldheap = vlib_stats_push_heap (NULL);
   vlib_stat_segment_lock ();
   vector_index = vlib_stats_create_counter (&e, oldheap);
-
-  shared_header->directory_vector = sm->directory_vector;
-
   vlib_stat_segment_unlock ();
   clib_mem_set_heap (oldheap);
 
@@ -488,6 +532,10 @@ vlib_map_stat_segment_init (void)
     /* Save the vector in the shared segment, for clients */
     shared_header->directory_vector = sm->directory_vector;
 
+  sm->node_clocks_histogram.n_buckets = vlib_histogram_n_buckets (1ULL << 32);
+  sm->node_vectors_histogram.n_buckets =
+    vlib_histogram_n_buckets (VLIB_FRAME_SIZE);
+
   clib_mem_set_heap (oldheap);
 
   vlib_stats_register_mem_heap (heap);
@@ -541,6 +589,14 @@ format_stat_dir_entry (u8 * s, va_list * args)
       type_name = "Symlink";
       break;
 
+    case STAT_DIR_TYPE_HISTOGRAM:
+      type_name = "Histogram";
+      break;
+
+    case STAT_DIR_TYPE_AGGREGATE:
+      type_name = "Aggregate";
+      break;
+
     default:
       type_name = "illegal!";
       break;
@@ -608,8 +664,80 @@ VLIB_CLI_COMMAND (show_stat_segment_command, static) =
  * total_vectors
  * total_calls
  * total suspends
+ * clocks and vectors histograms [threads][node-index][bucket]
  */
 
+/*
+ * Node runtime perf callback, records the clocks and vectors of each node
+ * call in the histograms of the calling thread. The nodes the histograms
+ * do not cover yet are skipped, the histograms are only extended under
+ * the barrier.
+ */
+static void
+stat_segment_node_histograms_callback (
+  vlib_node_runtime_perf_callback_data_t *data,
+  vlib_node_runtime_perf_callback_args_t *args)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  u32 thread_index = args->vm->thread_index;
+  u32 node_index = args->node->node_index;
+
+  if (args->call_type == VLIB_NODE_RUNTIME_PERF_BEFORE)
+    {
+      data->u[0].u = args->cpu_time_now;
+      return;
+    }
+
+  if (args->call_type != VLIB_NODE_RUNTIME_PERF_AFTER ||
+      node_index >= vec_len (sm->node_clocks_histogram.counters[thread_index]))
+    return;
+
+  vlib_histogram_add (&sm->node_clocks_histogram, thread_index, node_index,
+		      args->cpu_time_now - data->u[0].u);
+  vlib_histogram_add (&sm->node_vectors_histogram, thread_index, node_index,
+		      args->packets);
+}
+
+/*
+ * Must be called on the stat segment heap, with the workers stopped at the
+ * barrier.
+ */
+static void
+stat_validate_node_histogram (stat_segment_directory_entry_t *ep,
+			      vlib_histogram_main_t *hm, u32 max)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  int i, j;
+
+  stat_segment_entry_update_start (ep);
+  vec_validate_aligned (hm->counters, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    {
+      vec_validate_aligned (hm->counters[i], max, CLIB_CACHE_LINE_BYTES);
+      for (j = 0; j <= max; j++)
+	vec_validate_aligned (hm->counters[i][j], hm->n_buckets - 1,
+			      CLIB_CACHE_LINE_BYTES);
+    }
+
+  ep->data = hm->counters;
+  stat_segment_entry_update_end (ep);
+}
+
+static void
+stat_segment_node_histograms_enable (void)
+{
+  int i;
+
+  for (i = 0; i < vlib_get_n_threads (); i++)
+    {
+      vlib_main_t *ovm = vlib_get_main_by_index (i);
+      clib_callback_data_enable_disable (
+	&ovm->vlib_node_runtime_perf_callbacks,
+	stat_segment_node_histograms_callback, 1 /* enable */);
+    }
+}
+
 static inline void
 update_node_counters (stat_segment_main_t * sm)
 {
@@ -630,6 +758,11 @@ update_node_counters (stat_segment_main_t * sm)
    */
   if (l > no_max_nodes)
     {
+      vlib_main_t *vm = vlib_get_main ();
+
+      /* the workers write their histograms as they dispatch */
+      vlib_worker_thread_barrier_sync (vm);
+
       void *oldheap = clib_mem_set_heap (sm->heap);
       vlib_stat_segment_lock ();
 
@@ -641,10 +774,17 @@ update_node_counters (stat_segment_main_t * sm)
 	&sm->directory_vector[STAT_COUNTER_NODE_CALLS], l - 1);
       stat_validate_counter_vector (
 	&sm->directory_vector[STAT_COUNTER_NODE_SUSPENDS], l - 1);
+      stat_validate_node_histogram (
+	&sm->directory_vector[STAT_COUNTER_NODE_CLOCKS_HISTOGRAM],
+	&sm->node_clocks_histogram, l - 1);
+      stat_validate_node_histogram (
+	&sm->directory_vector[STAT_COUNTER_NODE_VECTORS_HISTOGRAM],
+	&sm->node_vectors_histogram, l - 1);
 
-      vec_validate (sm->nodes, l - 1);
       stat_segment_directory_entry_t *ep;
       ep = &sm->directory_vector[STAT_COUNTER_NODE_NAMES];
+      stat_segment_entry_update_start (ep);
+      vec_validate (sm->nodes, l - 1);
       ep->data = sm->nodes;
 
       /* Update names dictionary */
@@ -668,9 +808,16 @@ update_node_counters (stat_segment_main_t * sm)
 	  foreach_stat_segment_node_counter_name
 #undef _
 	}
+      /* registering symlinks may have moved the directory */
+      ep = &sm->directory_vector[STAT_COUNTER_NODE_NAMES];
+      stat_segment_entry_update_end (ep);
       vec_free (symlink_name);
       vlib_stat_segment_unlock ();
       clib_mem_set_heap (oldheap);
+      vlib_worker_thread_barrier_release (vm);
+
+      if (no_max_nodes == 0)
+	stat_segment_node_histograms_enable ();
       no_max_nodes = l;
     }
 
@@ -739,6 +886,201 @@ update_node_counters (stat_segment_main_t * sm)
   vec_free (stat_vms);
 }
 
+/*
+ * Aggregates: the simple and combined counter vectors with a name starting
+ * with one of the configured prefixes are summed over threads into an
+ * aggregate entry named after them, see stat_segment_aggregate_t.
+ */
+#define STAT_SEGMENT_AGGREGATE_PREFIX "/aggregate"
+
+static int
+stat_segment_aggregate_match (stat_segment_main_t *sm,
+			      stat_segment_directory_entry_t *ep)
+{
+  u8 **prefix;
+
+  if (ep->type != STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE &&
+      ep->type != STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED)
+    return 0;
+
+  vec_foreach (prefix, sm->aggregate_prefixes)
+    if (!strncmp (ep->name, (char *) prefix[0],
+		  strlen ((char *) prefix[0])))
+      return 1;
+  return 0;
+}
+
+static void
+stat_segment_aggregate_add (stat_segment_main_t *sm, u32 source_index)
+{
+  stat_segment_directory_entry_t *src = &sm->directory_vector[source_index];
+  stat_segment_directory_entry_t e = { 0 };
+  stat_segment_aggregate_t *a;
+  void *oldheap;
+  u32 index;
+  u8 *name;
+
+  name = format (0, STAT_SEGMENT_AGGREGATE_PREFIX "%s%c", src->name, 0);
+  if (vec_len (name) > sizeof (e.name) ||
+      lookup_hash_index (name) != STAT_SEGMENT_INDEX_INVALID)
+    {
+      vec_free (name);
+      return;
+    }
+  strcpy (e.name, (char *) name);
+  e.type = STAT_DIR_TYPE_AGGREGATE;
+  vec_free (name);
+
+  oldheap = clib_mem_set_heap (sm->heap);
+  a = clib_mem_alloc (sizeof (*a));
+  clib_memset (a, 0, sizeof (*a));
+  a->type = src->type;
+  a->source_index = source_index;
+  e.data = a;
+
+  vlib_stat_segment_lock ();
+  index = vlib_stats_create_counter (&e, oldheap);
+  vlib_stat_segment_unlock ();
+  clib_mem_set_heap (oldheap);
+
+  vec_add1 (sm->aggregates, index);
+}
+
+static void
+stat_segment_aggregate_del (stat_segment_main_t *sm, u32 i)
+{
+  u32 index = sm->aggregates[i];
+  stat_segment_aggregate_t *a = sm->directory_vector[index].data;
+  void *oldheap = clib_mem_set_heap (sm->heap);
+
+  vlib_stat_segment_lock ();
+  vlib_stats_delete_counter (index, oldheap);
+  vec_free (a->counters);
+  vec_free (a->generations);
+  clib_mem_free (a);
+  vlib_stat_segment_unlock ();
+  clib_mem_set_heap (oldheap);
+
+  vec_del1 (sm->aggregates, i);
+}
+
+/*
+ * Sum the source of an aggregate over threads, the sums that changed are
+ * stamped with generation.
+ */
+static void
+stat_segment_aggregate_update (stat_segment_main_t *sm,
+			       stat_segment_directory_entry_t *ep,
+			       u64 generation)
+{
+  stat_segment_aggregate_t *a = ep->data;
+  void *data = sm->directory_vector[a->source_index].data;
+  u32 i, j, n = 0;
+  void *oldheap;
+
+  oldheap = clib_mem_set_heap (sm->heap);
+  vlib_stat_segment_lock ();
+  stat_segment_entry_update_start (ep);
+
+  if (a->type == STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE)
+    {
+      counter_t **c = data, *sums = a->counters, sum;
+
+      for (j = 0; j < vec_len (c); j++)
+	n = clib_max (n, vec_len (c[j]));
+      if (n)
+	{
+	  vec_validate_aligned (sums, n - 1, CLIB_CACHE_LINE_BYTES);
+	  vec_validate (a->generations, n - 1);
+	  a->counters = sums;
+	}
+      for (i = 0; i < n; i++)
+	{
+	  sum = 0;
+	  for (j = 0; j < vec_len (c); j++)
+	    if (i < vec_len (c[j]))
+	      sum += c[j][i];
+	  if (sum != sums[i])
+	    {
+	      sums[i] = sum;
+	      a->generations[i] = a->generation = generation;
+	    }
+	}
+    }
+  else
+    {
+      vlib_counter_t **c = data, *sums = a->counters, sum;
+
+      for (j = 0; j < vec_len (c); j++)
+	n = clib_max (n, vec_len (c[j]));
+      if (n)
+	{
+	  vec_validate_aligned (sums, n - 1, CLIB_CACHE_LINE_BYTES);
+	  vec_validate (a->generations, n - 1);
+	  a->counters = sums;
+	}
+      for (i = 0; i < n; i++)
+	{
+	  sum.packets = sum.bytes = 0;
+	  for (j = 0; j < vec_len (c); j++)
+	    if (i < vec_len (c[j]))
+	      {
+		sum.packets += c[j][i].packets;
+		sum.bytes += c[j][i].bytes;
+	      }
+	  if (sum.packets != sums[i].packets || sum.bytes != sums[i].bytes)
+	    {
+	      sums[i] = sum;
+	      a->generations[i] = a->generation = generation;
+	    }
+	}
+    }
+
+  stat_segment_entry_update_end (ep);
+  vlib_stat_segment_unlock ();
+  clib_mem_set_heap (oldheap);
+}
+
+static void
+stat_segment_aggregates_update (stat_segment_main_t *sm)
+{
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  u64 generation = shared_header->aggregate_generation + 1;
+  stat_segment_directory_entry_t *ep, *src;
+  stat_segment_aggregate_t *a;
+  u32 n;
+  int i;
+
+  /* drop the aggregates of deleted or reused counter vectors */
+  for (i = vec_len (sm->aggregates) - 1; i >= 0; i--)
+    {
+      ep = &sm->directory_vector[sm->aggregates[i]];
+      a = ep->data;
+      src = &sm->directory_vector[a->source_index];
+      if (src->type != a->type ||
+	  strcmp (src->name,
+		  ep->name + strlen (STAT_SEGMENT_AGGREGATE_PREFIX)))
+	stat_segment_aggregate_del (sm, i);
+    }
+
+  /* within an epoch, only the entries appended since the last scan */
+  if (sm->aggregate_scan_epoch != shared_header->epoch)
+    sm->aggregate_scan_len = 0;
+  n = vec_len (sm->directory_vector);
+  for (i = sm->aggregate_scan_len; i < n; i++)
+    if (stat_segment_aggregate_match (sm, &sm->directory_vector[i]))
+      stat_segment_aggregate_add (sm, i);
+  sm->aggregate_scan_len = n;
+  sm->aggregate_scan_epoch = shared_header->epoch;
+
+  for (i = 0; i < vec_len (sm->aggregates); i++)
+    stat_segment_aggregate_update (
+      sm, &sm->directory_vector[sm->aggregates[i]], generation);
+
+  /* readers copying the sums changed since this pass miss none */
+  clib_atomic_store_rel_n (&shared_header->aggregate_generation, generation);
+}
+
 static void
 do_stat_segment_updates (vlib_main_t *vm, stat_segment_main_t *sm)
 {
@@ -785,6 +1127,9 @@ do_stat_segment_updates (vlib_main_t *vm, stat_segment_main_t *sm)
     }
   /* *INDENT-ON* */
 
+  if (vec_len (sm->aggregate_prefixes))
+    stat_segment_aggregates_update (sm);
+
   /* Heartbeat, so clients detect we're still here */
   sm->directory_vector[STAT_COUNTER_HEARTBEAT].value++;
 }
@@ -971,6 +1316,7 @@ static clib_error_t *
 statseg_config (vlib_main_t * vm, unformat_input_t * input)
 {
   stat_segment_main_t *sm = &stat_segment_main;
+  u8 *prefix;
   sm->update_interval = 10.0;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
@@ -992,6 +1338,8 @@ statseg_config (vlib_main_t * vm, unformat_input_t * input)
 	sm->node_counters_enabled = 0;
       else if (unformat (input, "update-interval %f", &sm->update_interval))
 	;
+      else if (unformat (input, "aggregate %s", &prefix))
+	vec_add1 (sm->aggregate_prefixes, prefix);
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
@@ -1021,9 +1369,12 @@ statseg_sw_interface_add_del (vnet_main_t * vnm, u32 sw_if_index, u32 is_add)
   u8 *symlink_name = 0;
   u32 vector_index;
 
+  stat_segment_directory_entry_t *ep;
   void *oldheap = vlib_stats_push_heap (sm->interfaces);
   vlib_stat_segment_lock ();
 
+  ep = &sm->directory_vector[STAT_COUNTER_INTERFACE_NAMES];
+  stat_segment_entry_update_start (ep);
   vec_validate (sm->interfaces, sw_if_index);
 
   ASSERT (si_sup->type == VNET_SW_INTERFACE_TYPE_HARDWARE);
@@ -1071,9 +1422,10 @@ statseg_sw_interface_add_del (vnet_main_t * vnm, u32 sw_if_index, u32 is_add)
 	  vec_free (symlink_name);
     }
 
-  stat_segment_directory_entry_t *ep;
+  /* registering symlinks may have moved the directory */
   ep = &sm->directory_vector[STAT_COUNTER_INTERFACE_NAMES];
   ep->data = sm->interfaces;
+  stat_segment_entry_update_end (ep);
 
   vlib_stat_segment_unlock ();
   clib_mem_set_heap (oldheap);
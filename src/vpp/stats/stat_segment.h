@@ -31,6 +31,8 @@ typedef enum
   STAT_COUNTER_NODE_VECTORS,
   STAT_COUNTER_NODE_CALLS,
   STAT_COUNTER_NODE_SUSPENDS,
+  STAT_COUNTER_NODE_CLOCKS_HISTOGRAM,
+  STAT_COUNTER_NODE_VECTORS_HISTOGRAM,
   STAT_COUNTER_INTERFACE_NAMES,
   STAT_COUNTER_NODE_NAMES,
   STAT_COUNTERS
@@ -41,7 +43,9 @@ typedef enum
   _ (NODE_CLOCKS, COUNTER_VECTOR_SIMPLE, clocks, /sys/node)                   \
   _ (NODE_VECTORS, COUNTER_VECTOR_SIMPLE, vectors, /sys/node)                 \
   _ (NODE_CALLS, COUNTER_VECTOR_SIMPLE, calls, /sys/node)                     \
-  _ (NODE_SUSPENDS, COUNTER_VECTOR_SIMPLE, suspends, /sys/node)
+  _ (NODE_SUSPENDS, COUNTER_VECTOR_SIMPLE, suspends, /sys/node)               \
+  _ (NODE_CLOCKS_HISTOGRAM, HISTOGRAM, clocks_histogram, /sys/node)           \
+  _ (NODE_VECTORS_HISTOGRAM, HISTOGRAM, vectors_histogram, /sys/node)
 
 #define foreach_stat_segment_counter_name                                     \
   _ (NUM_WORKER_THREADS, SCALAR_INDEX, num_worker_threads, /sys)              \
@@ -57,8 +61,9 @@ typedef enum
 /* Default stat segment 32m */
 #define STAT_SEGMENT_DEFAULT_SIZE	(32<<20)
 
-/* Shared segment memory layout version */
-#define STAT_SEGMENT_VERSION		2
+/* Shared segment memory layout version, 3 adds entry sequence numbers,
+   appends without an epoch change and aggregate entries */
+#define STAT_SEGMENT_VERSION		3
 
 #define STAT_SEGMENT_INDEX_INVALID	UINT32_MAX
 
@@ -78,10 +83,22 @@ typedef struct
   /* statistics segment */
   uword *directory_vector_by_name;
   stat_segment_directory_entry_t *directory_vector;
+  /* deleted entries, reused when appending would move the directory */
+  u32 *directory_empty_slots;
+  /* a change under the lock bumps the epoch on unlock */
+  u8 directory_changed;
   volatile u64 **error_vector;
   u8 **interfaces;
   u8 **nodes;
 
+  /* counter vectors summed over threads, by name prefix */
+  u8 **aggregate_prefixes;
+  /* directory indices of the aggregate entries */
+  u32 *aggregates;
+  /* directory scanned for new counter vectors up to, in epoch */
+  u32 aggregate_scan_len;
+  u64 aggregate_scan_epoch;
+
   /* Update interval */
   f64 update_interval;
 
@@ -91,6 +108,9 @@ typedef struct
   ssize_t memory_size;
   clib_mem_page_sz_t log2_page_sz;
   u8 node_counters_enabled;
+  /* per-call node clocks and vectors, written by each thread */
+  vlib_histogram_main_t node_clocks_histogram;
+  vlib_histogram_main_t node_vectors_histogram;
   void *last;
   void *heap;
   stat_segment_shared_header_t *shared_header;	/* pointer to shared memory segment */
@@ -118,9 +138,27 @@ u32 stat_segment_new_entry (u8 *name, stat_directory_type_t t);
 void vlib_stats_register_mem_heap (clib_mem_heap_t *heap);
 void vlib_stat_segment_lock (void);
 void vlib_stat_segment_unlock (void);
+void vlib_stat_segment_directory_change (void);
 void vlib_stats_register_symlink (void *oldheap, u8 *name, u32 index1,
 				  u32 index2, u8 lock);
 
 void stat_provider_register_vector_rate (u32 num_workers);
 
+/*
+ * Update the data of a directory entry in place, under the stat segment
+ * lock. Readers copying the entry meanwhile retry that entry only.
+ */
+static_always_inline void
+stat_segment_entry_update_start (stat_segment_directory_entry_t *ep)
+{
+  ep->seq++;
+  clib_atomic_fence_rel ();
+}
+
+static_always_inline void
+stat_segment_entry_update_end (stat_segment_directory_entry_t *ep)
+{
+  clib_atomic_store_rel_n (&ep->seq, ep->seq + 1);
+}
+
 #endif
@@ -100,7 +100,9 @@ vlib_stats_register_mem_heap (clib_mem_heap_t *heap)
 
   vlib_stat_segment_lock ();
   stat_segment_directory_entry_t *ep = &sm->directory_vector[mem_vector_index];
+  stat_segment_entry_update_start (ep);
   ep->data = stat_validate_counter_vector3 (ep->data, 0, STAT_MEM_RELEASABLE);
+  stat_segment_entry_update_end (ep);
 
   /* Create symlink */
   void *oldheap = clib_mem_set_heap (sm->heap);
@@ -193,6 +195,8 @@ stat_provider_register_vector_rate (u32 num_workers)
   stat_segment_main_t *sm = &stat_segment_main;
   vlib_stat_segment_lock ();
   stat_segment_directory_entry_t *ep = &sm->directory_vector[i];
+  stat_segment_entry_update_start (ep);
   ep->data = stat_validate_counter_vector3 (ep->data, num_workers, 0);
+  stat_segment_entry_update_end (ep);
   vlib_stat_segment_unlock ();
 }
@@ -26,11 +26,19 @@ typedef enum
   STAT_DIR_TYPE_NAME_VECTOR,
   STAT_DIR_TYPE_EMPTY,
   STAT_DIR_TYPE_SYMLINK,
+  /* per-thread vector of per-object vectors of log-linear histogram bucket
+   * counters, see vlib_histogram_bucket */
+  STAT_DIR_TYPE_HISTOGRAM,
+  /* sums over threads of a counter vector, see stat_segment_aggregate_t */
+  STAT_DIR_TYPE_AGGREGATE,
 } stat_directory_type_t;
 
 typedef struct
 {
   stat_directory_type_t type;
+  /* odd while the data of the entry is updated in place, readers copying
+   * the entry retry if it changed */
+  uint32_t seq;
   union {
     struct
     {
@@ -44,8 +52,30 @@ typedef struct
   char name[128]; // TODO change this to pointer to "somewhere"
 } stat_segment_directory_entry_t;
 
+/*
+ * Data of an aggregate entry, maintained by the stats collector: the sums
+ * over threads of the simple or combined counter vector at source_index,
+ * and for each sum the collector pass (generation) that last changed it.
+ * Readers copy the sums changed since the last pass they have seen, see
+ * aggregate_generation in the shared header.
+ */
+typedef struct
+{
+  stat_directory_type_t type; /* of the source, simple or combined */
+  uint32_t source_index;
+  uint64_t generation; /* last pass changing any of the sums */
+  void *counters;      /* counter_t or vlib_counter_t vector */
+  uint64_t *generations;
+} stat_segment_aggregate_t;
+
 /*
  * Shared header first in the shared memory segment.
+ *
+ * The epoch changes, with in_progress set during the change, when entries
+ * are deleted, renamed or reused, or when the directory or error vectors
+ * move. Entries appended within the directory vector capacity and entry
+ * data updated in place (see seq) leave it alone, the directory only grows
+ * between two epochs.
  */
 typedef struct
 {
@@ -55,6 +85,8 @@ typedef struct
   volatile uint64_t in_progress;
   volatile stat_segment_directory_entry_t *directory_vector;
   volatile uint64_t **error_vector;
+  /* last completed collector pass over the aggregate entries */
+  volatile uint64_t aggregate_generation;
 } stat_segment_shared_header_t;
 
 static inline void *
@@ -455,7 +455,9 @@ class VppTestCase(CPUInterface, unittest.TestCase):
             "cpu", "{", "main-core", str(cls.cpus[0]), ]
         if cls.get_vpp_worker_count():
             cls.vpp_cmdline.extend([
-                "corelist-workers", ",".join([str(x) for x in cls.cpus[1:]])])
+                "corelist-workers", ",".join(
+                    [str(x) for x in
+                     cls.cpus[1:1 + cls.get_vpp_worker_count()]])])
         cls.vpp_cmdline.extend([
             "}",
             "physmem", "{", "max-size", "32m", "}",
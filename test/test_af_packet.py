@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+
+import os
+import subprocess
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestAfPacket(VppTestCase):
+    """ Host interface (AF_PACKET) Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestAfPacket, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestAfPacket, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestAfPacket, self).setUp()
+        self.host_if = "vppafp%u" % os.getpid()
+        self.peer_if = "hstafp%u" % os.getpid()
+        try:
+            self.ip("link", "add", self.host_if, "type", "veth",
+                    "peer", "name", self.peer_if)
+        except (OSError, subprocess.CalledProcessError):
+            self.skipTest("cannot create a veth pair")
+        self.ip("addr", "add", "198.51.100.1/30", "dev", self.peer_if)
+        self.ip("link", "set", self.peer_if, "up")
+
+    def tearDown(self):
+        super(TestAfPacket, self).tearDown()
+        if not self.vpp_dead:
+            for ifc in self.vapi.af_packet_dump():
+                self.vapi.af_packet_delete(host_if_name=ifc.host_if_name)
+        subprocess.call(["ip", "link", "del", self.host_if])
+
+    def ip(self, *args):
+        subprocess.run(["ip"] + list(args), check=True,
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    def ping_host(self, **kwargs):
+        reply = self.vapi.af_packet_create_v2(host_if_name=self.host_if,
+                                              use_random_hw_addr=True,
+                                              **kwargs)
+        sw_if_index = reply.sw_if_index
+        self.vapi.sw_interface_set_flags(sw_if_index, flags=1)
+        self.vapi.sw_interface_add_del_address(sw_if_index=sw_if_index,
+                                               prefix="198.51.100.2/30")
+
+        # the first packets are lost to address resolution
+        self.vapi.cli("ping 198.51.100.1 repeat 2")
+        reply = self.vapi.cli("ping 198.51.100.1 repeat 5")
+        self.logger.info(reply)
+        self.assertIn("5 received", reply)
+        return self.vapi.cli("show hardware-interfaces host-%s" %
+                             self.host_if)
+
+    def test_af_packet_tx_v3(self):
+        """ Host interface with the default tx ring """
+        hw = self.ping_host(num_rx_queues=2, num_tx_queues=2)
+        self.logger.info(hw)
+        # TPACKET_V2 when the kernel has no TPACKET_V3 tx ring
+        self.assertIn("tx ring v", hw)
+        self.assertIn("num rx queues 2, num tx queues 2", hw)
+
+    def test_af_packet_tx_v2(self):
+        """ Host interface with a TPACKET_V2 tx ring """
+        hw = self.ping_host(num_rx_queues=1, num_tx_queues=1,
+                            use_tx_ring_v2=True)
+        self.logger.info(hw)
+        self.assertIn("tx ring v2", hw)
+
+    def test_af_packet_tx_v2_queues(self):
+        """ Host interface with several queues and TPACKET_V2 tx rings """
+        hw = self.ping_host(num_rx_queues=2, num_tx_queues=2,
+                            use_tx_ring_v2=True)
+        self.logger.info(hw)
+        self.assertIn("tx ring v2", hw)
+        self.assertIn("num rx queues 2, num tx queues 2", hw)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
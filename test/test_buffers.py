@@ -6,6 +6,12 @@ from framework import VppTestCase
 class TestBuffers(VppTestCase):
     """ Buffer C Unit Tests """
 
+    extra_vpp_punt_config = ["buffers", "{",
+                             "size-class", "data-size", "256",
+                             "buffers", "1024",
+                             "size-class", "data-size", "9216",
+                             "buffers", "256", "}"]
+
     @classmethod
     def setUpClass(cls):
         super(TestBuffers, cls).setUpClass()
@@ -27,3 +33,27 @@ class TestBuffers(VppTestCase):
         if error:
             self.logger.critical(error)
             self.assertNotIn('failed', error)
+
+    def test_depot(self):
+        """ Buffer Pool Depot """
+        error = self.vapi.cli("test buffer-depot threads 4 iter 1000")
+
+        if error:
+            self.logger.critical(error)
+            self.assertNotIn('failed', error)
+
+    def test_clone(self):
+        """ Buffer Clone """
+        # copied below head size + 2 cache lines, shared above
+        for size in [64, 383, 384, 385, 1500]:
+            error = self.vapi.cli("test buffer-clone size %u iter 100" % size)
+            self.logger.info(error)
+            self.assertNotIn('failed', error)
+
+    def test_size_class(self):
+        """ Buffer Size Classes """
+        error = self.vapi.cli("test buffer-size-class")
+
+        if error:
+            self.logger.critical(error)
+            self.assertNotIn('failed', error)
@@ -524,6 +524,109 @@ class TestCNatTranslation(VppTestCase):
         self.cnat_translation(vips)
 
 
+class TestCNatExpiry(VppTestCase):
+    """ CNat Session Expiry """
+    extra_vpp_punt_config = ["cnat", "{",
+                             "session-cleanup-timeout", "0.1",
+                             "session-max-age", "1",
+                             "tcp-max-age", "1",
+                             "scanner", "off", "}"]
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestCNatExpiry, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestCNatExpiry, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestCNatExpiry, self).setUp()
+
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    def tearDown(self):
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestCNatExpiry, self).tearDown()
+
+    def scanner_counter(self, name):
+        return self.statistics.get_err_counter(
+            "/err/cnat-scanner-process/%s" % name)
+
+    def test_cnat_expiry(self):
+        """ CNat sessions expire within their timeout """
+        vips = [Ep("30.0.0.1", 5555), Ep("30.0.0.1", 5553, UDP)]
+        sports = [1234, 1233]
+        # TCP sessions live for the RST timeout after a FIN
+        tcp_rst_timeout = 5
+
+        self.pg0.generate_remote_hosts(2)
+        self.pg0.configure_ipv4_neighbors()
+        self.pg1.generate_remote_hosts(len(vips))
+        self.pg1.configure_ipv4_neighbors()
+
+        trs = []
+        for nbr, vip in enumerate(vips):
+            dep = Ep(self.pg1.remote_hosts[nbr].ip4, 4000 + nbr)
+            tr = VppCNatTranslation(
+                self, vip.l4p, vip,
+                [EpTuple(Ep("0.0.0.0", 0), dep)])
+            tr.add_vpp_config()
+            trs.append(tr)
+
+        for vip in vips:
+            for src in self.pg0.remote_hosts:
+                for sport in sports:
+                    p = (Ether(dst=self.pg0.local_mac, src=src.mac) /
+                         IP(src=src.ip4, dst=vip.ip) /
+                         vip.l4p(sport=sport, dport=vip.port) /
+                         Raw())
+                    self.send_and_expect(self.pg0, p * N_PKTS, self.pg1)
+                    if vip.l4p != TCP:
+                        continue
+                    # repeated FINs, each shortening the session lifetime
+                    p[TCP].flags = "FA"
+                    self.send_and_expect(self.pg0, p * N_PKTS, self.pg1)
+
+        # a session and its return session per flow
+        n_sessions = 2 * len(vips) * len(self.pg0.remote_hosts) * len(sports)
+        self.assertEqual(len(self.vapi.cnat_session_dump()), n_sessions)
+
+        names = ["session timers visited", "sessions expired",
+                 "session timers rescheduled", "stale session timers"]
+        before = {n: self.scanner_counter(n) for n in names}
+
+        self.vapi.cli("test cnat scanner on")
+
+        # one second wheel slots and the scan interval add some slack
+        n_tries = 0
+        while self.vapi.cnat_session_dump() and n_tries < tcp_rst_timeout + 3:
+            n_tries += 1
+            self.sleep(1)
+        self.logger.info(self.vapi.cli("show errors"))
+        self.assertFalse(self.vapi.cnat_session_dump())
+
+        self.vapi.cli("test cnat scanner off")
+
+        delta = {n: self.scanner_counter(n) - before[n] for n in names}
+        self.assertEqual(delta["sessions expired"], n_sessions)
+        # the FINs moved each session's check, never duplicated it
+        self.assertEqual(delta["stale session timers"], 0)
+        self.assertEqual(delta["session timers visited"],
+                         delta["sessions expired"] +
+                         delta["session timers rescheduled"])
+
+        for tr in trs:
+            tr.remove_vpp_config()
+
+
 class TestCNatSourceNAT(VppTestCase):
     """ CNat Source NAT """
     extra_vpp_punt_config = ["cnat", "{",
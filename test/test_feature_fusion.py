@@ -0,0 +1,33 @@
+#!/usr/bin/env python3
+
+from framework import VppTestCase
+from framework import tag_fixme_vpp_workers
+
+
+@tag_fixme_vpp_workers
+class TestFeatureFusion(VppTestCase):
+    """ Feature Fusion C Unit Tests """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestFeatureFusion, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestFeatureFusion, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestFeatureFusion, self).setUp()
+
+    def tearDown(self):
+        super(TestFeatureFusion, self).tearDown()
+
+    def test_feature_fusion(self):
+        """ Fused and unfused feature arcs """
+        for n_features in range(1, 5):
+            reply = self.vapi.cli("test feature fusion packets 10000 "
+                                  "features %d" % n_features)
+
+            self.logger.info(reply)
+            self.assertNotIn('failed', reply)
+            self.assertIn('fused:', reply)
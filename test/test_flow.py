@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+
+import re
+import unittest
+
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+from scapy.layers.vxlan import VXLAN
+from scapy.contrib.geneve import GENEVE
+from scapy.packet import Raw
+
+from framework import VppTestCase, VppTestRunner
+from vpp_vxlan_tunnel import VppVxlanTunnel
+
+
+class TestFlowPg(VppTestCase):
+    """ Flows offloaded to packet-generator interfaces """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestFlowPg, cls).setUpClass()
+
+        cls.create_pg_interfaces(range(2))
+        for i in cls.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    @classmethod
+    def tearDownClass(cls):
+        for i in cls.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestFlowPg, cls).tearDownClass()
+
+    def flow_add(self, match, action):
+        reply = self.vapi.cli("test flow add %s %s" % (match, action))
+        return int(re.search(r"flow (\d+) added", reply).group(1))
+
+    def udp_stream(self, dport, n):
+        return [(Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                 IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4) /
+                 UDP(sport=1234, dport=dport) /
+                 Raw(b'\xa5' * 100)) for i in range(n)]
+
+    def encap_stream(self, dport, tunnel, n):
+        inner = (Ether(dst="00:00:00:00:00:02", src="00:00:00:00:00:01") /
+                 IP(src="1.1.1.1", dst="2.2.2.2") /
+                 UDP(sport=1111, dport=2222) /
+                 Raw(b'\xa5' * 100))
+        return [(Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                 IP(src=self.pg0.remote_ip4, dst=self.pg0.local_ip4) /
+                 UDP(sport=4321, dport=dport, chksum=0) / tunnel / inner)
+                for i in range(n)], inner
+
+    def xconnect(self, a, b, enable=1):
+        self.vapi.sw_interface_set_l2_xconnect(rx_sw_if_index=a,
+                                               tx_sw_if_index=b,
+                                               enable=enable)
+        self.vapi.sw_interface_set_l2_xconnect(rx_sw_if_index=b,
+                                               tx_sw_if_index=a,
+                                               enable=enable)
+
+    def test_flow_drop(self):
+        """ n-tuple flow dropping packets on a pg interface """
+        index = self.flow_add("src-ip %s dst-ip %s dst-port 4321 proto udp" %
+                              (self.pg0.remote_ip4, self.pg1.remote_ip4),
+                              "drop")
+        self.vapi.cli("test flow enable index %d %s" %
+                      (index, self.pg0.name))
+
+        # only the packets the flow does not match are routed
+        self.pg0.add_stream(self.udp_stream(4321, 10) +
+                            self.udp_stream(1234, 10))
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        rx = self.pg1.get_capture(10)
+        for p in rx:
+            self.assertEqual(p[UDP].dport, 1234)
+
+        # once disabled the flow no longer drops
+        self.vapi.cli("test flow disable index %d %s" %
+                      (index, self.pg0.name))
+        self.send_and_expect(self.pg0, self.udp_stream(4321, 10), self.pg1)
+        self.vapi.cli("test flow del index %d" % index)
+
+    def test_flow_vxlan_redirect(self):
+        """ VXLAN flow redirecting marked packets to the decap """
+        tun = VppVxlanTunnel(self, src=self.pg0.local_ip4,
+                             dst=self.pg0.remote_ip4, vni=100)
+        tun.add_vpp_config()
+        tun.admin_up()
+        self.xconnect(tun.sw_if_index, self.pg1.sw_if_index)
+
+        self.vapi.cli("set flow-offload vxlan hw %s rx %s" %
+                      (self.pg0.name, tun.name))
+        self.assertIn("ipv4-vxlan", self.vapi.cli("show flow entry"))
+
+        tx, inner = self.encap_stream(4789, VXLAN(vni=100, flags=0x08),
+                                     10)
+        rx = self.send_and_expect(self.pg0, tx, self.pg1)
+        for p in rx:
+            self.assertEqual(p[IP].src, inner[IP].src)
+            self.assertEqual(p[IP].dst, inner[IP].dst)
+
+        # the flow redirected the packets to vxlan-flow-input, which took
+        # the tunnel from their mark
+        trace = self.vapi.cli("show trace")
+        self.assertIn("vxlan-flow-input", trace)
+        self.assertIn("VXLAN decap from %s vni 100" % tun.name, trace)
+        self.assertNotIn("vxlan4-input", trace)
+
+        self.vapi.cli("set flow-offload vxlan hw %s rx %s del" %
+                      (self.pg0.name, tun.name))
+        self.xconnect(tun.sw_if_index, self.pg1.sw_if_index, enable=0)
+        tun.remove_vpp_config()
+
+    def test_flow_geneve_mark(self):
+        """ GENEVE flow marking packets with their tunnel """
+        r = self.vapi.geneve_add_del_tunnel(
+            local_address=self.pg0.local_ip4,
+            remote_address=self.pg0.remote_ip4, vni=200)
+        name = self.vapi.sw_interface_dump(
+            sw_if_index=r.sw_if_index)[0].interface_name
+        self.vapi.sw_interface_set_flags(r.sw_if_index, flags=1)
+        self.xconnect(r.sw_if_index, self.pg1.sw_if_index)
+
+        self.vapi.cli("set flow-offload geneve hw %s rx %s" %
+                      (self.pg0.name, name))
+        flows = self.vapi.cli("show flow entry")
+        self.assertIn("ipv4-geneve", flows)
+        self.assertIn("vni 200", flows)
+
+        tx, inner = self.encap_stream(6081, GENEVE(vni=200), 10)
+        rx = self.send_and_expect(self.pg0, tx, self.pg1)
+        for p in rx:
+            self.assertEqual(p[IP].src, inner[IP].src)
+            self.assertEqual(p[IP].dst, inner[IP].dst)
+        self.assertEqual(self.statistics.get_err_counter(
+            "/err/geneve4-input/good packets decapsulated"), 10)
+
+        self.vapi.cli("set flow-offload geneve hw %s rx %s del" %
+                      (self.pg0.name, name))
+        self.xconnect(r.sw_if_index, self.pg1.sw_if_index, enable=0)
+        self.vapi.geneve_add_del_tunnel(
+            is_add=0, local_address=self.pg0.local_ip4,
+            remote_address=self.pg0.remote_ip4, vni=200)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -2203,6 +2203,13 @@ class TestIPv4Frag(VppTestCase):
             payload += p[Raw].load
         self.assert_equal(payload, saved_payload, "payload")
 
+    def test_frag_chains(self):
+        """ Fragmentation of buffer chains """
+
+        error = self.vapi.cli("test ip frag")
+        self.logger.info(error)
+        self.assertNotIn("fail", error)
+
 
 class TestIPReplace(VppTestCase):
     """ IPv4 Table Replace """
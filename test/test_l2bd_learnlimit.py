@@ -72,6 +72,65 @@ class TestL2LearnLimit(VppTestCase):
         # check that 20 macs are learned.
         self.assertEqual(len(lfs), 20)
 
+    def wait_for_empty_fib(self, bd_id, timeout):
+        for i in range(timeout):
+            if not self.vapi.l2_fib_table_dump(bd_id):
+                return
+            self.sleep(1)
+        self.fail("MACs of bd %d not flushed" % bd_id)
+
+    def test_l2bd_learnlimit_move(self):
+        """ L2BD test with learn limit and MAC moves
+        """
+        pg0, pg2 = self.pg_interfaces[0], self.pg_interfaces[2]
+        self.vapi.bridge_domain_set_learn_limit(bd_id=1, learn_limit=10)
+        self.vapi.sw_interface_set_l2_bridge(pg2.sw_if_index, bd_id=1)
+
+        hosts = self.create_hosts(pg0, 20, 1)
+        self.learn_hosts(pg0, 1, hosts)
+        self.assertEqual(len(self.vapi.l2_fib_table_dump(1)), 10)
+
+        # moved MACs are not counted twice, nor is the limit applied to them
+        self.learn_hosts(pg2, 1, {pg2.sw_if_index: hosts[pg0.sw_if_index]})
+        lfs = self.vapi.l2_fib_table_dump(1)
+        self.assertEqual(len(lfs), 10)
+        for lf in lfs:
+            self.assertEqual(lf.sw_if_index, pg2.sw_if_index)
+
+        # flushing the bd gives its learn count back
+        self.vapi.l2fib_flush_bd(bd_id=1)
+        self.wait_for_empty_fib(1, 5)
+        hosts = self.create_hosts(pg0, 10, 2)
+        self.learn_hosts(pg0, 1, hosts)
+        self.assertEqual(len(self.vapi.l2_fib_table_dump(1)), 10)
+
+        self.vapi.sw_interface_set_l2_bridge(pg2.sw_if_index, bd_id=1,
+                                             enable=0)
+
+    @unittest.skipUnless(running_extended_tests, "part of extended tests")
+    def test_l2bd_learnlimit_aging(self):
+        """ L2BD test with learn limit and MAC aging
+        """
+        pg2 = self.pg_interfaces[2]
+        self.vapi.bridge_domain_add_del(bd_id=3, mac_age=1)
+        self.vapi.bridge_domain_set_learn_limit(bd_id=3, learn_limit=10)
+        self.vapi.sw_interface_set_l2_bridge(pg2.sw_if_index, bd_id=3)
+
+        hosts = self.create_hosts(pg2, 10, 3)
+        self.learn_hosts(pg2, 3, hosts)
+        self.assertEqual(len(self.vapi.l2_fib_table_dump(3)), 10)
+
+        # the ager scans a slice of the table at a time, the learn count
+        # must drop as soon as the MACs are aged out
+        self.wait_for_empty_fib(3, 180)
+        hosts = self.create_hosts(pg2, 10, 4)
+        self.learn_hosts(pg2, 3, hosts)
+        self.assertEqual(len(self.vapi.l2_fib_table_dump(3)), 10)
+
+        self.vapi.sw_interface_set_l2_bridge(pg2.sw_if_index, bd_id=3,
+                                             enable=0)
+        self.vapi.bridge_domain_add_del(bd_id=3, is_add=0)
+
     def setUp(self):
         super(TestL2LearnLimit, self).setUp()
 
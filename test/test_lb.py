@@ -500,3 +500,39 @@ class TestLB(VppTestCase):
                 "lb vip 2001::/16 protocol udp port 20000 encap nat6"
                 " type clusterip target_port 3307 del")
             self.vapi.cli("test lb flowtable flush")
+
+    def test_lb_as_weight(self):
+        """ Load Balancer AS weights """
+        try:
+            self.vapi.cli("lb vip 90.0.0.0/8 encap gre4")
+            self.vapi.lb_add_del_as_v2(pfx="90.0.0.0/8",
+                                       as_address="10.0.0.1", weight=5)
+            # the legacy message leaves the weight unchanged
+            with self.vapi.assert_negative_api_retval():
+                self.vapi.lb_add_del_as(pfx="90.0.0.0/8",
+                                        as_address="10.0.0.1")
+            self.assertIn("weight:5",
+                          self.vapi.cli("show lb vips verbose"))
+            for weight in (0, 65536):
+                with self.vapi.assert_negative_api_retval():
+                    self.vapi.lb_add_del_as_v2(pfx="90.0.0.0/8",
+                                               as_address="10.0.0.2",
+                                               weight=weight)
+            self.vapi.lb_add_del_as_v2(pfx="90.0.0.0/8",
+                                       as_address="10.0.0.2", weight=65535)
+            self.assertIn("weight:65535",
+                          self.vapi.cli("show lb vips verbose"))
+        finally:
+            for asid in (1, 2):
+                self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u del" % asid)
+            self.vapi.cli("lb vip 90.0.0.0/8 encap gre4 del")
+            self.vapi.cli("test lb flowtable flush")
+
+    def test_lb_maglev(self):
+        """ Load Balancer Maglev table build """
+        reply = self.vapi.cli("test lb maglev")
+        self.logger.info(reply)
+        reply = self.vapi.cli("test lb maglev ass 100 new_len 1048576"
+                              " weight 32767")
+        self.logger.info(reply)
+        self.assertIn("reweight", reply)
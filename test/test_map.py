@@ -6,7 +6,7 @@ import unittest
 from framework import VppTestCase, VppTestRunner
 from vpp_ip import DpoProto
 from vpp_ip_route import VppIpRoute, VppRoutePath
-from util import fragment_rfc791, fragment_rfc8200
+from util import fragment_rfc791, fragment_rfc8200, reassemble4
 
 import scapy.compat
 from scapy.layers.l2 import Ether
@@ -410,6 +410,46 @@ class TestMAP(VppTestCase):
         self.validate(rx[0][1], v6_reply1)
         self.validate(rx[1][1], v6_reply2)
 
+    def test_map_e_inner_frag_chained(self):
+        """ MAP-E Inner fragmentation of chained buffers """
+
+        map_route = VppIpRoute(self, "2001::", 32,
+                               [VppRoutePath(self.pg1.remote_ip6,
+                                             self.pg1.sw_if_index)])
+        map_route.add_vpp_config()
+
+        rv = self.vapi.map_add_domain(ip4_prefix='172.16.0.0/16',
+                                      ip6_prefix='2001::/32',
+                                      ip6_src='3000::1/128',
+                                      ea_bits_len=20,
+                                      psid_offset=4,
+                                      psid_length=4,
+                                      mtu=1000)
+        self.vapi.map_if_enable_disable(is_enable=1,
+                                        sw_if_index=self.pg0.sw_if_index,
+                                        is_translation=0)
+        self.vapi.map_param_set_fragmentation(inner=1)
+
+        # a payload larger than a buffer arrives in a chain
+        v4 = (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+              IP(src=self.pg0.remote_ip4, dst='172.16.1.1') /
+              UDP(sport=20000, dport=10000) /
+              Raw(bytes(range(256)) * 20))
+
+        self.pg_send(self.pg0, v4 * 1)
+        rx = self.pg1.get_capture(6)
+
+        for p in rx:
+            # the payload length covers all of the chain
+            self.assertEqual(p[IPv6].plen, len(p) - len(Ether()) - 40)
+        frags = [IP(bytes(p[IPv6].payload)) for p in rx]
+        frags.sort(key=lambda f: f.frag)
+        v4_rx = reassemble4(frags)
+        self.assertEqual(bytes(v4_rx[UDP].payload), bytes(v4[Raw]))
+
+        self.vapi.map_param_set_fragmentation(inner=0)
+        self.vapi.map_del_domain(index=rv.index)
+
     def test_map_e_tcp_mss(self):
         """ MAP-E TCP MSS"""
 
@@ -913,6 +913,14 @@ class TestMPLS(VppTestCase):
         self.verify_capture_fragmented_labelled_ip4(self.pg0, rx, tx,
                                                     [VppMplsLabel(32)])
 
+        #
+        # the trace shows the size of the chain before it is fragmented
+        #
+        self.vapi.cli("clear trace")
+        self.send_and_expect(self.pg0, tx[:1], self.pg0, 5)
+        self.assertIn("pkt-size:%d" % (len(tx[0][IP]) + 4),
+                      self.vapi.cli("show trace"))
+
         #
         # cleanup
         #
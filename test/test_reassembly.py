@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
 
+import re
 import unittest
 from random import shuffle, choice, randrange
 
@@ -167,6 +168,61 @@ class TestIPv4Reassembly(VppTestCase):
         self.verify_capture(packets)
         self.src_if.assert_nothing_captured()
 
+    def reassembled_n_buffers(self):
+        """ buffers in each reassembled packet, from the trace """
+        trace = self.vapi.cli("show trace max 1000")
+        return [int(n) for n in
+                re.findall(r"finalize reassembly, (\d+) buffers", trace)]
+
+    def test_chained_output(self):
+        """ reassembled packet keeps the fragments chained """
+
+        p = (Ether(dst=self.src_if.local_mac, src=self.src_if.remote_mac) /
+             IP(id=1000, src=self.src_if.remote_ip4,
+                dst=self.dst_if.remote_ip4) /
+             UDP(sport=1234, dport=5678) /
+             Raw(bytes(i % 251 for i in range(1400))))
+        frags = fragment_rfc791(p, 400)
+
+        self.pg_enable_capture()
+        self.src_if.add_stream(frags)
+        self.pg_start()
+
+        rx = self.dst_if.get_capture(1)
+        self.assertEqual(rx[0][Raw].load, p[Raw].load)
+        n_buffers = self.reassembled_n_buffers()
+        self.assertEqual(len(n_buffers), 1)
+        self.assertGreater(n_buffers[0], 1)
+
+    def test_short_first_fragment(self):
+        """ reassembled packet with a short first fragment is compacted """
+
+        p = (Ether(dst=self.src_if.local_mac, src=self.src_if.remote_mac) /
+             IP(id=1001, src=self.src_if.remote_ip4,
+                dst=self.dst_if.remote_ip4) /
+             UDP(sport=1234, dport=5678) /
+             Raw(bytes(i % 251 for i in range(1400))))
+        # 64 bytes of payload per fragment, too few to parse from
+        frags = fragment_rfc791(p, 100)
+        shuffle(frags)
+
+        self.pg_enable_capture()
+        self.src_if.add_stream(frags)
+        self.pg_start()
+
+        rx = self.dst_if.get_capture(1)
+        self.assertEqual(rx[0][Raw].load, p[Raw].load)
+        self.assertEqual(self.reassembled_n_buffers(), [1])
+
+    def test_fragment_storm(self):
+        """ fragment storm benchmark """
+
+        reply = self.vapi.cli("test ip reassembly ip4 packets 10000 "
+                              "fragments 4 fragment-size 1024")
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+        self.assertIn("reassemblies/sec", reply)
+
     def test_verify_clear_trace_mid_reassembly(self):
         """ verify clear trace works mid-reassembly """
 
@@ -961,6 +1017,26 @@ class TestIPv4MWReassembly(VppTestCase):
         for send_if in self.send_ifs:
             send_if.assert_nothing_captured()
 
+    def test_steering(self):
+        """ fragments steered to the owner of the context """
+
+        self.vapi.cli("set ip4-full-reassembly steering on")
+        try:
+            fragments = [[] for n in range(self.vpp_worker_count)]
+            for (_, p) in self.pkt_infos:
+                for f in p:
+                    fragments[randrange(self.vpp_worker_count)].append(f)
+
+            self.pg_enable_capture()
+            self.send_packets(fragments)
+
+            packets = self.dst_if.get_capture(len(self.pkt_infos))
+            self.verify_capture(packets)
+            for send_if in self.send_ifs:
+                send_if.assert_nothing_captured()
+        finally:
+            self.vapi.cli("set ip4-full-reassembly steering off")
+
 
 class TestIPv6Reassembly(VppTestCase):
     """ IPv6 Reassembly """
@@ -1104,6 +1180,61 @@ class TestIPv6Reassembly(VppTestCase):
         self.verify_capture(packets)
         self.src_if.assert_nothing_captured()
 
+    def reassembled_n_buffers(self):
+        """ buffers in each reassembled packet, from the trace """
+        trace = self.vapi.cli("show trace max 1000")
+        return [int(n) for n in
+                re.findall(r"finalize reassembly, (\d+) buffers", trace)]
+
+    def test_chained_output(self):
+        """ reassembled packet keeps the fragments chained """
+
+        p = (Ether(dst=self.src_if.local_mac, src=self.src_if.remote_mac) /
+             IPv6(src=self.src_if.remote_ip6,
+                  dst=self.dst_if.remote_ip6) /
+             UDP(sport=1234, dport=5678) /
+             Raw(bytes(i % 251 for i in range(1400))))
+        frags = fragment_rfc8200(p, 1000, 400)
+
+        self.pg_enable_capture()
+        self.src_if.add_stream(frags)
+        self.pg_start()
+
+        rx = self.dst_if.get_capture(1)
+        self.assertEqual(rx[0][Raw].load, p[Raw].load)
+        n_buffers = self.reassembled_n_buffers()
+        self.assertEqual(len(n_buffers), 1)
+        self.assertGreater(n_buffers[0], 1)
+
+    def test_short_first_fragment(self):
+        """ reassembled packet with a short first fragment is compacted """
+
+        p = (Ether(dst=self.src_if.local_mac, src=self.src_if.remote_mac) /
+             IPv6(src=self.src_if.remote_ip6,
+                  dst=self.dst_if.remote_ip6) /
+             UDP(sport=1234, dport=5678) /
+             Raw(bytes(i % 251 for i in range(1400))))
+        # 32 bytes of payload per fragment, too few to parse from
+        frags = fragment_rfc8200(p, 1001, 100)
+        shuffle(frags)
+
+        self.pg_enable_capture()
+        self.src_if.add_stream(frags)
+        self.pg_start()
+
+        rx = self.dst_if.get_capture(1)
+        self.assertEqual(rx[0][Raw].load, p[Raw].load)
+        self.assertEqual(self.reassembled_n_buffers(), [1])
+
+    def test_fragment_storm(self):
+        """ fragment storm benchmark """
+
+        reply = self.vapi.cli("test ip reassembly ip6 packets 10000 "
+                              "fragments 4 fragment-size 1024")
+        self.logger.info(reply)
+        self.assertNotIn("failed", reply)
+        self.assertIn("reassemblies/sec", reply)
+
     def test_buffer_boundary(self):
         """ fragment header crossing buffer boundary """
 
@@ -1609,6 +1740,26 @@ class TestIPv6MWReassembly(VppTestCase):
         for send_if in self.send_ifs:
             send_if.assert_nothing_captured()
 
+    def test_steering(self):
+        """ fragments steered to the owner of the context """
+
+        self.vapi.cli("set ip6-full-reassembly steering on")
+        try:
+            fragments = [[] for n in range(self.vpp_worker_count)]
+            for (_, p) in self.pkt_infos:
+                for f in p:
+                    fragments[randrange(self.vpp_worker_count)].append(f)
+
+            self.pg_enable_capture()
+            self.send_packets(fragments)
+
+            packets = self.dst_if.get_capture(len(self.pkt_infos))
+            self.verify_capture(packets)
+            for send_if in self.send_ifs:
+                send_if.assert_nothing_captured()
+        finally:
+            self.vapi.cli("set ip6-full-reassembly steering off")
+
 
 class TestIPv6SVReassembly(VppTestCase):
     """ IPv6 Shallow Virtual Reassembly """
@@ -2,7 +2,7 @@
 
 import unittest
 import psutil
-from vpp_papi.vpp_stats import VPPStats
+from vpp_papi.vpp_stats import VPPStats, histogram_bucket_min
 
 from framework import tag_fixme_vpp_workers
 from framework import VppTestCase, VppTestRunner
@@ -26,6 +26,7 @@ class StatsClientTestCase(VppTestCase):
     def setUpConstants(cls):
         cls.extra_vpp_statseg_config = "per-node-counters on"
         cls.extra_vpp_statseg_config += "update-interval 0.05"
+        cls.extra_vpp_statseg_config += " aggregate /if/"
         super(StatsClientTestCase, cls).setUpConstants()
 
     def test_set_errors(self):
@@ -124,6 +125,75 @@ class StatsClientTestCase(VppTestCase):
             i.unconfig()
             i.admin_down()
 
+    def test_node_histograms(self):
+        """Test node clocks and vectors histograms"""
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        p = list()
+        for i in range(5):
+            packet = (Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac) /
+                      IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4))
+            p.append(packet)
+
+        self.send_and_expect(self.pg0, p, self.pg1)
+        self.sleep(0.1)
+
+        calls = self.statistics.get_counter('/nodes/ip4-input/calls')
+        vectors = self.statistics.get_counter('/nodes/ip4-input/vectors')
+        clocks_hist = self.statistics.get_counter(
+            '/nodes/ip4-input/clocks_histogram').sum()
+        vectors_hist = self.statistics.get_counter(
+            '/nodes/ip4-input/vectors_histogram').sum()
+
+        # each call is counted once, frames this small have exact buckets
+        self.assertEqual(clocks_hist.total(), sum(calls))
+        self.assertEqual(vectors_hist.total(), sum(calls))
+        self.assertEqual(sum(histogram_bucket_min(b) * n
+                             for b, n in enumerate(vectors_hist)),
+                         sum(vectors))
+        self.assertGreater(clocks_hist.percentile(99), 0)
+
+        for i in self.pg_interfaces:
+            i.unconfig()
+            i.admin_down()
+
+    def test_interface_latency(self):
+        """Test interface pair latency sampling"""
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+            self.vapi.cli("set interface latency-sampling %s interval 1" %
+                          i.name)
+
+        p = list()
+        for i in range(5):
+            packet = (Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac) /
+                      IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4))
+            p.append(packet)
+
+        # the first sample of a pair creates its histogram
+        self.send_and_expect(self.pg0, p[:1], self.pg1)
+        self.send_and_expect(self.pg0, p, self.pg1)
+
+        latency = self.statistics.get_counter(
+            '/if/latency/pg0/pg1')[:, 0].sum()
+        self.assertEqual(latency.total(), 5)
+        self.assertGreater(latency.percentile(50), 0)
+
+        for i in self.pg_interfaces:
+            self.vapi.cli("set interface latency-sampling %s disable" %
+                          i.name)
+            i.unconfig()
+            i.admin_down()
+
     def test_index_consistency(self):
         """Test index consistency despite changes in the stats"""
         d = self.statistics.ls(['/if/names'])
@@ -140,6 +210,104 @@ class StatsClientTestCase(VppTestCase):
         for i in self.lo_interfaces:
             i.remove_vpp_config()
 
+    def test_directory_append(self):
+        """Test counters added within a directory epoch"""
+        epoch = self.statistics.epoch
+        self.create_loopback_interfaces(10)
+
+        # the symlinks of each interface are appended in place, the epoch
+        # only changes when the directory vector moves
+        self.assertLess(self.statistics.epoch - epoch, 10)
+
+        names = self.statistics.get_counter('/if/names')
+        for i in self.lo_interfaces:
+            self.assertIn(i.name, names)
+            rx = self.statistics.get_counter('/interfaces/%s/rx' % i.name)
+            self.assertEqual(rx[0]['packets'], 0)
+
+        for i in self.lo_interfaces:
+            i.remove_vpp_config()
+
+    def test_aggregate(self):
+        """Test interface counters summed over threads"""
+        self.create_pg_interfaces(range(2))
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        p = (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+             IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4))
+        self.send_and_expect(self.pg0, p * 5, self.pg1)
+
+        self.wait_for_aggregate_pass()
+
+        rx = self.statistics['/if/rx']
+        aggregate = self.statistics['/aggregate/if/rx']
+        self.assertEqual(aggregate[self.pg0.sw_if_index],
+                         (rx[:, self.pg0.sw_if_index].sum_packets(),
+                          rx[:, self.pg0.sw_if_index].sum_octets()))
+        self.assertEqual(aggregate[self.pg0.sw_if_index][0], 5)
+
+        drops = self.statistics['/if/drops']
+        self.assertEqual(self.statistics['/aggregate/if/drops'],
+                         [sum(c) for c in zip(*drops)])
+
+        for i in self.pg_interfaces:
+            i.unconfig()
+            i.admin_down()
+
+    def test_aggregate_changed(self):
+        """Test refreshing the interface sums changed since a dump"""
+        self.create_pg_interfaces(range(2))
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        p = (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+             IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4))
+        self.send_and_expect(self.pg0, p * 5, self.pg1)
+        self.wait_for_aggregate_pass()
+
+        rx, generation = self.statistics.dump_changed('/aggregate/if/rx', 0)
+        self.assertIn(self.pg0.sw_if_index, rx)
+        self.assertEqual(rx[self.pg0.sw_if_index],
+                         self.statistics['/aggregate/if/rx'][
+                             self.pg0.sw_if_index])
+
+        # only the sums of pg1 change when it receives
+        p = (Ether(dst=self.pg1.local_mac, src=self.pg1.remote_mac) /
+             IP(src=self.pg1.remote_ip4, dst=self.pg0.remote_ip4))
+        self.send_and_expect(self.pg1, p * 3, self.pg0)
+        self.wait_for_aggregate_pass()
+
+        changed, generation = self.statistics.dump_changed(
+            '/aggregate/if/rx', generation)
+        self.assertEqual(list(changed), [self.pg1.sw_if_index])
+        self.assertEqual(changed[self.pg1.sw_if_index][0],
+                         rx.get(self.pg1.sw_if_index, (0, 0))[0] + 3)
+
+        # and nothing changed since
+        self.wait_for_aggregate_pass()
+        changed, _ = self.statistics.dump_changed('/aggregate/if/rx',
+                                                  generation)
+        self.assertEqual(changed, {})
+
+        for i in self.pg_interfaces:
+            i.unconfig()
+            i.admin_down()
+
+    def wait_for_aggregate_pass(self, timeout=5):
+        # a pass completing right after this may have begun before the
+        # last packets were counted, wait for the pass after it
+        generation = self.statistics.aggregate_generation + 1
+        for i in range(int(timeout / 0.05)):
+            if self.statistics.aggregate_generation > generation:
+                return
+            self.sleep(0.05)
+        self.fail("no stats collector pass over the aggregates")
+
     @unittest.skip("Manual only")
     def test_mem_leak(self):
         def loop():
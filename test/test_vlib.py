@@ -141,6 +141,7 @@ class TestVlib(VppTestCase):
                 "clear interfaces",
                 "test vlib",
                 "test vlib2",
+                "test async-copy",
                 "show memory api-segment stats-segment main-heap verbose",
                 "leak-check { show memory }",
                 "show cpu",
@@ -218,5 +219,152 @@ class TestVlib(VppTestCase):
                 else:
                     self.logger.info(cmd + " FAIL retval " + str(r.retval))
 
+    def test_worker_quiescence(self):
+        """ Calls deferred until the workers went around their loop """
+        reply = self.vapi.cli("test worker-quiescence")
+        self.logger.info(reply)
+        self.assertIn("running: called after the workers went around", reply)
+        self.assertIn("barrier: called after the workers went around", reply)
+
+    def test_cpu_placement(self):
+        """ Automatic worker placement on a fake cpu topology """
+        reply = self.vapi.cli("test cpu-placement")
+        self.logger.info(reply)
+        for case in ["nic on node 1", "no nic", "no topology"]:
+            self.assertIn("%s: ok" % case, reply)
+
+    def test_node_batching(self):
+        """ Node Dispatch Batching Test """
+
+        cmds = ["loopback create",
+                "packet-generator new {\n"
+                " name batching\n"
+                " limit 15\n"
+                " size 128-128\n"
+                " interface loop0\n"
+                " node ip6-input\n"
+                " data {\n"
+                "   ICMP: db00::1 -> db00::2\n"
+                "   incrementing 30\n"
+                "   }\n"
+                "}\n",
+                "set node batching ip6-input min-vectors 32 max-delay 1000",
+                "packet-generator enable-stream batching",
+                ]
+
+        for cmd in cmds:
+            r = self.vapi.cli_return_response(cmd)
+            self.assertEqual(r.retval, 0, cmd)
+        self.sleep(0.1)
+
+        # the 15 packets are too few for ip6-input, they are held back for
+        # the whole delay then dispatched as one vector of 15
+        reply = self.vapi.cli("show node batching")
+        self.logger.info(reply)
+        line = [l for l in reply.splitlines() if l.startswith("ip6-input")]
+        self.assertEqual(len(line), 1)
+        fields = line[0].split()
+        self.assertEqual(fields[1], "32")
+        self.assertGreater(int(fields[3]), 0)
+        self.assertEqual(int(fields[4]), 1)
+        self.assertEqual(fields[5:], ["14-15:1"])
+
+        self.vapi.cli("set node batching ip6-input disable")
+        reply = self.vapi.cli("show node batching")
+        self.assertIn("no node batching", reply)
+        self.vapi.cli("packet-generator delete batching")
+
+    def test_node_batching_graph_change(self):
+        """ Node Dispatch Batching Across a Graph Change """
+        self.create_loopback_interfaces(1)
+        loop = self.lo_interfaces[0]
+        cmds = ["clear node batching",
+                "packet-generator new {\n"
+                " name batching-graph\n"
+                " limit 15\n"
+                " size 128-128\n"
+                " worker 0\n"
+                " interface %s\n"
+                " node ip6-input\n"
+                " data {\n"
+                "   ICMP: db00::1 -> db00::2\n"
+                "   incrementing 30\n"
+                "   }\n"
+                "}\n" % loop.name,
+                "set node batching ip6-input min-vectors 32 "
+                "max-delay 10000000",
+                "packet-generator enable-stream batching-graph",
+                ]
+
+        for cmd in cmds:
+            r = self.vapi.cli_return_response(cmd)
+            self.assertEqual(r.retval, 0, cmd)
+
+        # the worker holds the 15 packets back for up to 10 seconds, any
+        # API call would take the barrier, read the stats segment instead
+        self.sleep(0.2)
+        drops = self.statistics['/if/drops'][:, loop.sw_if_index]
+        self.assertEqual(sum(drops), 0)
+
+        # creating an interface adds nodes, the worker dispatches the frame
+        # it holds before the barrier and the node graph refork
+        r = self.vapi.create_loopback()
+        self.sleep(0.1)
+        drops = self.statistics['/if/drops'][:, loop.sw_if_index]
+        self.assertEqual(sum(drops), 15)
+
+        reply = self.vapi.cli("show node batching")
+        self.logger.info(reply)
+        line = [l for l in reply.splitlines() if l.startswith("ip6-input")]
+        self.assertEqual(len(line), 1)
+        fields = line[0].split()
+        self.assertGreater(int(fields[3]), 0)
+        self.assertEqual(int(fields[4]), 0)
+        self.assertEqual(fields[5:], ["14-15:1"])
+
+        self.vapi.cli("set node batching ip6-input disable")
+        self.vapi.cli("packet-generator delete batching-graph")
+        self.vapi.delete_loopback(sw_if_index=r.sw_if_index)
+        loop.remove_vpp_config()
+
+
+class TestVlibAsyncCopy(VppTestCase):
+    """ Vlib Async Copy Test Case """
+    vpp_worker_count = 2
+
+    @classmethod
+    def get_cpus_required(cls):
+        # one more for the copy helper thread
+        return super(TestVlibAsyncCopy, cls).get_cpus_required() + 1
+
+    @classmethod
+    def setUpClass(cls):
+        cls.extra_vpp_punt_config = ["cpu", "{", "corelist-copy",
+                                     str(cls.cpus[-1]), "}"]
+        super(TestVlibAsyncCopy, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestVlibAsyncCopy, cls).tearDownClass()
+
+    def test_async_copy(self):
+        """ Async copy on the main thread and the workers """
+        for i in range(50):
+            reply = self.vapi.cli("show async-copy")
+            if "started 1" in reply:
+                break
+            self.sleep(0.1)
+        self.assertIn("helpers 1 started 1", reply)
+
+        # each thread checks its batches were handed off to the helper
+        reply = self.vapi.cli("test async-copy")
+        self.logger.info(reply)
+        for thread in range(3):
+            self.assertIn("thread %u: async" % thread, reply)
+
+        # small batches are copied inline
+        reply = self.vapi.cli("test async-copy len 1000")
+        self.logger.info(reply)
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -53,3 +53,18 @@ class TestVpeApi(VppTestCase):
             print('\n'.join([str(v) for v in rv]))
             print('%r %s' % (rv.vpe_system_time,
                              rv.vpe_system_time))
+
+    def test_show_cpu_topology(self):
+        rv = self.vapi.show_cpu_topology()
+        if enable_print:
+            print('\n'.join([str(v) for v in rv.cpus]))
+        self.assertFalse(rv.placement_auto)
+        self.assertEqual(rv.count, len(rv.cpus))
+        self.assertTrue(rv.count > 0)
+
+        # the main thread is pinned to one of the cpus
+        threads = [c.thread_index for c in rv.cpus
+                   if c.thread_index != 0xffffffff]
+        self.assertIn(0, threads)
+        for c in rv.cpus:
+            self.assertGreater(c.n_siblings, 0)